@@ -745,9 +745,13 @@ BOOL WINAPI SetFirmwareEnvironmentVariableW(const WCHAR *name, const WCHAR *guid
  */
 BOOL WINAPI GetNumaNodeProcessorMask(UCHAR node, PULONGLONG mask)
 {
-    FIXME("(%c %p): stub\n", node, mask);
-    SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
-    return FALSE;
+    GROUP_AFFINITY affinity;
+
+    TRACE("(%u %p)\n", node, mask);
+
+    if (!GetNumaNodeProcessorMaskEx(node, &affinity)) return FALSE;
+    *mask = affinity.Mask;
+    return TRUE;
 }
 
 /**********************************************************************
@@ -775,16 +779,21 @@ BOOL WINAPI GetNumaAvailableMemoryNodeEx(USHORT node, PULONGLONG available_bytes
  */
 BOOL WINAPI GetNumaProcessorNode(UCHAR processor, PUCHAR node)
 {
+    PROCESSOR_NUMBER number;
+    USHORT node_number;
+
     TRACE("(%d, %p)\n", processor, node);
 
-    if (processor < system_info.NumberOfProcessors)
+    number.Group = 0;
+    number.Number = processor;
+    number.Reserved = 0;
+    if (GetNumaProcessorNodeEx(&number, &node_number))
     {
-        *node = 0;
+        *node = node_number;
         return TRUE;
     }
 
     *node = 0xFF;
-    SetLastError(ERROR_INVALID_PARAMETER);
     return FALSE;
 }
 
@@ -793,8 +802,34 @@ BOOL WINAPI GetNumaProcessorNode(UCHAR processor, PUCHAR node)
  */
 BOOL WINAPI GetNumaProcessorNodeEx(PPROCESSOR_NUMBER processor, PUSHORT node_number)
 {
-    SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
-    return FALSE;
+    GROUP_AFFINITY affinity;
+    ULONG node, highest;
+
+    TRACE("(%p, %p)\n", processor, node_number);
+
+    if (processor->Group || processor->Number >= system_info.NumberOfProcessors)
+    {
+        *node_number = 0xFFFF;
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+
+    if (GetNumaHighestNodeNumber(&highest))
+    {
+        for (node = 0; node <= highest; node++)
+        {
+            if (!GetNumaNodeProcessorMaskEx(node, &affinity)) continue;
+            if (affinity.Mask & ((KAFFINITY)1 << processor->Number))
+            {
+                *node_number = node;
+                return TRUE;
+            }
+        }
+    }
+
+    /* processors outside any reported node belong to node 0 */
+    *node_number = 0;
+    return TRUE;
 }
 
 /***********************************************************************
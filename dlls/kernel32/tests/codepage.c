@@ -1308,6 +1308,137 @@ static void test_dbcs_to_widechar(void)
     }
 }
 
+struct utf8_unit
+{
+    const char *str;
+    unsigned int kind;  /* bit mask of the corpora using it */
+};
+
+static const struct utf8_unit utf8_units[] =
+{
+    { "a", 1 | 2 | 4 },
+    { "The quick brown fox ", 1 | 2 | 4 },
+    { "0123456789", 1 | 4 },
+    { "\xc3\xa9", 2 | 4 },          /* U+00E9 */
+    { "\xc3\x9f", 2 | 4 },          /* U+00DF */
+    { "\xd0\x96", 2 | 4 },          /* U+0416 */
+    { "\xe4\xb8\xad", 4 | 8 },     /* U+4E2D */
+    { "\xe6\x96\x87", 4 | 8 },     /* U+6587 */
+    { "\xef\xbf\xbd", 8 },         /* U+FFFD */
+    { "\xf0\x9f\x98\x80", 4 | 8 }, /* U+1F600, needs a surrogate pair */
+    { "\x80", 4 },                  /* stray continuation byte */
+    { "\xed\xa0\x80", 4 },         /* encoded surrogate */
+    { "\xc0\xaf", 4 },              /* overlong */
+};
+
+static const char *utf8_corpus_names[] = { "ascii", "latin", "mixed", "cjk" };
+
+/* concatenate random units, along with the conversion of each unit on its own */
+static int build_utf8_corpus( unsigned int kind, char *src, int srclen, WCHAR *expect, int *expect_len )
+{
+    static unsigned int seed = 1234;
+    int len = 0, ret;
+
+    *expect_len = 0;
+    for (;;)
+    {
+        const struct utf8_unit *unit = &utf8_units[(seed = seed * 69069 + 1) % ARRAY_SIZE(utf8_units)];
+        int unit_len = strlen( unit->str );
+
+        if (!(unit->kind & kind)) continue;
+        if (len + unit_len > srclen) break;
+        memcpy( src + len, unit->str, unit_len );
+        len += unit_len;
+        ret = MultiByteToWideChar( CP_UTF8, 0, unit->str, unit_len, expect + *expect_len, 8 );
+        ok( ret > 0, "MultiByteToWideChar failed for %s\n", debugstr_a(unit->str) );
+        *expect_len += ret;
+    }
+    return len;
+}
+
+static void test_utf8_corpus(void)
+{
+    static const int sizes[] = { 5, 17, 64, 300, 4096 };
+    char *src, *back, *expect_back;
+    WCHAR *dst, *expect;
+    int i, j, k, len, expect_len, ret, back_len;
+    LARGE_INTEGER freq, start, end;
+
+    src = HeapAlloc( GetProcessHeap(), 0, 4096 + 8 );
+    back = HeapAlloc( GetProcessHeap(), 0, 4096 * 3 );
+    expect_back = HeapAlloc( GetProcessHeap(), 0, 4096 * 3 );
+    dst = HeapAlloc( GetProcessHeap(), 0, 4096 * sizeof(WCHAR) );
+    expect = HeapAlloc( GetProcessHeap(), 0, 4096 * sizeof(WCHAR) );
+
+    for (i = 0; i < ARRAY_SIZE(utf8_corpus_names); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(sizes); j++)
+        {
+            /* vary the alignment of the source */
+            for (k = 0; k < 8; k += 3)
+            {
+                len = build_utf8_corpus( 1 << i, src + k, sizes[j], expect, &expect_len );
+
+                ret = MultiByteToWideChar( CP_UTF8, 0, src + k, len, NULL, 0 );
+                ok( ret == expect_len, "%s %d: got length %d, expected %d\n",
+                    utf8_corpus_names[i], sizes[j], ret, expect_len );
+                memset( dst, 0xcc, 4096 * sizeof(WCHAR) );
+                ret = MultiByteToWideChar( CP_UTF8, 0, src + k, len, dst, 4096 );
+                ok( ret == expect_len, "%s %d: got %d, expected %d\n",
+                    utf8_corpus_names[i], sizes[j], ret, expect_len );
+                ok( !memcmp( dst, expect, expect_len * sizeof(WCHAR) ), "%s %d: wrong conversion %s\n",
+                    utf8_corpus_names[i], sizes[j], wine_dbgstr_wn( dst, expect_len ));
+
+                if (expect_len > 1)
+                {
+                    SetLastError( 0xdeadbeef );
+                    ret = MultiByteToWideChar( CP_UTF8, 0, src + k, len, dst, expect_len - 1 );
+                    ok( !ret && GetLastError() == ERROR_INSUFFICIENT_BUFFER, "%s %d: got %d, error %u\n",
+                        utf8_corpus_names[i], sizes[j], ret, GetLastError() );
+                }
+
+                /* the expected UTF-8 is the conversion of each character on its own */
+                for (ret = back_len = 0; ret < expect_len; ret++)
+                {
+                    int n = IS_HIGH_SURROGATE( expect[ret] ) && ret + 1 < expect_len &&
+                            IS_LOW_SURROGATE( expect[ret + 1] ) ? 2 : 1;
+                    back_len += WideCharToMultiByte( CP_UTF8, 0, expect + ret, n, expect_back + back_len, 4,
+                                                     NULL, NULL );
+                    ret += n - 1;
+                }
+                ret = WideCharToMultiByte( CP_UTF8, 0, expect, expect_len, NULL, 0, NULL, NULL );
+                ok( ret == back_len, "%s %d: got length %d, expected %d\n",
+                    utf8_corpus_names[i], sizes[j], ret, back_len );
+                ret = WideCharToMultiByte( CP_UTF8, 0, expect, expect_len, back, 4096 * 3, NULL, NULL );
+                ok( ret == back_len && !memcmp( back, expect_back, back_len ), "%s %d: wrong conversion %s\n",
+                    utf8_corpus_names[i], sizes[j], debugstr_an( back, ret ));
+            }
+        }
+
+        if (winetest_debug > 1)
+        {
+            len = build_utf8_corpus( 1 << i, src, 4096, expect, &expect_len );
+            QueryPerformanceFrequency( &freq );
+            QueryPerformanceCounter( &start );
+            for (j = 0; j < 10000; j++) MultiByteToWideChar( CP_UTF8, 0, src, len, dst, 4096 );
+            QueryPerformanceCounter( &end );
+            trace( "%-5s MultiByteToWideChar %8.1f MB/s\n", utf8_corpus_names[i],
+                   (double)len * j * freq.QuadPart / (end.QuadPart - start.QuadPart) / 1e6 );
+            QueryPerformanceCounter( &start );
+            for (j = 0; j < 10000; j++) WideCharToMultiByte( CP_UTF8, 0, dst, expect_len, back, 4096 * 3, NULL, NULL );
+            QueryPerformanceCounter( &end );
+            trace( "%-5s WideCharToMultiByte %8.1f MB/s\n", utf8_corpus_names[i],
+                   (double)expect_len * sizeof(WCHAR) * j * freq.QuadPart / (end.QuadPart - start.QuadPart) / 1e6 );
+        }
+    }
+
+    HeapFree( GetProcessHeap(), 0, src );
+    HeapFree( GetProcessHeap(), 0, back );
+    HeapFree( GetProcessHeap(), 0, expect_back );
+    HeapFree( GetProcessHeap(), 0, dst );
+    HeapFree( GetProcessHeap(), 0, expect );
+}
+
 START_TEST(codepage)
 {
     BOOL bUsedDefaultChar;
@@ -1330,4 +1461,5 @@ START_TEST(codepage)
     test_threadcp();
 
     test_dbcs_to_widechar();
+    test_utf8_corpus();
 }
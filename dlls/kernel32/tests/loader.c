@@ -2141,7 +2141,7 @@ static void test_import_resolution(void)
     IMAGE_SECTION_HEADER section;
     int test;
 
-    for (test = 0; test < 3; test++)
+    for (test = 0; test < 4; test++)
     {
 #define DATA_RVA(ptr) (page_size + ((char *)(ptr) - (char *)&data))
         nt = nt_header_template;
@@ -2169,6 +2169,11 @@ static void test_import_resolution(void)
         strcpy( data.function.name, "CreateEventA" );
         data.original_thunks[0].u1.AddressOfData = DATA_RVA( &data.function );
         data.thunks[0].u1.AddressOfData = 0xdeadbeef;
+        if (test == 3)  /* bound against a different kernel32 */
+        {
+            data.descr[0].TimeDateStamp = 0x12345678;
+            data.descr[0].ForwarderChain = ~0u;
+        }
 
         data.tls.StartAddressOfRawData = nt.OptionalHeader.ImageBase + DATA_RVA( data.tls_data );
         data.tls.EndAddressOfRawData = data.tls.StartAddressOfRawData + sizeof(data.tls_data);
@@ -2245,12 +2250,479 @@ static void test_import_resolution(void)
             ok( ptr->tls_index == 9999, "wrong tls index %d\n", ptr->tls_index );
             FreeLibrary( mod );
             break;
+        case 3:  /* stale binding is ignored */
+            mod = LoadLibraryA( dll_name );
+            ok( mod != NULL, "failed to load err %u\n", GetLastError() );
+            if (!mod) break;
+            ptr = (struct imports *)((char *)mod + page_size);
+            expect = GetProcAddress( GetModuleHandleA( data.module ), data.function.name );
+            ok( (void *)ptr->thunks[0].u1.Function == expect, "thunk %p instead of %p for %s.%s\n",
+                (void *)ptr->thunks[0].u1.Function, expect, data.module, data.function.name );
+            FreeLibrary( mod );
+            break;
         }
         DeleteFileA( dll_name );
 #undef DATA_RVA
     }
 }
 
+static void write_bound_test_dll( const char *name, const IMAGE_NT_HEADERS *nt, const void *data, DWORD size )
+{
+    IMAGE_SECTION_HEADER section;
+    DWORD dummy;
+    HANDLE hfile;
+
+    memset( &section, 0, sizeof(section) );
+    memcpy( section.Name, ".data", sizeof(".data") );
+    section.PointerToRawData = nt->OptionalHeader.FileAlignment;
+    section.VirtualAddress = nt->OptionalHeader.SectionAlignment;
+    section.Misc.VirtualSize = size;
+    section.SizeOfRawData = size;
+    section.Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE;
+
+    hfile = CreateFileA( name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, 0, 0 );
+    ok( hfile != INVALID_HANDLE_VALUE, "creation failed\n" );
+    WriteFile( hfile, &dos_header, sizeof(dos_header), &dummy, NULL );
+    WriteFile( hfile, nt, sizeof(*nt), &dummy, NULL );
+    WriteFile( hfile, &section, sizeof(section), &dummy, NULL );
+    SetFilePointer( hfile, section.PointerToRawData, NULL, SEEK_SET );
+    WriteFile( hfile, data, size, &dummy, NULL );
+    CloseHandle( hfile );
+}
+
+static void test_bound_imports(void)
+{
+    char temp_path[MAX_PATH];
+    char exp_name[MAX_PATH];
+    char imp_name[MAX_PATH];
+    struct exports
+    {
+        IMAGE_EXPORT_DIRECTORY dir;
+        DWORD functions[1];
+        DWORD names[1];
+        WORD ordinals[1];
+        char dll_name[16];
+        char func_name[16];
+        BYTE code[4];
+    } exp_data;
+    struct imports
+    {
+        IMAGE_IMPORT_DESCRIPTOR descr[2];
+        IMAGE_THUNK_DATA original_thunks[2];
+        IMAGE_THUNK_DATA thunks[2];
+        char module[MAX_PATH];
+        struct { WORD hint; char name[16]; } function;
+    } imp_data, *ptr;
+    IMAGE_NT_HEADERS nt;
+    HMODULE exp_mod, imp_mod;
+    ULONG_PTR bound, expect;
+    int test;
+
+    GetTempPathA( MAX_PATH, temp_path );
+    GetTempFileNameA( temp_path, "ldr", 0, exp_name );
+    GetTempFileNameA( temp_path, "ldr", 0, imp_name );
+
+    nt = nt_header_template;
+    nt.FileHeader.NumberOfSections = 1;
+    nt.FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER);
+    nt.FileHeader.Characteristics = IMAGE_FILE_EXECUTABLE_IMAGE | IMAGE_FILE_32BIT_MACHINE |
+                                    IMAGE_FILE_RELOCS_STRIPPED | IMAGE_FILE_DLL;
+    nt.FileHeader.TimeDateStamp = 0x12345678;
+    nt.OptionalHeader.SectionAlignment = page_size;
+    nt.OptionalHeader.FileAlignment = 0x200;
+    nt.OptionalHeader.ImageBase = 0x12350000;
+    nt.OptionalHeader.SizeOfImage = 2 * page_size;
+    nt.OptionalHeader.SizeOfHeaders = nt.OptionalHeader.FileAlignment;
+    nt.OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+    memset( nt.OptionalHeader.DataDirectory, 0, sizeof(nt.OptionalHeader.DataDirectory) );
+
+#define DATA_RVA(ptr) (page_size + ((char *)(ptr) - (char *)&exp_data))
+    memset( &exp_data, 0, sizeof(exp_data) );
+    exp_data.dir.TimeDateStamp = nt.FileHeader.TimeDateStamp;
+    exp_data.dir.Name = DATA_RVA( exp_data.dll_name );
+    exp_data.dir.Base = 1;
+    exp_data.dir.NumberOfFunctions = 1;
+    exp_data.dir.NumberOfNames = 1;
+    exp_data.dir.AddressOfFunctions = DATA_RVA( exp_data.functions );
+    exp_data.dir.AddressOfNames = DATA_RVA( exp_data.names );
+    exp_data.dir.AddressOfNameOrdinals = DATA_RVA( exp_data.ordinals );
+    exp_data.functions[0] = DATA_RVA( exp_data.code );
+    exp_data.names[0] = DATA_RVA( exp_data.func_name );
+    strcpy( exp_data.dll_name, "ldrbound.dll" );
+    strcpy( exp_data.func_name, "bound_func" );
+    exp_data.code[0] = 0xc3;  /* ret */
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].Size = sizeof(exp_data);
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].VirtualAddress = DATA_RVA( &exp_data.dir );
+    expect = nt.OptionalHeader.ImageBase + DATA_RVA( exp_data.code );
+    /* an address the loader would never compute, so that a kept table can be told apart */
+    bound = nt.OptionalHeader.ImageBase + DATA_RVA( exp_data.code + 1 );
+#undef DATA_RVA
+    write_bound_test_dll( exp_name, &nt, &exp_data, sizeof(exp_data) );
+
+    exp_mod = LoadLibraryA( exp_name );
+    ok( exp_mod != NULL, "failed to load err %u\n", GetLastError() );
+    if (!exp_mod) goto done;
+    if (exp_mod != (HMODULE)nt.OptionalHeader.ImageBase)
+    {
+        skip( "export dll not loaded at its preferred base\n" );
+        FreeLibrary( exp_mod );
+        goto done;
+    }
+
+    for (test = 0; test < 2; test++)
+    {
+        nt.FileHeader.TimeDateStamp = 0;
+        nt.OptionalHeader.ImageBase = 0x12340000;
+        memset( nt.OptionalHeader.DataDirectory, 0, sizeof(nt.OptionalHeader.DataDirectory) );
+
+#define DATA_RVA(ptr) (page_size + ((char *)(ptr) - (char *)&imp_data))
+        memset( &imp_data, 0, sizeof(imp_data) );
+        U(imp_data.descr[0]).OriginalFirstThunk = DATA_RVA( imp_data.original_thunks );
+        imp_data.descr[0].FirstThunk = DATA_RVA( imp_data.thunks );
+        imp_data.descr[0].Name = DATA_RVA( imp_data.module );
+        /* old style binding, against the timestamp of the loaded dll or a different one */
+        imp_data.descr[0].TimeDateStamp = test ? 0x87654321 : 0x12345678;
+        imp_data.descr[0].ForwarderChain = ~0u;
+        strcpy( imp_data.module, strrchr( exp_name, '\\' ) + 1 );
+        strcpy( imp_data.function.name, "bound_func" );
+        imp_data.original_thunks[0].u1.AddressOfData = DATA_RVA( &imp_data.function );
+        imp_data.thunks[0].u1.Function = bound;
+        nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].Size = sizeof(imp_data.descr);
+        nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress = DATA_RVA( imp_data.descr );
+#undef DATA_RVA
+        write_bound_test_dll( imp_name, &nt, &imp_data, sizeof(imp_data) );
+
+        imp_mod = LoadLibraryA( imp_name );
+        ok( imp_mod != NULL, "%d: failed to load err %u\n", test, GetLastError() );
+        if (!imp_mod) continue;
+        ptr = (struct imports *)((char *)imp_mod + page_size);
+        if (!test)
+            ok( ptr->thunks[0].u1.Function == bound || broken( ptr->thunks[0].u1.Function == expect ),
+                "bound thunk changed to %p\n", (void *)ptr->thunks[0].u1.Function );
+        else
+            ok( ptr->thunks[0].u1.Function == expect, "stale thunk %p, expected %p\n",
+                (void *)ptr->thunks[0].u1.Function, (void *)expect );
+        FreeLibrary( imp_mod );
+    }
+    FreeLibrary( exp_mod );
+
+done:
+    DeleteFileA( imp_name );
+    DeleteFileA( exp_name );
+}
+
+static void test_many_imports(void)
+{
+    static const struct
+    {
+        const char *dll;
+        const char *func;
+    } imports[] =
+    {
+        { "advapi32.dll", "RegCloseKey" },
+        { "user32.dll", "GetDesktopWindow" },
+        { "gdi32.dll", "GetStockObject" },
+        { "shell32.dll", "SHGetFolderPathA" },
+        { "ole32.dll", "CoInitialize" },
+        { "oleaut32.dll", "SysFreeString" },
+        { "comctl32.dll", "InitCommonControls" },
+        { "comdlg32.dll", "GetOpenFileNameA" },
+        { "shlwapi.dll", "PathFileExistsA" },
+        { "version.dll", "GetFileVersionInfoSizeA" },
+        { "winmm.dll", "timeGetTime" },
+        { "ws2_32.dll", "WSAGetLastError" },
+        { "rpcrt4.dll", "UuidCreate" },
+        { "setupapi.dll", "SetupCloseInfFile" },
+        { "crypt32.dll", "CertCloseStore" },
+        { "imm32.dll", "ImmGetContext" },
+        { "msvcrt.dll", "strlen" },
+        { "psapi.dll", "GetModuleBaseNameA" },
+        { "wininet.dll", "InternetCloseHandle" },
+        { "winspool.drv", "ClosePrinter" },
+    };
+    struct
+    {
+        IMAGE_IMPORT_DESCRIPTOR descr[ARRAY_SIZE(imports) + 1];
+        IMAGE_THUNK_DATA original_thunks[ARRAY_SIZE(imports)][2];
+        IMAGE_THUNK_DATA thunks[ARRAY_SIZE(imports)][2];
+        char module[ARRAY_SIZE(imports)][16];
+        struct { WORD hint; char name[32]; } function[ARRAY_SIZE(imports)];
+        BYTE code[8];
+    } data;
+    static const BYTE code[] = { 0xb8, 0x2a, 0x00, 0x00, 0x00, 0xc3 };  /* mov $42,%eax; ret */
+    char temp_path[MAX_PATH];
+    char exe_name[MAX_PATH];
+    IMAGE_NT_HEADERS nt;
+    IMAGE_SECTION_HEADER section;
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = { sizeof(si) };
+    DWORD dummy, ret;
+    HANDLE hfile;
+    int i;
+
+#if !defined(__i386__) && !defined(__x86_64__)
+    skip( "no entry point code for this architecture\n" );
+    return;
+#endif
+
+#define DATA_RVA(ptr) (page_size + ((char *)(ptr) - (char *)&data))
+    nt = nt_header_template;
+    nt.FileHeader.NumberOfSections = 1;
+    nt.FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER);
+    nt.FileHeader.Characteristics = IMAGE_FILE_EXECUTABLE_IMAGE | IMAGE_FILE_32BIT_MACHINE | IMAGE_FILE_RELOCS_STRIPPED;
+    nt.OptionalHeader.SectionAlignment = page_size;
+    nt.OptionalHeader.FileAlignment = 0x200;
+    nt.OptionalHeader.ImageBase = 0x12340000;
+    nt.OptionalHeader.SizeOfImage = 2 * page_size;
+    nt.OptionalHeader.SizeOfHeaders = nt.OptionalHeader.FileAlignment;
+    nt.OptionalHeader.AddressOfEntryPoint = DATA_RVA( data.code );
+    nt.OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+    memset( nt.OptionalHeader.DataDirectory, 0, sizeof(nt.OptionalHeader.DataDirectory) );
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].Size = sizeof(data.descr);
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress = DATA_RVA( data.descr );
+
+    memset( &data, 0, sizeof(data) );
+    for (i = 0; i < ARRAY_SIZE(imports); i++)
+    {
+        U(data.descr[i]).OriginalFirstThunk = DATA_RVA( data.original_thunks[i] );
+        data.descr[i].FirstThunk = DATA_RVA( data.thunks[i] );
+        data.descr[i].Name = DATA_RVA( data.module[i] );
+        strcpy( data.module[i], imports[i].dll );
+        strcpy( data.function[i].name, imports[i].func );
+        data.original_thunks[i][0].u1.AddressOfData = DATA_RVA( &data.function[i] );
+        data.thunks[i][0].u1.AddressOfData = DATA_RVA( &data.function[i] );
+    }
+    memcpy( data.code, code, sizeof(code) );
+#undef DATA_RVA
+
+    GetTempPathA( MAX_PATH, temp_path );
+    GetTempFileNameA( temp_path, "ldr", 0, exe_name );
+
+    hfile = CreateFileA( exe_name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, 0, 0 );
+    ok( hfile != INVALID_HANDLE_VALUE, "creation failed\n" );
+
+    memset( &section, 0, sizeof(section) );
+    memcpy( section.Name, ".text", sizeof(".text") );
+    section.PointerToRawData = nt.OptionalHeader.FileAlignment;
+    section.VirtualAddress = nt.OptionalHeader.SectionAlignment;
+    section.Misc.VirtualSize = sizeof(data);
+    section.SizeOfRawData = sizeof(data);
+    section.Characteristics = IMAGE_SCN_CNT_CODE | IMAGE_SCN_MEM_EXECUTE | IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE;
+
+    WriteFile( hfile, &dos_header, sizeof(dos_header), &dummy, NULL );
+    WriteFile( hfile, &nt, sizeof(nt), &dummy, NULL );
+    WriteFile( hfile, &section, sizeof(section), &dummy, NULL );
+    SetFilePointer( hfile, section.PointerToRawData, NULL, SEEK_SET );
+    WriteFile( hfile, &data, sizeof(data), &dummy, NULL );
+    CloseHandle( hfile );
+
+    /* the dependencies of a new process are opened on several threads at once */
+    for (i = 0; i < 3; i++)
+    {
+        ret = CreateProcessA( exe_name, NULL, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
+        ok( ret, "CreateProcess failed err %u\n", GetLastError() );
+        if (!ret) break;
+        ret = WaitForSingleObject( pi.hProcess, 10000 );
+        ok( ret == WAIT_OBJECT_0, "wait failed %u\n", ret );
+        if (ret != WAIT_OBJECT_0) TerminateProcess( pi.hProcess, 1 );
+        ret = 0xdeadbeef;
+        GetExitCodeProcess( pi.hProcess, &ret );
+        ok( ret == 42, "%d: got exit code %#x\n", i, ret );
+        CloseHandle( pi.hThread );
+        CloseHandle( pi.hProcess );
+    }
+    DeleteFileA( exe_name );
+}
+
+static void test_image_relocation(void)
+{
+    char temp_path[MAX_PATH];
+    char dll_name[MAX_PATH];
+    DWORD dummy;
+    HANDLE hfile;
+    HMODULE mod;
+    void *reserved;
+    struct relocs
+    {
+        IMAGE_BASE_RELOCATION block;
+        USHORT entries[2];
+        ULONG_PTR ptr;
+        char str[16];
+    } data, *ptr;
+    IMAGE_NT_HEADERS nt, *pnt;
+    IMAGE_SECTION_HEADER section;
+    int i;
+
+#define DATA_RVA(ptr) (page_size + ((char *)(ptr) - (char *)&data))
+    nt = nt_header_template;
+    nt.FileHeader.NumberOfSections = 1;
+    nt.FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER);
+    nt.OptionalHeader.SizeOfCode = sizeof(data);
+    nt.OptionalHeader.SectionAlignment = page_size;
+    nt.OptionalHeader.FileAlignment = 0x200;
+    nt.OptionalHeader.ImageBase = 0x12340000;
+    nt.OptionalHeader.SizeOfImage = 2 * page_size;
+    nt.OptionalHeader.SizeOfHeaders = nt.OptionalHeader.FileAlignment;
+    nt.OptionalHeader.DllCharacteristics = IMAGE_DLLCHARACTERISTICS_DYNAMIC_BASE;
+    nt.OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+    memset( nt.OptionalHeader.DataDirectory, 0, sizeof(nt.OptionalHeader.DataDirectory) );
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC].Size = sizeof(data.block) + sizeof(data.entries);
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC].VirtualAddress = DATA_RVA( &data.block );
+
+    memset( &data, 0, sizeof(data) );
+    data.block.VirtualAddress = page_size;
+    data.block.SizeOfBlock = sizeof(data.block) + sizeof(data.entries);
+#ifdef _WIN64
+    data.entries[0] = (IMAGE_REL_BASED_DIR64 << 12) | (DATA_RVA( &data.ptr ) & 0xfff);
+#else
+    data.entries[0] = (IMAGE_REL_BASED_HIGHLOW << 12) | (DATA_RVA( &data.ptr ) & 0xfff);
+#endif
+    data.entries[1] = IMAGE_REL_BASED_ABSOLUTE << 12;
+    data.ptr = nt.OptionalHeader.ImageBase + DATA_RVA( data.str );
+    strcpy( data.str, "relocated" );
+
+    GetTempPathA(MAX_PATH, temp_path);
+    GetTempFileNameA(temp_path, "ldr", 0, dll_name);
+
+    hfile = CreateFileA(dll_name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, 0, 0);
+    ok( hfile != INVALID_HANDLE_VALUE, "creation failed\n" );
+
+    memset( &section, 0, sizeof(section) );
+    memcpy( section.Name, ".data", sizeof(".data") );
+    section.PointerToRawData = nt.OptionalHeader.FileAlignment;
+    section.VirtualAddress = nt.OptionalHeader.SectionAlignment;
+    section.Misc.VirtualSize = sizeof(data);
+    section.SizeOfRawData = sizeof(data);
+    section.Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE;
+
+    WriteFile(hfile, &dos_header, sizeof(dos_header), &dummy, NULL);
+    WriteFile(hfile, &nt, sizeof(nt), &dummy, NULL);
+    WriteFile(hfile, &section, sizeof(section), &dummy, NULL);
+
+    SetFilePointer( hfile, section.PointerToRawData, NULL, SEEK_SET );
+    WriteFile(hfile, &data, sizeof(data), &dummy, NULL);
+
+    CloseHandle( hfile );
+
+    /* make sure the dll can't be loaded at its preferred base */
+    reserved = VirtualAlloc( (void *)nt.OptionalHeader.ImageBase, nt.OptionalHeader.SizeOfImage,
+                             MEM_RESERVE, PAGE_NOACCESS );
+    ok( reserved != NULL, "failed to reserve %p err %u\n", (void *)nt.OptionalHeader.ImageBase, GetLastError() );
+
+    /* load it twice, the second time the relocated pages may be shared with the first load */
+    for (i = 0; i < 2; i++)
+    {
+        mod = LoadLibraryA( dll_name );
+        ok( mod != NULL, "failed to load err %u\n", GetLastError() );
+        if (!mod) break;
+        ok( mod != reserved, "loaded at reserved address %p\n", mod );
+
+        ptr = (struct relocs *)((char *)mod + page_size);
+        ok( ptr->ptr == (ULONG_PTR)ptr->str, "wrong relocated pointer %p / %p\n", (void *)ptr->ptr, ptr->str );
+        ok( !strcmp( ptr->str, "relocated" ), "wrong data %s\n", debugstr_a(ptr->str) );
+
+        pnt = pRtlImageNtHeader( mod );
+        ok( pnt->OptionalHeader.ImageBase == (ULONG_PTR)mod, "wrong image base %p / %p\n",
+            (void *)pnt->OptionalHeader.ImageBase, mod );
+        FreeLibrary( mod );
+    }
+
+    if (reserved) VirtualFree( reserved, 0, MEM_RELEASE );
+    DeleteFileA( dll_name );
+#undef DATA_RVA
+}
+
+static void test_module_lookup(void)
+{
+    char temp_path[MAX_PATH];
+    char dll_name[MAX_PATH];
+    char names[64][MAX_PATH];
+    HMODULE mods[64], mod;
+    const char *base_name;
+    DWORD dummy;
+    HANDLE hfile;
+    IMAGE_NT_HEADERS nt;
+    IMAGE_SECTION_HEADER section;
+    BOOL ret;
+    int i;
+
+    nt = nt_header_template;
+    nt.FileHeader.NumberOfSections = 1;
+    nt.FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER);
+    nt.OptionalHeader.SectionAlignment = page_size;
+    nt.OptionalHeader.FileAlignment = 0x200;
+    nt.OptionalHeader.ImageBase = 0x12340000;
+    nt.OptionalHeader.SizeOfImage = 2 * page_size;
+    nt.OptionalHeader.SizeOfHeaders = nt.OptionalHeader.FileAlignment;
+    nt.OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+    memset( nt.OptionalHeader.DataDirectory, 0, sizeof(nt.OptionalHeader.DataDirectory) );
+
+    memset( &section, 0, sizeof(section) );
+    memcpy( section.Name, ".rdata", sizeof(".rdata") );
+    section.PointerToRawData = nt.OptionalHeader.FileAlignment;
+    section.VirtualAddress = nt.OptionalHeader.SectionAlignment;
+    section.Misc.VirtualSize = sizeof(section_data);
+    section.SizeOfRawData = sizeof(section_data);
+    section.Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ;
+
+    GetTempPathA(MAX_PATH, temp_path);
+    GetTempFileNameA(temp_path, "ldr", 0, dll_name);
+
+    hfile = CreateFileA(dll_name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, 0, 0);
+    ok( hfile != INVALID_HANDLE_VALUE, "creation failed\n" );
+    WriteFile(hfile, &dos_header, sizeof(dos_header), &dummy, NULL);
+    WriteFile(hfile, &nt, sizeof(nt), &dummy, NULL);
+    WriteFile(hfile, &section, sizeof(section), &dummy, NULL);
+    SetFilePointer( hfile, section.PointerToRawData, NULL, SEEK_SET );
+    WriteFile(hfile, section_data, sizeof(section_data), &dummy, NULL);
+    CloseHandle( hfile );
+
+    for (i = 0; i < ARRAY_SIZE(mods); i++)
+    {
+        sprintf( names[i], "%sldrlookup%02d.dll", temp_path, i );
+        ret = CopyFileA( dll_name, names[i], FALSE );
+        ok( ret, "CopyFile failed err %u\n", GetLastError() );
+        mods[i] = LoadLibraryA( names[i] );
+        ok( mods[i] != NULL, "failed to load %s err %u\n", names[i], GetLastError() );
+    }
+
+    /* lookups by full name, base name and address must all agree */
+    for (i = 0; i < ARRAY_SIZE(mods); i++)
+    {
+        if (!mods[i]) continue;
+        base_name = strrchr( names[i], '\\' ) + 1;
+        mod = GetModuleHandleA( names[i] );
+        ok( mod == mods[i], "%d: got %p for full name, expected %p\n", i, mod, mods[i] );
+        mod = GetModuleHandleA( base_name );
+        ok( mod == mods[i], "%d: got %p for base name, expected %p\n", i, mod, mods[i] );
+        mod = NULL;
+        ret = GetModuleHandleExA( GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                                  (const char *)mods[i] + page_size + 1, &mod );
+        ok( ret, "%d: GetModuleHandleEx failed err %u\n", i, GetLastError() );
+        ok( mod == mods[i], "%d: got %p for address, expected %p\n", i, mod, mods[i] );
+    }
+
+    /* unload every other module, the others must still be found */
+    for (i = 0; i < ARRAY_SIZE(mods); i += 2) if (mods[i]) FreeLibrary( mods[i] );
+    for (i = 0; i < ARRAY_SIZE(mods); i++)
+    {
+        base_name = strrchr( names[i], '\\' ) + 1;
+        mod = GetModuleHandleA( base_name );
+        if (i % 2) ok( mod == mods[i], "%d: got %p for base name, expected %p\n", i, mod, mods[i] );
+        else ok( !mod, "%d: unloaded module still found at %p\n", i, mod );
+        mod = GetModuleHandleA( names[i] );
+        if (i % 2) ok( mod == mods[i], "%d: got %p for full name, expected %p\n", i, mod, mods[i] );
+        else ok( !mod, "%d: unloaded module still found at %p\n", i, mod );
+    }
+
+    for (i = 0; i < ARRAY_SIZE(mods); i++)
+    {
+        if (i % 2 && mods[i]) FreeLibrary( mods[i] );
+        DeleteFileA( names[i] );
+    }
+    DeleteFileA( dll_name );
+}
+
 #define MAX_COUNT 10
 static HANDLE attached_thread[MAX_COUNT];
 static DWORD attached_thread_count;
@@ -4124,6 +4596,10 @@ START_TEST(loader)
     test_ImportDescriptors();
     test_section_access();
     test_import_resolution();
+    test_bound_imports();
+    test_many_imports();
+    test_image_relocation();
+    test_module_lookup();
     test_ExitProcess();
     test_InMemoryOrderModuleList();
     test_LoadPackagedLibrary();
@@ -2989,6 +2989,150 @@ static void test_sorting(void)
     }
 }
 
+static WCHAR (*sort_strings)[16];
+
+static void make_sort_string(WCHAR *str, BOOL ascii_only)
+{
+    static const WCHAR chars[] = L"aabbceeAABBCE019 -'.\x00e9\x00c9\x00df\x0301\x03b1";
+    int i, len = rand() % 15;
+
+    for (i = 0; i < len; i++)
+    {
+        if (ascii_only || rand() % 4) str[i] = "abcdeABCDE0189"[rand() % 14];
+        else str[i] = chars[rand() % (ARRAY_SIZE(chars) - 1)];
+    }
+    str[len] = 0;
+}
+
+static int compare_sort_string(const void *e1, const void *e2)
+{
+    return CompareStringW(LOCALE_USER_DEFAULT, 0, sort_strings[*(const int *)e1], -1,
+                          sort_strings[*(const int *)e2], -1) - CSTR_EQUAL;
+}
+
+static void test_CompareString_consistency(void)
+{
+    static const DWORD flags[] = { 0, NORM_IGNORECASE, NORM_IGNORENONSPACE, NORM_IGNORESYMBOLS, SORT_STRINGSORT };
+    static const struct
+    {
+        DWORD flags;
+        const WCHAR *str1;
+        const WCHAR *str2;
+        int ret;
+    }
+    simple_tests[] =
+    {
+        /* a primary difference decides over an earlier case or diacritic difference */
+        { 0, L"ab", L"Ab", CSTR_LESS_THAN },
+        { 0, L"Ab", L"ac", CSTR_LESS_THAN },
+        { 0, L"aC", L"Ab", CSTR_GREATER_THAN },
+        { 0, L"\x00e0" L"a", L"ab", CSTR_LESS_THAN },
+        { 0, L"\x00e0" L"c", L"ab", CSTR_GREATER_THAN },
+        { 0, L"\x00c0" L"a", L"ab", CSTR_LESS_THAN },
+        /* then the length */
+        { 0, L"\x00e0", L"ab", CSTR_LESS_THAN },
+        { 0, L"A", L"ab", CSTR_LESS_THAN },
+        { 0, L"\x00e1" L"b", L"abc", CSTR_LESS_THAN },
+        /* then the first diacritic difference, then the first case difference */
+        { 0, L"a", L"\x00e1", CSTR_LESS_THAN },
+        { 0, L"\x00e0" L"b", L"ab", CSTR_GREATER_THAN },
+        { 0, L"\x00e1", L"A", CSTR_GREATER_THAN },
+        { 0, L"A\x00e1", L"\x00e1" L"a", CSTR_LESS_THAN },
+        { 0, L"aB", L"Ab", CSTR_LESS_THAN },
+        { 0, L"ab", L"ab", CSTR_EQUAL },
+        { NORM_IGNORECASE, L"ab", L"AB", CSTR_EQUAL },
+        { NORM_IGNORECASE, L"ab", L"AC", CSTR_LESS_THAN },
+        { NORM_IGNORECASE, L"A", L"ab", CSTR_LESS_THAN },
+        { NORM_IGNORECASE, L"\x00e0", L"A", CSTR_GREATER_THAN },
+        { NORM_IGNORENONSPACE, L"\x00e0" L"b", L"ab", CSTR_EQUAL },
+        { NORM_IGNORENONSPACE, L"\x00e0" L"B", L"ab", CSTR_GREATER_THAN },
+        { NORM_IGNORENONSPACE, L"\x00e1", L"ab", CSTR_LESS_THAN },
+        { NORM_IGNORECASE | NORM_IGNORENONSPACE, L"\x00c0" L"B", L"ab", CSTR_EQUAL },
+        { NORM_IGNORECASE | NORM_IGNORENONSPACE, L"\x00c0" L"c", L"ab", CSTR_GREATER_THAN },
+    };
+    LCID lcid = MAKELCID(MAKELANGID(LANG_ENGLISH, SUBLANG_ENGLISH_US), SORT_DEFAULT);
+    int i, j, ret, ret2, count = winetest_debug > 1 ? 1000000 : 4000, *order;
+    WCHAR str1[32], str2[32];
+    char key1[128], key2[128];
+    DWORD start;
+
+    for (i = 0; i < ARRAY_SIZE(simple_tests); i++)
+    {
+        ret = CompareStringW(lcid, simple_tests[i].flags, simple_tests[i].str1, -1, simple_tests[i].str2, -1);
+        ok(ret == simple_tests[i].ret, "%s %s flags %#x: got %d, expected %d\n",
+           wine_dbgstr_w(simple_tests[i].str1), wine_dbgstr_w(simple_tests[i].str2),
+           simple_tests[i].flags, ret, simple_tests[i].ret);
+        ret = CompareStringW(lcid, simple_tests[i].flags, simple_tests[i].str2, -1, simple_tests[i].str1, -1);
+        ok(ret == 2 * CSTR_EQUAL - simple_tests[i].ret, "%s %s flags %#x: got %d, expected %d\n",
+           wine_dbgstr_w(simple_tests[i].str2), wine_dbgstr_w(simple_tests[i].str1),
+           simple_tests[i].flags, ret, 2 * CSTR_EQUAL - simple_tests[i].ret);
+    }
+
+    srand(0x1234);
+    for (i = 0; i < 4000; i++)
+    {
+        make_sort_string(str1 + 3, i & 1);
+        make_sort_string(str2 + 3, i & 1);
+        str1[0] = str2[0] = 'x';
+        str1[1] = str2[1] = 'Y';
+        str1[2] = str2[2] = '4';
+
+        for (j = 0; j < ARRAY_SIZE(flags); j++)
+        {
+            ret = CompareStringW(LOCALE_USER_DEFAULT, flags[j], str1 + 3, -1, str2 + 3, -1);
+            ok(ret, "%s %s: CompareStringW failed\n", wine_dbgstr_w(str1 + 3), wine_dbgstr_w(str2 + 3));
+            ret2 = CompareStringW(LOCALE_USER_DEFAULT, flags[j], str2 + 3, -1, str1 + 3, -1);
+            ok(ret + ret2 == 2 * CSTR_EQUAL, "%s %s flags %#x: got %d and %d\n",
+               wine_dbgstr_w(str1 + 3), wine_dbgstr_w(str2 + 3), flags[j], ret, ret2);
+            /* an identical prefix doesn't change the result */
+            ret2 = CompareStringW(LOCALE_USER_DEFAULT, flags[j], str1, -1, str2, -1);
+            ok(ret == ret2, "%s %s flags %#x: got %d and %d\n",
+               wine_dbgstr_w(str1), wine_dbgstr_w(str2), flags[j], ret, ret2);
+
+            if (!(i & 1) || (flags[j] & ~NORM_IGNORECASE)) continue;
+            LCMapStringW(LOCALE_USER_DEFAULT, LCMAP_SORTKEY | flags[j], str1, -1, (WCHAR *)key1, sizeof(key1));
+            LCMapStringW(LOCALE_USER_DEFAULT, LCMAP_SORTKEY | flags[j], str2, -1, (WCHAR *)key2, sizeof(key2));
+            ret2 = strcmp(key1, key2);
+            ret2 = ret2 < 0 ? CSTR_LESS_THAN : ret2 > 0 ? CSTR_GREATER_THAN : CSTR_EQUAL;
+            ok(ret == ret2, "%s %s flags %#x: got %d, sort keys %d\n",
+               wine_dbgstr_w(str1), wine_dbgstr_w(str2), flags[j], ret, ret2);
+        }
+    }
+
+    sort_strings = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*sort_strings));
+    order = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*order));
+    for (i = 0; i < count; i++)
+    {
+        make_sort_string(sort_strings[i], !(i % 8));
+        order[i] = i;
+    }
+
+    start = GetTickCount();
+    qsort(order, count, sizeof(*order), compare_sort_string);
+    if (winetest_debug > 1) trace("sorted %d strings in %u ms\n", count, GetTickCount() - start);
+
+    for (i = 1; i < count; i++)
+    {
+        ret = compare_sort_string(&order[i - 1], &order[i]);
+        if (ret > 0)
+        {
+            ok(0, "%s > %s\n", wine_dbgstr_w(sort_strings[order[i - 1]]), wine_dbgstr_w(sort_strings[order[i]]));
+            break;
+        }
+    }
+
+    if (winetest_debug > 1)
+    {
+        start = GetTickCount();
+        for (i = 0; i < count; i++)
+            LCMapStringW(LOCALE_USER_DEFAULT, LCMAP_SORTKEY, sort_strings[i], -1, (WCHAR *)key1, sizeof(key1));
+        trace("computed %d sort keys in %u ms\n", count, GetTickCount() - start);
+    }
+
+    HeapFree(GetProcessHeap(), 0, order);
+    HeapFree(GetProcessHeap(), 0, sort_strings);
+}
+
 static void test_FoldStringA(void)
 {
   int ret, i, j;
@@ -7163,6 +7307,7 @@ START_TEST(locale)
   test_CompareStringA();
   test_CompareStringW();
   test_CompareStringEx();
+  test_CompareString_consistency();
   test_LCMapStringA();
   test_LCMapStringW();
   test_LCMapStringEx();
@@ -79,6 +79,9 @@ static BOOL   (WINAPI *pQueryInformationJobObject)(HANDLE job, JOBOBJECTINFOCLAS
 static BOOL   (WINAPI *pSetInformationJobObject)(HANDLE job, JOBOBJECTINFOCLASS class, LPVOID info, DWORD len);
 static HANDLE (WINAPI *pCreateIoCompletionPort)(HANDLE file, HANDLE existing_port, ULONG_PTR key, DWORD threads);
 static BOOL   (WINAPI *pGetNumaProcessorNode)(UCHAR, PUCHAR);
+static BOOL   (WINAPI *pGetNumaHighestNodeNumber)(ULONG *);
+static BOOL   (WINAPI *pGetNumaNodeProcessorMaskEx)(USHORT, GROUP_AFFINITY *);
+static void * (WINAPI *pVirtualAllocExNuma)(HANDLE, void *, SIZE_T, DWORD, DWORD, DWORD);
 static NTSTATUS (WINAPI *pNtQueryInformationProcess)(HANDLE, PROCESSINFOCLASS, PVOID, ULONG, PULONG);
 static NTSTATUS (WINAPI *pNtQueryInformationThread)(HANDLE, THREADINFOCLASS, PVOID, ULONG, PULONG);
 static NTSTATUS (WINAPI *pNtQuerySystemInformationEx)(SYSTEM_INFORMATION_CLASS, void*, ULONG, void*, ULONG, ULONG*);
@@ -268,6 +271,9 @@ static BOOL init(void)
     pSetInformationJobObject = (void *)GetProcAddress(hkernel32, "SetInformationJobObject");
     pCreateIoCompletionPort = (void *)GetProcAddress(hkernel32, "CreateIoCompletionPort");
     pGetNumaProcessorNode = (void *)GetProcAddress(hkernel32, "GetNumaProcessorNode");
+    pGetNumaHighestNodeNumber = (void *)GetProcAddress(hkernel32, "GetNumaHighestNodeNumber");
+    pGetNumaNodeProcessorMaskEx = (void *)GetProcAddress(hkernel32, "GetNumaNodeProcessorMaskEx");
+    pVirtualAllocExNuma = (void *)GetProcAddress(hkernel32, "VirtualAllocExNuma");
     pWTSGetActiveConsoleSessionId = (void *)GetProcAddress(hkernel32, "WTSGetActiveConsoleSessionId");
     pCreateToolhelp32Snapshot = (void *)GetProcAddress(hkernel32, "CreateToolhelp32Snapshot");
     pProcess32First = (void *)GetProcAddress(hkernel32, "Process32First");
@@ -3677,6 +3683,69 @@ static void test_GetNumaProcessorNode(void)
     }
 }
 
+static void test_numa_nodes(void)
+{
+    ULONG highest, node;
+    ULONGLONG all_mask = 0;
+    GROUP_AFFINITY affinity;
+    DWORD_PTR process_mask, system_mask;
+    UCHAR cpu_node;
+    char *ptr;
+    BOOL ret;
+    int i;
+
+    if (!pGetNumaHighestNodeNumber || !pGetNumaNodeProcessorMaskEx || !pVirtualAllocExNuma)
+    {
+        win_skip("NUMA functions are missing\n");
+        return;
+    }
+
+    ret = pGetNumaHighestNodeNumber(&highest);
+    ok(ret, "GetNumaHighestNodeNumber failed, error %u\n", GetLastError());
+    if (winetest_debug > 1) trace("highest NUMA node %u\n", highest);
+
+    for (node = 0; node <= highest; node++)
+    {
+        memset(&affinity, 0xcc, sizeof(affinity));
+        ret = pGetNumaNodeProcessorMaskEx(node, &affinity);
+        if (!ret) continue;
+        ok(!affinity.Group, "node %u: got group %u\n", node, affinity.Group);
+        ok(!(all_mask & affinity.Mask), "node %u: mask %s overlaps other nodes\n", node,
+           wine_dbgstr_longlong(affinity.Mask));
+        all_mask |= affinity.Mask;
+
+        for (i = 0; i < sizeof(affinity.Mask) * 8; i++)
+        {
+            if (!(affinity.Mask & ((KAFFINITY)1 << i))) continue;
+            ret = pGetNumaProcessorNode(i, &cpu_node);
+            ok(ret, "GetNumaProcessorNode(%u) failed\n", i);
+            ok(cpu_node == node, "processor %u: got node %u, expected %u\n", i, cpu_node, node);
+        }
+    }
+
+    ret = GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+    ok(ret, "GetProcessAffinityMask failed, error %u\n", GetLastError());
+    ok((all_mask & system_mask) == system_mask, "nodes mask %s doesn't cover system mask %s\n",
+       wine_dbgstr_longlong(all_mask), wine_dbgstr_longlong(system_mask));
+
+    SetLastError(0xdeadbeef);
+    ret = pGetNumaNodeProcessorMaskEx(highest + 1, &affinity);
+    ok(!ret, "GetNumaNodeProcessorMaskEx succeeded for node %u\n", highest + 1);
+    ok(GetLastError() == ERROR_INVALID_PARAMETER, "got error %u\n", GetLastError());
+
+    ptr = pVirtualAllocExNuma(GetCurrentProcess(), NULL, 0x10000, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, highest);
+    ok(ptr != NULL, "VirtualAllocExNuma failed, error %u\n", GetLastError());
+    memset(ptr, 0xcc, 0x10000);
+    ok(ptr[0xffff] == (char)0xcc, "got %#x\n", ptr[0xffff]);
+    ret = VirtualFree(ptr, 0, MEM_RELEASE);
+    ok(ret, "VirtualFree failed, error %u\n", GetLastError());
+
+    ptr = pVirtualAllocExNuma(GetCurrentProcess(), NULL, 0x10000, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE,
+                              NUMA_NO_PREFERRED_NODE);
+    ok(ptr != NULL, "VirtualAllocExNuma failed, error %u\n", GetLastError());
+    VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
 static void test_session_info(void)
 {
     DWORD session_id, active_session;
@@ -4328,6 +4397,25 @@ static void test_handle_list_attribute(BOOL child, HANDLE handle1, HANDLE handle
     CloseHandle(pipe[1]);
 }
 
+static void test_process_spawn_time(void)
+{
+    LARGE_INTEGER freq, start, end;
+    PROCESS_INFORMATION pi;
+    int i;
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < 10; i++)
+    {
+        create_process("exit", &pi);
+        wait_and_close_child_process(&pi);
+    }
+    QueryPerformanceCounter(&end);
+    if (winetest_debug > 1)
+        trace("average process spawn time %u us\n",
+              (unsigned int)((end.QuadPart - start.QuadPart) * 1000000 / freq.QuadPart / 10));
+}
+
 static void test_dead_process(void)
 {
     DWORD_PTR data[256];
@@ -5078,6 +5166,7 @@ START_TEST(process)
     test_DetachConsoleHandles();
     test_DetachStdHandles();
     test_GetNumaProcessorNode();
+    test_numa_nodes();
     test_session_info();
     test_GetLogicalProcessorInformationEx();
     test_GetSystemCpuSetInformation();
@@ -5088,6 +5177,7 @@ START_TEST(process)
     test_parent_process_attribute(0, NULL);
     test_handle_list_attribute(FALSE, NULL, NULL);
     test_dead_process();
+    test_process_spawn_time();
 
     /* things that can be tested:
      *  lookup:         check the way program to be executed is searched
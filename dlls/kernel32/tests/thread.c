@@ -927,6 +927,7 @@ static VOID test_thread_processor(void)
 
             error=pSetThreadIdealProcessor(curthread,MAXIMUM_PROCESSORS);
             ok(error!=-1, "SetThreadIdealProcessor failed\n");
+            ok(error==0, "expected previous ideal processor 0, got %d\n", error);
         }
         else
             win_skip("SetThreadIdealProcessor is not implemented\n");
@@ -610,6 +610,17 @@ static struct
     struct sortguid *guids;      /* table of sort GUIDs */
 } sort;
 
+#define COLL_SIMPLE 0x01  /* nonzero weights at all levels, no decomposition and no special rules */
+#define COLL_SYMBOL 0x02  /* ignored with NORM_IGNORESYMBOLS */
+
+static struct
+{
+    unsigned int ce;     /* collation element, see get_weight() */
+    BYTE         flags;  /* COLL_* flags */
+} latin1_collation[0x100];
+
+static void init_latin1_collation(void);
+
 static CRITICAL_SECTION locale_section;
 static CRITICAL_SECTION_DEBUG critsect_debug =
 {
@@ -761,6 +772,7 @@ void init_locale(void)
     NtGetNlsSectionPtr( 9, 0, NULL, &sort_ptr, &size );
     NtGetNlsSectionPtr( 12, NormalizationC, NULL, (void **)&norm_info, &size );
     init_sortkeys( sort_ptr );
+    init_latin1_collation();
 
     if (!ansi_cp || NtGetNlsSectionPtr( 11, ansi_cp, NULL, (void **)&ansi_ptr, &size ))
         NtGetNlsSectionPtr( 11, 1252, NULL, (void **)&ansi_ptr, &size );
@@ -2165,6 +2177,40 @@ static int wcstombs_codepage( UINT codepage, DWORD flags, const WCHAR *src, int
 }
 
 
+static inline unsigned int get_collation_element( WCHAR ch )
+{
+    if (ch < ARRAY_SIZE(latin1_collation)) return latin1_collation[ch].ce;
+    return collation_table[collation_table[collation_table[ch >> 8] + ((ch >> 4) & 0x0f)] + (ch & 0xf)];
+}
+
+
+static inline BOOL is_ignored_symbol( WCHAR ch )
+{
+    if (ch < ARRAY_SIZE(latin1_collation)) return latin1_collation[ch].flags & COLL_SYMBOL;
+    return get_char_type( CT_CTYPE1, ch ) & (C1_PUNCT | C1_SPACE);
+}
+
+
+/* cache the collation data of the Latin-1 range, which covers most of the strings being compared */
+static void init_latin1_collation(void)
+{
+    unsigned int ch, ce, len;
+
+    for (ch = 0; ch < ARRAY_SIZE(latin1_collation); ch++)
+    {
+        ce = collation_table[collation_table[collation_table[ch >> 8] + ((ch >> 4) & 0x0f)] + (ch & 0xf)];
+        latin1_collation[ch].ce = ce;
+        latin1_collation[ch].flags = 0;
+        if (get_char_type( CT_CTYPE1, ch ) & (C1_PUNCT | C1_SPACE)) latin1_collation[ch].flags |= COLL_SYMBOL;
+
+        if (ce == ~0u || !(ce >> 16) || !((ce >> 8) & 0xff) || !((ce >> 4) & 0x0f)) continue;
+        if (ch == '-' || ch == '\'') continue;  /* see compare_weights() */
+        if (get_decomposition( ch, &len )) continue;
+        latin1_collation[ch].flags |= COLL_SIMPLE;
+    }
+}
+
+
 static int get_sortkey( DWORD flags, const WCHAR *src, int srclen, char *dst, int dstlen )
 {
     WCHAR dummy[4]; /* no decomposition is larger than 4 chars */
@@ -2185,13 +2231,11 @@ static int get_sortkey( DWORD flags, const WCHAR *src, int srclen, char *dst, in
                 WCHAR wch = dummy[i];
                 unsigned int ce;
 
-                if ((flags & NORM_IGNORESYMBOLS) &&
-                    (get_char_type( CT_CTYPE1, wch ) & (C1_PUNCT | C1_SPACE)))
-                    continue;
+                if ((flags & NORM_IGNORESYMBOLS) && is_ignored_symbol( wch )) continue;
 
                 if (flags & NORM_IGNORECASE) wch = casemap( nls_info.LowerCaseTable, wch );
 
-                ce = collation_table[collation_table[collation_table[wch >> 8] + ((wch >> 4) & 0x0f)] + (wch & 0xf)];
+                ce = get_collation_element( wch );
                 if (ce != (unsigned int)-1)
                 {
                     if (ce >> 16) key_len[0] += 2;
@@ -2239,13 +2283,11 @@ static int get_sortkey( DWORD flags, const WCHAR *src, int srclen, char *dst, in
                 WCHAR wch = dummy[i];
                 unsigned int ce;
 
-                if ((flags & NORM_IGNORESYMBOLS) &&
-                    (get_char_type( CT_CTYPE1, wch ) & (C1_PUNCT | C1_SPACE)))
-                    continue;
+                if ((flags & NORM_IGNORESYMBOLS) && is_ignored_symbol( wch )) continue;
 
                 if (flags & NORM_IGNORECASE) wch = casemap( nls_info.LowerCaseTable, wch );
 
-                ce = collation_table[collation_table[collation_table[wch >> 8] + ((wch >> 4) & 0x0f)] + (wch & 0xf)];
+                ce = get_collation_element( wch );
                 if (ce != (unsigned int)-1)
                 {
                     WCHAR key;
@@ -2504,7 +2546,7 @@ static unsigned int get_weight( WCHAR ch, enum weight type )
 {
     unsigned int ret;
 
-    ret = collation_table[collation_table[collation_table[ch >> 8] + ((ch >> 4) & 0x0f)] + (ch & 0xf)];
+    ret = get_collation_element( ch );
     if (ret == ~0u) return ch;
 
     switch (type)
@@ -2544,12 +2586,12 @@ static int compare_weights(int flags, const WCHAR *str1, int len1,
         {
             int skip = 0;
             /* FIXME: not tested */
-            if (get_char_type( CT_CTYPE1, dstr1[dpos1] ) & (C1_PUNCT | C1_SPACE))
+            if (is_ignored_symbol( dstr1[dpos1] ))
             {
                 inc_str_pos( &str1, &len1, &dpos1, &dlen1 );
                 skip = 1;
             }
-            if (get_char_type( CT_CTYPE1, dstr2[dpos2] ) & (C1_PUNCT | C1_SPACE))
+            if (is_ignored_symbol( dstr2[dpos2] ))
             {
                 inc_str_pos( &str2, &len2, &dpos2, &dlen2 );
                 skip = 1;
@@ -2613,6 +2655,57 @@ static int compare_weights(int flags, const WCHAR *str1, int len1,
 }
 
 
+/* Compare the strings in a single pass if they only contain simple Latin-1 chars, where
+ * the weight levels are aligned and compare_weights() would decide on the first difference
+ * of each level. Otherwise skip their identical prefix and let compare_weights() do the rest.
+ */
+static BOOL compare_latin1_weights( DWORD flags, const WCHAR **str1, int *len1,
+                                    const WCHAR **str2, int *len2, int *ret )
+{
+    BYTE mask = (flags & NORM_IGNORESYMBOLS) ? COLL_SIMPLE | COLL_SYMBOL : COLL_SIMPLE;
+    const WCHAR *p1 = *str1, *p2 = *str2;
+    int i, prefix = 0, len = min( *len1, *len2 ), diacritic = 0, case_diff = 0;
+    unsigned int ce1, ce2;
+
+#define IS_SIMPLE(ch) ((ch) < ARRAY_SIZE(latin1_collation) && (latin1_collation[ch].flags & mask) == COLL_SIMPLE)
+
+    for (i = 0; i < len; i++)
+    {
+        if (!IS_SIMPLE( p1[i] ) || !IS_SIMPLE( p2[i] )) goto done;
+        if (p1[i] == p2[i])
+        {
+            if (prefix == i) prefix++;
+            continue;
+        }
+        ce1 = latin1_collation[p1[i]].ce;
+        ce2 = latin1_collation[p2[i]].ce;
+        if ((ce1 >> 16) != (ce2 >> 16))
+        {
+            *ret = (int)(ce1 >> 16) - (int)(ce2 >> 16);
+            return TRUE;
+        }
+        if (!diacritic) diacritic = (int)((ce1 >> 8) & 0xff) - (int)((ce2 >> 8) & 0xff);
+        if (!case_diff) case_diff = (int)((ce1 >> 4) & 0x0f) - (int)((ce2 >> 4) & 0x0f);
+    }
+    for (i = len; i < *len1; i++) if (!IS_SIMPLE( p1[i] )) goto done;
+    for (i = len; i < *len2; i++) if (!IS_SIMPLE( p2[i] )) goto done;
+
+#undef IS_SIMPLE
+
+    *ret = *len1 - *len2;
+    if (!*ret && !(flags & NORM_IGNORENONSPACE)) *ret = diacritic;
+    if (!*ret && !(flags & NORM_IGNORECASE)) *ret = case_diff;
+    return TRUE;
+
+done:
+    *str1 += prefix;
+    *len1 -= prefix;
+    *str2 += prefix;
+    *len2 -= prefix;
+    return FALSE;
+}
+
+
 static const struct geoinfo *get_geoinfo_ptr( GEOID geoid )
 {
     int min = 0, max = ARRAY_SIZE( geoinfodata )-1;
@@ -3086,13 +3179,16 @@ INT WINAPI CompareStringEx( const WCHAR *locale, DWORD flags, const WCHAR *str1,
     if (len1 < 0) len1 = lstrlenW(str1);
     if (len2 < 0) len2 = lstrlenW(str2);
 
-    ret = compare_weights( flags, str1, len1, str2, len2, UNICODE_WEIGHT );
-    if (!ret)
+    if (!compare_latin1_weights( flags, &str1, &len1, &str2, &len2, &ret ))
     {
-        if (!(flags & NORM_IGNORENONSPACE))
-            ret = compare_weights( flags, str1, len1, str2, len2, DIACRITIC_WEIGHT );
-        if (!ret && !(flags & NORM_IGNORECASE))
-            ret = compare_weights( flags, str1, len1, str2, len2, CASE_WEIGHT );
+        ret = compare_weights( flags, str1, len1, str2, len2, UNICODE_WEIGHT );
+        if (!ret)
+        {
+            if (!(flags & NORM_IGNORENONSPACE))
+                ret = compare_weights( flags, str1, len1, str2, len2, DIACRITIC_WEIGHT );
+            if (!ret && !(flags & NORM_IGNORECASE))
+                ret = compare_weights( flags, str1, len1, str2, len2, CASE_WEIGHT );
+        }
     }
     if (!ret) return CSTR_EQUAL;
     return (ret < 0) ? CSTR_LESS_THAN : CSTR_GREATER_THAN;
@@ -1113,6 +1113,37 @@ BOOL WINAPI DECLSPEC_HOTPATCH MapUserPhysicalPages( void *addr, ULONG_PTR page_c
  ***********************************************************************/
 
 
+static SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *get_numa_nodes( DWORD *size )
+{
+    LOGICAL_PROCESSOR_RELATIONSHIP relation = RelationNumaNode;
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info = NULL;
+    NTSTATUS status;
+    ULONG len = 0;
+
+    for (;;)
+    {
+        status = NtQuerySystemInformationEx( SystemLogicalProcessorInformationEx, &relation,
+                                             sizeof(relation), info, len, &len );
+        if (status != STATUS_INFO_LENGTH_MISMATCH) break;
+        HeapFree( GetProcessHeap(), 0, info );
+        if (!(info = HeapAlloc( GetProcessHeap(), 0, len ))) return NULL;
+    }
+    if (status)
+    {
+        HeapFree( GetProcessHeap(), 0, info );
+        SetLastError( RtlNtStatusToDosError( status ));
+        return NULL;
+    }
+    *size = len;
+    return info;
+}
+
+static inline SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *next_numa_node( SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info )
+{
+    return (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)info + info->Size);
+}
+
+
 /***********************************************************************
  *             AllocateUserPhysicalPagesNuma   (kernelbase.@)
  */
@@ -1207,8 +1238,16 @@ BOOL WINAPI SetThreadSelectedCpuSets(HANDLE thread, const ULONG *cpu_set_ids, UL
  */
 BOOL WINAPI DECLSPEC_HOTPATCH GetNumaHighestNodeNumber( ULONG *node )
 {
-    FIXME( "semi-stub: %p\n", node );
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info, *ptr;
+    DWORD size;
+
+    if (!(info = get_numa_nodes( &size ))) return FALSE;
+
     *node = 0;
+    for (ptr = info; (char *)ptr < (char *)info + size; ptr = next_numa_node( ptr ))
+        *node = max( *node, ptr->u.NumaNode.NodeNumber );
+
+    HeapFree( GetProcessHeap(), 0, info );
     return TRUE;
 }
 
@@ -1218,9 +1257,25 @@ BOOL WINAPI DECLSPEC_HOTPATCH GetNumaHighestNodeNumber( ULONG *node )
  */
 BOOL WINAPI DECLSPEC_HOTPATCH GetNumaNodeProcessorMaskEx( USHORT node, GROUP_AFFINITY *mask )
 {
-    FIXME( "stub: %hu %p\n", node, mask );
-    SetLastError( ERROR_CALL_NOT_IMPLEMENTED );
-    return FALSE;
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info, *ptr;
+    BOOL ret = FALSE;
+    DWORD size;
+
+    TRACE( "%hu %p\n", node, mask );
+
+    if (!(info = get_numa_nodes( &size ))) return FALSE;
+
+    for (ptr = info; (char *)ptr < (char *)info + size; ptr = next_numa_node( ptr ))
+    {
+        if (ptr->u.NumaNode.NodeNumber != node) continue;
+        *mask = ptr->u.NumaNode.GroupMask;
+        ret = TRUE;
+        break;
+    }
+
+    HeapFree( GetProcessHeap(), 0, info );
+    if (!ret) SetLastError( ERROR_INVALID_PARAMETER );
+    return ret;
 }
 
 
@@ -1252,8 +1307,14 @@ LPVOID WINAPI DECLSPEC_HOTPATCH MapViewOfFileExNuma( HANDLE handle, DWORD access
 LPVOID WINAPI DECLSPEC_HOTPATCH VirtualAllocExNuma( HANDLE process, void *addr, SIZE_T size,
                                                     DWORD type, DWORD protect, DWORD node )
 {
-    if (node) FIXME( "Ignoring preferred node %u\n", node );
-    return VirtualAllocEx( process, addr, size, type, protect );
+    MEM_EXTENDED_PARAMETER param;
+
+    if (node == NUMA_NO_PREFERRED_NODE) return VirtualAllocEx( process, addr, size, type, protect );
+
+    memset( &param, 0, sizeof(param) );
+    param.s.Type = MemExtendedParameterNumaNode;
+    param.u.ULong = node;
+    return VirtualAlloc2( process, addr, size, type, protect, &param, 1 );
 }
 
 
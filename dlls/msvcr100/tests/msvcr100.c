@@ -148,10 +148,33 @@ typedef struct {
     char pad[64];
 } event;
 
+struct ContextVtbl;
 typedef struct {
-    void *vtable;
+    struct ContextVtbl *vtable;
 } Context;
 
+struct ContextVtbl {
+    unsigned int (__thiscall *GetId)(Context*);
+    unsigned int (__thiscall *GetVirtualProcessorId)(Context*);
+    unsigned int (__thiscall *GetScheduleGroupId)(Context*);
+    void (__thiscall *Unblock)(Context*);
+    BOOL (__thiscall *IsSynchronouslyBlocked)(Context*);
+    Context* (__thiscall *vector_dtor)(Context*, unsigned int);
+};
+
+struct ScheduleGroupVtbl;
+typedef struct {
+    struct ScheduleGroupVtbl *vtable;
+} ScheduleGroup;
+
+struct ScheduleGroupVtbl {
+    void (__thiscall *ScheduleTask)(ScheduleGroup*, void (__cdecl*)(void*), void*);
+    unsigned int (__thiscall *Id)(ScheduleGroup*);
+    unsigned int (__thiscall *Reference)(ScheduleGroup*);
+    unsigned int (__thiscall *Release)(ScheduleGroup*);
+    ScheduleGroup* (__thiscall *vector_dtor)(ScheduleGroup*, unsigned int);
+};
+
 typedef struct {
     void *policy_container;
 } SchedulerPolicy;
@@ -170,8 +193,8 @@ struct SchedulerVtbl {
     unsigned int (__thiscall *Release)(Scheduler*);
     void (__thiscall *RegisterShutdownEvent)(Scheduler*,HANDLE);
     void (__thiscall *Attach)(Scheduler*);
-    /* CreateScheduleGroup */
-    /* ScheduleTask */
+    ScheduleGroup* (__thiscall *CreateScheduleGroup)(Scheduler*);
+    void (__thiscall *ScheduleTask)(Scheduler*, void (__cdecl*)(void*), void*);
 };
 
 static int* (__cdecl *p_errno)(void);
@@ -223,6 +246,8 @@ static int (__cdecl *p_event_wait_for_multiple)(event**, size_t, MSVCRT_bool, un
 
 static Context* (__cdecl *p_Context_CurrentContext)(void);
 static unsigned int (__cdecl *p_Context_Id)(void);
+static void (__cdecl *p_Context_Block)(void);
+static unsigned int (__cdecl *p_Context_ScheduleGroupId)(void);
 static SchedulerPolicy* (__thiscall *p_SchedulerPolicy_ctor)(SchedulerPolicy*);
 static void (__thiscall *p_SchedulerPolicy_SetConcurrencyLimits)(SchedulerPolicy*, unsigned int, unsigned int);
 static void (__thiscall *p_SchedulerPolicy_dtor)(SchedulerPolicy*);
@@ -274,6 +299,8 @@ static BOOL init(void)
     SET(p___strncnt, "__strncnt");
 
     SET(p_Context_Id, "?Id@Context@Concurrency@@SAIXZ");
+    SET(p_Context_Block, "?Block@Context@Concurrency@@SAXXZ");
+    SET(p_Context_ScheduleGroupId, "?ScheduleGroupId@Context@Concurrency@@SAIXZ");
     SET(p_CurrentScheduler_Detach, "?Detach@CurrentScheduler@Concurrency@@SAXXZ");
     SET(p_CurrentScheduler_Id, "?Id@CurrentScheduler@Concurrency@@SAIXZ");
 
@@ -989,6 +1016,99 @@ static void test_Scheduler(void)
     call_func1(p_SchedulerPolicy_dtor, &policy);
 }
 
+#define TASK_TREE_DEPTH 10
+
+static struct {
+    Scheduler *scheduler;
+    ScheduleGroup *group;
+    LONG count;
+    LONG total;
+    LONG group_id;
+    Context *blocked;
+    HANDLE event;
+} tasks;
+
+static void __cdecl tree_task(void *data)
+{
+    INT_PTR depth = (INT_PTR)data;
+
+    if (depth) {
+        call_func3(tasks.scheduler->vtable->ScheduleTask, tasks.scheduler, tree_task, (void*)(depth - 1));
+        call_func3(tasks.scheduler->vtable->ScheduleTask, tasks.scheduler, tree_task, (void*)(depth - 1));
+    }
+    if (InterlockedIncrement(&tasks.count) == tasks.total)
+        SetEvent(tasks.event);
+}
+
+static void __cdecl group_task(void *data)
+{
+    InterlockedExchange(&tasks.group_id, p_Context_ScheduleGroupId());
+    SetEvent(tasks.event);
+}
+
+static void __cdecl unblock_task(void *data)
+{
+    call_func1(tasks.blocked->vtable->Unblock, tasks.blocked);
+}
+
+static void __cdecl block_task(void *data)
+{
+    tasks.blocked = p_Context_CurrentContext();
+    /* with a single virtual processor unblock_task only runs if blocking releases it */
+    call_func3(tasks.scheduler->vtable->ScheduleTask, tasks.scheduler, unblock_task, NULL);
+    p_Context_Block();
+    SetEvent(tasks.event);
+}
+
+static void test_Scheduler_tasks(void)
+{
+    SchedulerPolicy policy;
+    LARGE_INTEGER freq, start, end;
+    unsigned int id;
+    DWORD ret;
+
+    tasks.event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    call_func1(p_SchedulerPolicy_ctor, &policy);
+    call_func3(p_SchedulerPolicy_SetConcurrencyLimits, &policy, 2, 2);
+    tasks.scheduler = p_Scheduler_Create(&policy);
+    ok(tasks.scheduler != NULL, "Scheduler::Create() = NULL\n");
+
+    tasks.count = 0;
+    tasks.total = (2 << TASK_TREE_DEPTH) - 1;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    call_func3(tasks.scheduler->vtable->ScheduleTask, tasks.scheduler, tree_task, (void*)TASK_TREE_DEPTH);
+    ret = WaitForSingleObject(tasks.event, 5000);
+    QueryPerformanceCounter(&end);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+    ok(tasks.count == tasks.total, "count = %d, expected %d\n", tasks.count, tasks.total);
+    if (winetest_debug > 1)
+        trace("%d tasks, %.3f us per task\n", tasks.total,
+                (end.QuadPart - start.QuadPart) * 1000000.0 / freq.QuadPart / tasks.total);
+
+    tasks.group = call_func1(tasks.scheduler->vtable->CreateScheduleGroup, tasks.scheduler);
+    ok(tasks.group != NULL, "Scheduler::CreateScheduleGroup() = NULL\n");
+    id = call_func1(tasks.group->vtable->Id, tasks.group);
+    tasks.group_id = -1;
+    call_func3(tasks.group->vtable->ScheduleTask, tasks.group, group_task, NULL);
+    ret = WaitForSingleObject(tasks.event, 5000);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+    ok(tasks.group_id == id, "Context::ScheduleGroupId() = %d, expected %u\n", tasks.group_id, id);
+    call_func1(tasks.group->vtable->Release, tasks.group);
+    call_func1(tasks.scheduler->vtable->Release, tasks.scheduler);
+
+    call_func3(p_SchedulerPolicy_SetConcurrencyLimits, &policy, 1, 1);
+    tasks.scheduler = p_Scheduler_Create(&policy);
+    ok(tasks.scheduler != NULL, "Scheduler::Create() = NULL\n");
+    call_func3(tasks.scheduler->vtable->ScheduleTask, tasks.scheduler, block_task, NULL);
+    ret = WaitForSingleObject(tasks.event, 5000);
+    ok(ret == WAIT_OBJECT_0, "blocked task was not unblocked: %u\n", ret);
+    call_func1(tasks.scheduler->vtable->Release, tasks.scheduler);
+
+    call_func1(p_SchedulerPolicy_dtor, &policy);
+    CloseHandle(tasks.event);
+}
+
 static void test__memicmp(void)
 {
     static const char *s1 = "abc";
@@ -1113,6 +1233,7 @@ START_TEST(msvcr100)
 
     test_ExternalContextBase();
     test_Scheduler();
+    test_Scheduler_tasks();
     test_wmemcpy_s();
     test_wmemmove_s();
     test_fread_s();
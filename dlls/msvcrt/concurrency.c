@@ -24,6 +24,7 @@
 #include "windef.h"
 #include "winternl.h"
 #include "wine/debug.h"
+#include "wine/list.h"
 #include "msvcrt.h"
 #include "cxx.h"
 
@@ -36,6 +37,7 @@ CREATE_EXCEPTION_OBJECT(cexception)
 
 static int context_id = -1;
 static int scheduler_id = -1;
+static int schedule_group_id = -1;
 
 typedef enum {
     SchedulerKind,
@@ -94,6 +96,9 @@ typedef struct {
     struct scheduler_list scheduler;
     unsigned int id;
     union allocator_cache_entry *allocator_cache[8];
+    struct scheduler_vproc *vproc;      /* only set for worker threads */
+    struct ScheduleGroupBase *group;    /* group of the running chore */
+    LONG blocked;
 } ExternalContextBase;
 extern const vtable_ptr ExternalContextBase_vtable;
 static void ExternalContextBase_ctor(ExternalContextBase*);
@@ -125,7 +130,34 @@ typedef struct Scheduler {
         void, (Scheduler*,void (__cdecl*)(void*),void*), (this,proc,data))
 #endif
 
-typedef struct {
+struct scheduler_chore
+{
+    void (__cdecl *proc)(void*);
+    void *data;
+    struct ScheduleGroupBase *group;
+};
+
+/* the owner of a virtual processor takes its most recent chore,
+ * other workers steal the oldest one */
+struct chore_queue
+{
+    SRWLOCK lock;
+    struct scheduler_chore *chores;
+    unsigned int head;
+    unsigned int count;
+    unsigned int size;
+};
+
+struct scheduler_vproc
+{
+    struct ThreadScheduler *scheduler;
+    unsigned int id;
+    DWORD owner;    /* worker thread id, protected by the scheduler cs */
+    HANDLE thread;
+    struct chore_queue queue;
+};
+
+typedef struct ThreadScheduler {
     Scheduler scheduler;
     LONG ref;
     unsigned int id;
@@ -135,9 +167,33 @@ typedef struct {
     int shutdown_size;
     HANDLE *shutdown_events;
     CRITICAL_SECTION cs;
+
+    /* worker threads */
+    struct scheduler_vproc *vprocs;
+    LONG active_vprocs;
+    LONG idle_workers;
+    HANDLE work_sem;
+    BOOL shutdown;
+    struct chore_queue queue;   /* anonymous schedule group */
+    SRWLOCK groups_lock;
+    struct list groups;
 } ThreadScheduler;
 extern const vtable_ptr ThreadScheduler_vtable;
 
+typedef struct {
+    const vtable_ptr *vtable;
+} ScheduleGroup;
+
+typedef struct ScheduleGroupBase {
+    ScheduleGroup group;
+    LONG ref;
+    unsigned int id;
+    ThreadScheduler *scheduler;
+    struct chore_queue queue;
+    struct list entry;
+} ScheduleGroupBase;
+extern const vtable_ptr ScheduleGroupBase_vtable;
+
 typedef struct {
     Scheduler *scheduler;
 } _Scheduler;
@@ -688,23 +744,52 @@ unsigned int __cdecl Context_Id(void)
     return ctx ? call_Context_GetId(ctx) : -1;
 }
 
+static void scheduler_handoff_vproc(ExternalContextBase *context);
+
 /* ?Block@Context@Concurrency@@SAXXZ */
 void __cdecl Context_Block(void)
 {
-    FIXME("()\n");
+    ExternalContextBase *context = (ExternalContextBase*)get_current_context();
+
+    TRACE("()\n");
+
+    if (context->context.vtable != &ExternalContextBase_vtable) {
+        ERR("unknown context set\n");
+        return;
+    }
+
+    /* Unblock releases the keyed event as soon as it sees the decrement */
+    if (!keyed_event) {
+        HANDLE event;
+
+        NtCreateKeyedEvent(&event, GENERIC_READ|GENERIC_WRITE, NULL, 0);
+        if (InterlockedCompareExchangePointer(&keyed_event, event, NULL) != NULL)
+            NtClose(event);
+    }
+
+    /* Unblock may be called before Block */
+    if (InterlockedDecrement(&context->blocked) >= 0)
+        return;
+
+    /* let another worker run the chores of our virtual processor */
+    if (context->vproc)
+        scheduler_handoff_vproc(context);
+    NtWaitForKeyedEvent(keyed_event, context, 0, NULL);
 }
 
 /* ?Yield@Context@Concurrency@@SAXXZ */
 /* ?_Yield@_Context@details@Concurrency@@SAXXZ */
 void __cdecl Context_Yield(void)
 {
-    FIXME("()\n");
+    TRACE("()\n");
+    SwitchToThread();
 }
 
 /* ?_SpinYield@Context@Concurrency@@SAXXZ */
 void __cdecl Context__SpinYield(void)
 {
-    FIXME("()\n");
+    TRACE("()\n");
+    Sleep(0);
 }
 
 /* ?IsCurrentTaskCollectionCanceling@Context@Concurrency@@SA_NXZ */
@@ -717,7 +802,13 @@ bool __cdecl Context_IsCurrentTaskCollectionCanceling(void)
 /* ?Oversubscribe@Context@Concurrency@@SAX_N@Z */
 void __cdecl Context_Oversubscribe(bool begin)
 {
-    FIXME("(%x)\n", begin);
+    ExternalContextBase *context = (ExternalContextBase*)try_get_current_context();
+
+    TRACE("(%x)\n", begin);
+
+    /* the worker gives up its virtual processor until its chore is done */
+    if (begin && context && context->context.vtable == &ExternalContextBase_vtable && context->vproc)
+        scheduler_handoff_vproc(context);
 }
 
 /* ?ScheduleGroupId@Context@Concurrency@@SAIXZ */
@@ -756,28 +847,31 @@ unsigned int __thiscall ExternalContextBase_GetId(const ExternalContextBase *thi
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_GetVirtualProcessorId, 4)
 unsigned int __thiscall ExternalContextBase_GetVirtualProcessorId(const ExternalContextBase *this)
 {
-    FIXME("(%p)->() stub\n", this);
-    return -1;
+    TRACE("(%p)->()\n", this);
+    return this->vproc ? this->vproc->id : -1;
 }
 
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_GetScheduleGroupId, 4)
 unsigned int __thiscall ExternalContextBase_GetScheduleGroupId(const ExternalContextBase *this)
 {
-    FIXME("(%p)->() stub\n", this);
-    return -1;
+    TRACE("(%p)->()\n", this);
+    return this->group ? this->group->id : -1;
 }
 
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_Unblock, 4)
 void __thiscall ExternalContextBase_Unblock(ExternalContextBase *this)
 {
-    FIXME("(%p)->() stub\n", this);
+    TRACE("(%p)->()\n", this);
+
+    if (InterlockedIncrement(&this->blocked) <= 0)
+        NtReleaseKeyedEvent(keyed_event, this, 0, NULL);
 }
 
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_IsSynchronouslyBlocked, 4)
 bool __thiscall ExternalContextBase_IsSynchronouslyBlocked(const ExternalContextBase *this)
 {
-    FIXME("(%p)->() stub\n", this);
-    return FALSE;
+    TRACE("(%p)->()\n", this);
+    return this->blocked < 0;
 }
 
 static void ExternalContextBase_dtor(ExternalContextBase *this)
@@ -1095,11 +1189,401 @@ void __thiscall SchedulerPolicy_dtor(SchedulerPolicy *this)
     operator_delete(this->policy_container);
 }
 
+#define SCHEDULER_IDLE_TIMEOUT 5000
+
+static void chore_queue_init(struct chore_queue *queue)
+{
+    InitializeSRWLock(&queue->lock);
+    queue->chores = NULL;
+    queue->head = queue->count = queue->size = 0;
+}
+
+static void chore_queue_destroy(struct chore_queue *queue)
+{
+    if (queue->count) WARN("%u chores were never run\n", queue->count);
+    operator_delete(queue->chores);
+}
+
+static void chore_queue_push(struct chore_queue *queue, const struct scheduler_chore *chore)
+{
+    struct scheduler_chore *chores, *old;
+    unsigned int i, size;
+
+    AcquireSRWLockExclusive(&queue->lock);
+    while (queue->count == queue->size) {
+        size = queue->size ? queue->size * 2 : 16;
+        ReleaseSRWLockExclusive(&queue->lock);
+
+        /* operator_new may throw, don't hold the lock while allocating */
+        chores = old = operator_new(size * sizeof(*chores));
+
+        AcquireSRWLockExclusive(&queue->lock);
+        if (queue->count == queue->size && size > queue->size) {
+            for (i = 0; i < queue->count; i++)
+                chores[i] = queue->chores[(queue->head + i) & (queue->size - 1)];
+            old = queue->chores;
+            queue->chores = chores;
+            queue->head = 0;
+            queue->size = size;
+        }
+        operator_delete(old);
+    }
+    queue->chores[(queue->head + queue->count++) & (queue->size - 1)] = *chore;
+    ReleaseSRWLockExclusive(&queue->lock);
+}
+
+static BOOL chore_queue_pop(struct chore_queue *queue, BOOL newest, struct scheduler_chore *chore)
+{
+    BOOL ret = FALSE;
+
+    if (!*(volatile unsigned int *)&queue->count)
+        return FALSE;
+
+    AcquireSRWLockExclusive(&queue->lock);
+    if (queue->count) {
+        if (newest) {
+            *chore = queue->chores[(queue->head + queue->count - 1) & (queue->size - 1)];
+        } else {
+            *chore = queue->chores[queue->head];
+            queue->head = (queue->head + 1) & (queue->size - 1);
+        }
+        queue->count--;
+        ret = TRUE;
+    }
+    ReleaseSRWLockExclusive(&queue->lock);
+    return ret;
+}
+
+static void ScheduleGroupBase_dtor(ScheduleGroupBase *this)
+{
+    ThreadScheduler *scheduler = this->scheduler;
+
+    AcquireSRWLockExclusive(&scheduler->groups_lock);
+    list_remove(&this->entry);
+    ReleaseSRWLockExclusive(&scheduler->groups_lock);
+
+    chore_queue_destroy(&this->queue);
+    call_Scheduler_Release(&scheduler->scheduler);
+}
+
+DEFINE_THISCALL_WRAPPER(ScheduleGroupBase_Id, 4)
+unsigned int __thiscall ScheduleGroupBase_Id(const ScheduleGroupBase *this)
+{
+    TRACE("(%p)\n", this);
+    return this->id;
+}
+
+DEFINE_THISCALL_WRAPPER(ScheduleGroupBase_Reference, 4)
+unsigned int __thiscall ScheduleGroupBase_Reference(ScheduleGroupBase *this)
+{
+    TRACE("(%p)\n", this);
+    return InterlockedIncrement(&this->ref);
+}
+
+DEFINE_THISCALL_WRAPPER(ScheduleGroupBase_Release, 4)
+unsigned int __thiscall ScheduleGroupBase_Release(ScheduleGroupBase *this)
+{
+    unsigned int ret = InterlockedDecrement(&this->ref);
+
+    TRACE("(%p)\n", this);
+
+    if(!ret) {
+        ScheduleGroupBase_dtor(this);
+        operator_delete(this);
+    }
+    return ret;
+}
+
+DEFINE_THISCALL_WRAPPER(ScheduleGroupBase_vector_dtor, 8)
+ScheduleGroup* __thiscall ScheduleGroupBase_vector_dtor(ScheduleGroupBase *this, unsigned int flags)
+{
+    TRACE("(%p %x)\n", this, flags);
+    if(flags & 2) {
+        /* we have an array, with the number of elements stored before the first object */
+        INT_PTR i, *ptr = (INT_PTR *)this-1;
+
+        for(i=*ptr-1; i>=0; i--)
+            ScheduleGroupBase_dtor(this+i);
+        operator_delete(ptr);
+    } else {
+        ScheduleGroupBase_dtor(this);
+        if(flags & 1)
+            operator_delete(this);
+    }
+
+    return &this->group;
+}
+
+/* decrements the number of workers waiting for a chore, returns FALSE if they were all woken */
+static BOOL scheduler_take_idle_worker(ThreadScheduler *scheduler)
+{
+    LONG idle;
+
+    while ((idle = *(volatile LONG *)&scheduler->idle_workers) > 0) {
+        if (InterlockedCompareExchange(&scheduler->idle_workers, idle - 1, idle) == idle)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static BOOL scheduler_get_chore(ThreadScheduler *scheduler,
+        struct scheduler_vproc *vproc, struct scheduler_chore *chore)
+{
+    ScheduleGroupBase *group;
+    unsigned int i;
+    BOOL ret = FALSE;
+
+    if (chore_queue_pop(&vproc->queue, TRUE, chore))
+        return TRUE;
+    if (chore_queue_pop(&scheduler->queue, FALSE, chore))
+        return TRUE;
+
+    AcquireSRWLockShared(&scheduler->groups_lock);
+    LIST_FOR_EACH_ENTRY(group, &scheduler->groups, ScheduleGroupBase, entry) {
+        if ((ret = chore_queue_pop(&group->queue, FALSE, chore)))
+            break;
+    }
+    ReleaseSRWLockShared(&scheduler->groups_lock);
+    if (ret)
+        return TRUE;
+
+    for (i = 1; i < scheduler->virt_proc_no; i++) {
+        struct scheduler_vproc *victim = &scheduler->vprocs[(vproc->id + i) % scheduler->virt_proc_no];
+        if (chore_queue_pop(&victim->queue, FALSE, chore))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static BOOL scheduler_has_chores(ThreadScheduler *scheduler)
+{
+    ScheduleGroupBase *group;
+    unsigned int i;
+    BOOL ret = FALSE;
+
+    if (*(volatile unsigned int *)&scheduler->queue.count)
+        return TRUE;
+    for (i = 0; i < scheduler->virt_proc_no; i++) {
+        if (*(volatile unsigned int *)&scheduler->vprocs[i].queue.count)
+            return TRUE;
+    }
+
+    AcquireSRWLockShared(&scheduler->groups_lock);
+    LIST_FOR_EACH_ENTRY(group, &scheduler->groups, ScheduleGroupBase, entry) {
+        if ((ret = *(volatile unsigned int *)&group->queue.count != 0))
+            break;
+    }
+    ReleaseSRWLockShared(&scheduler->groups_lock);
+    return ret;
+}
+
+static DWORD WINAPI scheduler_worker_proc(void*);
+
+/* must be called with scheduler cs held */
+static void scheduler_start_worker(ThreadScheduler *scheduler, struct scheduler_vproc *vproc)
+{
+    unsigned int stack_size = SchedulerPolicy_GetPolicyValue(&scheduler->policy, ContextStackSize);
+    int priority = SchedulerPolicy_GetPolicyValue(&scheduler->policy, ContextPriority);
+    HMODULE module;
+    HANDLE thread;
+    DWORD tid;
+
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
+                (const WCHAR*)scheduler_worker_proc, &module))
+        return;
+
+    thread = CreateThread(NULL, stack_size * 1024, scheduler_worker_proc, vproc, CREATE_SUSPENDED, &tid);
+    if (!thread) {
+        WARN("failed to create worker thread: %u\n", GetLastError());
+        FreeLibrary(module);
+        return;
+    }
+    if (priority != INHERIT_THREAD_PRIORITY)
+        SetThreadPriority(thread, priority);
+
+    vproc->owner = tid;
+    vproc->thread = thread;
+    InterlockedIncrement(&scheduler->active_vprocs);
+    ResumeThread(thread);
+}
+
+static void scheduler_wake_worker(ThreadScheduler *scheduler)
+{
+    unsigned int i;
+
+    if (scheduler_take_idle_worker(scheduler)) {
+        ReleaseSemaphore(scheduler->work_sem, 1, NULL);
+        return;
+    }
+    if (*(volatile LONG *)&scheduler->active_vprocs >= scheduler->virt_proc_no)
+        return;
+
+    EnterCriticalSection(&scheduler->cs);
+    for (i = 0; i < scheduler->virt_proc_no && !scheduler->shutdown; i++) {
+        if (!scheduler->vprocs[i].owner) {
+            scheduler_start_worker(scheduler, &scheduler->vprocs[i]);
+            break;
+        }
+    }
+    LeaveCriticalSection(&scheduler->cs);
+}
+
+/* the context keeps running its chore, but no longer on the virtual processor */
+static void scheduler_handoff_vproc(ExternalContextBase *context)
+{
+    struct scheduler_vproc *vproc = context->vproc;
+    ThreadScheduler *scheduler = vproc->scheduler;
+
+    context->vproc = NULL;
+
+    EnterCriticalSection(&scheduler->cs);
+    if (!scheduler->shutdown) {
+        CloseHandle(vproc->thread);
+        vproc->thread = NULL;
+        vproc->owner = 0;
+        InterlockedDecrement(&scheduler->active_vprocs);
+        scheduler_start_worker(scheduler, vproc);
+    }
+    LeaveCriticalSection(&scheduler->cs);
+}
+
+static void scheduler_schedule_chore(ThreadScheduler *scheduler, ScheduleGroupBase *group,
+        void (__cdecl *proc)(void*), void *data)
+{
+    ExternalContextBase *context = (ExternalContextBase*)try_get_current_context();
+    struct scheduler_chore chore;
+    struct chore_queue *queue;
+
+    chore.proc = proc;
+    chore.data = data;
+    chore.group = group;
+
+    /* pending chores keep the scheduler and their group alive */
+    call_Scheduler_Reference(&scheduler->scheduler);
+    if (group)
+        ScheduleGroupBase_Reference(group);
+
+    if (group)
+        queue = &group->queue;
+    else if (context && context->context.vtable == &ExternalContextBase_vtable
+            && context->vproc && context->vproc->scheduler == scheduler)
+        queue = &context->vproc->queue;
+    else
+        queue = &scheduler->queue;
+
+    chore_queue_push(queue, &chore);
+    scheduler_wake_worker(scheduler);
+}
+
+DEFINE_THISCALL_WRAPPER(ScheduleGroupBase_ScheduleTask, 12)
+void __thiscall ScheduleGroupBase_ScheduleTask(ScheduleGroupBase *this,
+        void (__cdecl *proc)(void*), void *data)
+{
+    TRACE("(%p %p %p)\n", this, proc, data);
+    scheduler_schedule_chore(this->scheduler, this, proc, data);
+}
+
+static DWORD WINAPI scheduler_worker_proc(void *arg)
+{
+    struct scheduler_vproc *vproc = arg;
+    ThreadScheduler *scheduler = vproc->scheduler;
+    ExternalContextBase *context = (ExternalContextBase*)get_current_context();
+    struct scheduler_chore chore;
+    HMODULE module;
+
+    TRACE("starting worker %u of %p\n", vproc->id, scheduler);
+
+    /* workers don't keep their scheduler alive, the chores do */
+    if (context->scheduler.scheduler)
+        call_Scheduler_Release(context->scheduler.scheduler);
+    context->scheduler.scheduler = &scheduler->scheduler;
+    context->vproc = vproc;
+
+    for (;;) {
+        BOOL retire;
+
+        if (!scheduler_get_chore(scheduler, vproc, &chore)) {
+            DWORD ret;
+
+            InterlockedIncrement(&scheduler->idle_workers);
+            if (scheduler_get_chore(scheduler, vproc, &chore)) {
+                /* if this fails a wake up is pending, it will be consumed later */
+                scheduler_take_idle_worker(scheduler);
+            } else {
+                ret = WaitForSingleObject(scheduler->work_sem, SCHEDULER_IDLE_TIMEOUT);
+                if (scheduler->shutdown)
+                    break;
+                if (ret != WAIT_TIMEOUT || !scheduler_take_idle_worker(scheduler))
+                    continue;
+
+                EnterCriticalSection(&scheduler->cs);
+                if (!scheduler->shutdown) {
+                    CloseHandle(vproc->thread);
+                    vproc->thread = NULL;
+                    vproc->owner = 0;
+                    InterlockedDecrement(&scheduler->active_vprocs);
+                    /* a chore pushed before the decrement may have found no
+                     * idle worker and no free virtual processor */
+                    if (scheduler_has_chores(scheduler))
+                        scheduler_start_worker(scheduler, vproc);
+                }
+                LeaveCriticalSection(&scheduler->cs);
+                break;
+            }
+        }
+
+        context->group = chore.group;
+        chore.proc(chore.data);
+        context->group = NULL;
+        if (chore.group)
+            ScheduleGroupBase_Release(chore.group);
+
+        /* the virtual processor was handed to another worker while we were blocked */
+        retire = context->vproc != vproc;
+        if (!call_Scheduler_Release(&scheduler->scheduler) || retire)
+            break;
+    }
+
+    TRACE("terminating worker of %p\n", scheduler);
+
+    context->scheduler.scheduler = NULL;
+    context->vproc = NULL;
+    GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+            (const WCHAR*)scheduler_worker_proc, &module);
+    FreeLibraryAndExitThread(module, 0);
+    return 0;
+}
+
+static void scheduler_stop_workers(ThreadScheduler *this)
+{
+    DWORD tid = GetCurrentThreadId();
+    unsigned int i;
+
+    EnterCriticalSection(&this->cs);
+    this->shutdown = TRUE;
+    LeaveCriticalSection(&this->cs);
+
+    ReleaseSemaphore(this->work_sem, this->virt_proc_no, NULL);
+    for (i = 0; i < this->virt_proc_no; i++) {
+        if (!this->vprocs[i].thread) continue;
+        if (this->vprocs[i].owner != tid)
+            WaitForSingleObject(this->vprocs[i].thread, INFINITE);
+        CloseHandle(this->vprocs[i].thread);
+    }
+
+    for (i = 0; i < this->virt_proc_no; i++)
+        chore_queue_destroy(&this->vprocs[i].queue);
+    operator_delete(this->vprocs);
+    chore_queue_destroy(&this->queue);
+    CloseHandle(this->work_sem);
+}
+
 static void ThreadScheduler_dtor(ThreadScheduler *this)
 {
     int i;
 
     if(this->ref != 0) WARN("ref = %d\n", this->ref);
+    scheduler_stop_workers(this);
     SchedulerPolicy_dtor(&this->policy);
 
     for(i=0; i<this->shutdown_count; i++)
@@ -1206,29 +1690,45 @@ DEFINE_THISCALL_WRAPPER(ThreadScheduler_CreateScheduleGroup_loc, 8)
 /*ScheduleGroup*/void* __thiscall ThreadScheduler_CreateScheduleGroup_loc(
         ThreadScheduler *this, /*location*/void *placement)
 {
-    FIXME("(%p %p) stub\n", this, placement);
-    return NULL;
+    ScheduleGroupBase *group;
+
+    TRACE("(%p %p)\n", this, placement);
+
+    group = operator_new(sizeof(*group));
+    group->group.vtable = &ScheduleGroupBase_vtable;
+    group->ref = 1;
+    group->id = InterlockedIncrement(&schedule_group_id);
+    group->scheduler = this;
+    chore_queue_init(&group->queue);
+    ThreadScheduler_Reference(this);
+
+    AcquireSRWLockExclusive(&this->groups_lock);
+    list_add_tail(&this->groups, &group->entry);
+    ReleaseSRWLockExclusive(&this->groups_lock);
+    return &group->group;
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_CreateScheduleGroup, 4)
 /*ScheduleGroup*/void* __thiscall ThreadScheduler_CreateScheduleGroup(ThreadScheduler *this)
 {
-    FIXME("(%p) stub\n", this);
-    return NULL;
+    TRACE("(%p)\n", this);
+    return ThreadScheduler_CreateScheduleGroup_loc(this, NULL);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask_loc, 16)
 void __thiscall ThreadScheduler_ScheduleTask_loc(ThreadScheduler *this,
         void (__cdecl *proc)(void*), void* data, /*location*/void *placement)
 {
-    FIXME("(%p %p %p %p) stub\n", this, proc, data, placement);
+    TRACE("(%p %p %p %p)\n", this, proc, data, placement);
+    scheduler_schedule_chore(this, NULL, proc, data);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask, 12)
 void __thiscall ThreadScheduler_ScheduleTask(ThreadScheduler *this,
         void (__cdecl *proc)(void*), void* data)
 {
-    FIXME("(%p %p %p) stub\n", this, proc, data);
+    TRACE("(%p %p %p)\n", this, proc, data);
+    scheduler_schedule_chore(this, NULL, proc, data);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_IsAvailableLocation, 8)
@@ -1263,6 +1763,7 @@ static ThreadScheduler* ThreadScheduler_ctor(ThreadScheduler *this,
         const SchedulerPolicy *policy)
 {
     SYSTEM_INFO si;
+    unsigned int i;
 
     TRACE("(%p)->()\n", this);
 
@@ -1275,12 +1776,31 @@ static ThreadScheduler* ThreadScheduler_ctor(ThreadScheduler *this,
     this->virt_proc_no = SchedulerPolicy_GetPolicyValue(&this->policy, MaxConcurrency);
     if(this->virt_proc_no > si.dwNumberOfProcessors)
         this->virt_proc_no = si.dwNumberOfProcessors;
+    if(this->virt_proc_no < SchedulerPolicy_GetPolicyValue(&this->policy, MinConcurrency))
+        this->virt_proc_no = SchedulerPolicy_GetPolicyValue(&this->policy, MinConcurrency);
 
     this->shutdown_count = this->shutdown_size = 0;
     this->shutdown_events = NULL;
 
     InitializeCriticalSection(&this->cs);
     this->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": ThreadScheduler");
+
+    /* worker threads are only started when chores are scheduled */
+    this->vprocs = operator_new(this->virt_proc_no * sizeof(*this->vprocs));
+    for(i=0; i<this->virt_proc_no; i++) {
+        this->vprocs[i].scheduler = this;
+        this->vprocs[i].id = i;
+        this->vprocs[i].owner = 0;
+        this->vprocs[i].thread = NULL;
+        chore_queue_init(&this->vprocs[i].queue);
+    }
+    this->active_vprocs = 0;
+    this->idle_workers = 0;
+    this->work_sem = CreateSemaphoreW(NULL, 0, MAXLONG, NULL);
+    this->shutdown = FALSE;
+    chore_queue_init(&this->queue);
+    InitializeSRWLock(&this->groups_lock);
+    list_init(&this->groups);
     return this;
 }
 
@@ -2862,6 +3382,9 @@ DEFINE_RTTI_DATA0(Scheduler, 0, ".?AVScheduler@Concurrency@@")
 DEFINE_RTTI_DATA1(SchedulerBase, 0, &Scheduler_rtti_base_descriptor, ".?AVSchedulerBase@details@Concurrency@@")
 DEFINE_RTTI_DATA2(ThreadScheduler, 0, &SchedulerBase_rtti_base_descriptor,
         &Scheduler_rtti_base_descriptor, ".?AVThreadScheduler@details@Concurrency@@")
+DEFINE_RTTI_DATA0(ScheduleGroup, 0, ".?AVScheduleGroup@Concurrency@@")
+DEFINE_RTTI_DATA1(ScheduleGroupBase, 0, &ScheduleGroup_rtti_base_descriptor,
+        ".?AVScheduleGroupBase@details@Concurrency@@")
 DEFINE_RTTI_DATA0(_Timer, 0, ".?AV_Timer@details@Concurrency@@");
 
 __ASM_BLOCK_BEGIN(concurrency_vtables)
@@ -2893,6 +3416,12 @@ __ASM_BLOCK_BEGIN(concurrency_vtables)
             VTABLE_ADD_FUNC(ThreadScheduler_IsAvailableLocation)
 #endif
             );
+    __ASM_VTABLE(ScheduleGroupBase,
+            VTABLE_ADD_FUNC(ScheduleGroupBase_ScheduleTask)
+            VTABLE_ADD_FUNC(ScheduleGroupBase_Id)
+            VTABLE_ADD_FUNC(ScheduleGroupBase_Reference)
+            VTABLE_ADD_FUNC(ScheduleGroupBase_Release)
+            VTABLE_ADD_FUNC(ScheduleGroupBase_vector_dtor));
     __ASM_VTABLE(_Timer,
             VTABLE_ADD_FUNC(_Timer_vector_dtor));
 __ASM_BLOCK_END
@@ -2914,6 +3443,8 @@ void msvcrt_init_concurrency(void *base)
     init_Scheduler_rtti(base);
     init_SchedulerBase_rtti(base);
     init_ThreadScheduler_rtti(base);
+    init_ScheduleGroup_rtti(base);
+    init_ScheduleGroupBase_rtti(base);
     init__Timer_rtti(base);
 
     init_cexception_cxx_type_info(base);
@@ -34,6 +34,13 @@
 #undef wcsncpy
 
 extern BOOL sse2_supported DECLSPEC_HIDDEN;
+extern BOOL avx2_supported DECLSPEC_HIDDEN;
+
+/* 32 byte vector spills need a stack realignment that x86_64 PE code
+ * can't do (GCC bug 54412), so the AVX2 functions are left out there */
+#if defined(__i386__) || (defined(__x86_64__) && !defined(__WINE_PE_BUILD))
+#define USE_AVX2
+#endif
 
 #define DBL80_MAX_10_EXP 4932
 #define DBL80_MIN_10_EXP -4951
@@ -34,6 +34,15 @@
 #include "wine/asm.h"
 #include "wine/debug.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include "string_simd.h"
+#endif
+#ifdef USE_AVX2
+#define SIMD_AVX2
+#include "string_simd.h"
+#undef SIMD_AVX2
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(msvcrt);
 
 /*********************************************************************
@@ -1513,6 +1522,13 @@ int CDECL _atoldbl(_LDOUBLE *value, char *str)
 size_t __cdecl strlen(const char *str)
 {
     const char *s = str;
+
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef USE_AVX2
+    if (avx2_supported) return avx2_strlen(str);
+#endif
+    if (sse2_supported) return sse2_strlen(str);
+#endif
     while (*s) s++;
     return s - str;
 }
@@ -2682,6 +2698,12 @@ int __cdecl memcmp(const void *ptr1, const void *ptr2, size_t n)
 {
     const unsigned char *p1, *p2;
 
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef USE_AVX2
+    if (avx2_supported) return avx2_memcmp(ptr1, ptr2, n);
+#endif
+    if (sse2_supported) return sse2_memcmp(ptr1, ptr2, n);
+#endif
     for (p1 = ptr1, p2 = ptr2; n; n--, p1++, p2++)
     {
         if (*p1 < *p2) return -1;
@@ -3116,6 +3138,14 @@ void *__cdecl memset(void *dst, int c, size_t n)
         if (n <= 64) return dst;
 
         n = (n - a) & ~0x1f;
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef USE_AVX2
+        if (avx2_supported) avx2_memset_aligned_32(d + a, c, n);
+        else
+#endif
+        if (sse2_supported) sse2_memset_aligned_32(d + a, c, n);
+        else
+#endif
         memset_aligned_32(d + a, v, n);
         return dst;
     }
@@ -3150,6 +3180,12 @@ void *__cdecl memset(void *dst, int c, size_t n)
  */
 char* __cdecl strchr(const char *str, int c)
 {
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef USE_AVX2
+    if (avx2_supported) return avx2_strchr(str, c);
+#endif
+    if (sse2_supported) return sse2_strchr(str, c);
+#endif
     do
     {
         if (*str == (char)c) return (char*)str;
@@ -3174,6 +3210,12 @@ void* __cdecl memchr(const void *ptr, int c, size_t n)
 {
     const unsigned char *p = ptr;
 
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef USE_AVX2
+    if (avx2_supported) return avx2_memchr(ptr, c, n);
+#endif
+    if (sse2_supported) return sse2_memchr(ptr, c, n);
+#endif
     for (p = ptr; n; n--, p++) if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
     return NULL;
 }
@@ -3183,6 +3225,12 @@ void* __cdecl memchr(const void *ptr, int c, size_t n)
  */
 int __cdecl strcmp(const char *str1, const char *str2)
 {
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef USE_AVX2
+    if (avx2_supported) return avx2_strcmp(str1, str2);
+#endif
+    if (sse2_supported) return sse2_strcmp(str1, str2);
+#endif
     while (*str1 && *str1 == *str2) { str1++; str2++; }
     if ((unsigned char)*str1 > (unsigned char)*str2) return 1;
     if ((unsigned char)*str1 < (unsigned char)*str2) return -1;
@@ -0,0 +1,219 @@
+/*
+ * SSE2 and AVX2 string functions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * Included once per instruction set and character type, like printf.h.
+ * SIMD_AVX2 selects 32 byte AVX2 vectors instead of 16 byte SSE2 ones, and
+ * is only used where USE_AVX2 is defined. SIMD_WIDE generates the wcs*
+ * functions instead of the str* and mem* ones.
+ *
+ * Aligned loads never cross a page boundary, so they may read past the
+ * end of the string. Unaligned loads are only done when the vector does
+ * not reach into the next page.
+ */
+
+#ifdef SIMD_AVX2
+#define SIMD_SIZE 32
+#define SIMD_TARGET "avx2"
+#define SIMD_MOVEMASK(v) ((unsigned int)__builtin_ia32_pmovmskb256((simd_vec8)(v)))
+#define SIMD_FUNC(func) avx2_ ## func
+#else
+#define SIMD_SIZE 16
+#define SIMD_TARGET "sse2"
+#define SIMD_MOVEMASK(v) ((unsigned int)__builtin_ia32_pmovmskb128((simd_vec8)(v)))
+#define SIMD_FUNC(func) sse2_ ## func
+#endif
+
+#ifdef SIMD_WIDE
+#define SIMD_CHAR wchar_t
+#define SIMD_ELEM unsigned short
+#define SIMD_STR(func) SIMD_FUNC(wcs ## func)
+#else
+#define SIMD_CHAR char
+#define SIMD_ELEM unsigned char
+#define SIMD_STR(func) SIMD_FUNC(str ## func)
+#endif
+
+#define SIMD_PAGE_SIZE 0x1000
+/* TRUE if an unaligned vector load at p could touch the next page */
+#define SIMD_CROSSES_PAGE(p) (((ULONG_PTR)(p) & (SIMD_PAGE_SIZE - 1)) > SIMD_PAGE_SIZE - SIMD_SIZE)
+
+#define simd_vec8 SIMD_STR(vec8)
+#define simd_vec SIMD_STR(vec)
+#define simd_uvec SIMD_STR(uvec)
+
+typedef char simd_vec8 __attribute__((vector_size(SIMD_SIZE)));
+typedef SIMD_ELEM simd_vec __attribute__((vector_size(SIMD_SIZE), may_alias));
+typedef SIMD_ELEM simd_uvec __attribute__((vector_size(SIMD_SIZE), may_alias, aligned(1)));
+
+static size_t __cdecl __attribute__((target(SIMD_TARGET))) SIMD_STR(len)(const SIMD_CHAR *str)
+{
+    const simd_vec *p = (const simd_vec *)((ULONG_PTR)str & ~(SIMD_SIZE - 1));
+    const simd_vec zero = {0};
+    unsigned int mask;
+
+    mask = SIMD_MOVEMASK(*p == zero) >> ((ULONG_PTR)str & (SIMD_SIZE - 1));
+    if (mask) return __builtin_ctz(mask) / sizeof(SIMD_CHAR);
+
+    for (;;)
+    {
+        p++;
+        if ((mask = SIMD_MOVEMASK(*p == zero)))
+            return ((const char *)p - (const char *)str + __builtin_ctz(mask)) / sizeof(SIMD_CHAR);
+    }
+}
+
+static SIMD_CHAR * __cdecl __attribute__((target(SIMD_TARGET))) SIMD_STR(chr)(const SIMD_CHAR *str, SIMD_CHAR c)
+{
+    const simd_vec *p = (const simd_vec *)((ULONG_PTR)str & ~(SIMD_SIZE - 1));
+    const simd_vec zero = {0}, match = zero + (SIMD_ELEM)c;
+    const SIMD_CHAR *ret;
+    unsigned int mask;
+
+    mask = SIMD_MOVEMASK((*p == match) | (*p == zero)) >> ((ULONG_PTR)str & (SIMD_SIZE - 1));
+    if (mask)
+        ret = (const SIMD_CHAR *)((const char *)str + __builtin_ctz(mask));
+    else
+    {
+        do
+        {
+            p++;
+            mask = SIMD_MOVEMASK((*p == match) | (*p == zero));
+        } while (!mask);
+        ret = (const SIMD_CHAR *)((const char *)p + __builtin_ctz(mask));
+    }
+    return *ret == c ? (SIMD_CHAR *)ret : NULL;
+}
+
+static int __cdecl __attribute__((target(SIMD_TARGET))) SIMD_STR(cmp)(const SIMD_CHAR *str1, const SIMD_CHAR *str2)
+{
+    const simd_vec zero = {0};
+    simd_vec v1, v2;
+    unsigned int mask;
+
+    for (;;)
+    {
+        if (SIMD_CROSSES_PAGE(str1) || SIMD_CROSSES_PAGE(str2))
+        {
+            if (!*str1 || *str1 != *str2) break;
+            str1++;
+            str2++;
+            continue;
+        }
+
+        v1 = *(const simd_uvec *)str1;
+        v2 = *(const simd_uvec *)str2;
+        if ((mask = SIMD_MOVEMASK((v1 != v2) | (v1 == zero))))
+        {
+            str1 = (const SIMD_CHAR *)((const char *)str1 + __builtin_ctz(mask));
+            str2 = (const SIMD_CHAR *)((const char *)str2 + __builtin_ctz(mask));
+            break;
+        }
+        str1 += SIMD_SIZE / sizeof(SIMD_CHAR);
+        str2 += SIMD_SIZE / sizeof(SIMD_CHAR);
+    }
+
+    if ((SIMD_ELEM)*str1 < (SIMD_ELEM)*str2) return -1;
+    if ((SIMD_ELEM)*str1 > (SIMD_ELEM)*str2) return 1;
+    return 0;
+}
+
+#ifndef SIMD_WIDE
+
+static void * __cdecl __attribute__((target(SIMD_TARGET))) SIMD_FUNC(memchr)(const void *ptr, int c, size_t n)
+{
+    const simd_vec *p = (const simd_vec *)((ULONG_PTR)ptr & ~(SIMD_SIZE - 1));
+    const simd_vec match = (simd_vec){0} + (unsigned char)c;
+    size_t left = SIMD_SIZE - ((ULONG_PTR)ptr & (SIMD_SIZE - 1));
+    unsigned int mask;
+
+    if (!n) return NULL;
+
+    mask = SIMD_MOVEMASK(*p == match) >> ((ULONG_PTR)ptr & (SIMD_SIZE - 1));
+    if (mask) return __builtin_ctz(mask) < n ? (char *)ptr + __builtin_ctz(mask) : NULL;
+
+    /* every further block starts with at least one byte of the buffer */
+    for (n = n > left ? n - left : 0; n; n = n > SIMD_SIZE ? n - SIMD_SIZE : 0)
+    {
+        p++;
+        if ((mask = SIMD_MOVEMASK(*p == match)))
+            return __builtin_ctz(mask) < n ? (char *)p + __builtin_ctz(mask) : NULL;
+    }
+    return NULL;
+}
+
+static int __cdecl __attribute__((target(SIMD_TARGET))) SIMD_FUNC(memcmp)(const void *ptr1, const void *ptr2, size_t n)
+{
+    const unsigned char *p1 = ptr1, *p2 = ptr2;
+    unsigned int mask;
+
+    if (n < SIMD_SIZE)
+    {
+        for (; n; n--, p1++, p2++)
+            if (*p1 != *p2) return *p1 < *p2 ? -1 : 1;
+        return 0;
+    }
+
+    for (; n >= SIMD_SIZE; n -= SIMD_SIZE, p1 += SIMD_SIZE, p2 += SIMD_SIZE)
+    {
+        if ((mask = SIMD_MOVEMASK(*(const simd_uvec *)p1 != *(const simd_uvec *)p2)))
+            goto done;
+    }
+    if (!n) return 0;
+
+    /* the overlapping bytes are known to be equal */
+    p1 -= SIMD_SIZE - n;
+    p2 -= SIMD_SIZE - n;
+    if (!(mask = SIMD_MOVEMASK(*(const simd_uvec *)p1 != *(const simd_uvec *)p2)))
+        return 0;
+
+done:
+    p1 += __builtin_ctz(mask);
+    p2 += __builtin_ctz(mask);
+    return *p1 < *p2 ? -1 : 1;
+}
+
+static void __cdecl __attribute__((target(SIMD_TARGET))) SIMD_FUNC(memset_aligned_32)(unsigned char *d, unsigned char c, size_t n)
+{
+    const simd_vec v = (simd_vec){0} + c;
+    unsigned char *end = d + n;
+
+    while (d < end)
+    {
+        *(simd_vec *)d = v;
+#if SIMD_SIZE < 32
+        *(simd_vec *)(d + 16) = v;
+#endif
+        d += 32;
+    }
+}
+
+#endif /* SIMD_WIDE */
+
+#undef SIMD_SIZE
+#undef SIMD_TARGET
+#undef SIMD_MOVEMASK
+#undef SIMD_FUNC
+#undef SIMD_CHAR
+#undef SIMD_ELEM
+#undef SIMD_STR
+#undef SIMD_PAGE_SIZE
+#undef SIMD_CROSSES_PAGE
+#undef simd_vec8
+#undef simd_vec
+#undef simd_uvec
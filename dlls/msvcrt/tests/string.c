@@ -58,7 +58,14 @@ static char *buf_to_string(const unsigned char *bin, int len, int nr)
 static void* (__cdecl *pmemcpy)(void *, const void *, size_t n);
 static int (__cdecl *p_memcpy_s)(void *, size_t, const void *, size_t);
 static int (__cdecl *p_memmove_s)(void *, size_t, const void *, size_t);
-static int* (__cdecl *pmemcmp)(void *, const void *, size_t n);
+static int (__cdecl *pmemcmp)(const void *, const void *, size_t n);
+static void* (__cdecl *p_memchr)(const void *, int, size_t);
+static void* (__cdecl *p_memset)(void *, int, size_t);
+static size_t (__cdecl *p_strlen)(const char *);
+static char* (__cdecl *p_strchr)(const char *, int);
+static size_t (__cdecl *p_wcslen)(const wchar_t *);
+static wchar_t* (__cdecl *p_wcschr)(const wchar_t *, wchar_t);
+static int (__cdecl *p_wcscmp)(const wchar_t *, const wchar_t *);
 static int (__cdecl *p_strcmp)(const char *, const char *);
 static int (__cdecl *p_strncmp)(const char *, const char *, size_t);
 static int (__cdecl *p_strcpy)(char *dst, const char *src);
@@ -4271,6 +4278,189 @@ static void test_wcscmp(void)
     ok(!r, "wcscmp returned %d\n", r);
 }
 
+static unsigned int fuzz_seed;
+
+static unsigned int fuzz_rand(void)
+{
+    fuzz_seed = fuzz_seed * 1103515245 + 12345;
+    return fuzz_seed >> 16;
+}
+
+static int sign(int x)
+{
+    return x < 0 ? -1 : x > 0;
+}
+
+static size_t ref_strlen(const char *str)
+{
+    const char *s = str;
+    while (*s) s++;
+    return s - str;
+}
+
+static const char *ref_strchr(const char *str, char c)
+{
+    do { if (*str == c) return str; } while (*str++);
+    return NULL;
+}
+
+static int ref_strcmp(const unsigned char *str1, const unsigned char *str2)
+{
+    while (*str1 && *str1 == *str2) { str1++; str2++; }
+    return *str1 < *str2 ? -1 : *str1 > *str2;
+}
+
+static const void *ref_memchr(const unsigned char *ptr, unsigned char c, size_t n)
+{
+    for (; n; n--, ptr++) if (*ptr == c) return ptr;
+    return NULL;
+}
+
+static int ref_memcmp(const unsigned char *ptr1, const unsigned char *ptr2, size_t n)
+{
+    for (; n; n--, ptr1++, ptr2++) if (*ptr1 != *ptr2) return *ptr1 < *ptr2 ? -1 : 1;
+    return 0;
+}
+
+static size_t ref_wcslen(const wchar_t *str)
+{
+    const wchar_t *s = str;
+    while (*s) s++;
+    return s - str;
+}
+
+static const wchar_t *ref_wcschr(const wchar_t *str, wchar_t c)
+{
+    do { if (*str == c) return str; } while (*str++);
+    return NULL;
+}
+
+static int ref_wcscmp(const wchar_t *str1, const wchar_t *str2)
+{
+    while (*str1 && *str1 == *str2) { str1++; str2++; }
+    return *str1 < *str2 ? -1 : *str1 > *str2;
+}
+
+static void benchmark_string(char *buf, size_t size)
+{
+    LARGE_INTEGER freq, start, end;
+    volatile size_t res = 0;
+    unsigned int i, count = 2000;
+    double ref, crt;
+
+    memset(buf, 'a', size - 2);
+    buf[size - 2] = buf[size - 1] = 0;
+    QueryPerformanceFrequency(&freq);
+
+#define BENCH(name, ref_call, crt_call) \
+    QueryPerformanceCounter(&start); \
+    for (i = 0; i < count; i++) res += (size_t)(ref_call); \
+    QueryPerformanceCounter(&end); \
+    ref = (end.QuadPart - start.QuadPart) * 1e9 / freq.QuadPart / count; \
+    QueryPerformanceCounter(&start); \
+    for (i = 0; i < count; i++) res += (size_t)(crt_call); \
+    QueryPerformanceCounter(&end); \
+    crt = (end.QuadPart - start.QuadPart) * 1e9 / freq.QuadPart / count; \
+    trace("%-7s %Iu bytes: %10.0f ns, scalar %10.0f ns\n", name, size, crt, ref)
+
+    BENCH("strlen", ref_strlen(buf), p_strlen(buf));
+    BENCH("strchr", ref_strchr(buf, 'b'), p_strchr(buf, 'b'));
+    BENCH("strcmp", ref_strcmp((unsigned char *)buf, (unsigned char *)buf + 1), p_strcmp(buf, buf + 1));
+    BENCH("memchr", ref_memchr((unsigned char *)buf, 'b', size), p_memchr(buf, 'b', size));
+    BENCH("memcmp", ref_memcmp((unsigned char *)buf, (unsigned char *)buf + 1, size - 1),
+            pmemcmp(buf, buf + 1, size - 1));
+    BENCH("wcslen", ref_wcslen((wchar_t *)buf), p_wcslen((wchar_t *)buf));
+#undef BENCH
+}
+
+static void test_string_fuzz(void)
+{
+    SYSTEM_INFO si;
+    unsigned char *mem, *end, *s1, *s2, *m;
+    wchar_t *w1, *w2;
+    size_t len, off, n, i;
+    unsigned int iter;
+    DWORD old_prot;
+    int c, r;
+
+    GetSystemInfo(&si);
+    mem = VirtualAlloc(NULL, si.dwPageSize * 3, MEM_COMMIT, PAGE_READWRITE);
+    ok(mem != NULL, "VirtualAlloc failed\n");
+    /* strings ending right before the guard page catch overreads */
+    VirtualProtect(mem + si.dwPageSize * 2, si.dwPageSize, PAGE_NOACCESS, &old_prot);
+    end = mem + si.dwPageSize * 2;
+
+    fuzz_seed = 0xdeadbeef;
+    for (iter = 0; iter < 20000; iter++)
+    {
+        len = fuzz_rand() % 160;
+        off = fuzz_rand() % 64;
+
+        s1 = (iter & 1) ? end - len - 1 - off : mem + si.dwPageSize + fuzz_rand() % 512;
+        for (i = 0; i < len; i++) s1[i] = 0x7e + fuzz_rand() % 4;
+        s1[len] = 0;
+        s2 = end - len - 1;
+        memmove(s2, s1, len + 1);
+        s1 = memmove(mem + si.dwPageSize - (fuzz_rand() % 64), s2, len + 1);
+        if (len && (fuzz_rand() & 1)) s2[fuzz_rand() % len] = 0x7e + fuzz_rand() % 4;
+        if (len && !(fuzz_rand() % 4)) s2[fuzz_rand() % len] = 0;
+        c = 0x7e + fuzz_rand() % 5;
+        if (!(fuzz_rand() % 8)) c = 0;
+
+        ok(p_strlen((char *)s2) == ref_strlen((char *)s2), "%u: strlen returned %Iu\n",
+                iter, p_strlen((char *)s2));
+        ok(p_strchr((char *)s2, c) == ref_strchr((char *)s2, c), "%u: strchr(%#x) returned %p, expected %p\n",
+                iter, c, p_strchr((char *)s2, c), ref_strchr((char *)s2, c));
+        r = ref_strcmp(s1, s2);
+        ok(p_strcmp((char *)s1, (char *)s2) == r, "%u: strcmp returned %d, expected %d\n",
+                iter, p_strcmp((char *)s1, (char *)s2), r);
+        ok(p_strcmp((char *)s2, (char *)s1) == -r, "%u: strcmp returned %d, expected %d\n",
+                iter, p_strcmp((char *)s2, (char *)s1), -r);
+
+        n = fuzz_rand() % (len + 2);
+        m = end - n;
+        memmove(m, s1, n);
+        ok(p_memchr(m, c, n) == ref_memchr(m, c, n), "%u: memchr returned %p, expected %p\n",
+                iter, p_memchr(m, c, n), ref_memchr(m, c, n));
+        ok(p_memchr(s1, c, n) == ref_memchr(s1, c, n), "%u: memchr returned %p, expected %p\n",
+                iter, p_memchr(s1, c, n), ref_memchr(s1, c, n));
+        r = ref_memcmp(m, s2, n);
+        ok(sign(pmemcmp(m, s2, n)) == r, "%u: memcmp returned %d, expected %d\n",
+                iter, pmemcmp(m, s2, n), r);
+
+        n = len / 2;
+        w1 = (wchar_t *)(end - (n + 1) * sizeof(wchar_t) - (fuzz_rand() % 16) * sizeof(wchar_t));
+        for (i = 0; i < n; i++) w1[i] = 0x7ffe + fuzz_rand() % 4;
+        w1[n] = 0;
+        w2 = memmove(end - (n + 1) * sizeof(wchar_t), w1, (n + 1) * sizeof(wchar_t));
+        w1 = memmove(mem + si.dwPageSize - (fuzz_rand() % 32) * sizeof(wchar_t), w2, (n + 1) * sizeof(wchar_t));
+        if (n && (fuzz_rand() & 1)) w2[fuzz_rand() % n] = 0x7ffe + fuzz_rand() % 4;
+        c = w2[fuzz_rand() % (n + 1)];
+
+        ok(p_wcslen(w2) == ref_wcslen(w2), "%u: wcslen returned %Iu\n", iter, p_wcslen(w2));
+        ok(p_wcschr(w2, c) == ref_wcschr(w2, c), "%u: wcschr(%#x) returned %p, expected %p\n",
+                iter, c, p_wcschr(w2, c), ref_wcschr(w2, c));
+        r = ref_wcscmp(w1, w2);
+        ok(p_wcscmp(w1, w2) == r, "%u: wcscmp returned %d, expected %d\n", iter, p_wcscmp(w1, w2), r);
+
+        n = fuzz_rand() % 300;
+        off = fuzz_rand() % 64;
+        memset(mem, 0x55, 512);
+        p_memset(mem + off, 0xaa, n);
+        for (i = 0; i < 512; i++)
+            if (mem[i] != (i >= off && i < off + n ? 0xaa : 0x55)) break;
+        ok(i == 512, "%u: memset(%Iu, %Iu) wrote wrong byte at %Iu\n", iter, off, n, i);
+    }
+
+    if (winetest_debug > 1)
+    {
+        benchmark_string((char *)mem, 64);
+        benchmark_string((char *)mem, si.dwPageSize);
+    }
+
+    VirtualFree(mem, 0, MEM_RELEASE);
+}
+
 static const char* debugstr_ldouble(_LDOUBLE *v)
 {
     static char buf[2 * ARRAY_SIZE(v->ld) + 1];
@@ -4496,6 +4686,13 @@ START_TEST(string)
     SET(p_strcpy, "strcpy");
     SET(p_strcmp, "strcmp");
     SET(p_strncmp, "strncmp");
+    SET(p_memchr, "memchr");
+    SET(p_memset, "memset");
+    SET(p_strlen, "strlen");
+    SET(p_strchr, "strchr");
+    SET(p_wcslen, "wcslen");
+    SET(p_wcschr, "wcschr");
+    SET(p_wcscmp, "wcscmp");
     pstrcpy_s = (void *)GetProcAddress( hMsvcrt,"strcpy_s" );
     pstrcat_s = (void *)GetProcAddress( hMsvcrt,"strcat_s" );
     p_mbscat_s = (void*)GetProcAddress( hMsvcrt, "_mbscat_s" );
@@ -4633,4 +4830,5 @@ START_TEST(string)
     test_SpecialCasing();
     test__mbbtype();
     test_wcsncpy();
+    test_string_fuzz();
 }
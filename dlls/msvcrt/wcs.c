@@ -49,6 +49,17 @@ static BOOL n_format_enabled = TRUE;
 #include "printf.h"
 #undef PRINTF_WIDE
 
+#if defined(__i386__) || defined(__x86_64__)
+#define SIMD_WIDE
+#include "string_simd.h"
+#ifdef USE_AVX2
+#define SIMD_AVX2
+#include "string_simd.h"
+#undef SIMD_AVX2
+#endif
+#undef SIMD_WIDE
+#endif
+
 #if _MSVCR_VER>=80
 
 /*********************************************************************
@@ -1868,6 +1879,12 @@ int WINAPIV _swprintf_p_l(wchar_t *buffer, size_t length,
  */
 int CDECL wcscmp(const wchar_t *str1, const wchar_t *str2)
 {
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef USE_AVX2
+    if (avx2_supported) return avx2_wcscmp(str1, str2);
+#endif
+    if (sse2_supported) return sse2_wcscmp(str1, str2);
+#endif
     while (*str1 && (*str1 == *str2))
     {
         str1++;
@@ -2857,6 +2874,16 @@ wint_t CDECL towupper(wint_t c)
  */
 wchar_t* CDECL wcschr(const wchar_t *str, wchar_t ch)
 {
+#if defined(__i386__) || defined(__x86_64__)
+    /* the vector code needs the characters aligned to their size */
+    if (!((ULONG_PTR)str & 1))
+    {
+#ifdef USE_AVX2
+        if (avx2_supported) return avx2_wcschr(str, ch);
+#endif
+        if (sse2_supported) return sse2_wcschr(str, ch);
+    }
+#endif
     do { if (*str == ch) return (WCHAR *)(ULONG_PTR)str; } while (*str++);
     return NULL;
 }
@@ -2877,6 +2904,16 @@ wchar_t* CDECL wcsrchr(const wchar_t *str, wchar_t ch)
 size_t CDECL wcslen(const wchar_t *str)
 {
     const wchar_t *s = str;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (!((ULONG_PTR)str & 1))
+    {
+#ifdef USE_AVX2
+        if (avx2_supported) return avx2_wcslen(str);
+#endif
+        if (sse2_supported) return sse2_wcslen(str);
+    }
+#endif
     while (*s) s++;
     return s - str;
 }
@@ -36,6 +36,7 @@
 #include "wine/exception.h"
 #include "wine/debug.h"
 #include "wine/list.h"
+#include "wine/rbtree.h"
 #include "ntdll_misc.h"
 #include "ddk/wdm.h"
 
@@ -91,6 +92,7 @@ static const WCHAR system_path[] = L"C:\\windows\\system32;C:\\windows\\system;C
 
 static BOOL is_prefix_bootstrap;  /* are we bootstrapping the prefix? */
 static BOOL imports_fixup_done = FALSE;  /* set once the imports have been fixed up, before attaching them */
+static BOOL startup_trace_enabled;      /* WINESTARTUPTRACE is set */
 static BOOL process_detaching = FALSE;  /* set on process detach to avoid deadlocks with thread detach */
 static int free_lib_count;   /* recursion depth of LdrUnloadDll calls */
 static ULONG path_safe_mode;  /* path mode set by RtlSetSearchPathMode */
@@ -139,8 +141,28 @@ typedef struct _wine_modref
     struct file_id        id;
     ULONG                 CheckSum;
     BOOL                  system;
+    ULONG                 fullname_hash;   /* hash of the full name, ldr.BaseNameHashValue for the base name */
+    LIST_ENTRY            fullname_links;  /* entry in the full name hash table */
+    struct wine_rb_entry  base_entry;      /* entry in the base address tree */
 } WINE_MODREF;
 
+/* hash tables for module lookups by name, the base name one uses ldr.HashLinks like Windows does */
+#define MODULE_HASH_SIZE 128
+static LIST_ENTRY basename_hash_table[MODULE_HASH_SIZE];
+static LIST_ENTRY fullname_hash_table[MODULE_HASH_SIZE];
+
+/* address range index of the loaded modules */
+static int module_base_compare( const void *addr, const struct wine_rb_entry *entry )
+{
+    const WINE_MODREF *wm = WINE_RB_ENTRY_VALUE( entry, const WINE_MODREF, base_entry );
+
+    if ((const char *)addr < (const char *)wm->ldr.DllBase) return -1;
+    if ((const char *)addr >= (const char *)wm->ldr.DllBase + wm->ldr.SizeOfImage) return 1;
+    return 0;
+}
+
+static struct wine_rb_tree module_base_tree = { module_base_compare };
+
 static UINT tls_module_count;      /* number of modules with TLS directory */
 static IMAGE_TLS_DIRECTORY *tls_dirs;  /* array of TLS directories */
 LIST_ENTRY tls_links = { &tls_links, &tls_links };
@@ -183,13 +205,15 @@ static PEB_LDR_DATA ldr =
 static RTL_BITMAP tls_bitmap;
 static RTL_BITMAP tls_expansion_bitmap;
 
-static WINE_MODREF *cached_modref;
 static WINE_MODREF *current_modref;
 static WINE_MODREF *last_failed_modref;
 
 static LDR_DDAG_NODE *node_ntdll, *node_kernel32;
 
 static NTSTATUS load_dll( const WCHAR *load_path, const WCHAR *libname, DWORD flags, WINE_MODREF** pwm, BOOL system );
+static void queue_import_prefetch( WINE_MODREF *wm, const IMAGE_IMPORT_DESCRIPTOR *imports,
+                                   int nb_imports, LPCWSTR load_path );
+static void flush_import_prefetch( const WINE_MODREF *wm );
 static NTSTATUS process_attach( LDR_DDAG_NODE *node, LPVOID lpReserved );
 static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
                                     DWORD exp_size, DWORD ordinal, LPCWSTR load_path );
@@ -507,6 +531,70 @@ static void call_ldr_notifications( ULONG reason, LDR_DATA_TABLE_ENTRY *module )
     }
 }
 
+/*************************************************************************
+ *		hash_module_name
+ *
+ * Case-insensitive hash of a module name, same as the Windows BaseNameHashValue.
+ */
+static ULONG hash_module_name( const UNICODE_STRING *name )
+{
+    ULONG hash = 0;
+
+    RtlHashUnicodeString( name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash );
+    return hash;
+}
+
+
+/*************************************************************************
+ *		init_module_index
+ *
+ * Initialize the module lookup indices.
+ */
+static void init_module_index(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < MODULE_HASH_SIZE; i++)
+    {
+        InitializeListHead( &basename_hash_table[i] );
+        InitializeListHead( &fullname_hash_table[i] );
+    }
+}
+
+
+/*************************************************************************
+ *		add_module_index
+ *
+ * Add a module to the lookup indices, along with the PEB lists.
+ * The loader_section must be locked while calling this function.
+ */
+static void add_module_index( WINE_MODREF *wm )
+{
+    wm->ldr.BaseNameHashValue = hash_module_name( &wm->ldr.BaseDllName );
+    wm->fullname_hash = hash_module_name( &wm->ldr.FullDllName );
+    InsertTailList( &basename_hash_table[wm->ldr.BaseNameHashValue % MODULE_HASH_SIZE], &wm->ldr.HashLinks );
+    InsertTailList( &fullname_hash_table[wm->fullname_hash % MODULE_HASH_SIZE], &wm->fullname_links );
+    if (wine_rb_put( &module_base_tree, wm->ldr.DllBase, &wm->base_entry ))
+        ERR( "module %p %s overlaps with an existing module\n",
+             wm->ldr.DllBase, debugstr_w(wm->ldr.FullDllName.Buffer) );
+}
+
+
+/*************************************************************************
+ *		remove_module_index
+ *
+ * Remove a module from the lookup indices, along with the PEB lists.
+ * The loader_section must be locked while calling this function.
+ */
+static void remove_module_index( WINE_MODREF *wm )
+{
+    RemoveEntryList( &wm->ldr.HashLinks );
+    RemoveEntryList( &wm->fullname_links );
+    if (wine_rb_get( &module_base_tree, wm->ldr.DllBase ) == &wm->base_entry)
+        wine_rb_remove( &module_base_tree, &wm->base_entry );
+}
+
+
 /*************************************************************************
  *		get_modref
  *
@@ -515,19 +603,12 @@ static void call_ldr_notifications( ULONG reason, LDR_DATA_TABLE_ENTRY *module )
  */
 static WINE_MODREF *get_modref( HMODULE hmod )
 {
-    PLIST_ENTRY mark, entry;
-    PLDR_DATA_TABLE_ENTRY mod;
-
-    if (cached_modref && cached_modref->ldr.DllBase == hmod) return cached_modref;
+    struct wine_rb_entry *entry = wine_rb_get( &module_base_tree, hmod );
+    WINE_MODREF *wm;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList;
-    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
-    {
-        mod = CONTAINING_RECORD(entry, LDR_DATA_TABLE_ENTRY, InMemoryOrderLinks);
-        if (mod->DllBase == hmod)
-            return cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
-    }
-    return NULL;
+    if (!entry) return NULL;
+    wm = WINE_RB_ENTRY_VALUE( entry, WINE_MODREF, base_entry );
+    return wm->ldr.DllBase == hmod ? wm : NULL;
 }
 
 
@@ -541,21 +622,18 @@ static WINE_MODREF *find_basename_module( LPCWSTR name )
 {
     PLIST_ENTRY mark, entry;
     UNICODE_STRING name_str;
+    ULONG hash;
 
     RtlInitUnicodeString( &name_str, name );
+    hash = hash_module_name( &name_str );
 
-    if (cached_modref && RtlEqualUnicodeString( &name_str, &cached_modref->ldr.BaseDllName, TRUE ))
-        return cached_modref;
-
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
+    mark = &basename_hash_table[hash % MODULE_HASH_SIZE];
     for (entry = mark->Flink; entry != mark; entry = entry->Flink)
     {
-        WINE_MODREF *mod = CONTAINING_RECORD(entry, WINE_MODREF, ldr.InLoadOrderLinks);
-        if (RtlEqualUnicodeString( &name_str, &mod->ldr.BaseDllName, TRUE ) && !mod->system)
-        {
-            cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
-            return cached_modref;
-        }
+        WINE_MODREF *mod = CONTAINING_RECORD(entry, WINE_MODREF, ldr.HashLinks);
+        if (mod->ldr.BaseNameHashValue == hash && !mod->system &&
+            RtlEqualUnicodeString( &name_str, &mod->ldr.BaseDllName, TRUE ))
+            return mod;
     }
     return NULL;
 }
@@ -571,23 +649,19 @@ static WINE_MODREF *find_fullname_module( const UNICODE_STRING *nt_name )
 {
     PLIST_ENTRY mark, entry;
     UNICODE_STRING name = *nt_name;
+    ULONG hash;
 
     if (name.Length <= 4 * sizeof(WCHAR)) return NULL;
     name.Length -= 4 * sizeof(WCHAR);  /* for \??\ prefix */
     name.Buffer += 4;
+    hash = hash_module_name( &name );
 
-    if (cached_modref && RtlEqualUnicodeString( &name, &cached_modref->ldr.FullDllName, TRUE ))
-        return cached_modref;
-
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
+    mark = &fullname_hash_table[hash % MODULE_HASH_SIZE];
     for (entry = mark->Flink; entry != mark; entry = entry->Flink)
     {
-        LDR_DATA_TABLE_ENTRY *mod = CONTAINING_RECORD(entry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks);
-        if (RtlEqualUnicodeString( &name, &mod->FullDllName, TRUE ))
-        {
-            cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
-            return cached_modref;
-        }
+        WINE_MODREF *mod = CONTAINING_RECORD(entry, WINE_MODREF, fullname_links);
+        if (mod->fullname_hash == hash && RtlEqualUnicodeString( &name, &mod->ldr.FullDllName, TRUE ))
+            return mod;
     }
     return NULL;
 }
@@ -603,19 +677,13 @@ static WINE_MODREF *find_fileid_module( const struct file_id *id )
 {
     LIST_ENTRY *mark, *entry;
 
-    if (cached_modref && !memcmp( &cached_modref->id, id, sizeof(*id) )) return cached_modref;
-
     mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
     for (entry = mark->Flink; entry != mark; entry = entry->Flink)
     {
         LDR_DATA_TABLE_ENTRY *mod = CONTAINING_RECORD( entry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks );
         WINE_MODREF *wm = CONTAINING_RECORD( mod, WINE_MODREF, ldr );
 
-        if (!memcmp( &wm->id, id, sizeof(*id) ))
-        {
-            cached_modref = wm;
-            return wm;
-        }
+        if (!memcmp( &wm->id, id, sizeof(*id) )) return wm;
     }
     return NULL;
 }
@@ -952,6 +1020,84 @@ void * WINAPI RtlFindExportedRoutineByName( HMODULE module, const char *name )
 }
 
 
+/*************************************************************************
+ *		is_bound_module_valid
+ *
+ * Check that a module is the one a bound import table was bound against.
+ */
+static BOOL is_bound_module_valid( const WINE_MODREF *wm, DWORD timestamp )
+{
+    return wm->ldr.TimeDateStamp == timestamp && (ULONG_PTR)wm->ldr.DllBase == wm->ldr.OriginalBase;
+}
+
+
+/*************************************************************************
+ *		is_import_bound
+ *
+ * Check if the import address table of a descriptor has been bound against
+ * the imported dll, in which case it can be used as is. The dlls that bound
+ * entries are forwarded to then become dependencies of the current module.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL is_import_bound( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr,
+                             const char *name, const WINE_MODREF *imp )
+{
+    const IMAGE_BOUND_IMPORT_DESCRIPTOR *bound, *ptr;
+    const IMAGE_BOUND_FORWARDER_REF *ref;
+    const char *end, *mod_name;
+    WCHAR buffer[256];
+    WINE_MODREF *wm;
+    DWORD size;
+    unsigned int i;
+
+    if (!descr->TimeDateStamp) return FALSE;
+    /* relay and snoop need their own thunks in the import table */
+    if (TRACE_ON(relay) || TRACE_ON(snoop)) return FALSE;
+
+    if (descr->TimeDateStamp != ~0u)  /* old style binding */
+        return descr->ForwarderChain == ~0u && is_bound_module_valid( imp, descr->TimeDateStamp );
+
+    if (!(bound = RtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_BOUND_IMPORT, &size )))
+        return FALSE;
+    end = (const char *)bound + size;
+
+    for (ptr = bound; (const char *)(ptr + 1) <= end && ptr->OffsetModuleName; )
+    {
+        ref = (const IMAGE_BOUND_FORWARDER_REF *)(ptr + 1);
+        if ((const char *)(ref + ptr->NumberOfModuleForwarderRefs) > end) return FALSE;
+        if (ptr->OffsetModuleName >= size) return FALSE;
+        mod_name = (const char *)bound + ptr->OffsetModuleName;
+        if (!_stricmp( mod_name, name ))
+        {
+            if (!is_bound_module_valid( imp, ptr->TimeDateStamp )) return FALSE;
+
+            /* the forwarded entries point into other dlls, check them too */
+            for (i = 0; i < ptr->NumberOfModuleForwarderRefs; i++)
+            {
+                if (ref[i].OffsetModuleName >= size) return FALSE;
+                mod_name = (const char *)bound + ref[i].OffsetModuleName;
+                if (build_import_name( buffer, mod_name, strlen(mod_name) )) return FALSE;
+                if (!(wm = find_basename_module( buffer ))) return FALSE;
+                if (!is_bound_module_valid( wm, ref[i].TimeDateStamp )) return FALSE;
+            }
+
+            /* reference the forwarded dlls like find_forwarded_export does */
+            for (i = 0; i < ptr->NumberOfModuleForwarderRefs; i++)
+            {
+                mod_name = (const char *)bound + ref[i].OffsetModuleName;
+                build_import_name( buffer, mod_name, strlen(mod_name) );
+                wm = find_basename_module( buffer );
+                if (wm->ldr.LoadCount != -1) wm->ldr.LoadCount++;
+                add_module_dependency( current_modref->ldr.DdagNode, wm->ldr.DdagNode );
+            }
+            return TRUE;
+        }
+        ptr = (const IMAGE_BOUND_IMPORT_DESCRIPTOR *)(ref + ptr->NumberOfModuleForwarderRefs);
+    }
+    return FALSE;
+}
+
+
 /*************************************************************************
  *		import_dll
  *
@@ -1010,6 +1156,13 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
         return FALSE;
     }
 
+    if (is_import_bound( module, descr, name, wmImp ))
+    {
+        TRACE_(imports)( "--- using bound imports from %s\n", name );
+        *pwm = wmImp;
+        return TRUE;
+    }
+
     /* unprotect the import address table since it can be located in
      * readonly section */
     while (import_list[protect_size].u1.Ordinal) protect_size++;
@@ -1323,6 +1476,9 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     /* load the imported modules. They are automatically
      * added to the modref list of the process.
      */
+    /* open the not yet loaded dependencies in parallel, then load them in order */
+    queue_import_prefetch( wm, imports, nb_imports, load_path );
+
     prev = current_modref;
     current_modref = wm;
     status = STATUS_SUCCESS;
@@ -1340,6 +1496,7 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
         }
     }
     current_modref = prev;
+    flush_import_prefetch( wm );
     if (wm->ldr.ActivationContext) RtlDeactivateActivationContext( 0, cookie );
     return status;
 }
@@ -1402,6 +1559,7 @@ static WINE_MODREF *alloc_module( HMODULE hModule, const UNICODE_STRING *nt_name
                    &wm->ldr.InLoadOrderLinks);
     InsertTailList(&NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList,
                    &wm->ldr.InMemoryOrderLinks);
+    add_module_index( wm );
     /* wait until init is called for inserting into InInitializationOrderModuleList */
 
     if (!(nt->OptionalHeader.DllCharacteristics & IMAGE_DLLCHARACTERISTICS_NX_COMPAT))
@@ -1548,6 +1706,23 @@ static NTSTATUS MODULE_InitDLL( WINE_MODREF *wm, UINT reason, LPVOID lpReserved
 }
 
 
+/*************************************************************************
+ *		trace_module_stage
+ *
+ * Record a startup stage named after a module in the startup trace.
+ */
+static void trace_module_stage( const WINE_MODREF *wm, unsigned int type )
+{
+    char name[64];
+    DWORD len;
+
+    if (!startup_trace_enabled) return;
+    RtlUnicodeToUTF8N( name, sizeof(name) - 1, &len, wm->ldr.BaseDllName.Buffer, wm->ldr.BaseDllName.Length );
+    name[len] = 0;
+    __wine_startup_trace( name, type );
+}
+
+
 /*************************************************************************
  *		process_attach
  *
@@ -1617,7 +1792,9 @@ static NTSTATUS process_attach( LDR_DDAG_NODE *node, LPVOID lpReserved )
         current_modref = wm;
 
         call_ldr_notifications( LDR_DLL_NOTIFICATION_REASON_LOADED, &wm->ldr );
+        trace_module_stage( wm, __WINE_STARTUP_TRACE_BEGIN );
         status = MODULE_InitDLL( wm, DLL_PROCESS_ATTACH, lpReserved );
+        trace_module_stage( wm, __WINE_STARTUP_TRACE_END );
         if (status == STATUS_SUCCESS)
         {
             wm->ldr.Flags |= LDR_PROCESS_ATTACHED;
@@ -1735,21 +1912,11 @@ NTSTATUS WINAPI LdrDisableThreadCalloutsForDll(HMODULE hModule)
  */
 NTSTATUS WINAPI LdrFindEntryForAddress( const void *addr, PLDR_DATA_TABLE_ENTRY *pmod )
 {
-    PLIST_ENTRY mark, entry;
-    PLDR_DATA_TABLE_ENTRY mod;
+    struct wine_rb_entry *entry = wine_rb_get( &module_base_tree, addr );
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
-    for (entry = mark->Blink; entry != mark; entry = entry->Blink)
-    {
-        mod = CONTAINING_RECORD(entry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks);
-        if (mod->DllBase <= addr &&
-            (const char *)addr < (char*)mod->DllBase + mod->SizeOfImage)
-        {
-            *pmod = mod;
-            return STATUS_SUCCESS;
-        }
-    }
-    return STATUS_NO_MORE_ENTRIES;
+    if (!entry) return STATUS_NO_MORE_ENTRIES;
+    *pmod = &WINE_RB_ENTRY_VALUE( entry, WINE_MODREF, base_entry )->ldr;
+    return STATUS_SUCCESS;
 }
 
 /******************************************************************
@@ -2138,9 +2305,11 @@ static NTSTATUS build_module( LPCWSTR load_path, const UNICODE_STRING *nt_name,
     WINE_MODREF *wm;
     NTSTATUS status;
     SIZE_T map_size;
+    ULONG_PTR orig_base;
 
     if (!(nt = RtlImageNtHeader( *module ))) return STATUS_INVALID_IMAGE_FORMAT;
 
+    orig_base = nt->OptionalHeader.ImageBase;
     map_size = (nt->OptionalHeader.SizeOfImage + page_size - 1) & ~(page_size - 1);
     if ((status = perform_relocations( *module, nt, map_size ))) return status;
 
@@ -2152,6 +2321,11 @@ static NTSTATUS build_module( LPCWSTR load_path, const UNICODE_STRING *nt_name,
     if (!(wm = alloc_module( *module, nt_name, is_builtin ))) return STATUS_NO_MEMORY;
 
     if (id) wm->id = *id;
+    /* the header base has already been updated if the image got relocated when mapped */
+    if (image_info->TransferAddress)
+        wm->ldr.OriginalBase = (ULONG_PTR)image_info->TransferAddress - nt->OptionalHeader.AddressOfEntryPoint;
+    else
+        wm->ldr.OriginalBase = orig_base;
     if (image_info->LoaderFlags) wm->ldr.Flags |= LDR_COR_IMAGE;
     if (image_info->u.s.ComPlusILOnly) wm->ldr.Flags |= LDR_COR_ILONLY;
     wm->system = system;
@@ -2173,6 +2347,7 @@ static NTSTATUS build_module( LPCWSTR load_path, const UNICODE_STRING *nt_name,
             /* the module has only be inserted in the load & memory order lists */
             RemoveEntryList(&wm->ldr.InLoadOrderLinks);
             RemoveEntryList(&wm->ldr.InMemoryOrderLinks);
+            remove_module_index( wm );
 
             /* FIXME: there are several more dangling references
              * left. Including dlls loaded by this dll before the
@@ -2509,23 +2684,18 @@ static NTSTATUS get_dll_load_path_search_flags( LPCWSTR module, DWORD flags, WCH
 }
 
 
-/***********************************************************************
- *	open_dll_file
+/******************************************************************************
+ *	open_dll_handle
  *
- * Open a file for a new dll. Helper for find_dll_file.
+ * Open a dll file and retrieve its file id. Doesn't depend on the loader state.
  */
-static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm, HANDLE *mapping,
-                               SECTION_IMAGE_INFORMATION *image_info, struct file_id *id )
+static NTSTATUS open_dll_handle( UNICODE_STRING *nt_name, HANDLE *handle, struct file_id *id, BOOL *has_id )
 {
     FILE_BASIC_INFORMATION info;
     OBJECT_ATTRIBUTES attr;
     IO_STATUS_BLOCK io;
-    LARGE_INTEGER size;
     FILE_OBJECTID_BUFFER fid;
     NTSTATUS status;
-    HANDLE handle;
-
-    if ((*pwm = find_fullname_module( nt_name ))) return STATUS_SUCCESS;
 
     attr.Length = sizeof(attr);
     attr.RootDirectory = 0;
@@ -2533,7 +2703,7 @@ static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm, HANDL
     attr.ObjectName = nt_name;
     attr.SecurityDescriptor = NULL;
     attr.SecurityQualityOfService = NULL;
-    if ((status = NtOpenFile( &handle, GENERIC_READ | SYNCHRONIZE, &attr, &io,
+    if ((status = NtOpenFile( handle, GENERIC_READ | SYNCHRONIZE, &attr, &io,
                               FILE_SHARE_READ | FILE_SHARE_DELETE,
                               FILE_SYNCHRONOUS_IO_NONALERT | FILE_NON_DIRECTORY_FILE )))
     {
@@ -2548,17 +2718,22 @@ static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm, HANDL
         return STATUS_DLL_NOT_FOUND;
     }
 
-    if (!NtFsControlFile( handle, 0, NULL, NULL, &io, FSCTL_GET_OBJECT_ID, NULL, 0, &fid, sizeof(fid) ))
-    {
-        memcpy( id, fid.ObjectId, sizeof(*id) );
-        if ((*pwm = find_fileid_module( id )))
-        {
-            TRACE( "%s is the same file as existing module %p %s\n", debugstr_w( nt_name->Buffer ),
-                   (*pwm)->ldr.DllBase, debugstr_w( (*pwm)->ldr.FullDllName.Buffer ));
-            NtClose( handle );
-            return STATUS_SUCCESS;
-        }
-    }
+    *has_id = !NtFsControlFile( *handle, 0, NULL, NULL, &io, FSCTL_GET_OBJECT_ID, NULL, 0, &fid, sizeof(fid) );
+    if (*has_id) memcpy( id, fid.ObjectId, sizeof(*id) );
+    return STATUS_SUCCESS;
+}
+
+
+/******************************************************************************
+ *	create_dll_section
+ *
+ * Create the image section for an opened dll file. Doesn't depend on the loader state.
+ */
+static NTSTATUS create_dll_section( HANDLE handle, const UNICODE_STRING *nt_name, HANDLE *mapping,
+                                    SECTION_IMAGE_INFORMATION *image_info )
+{
+    LARGE_INTEGER size;
+    NTSTATUS status;
 
     size.QuadPart = 0;
     status = NtCreateSection( mapping, STANDARD_RIGHTS_REQUIRED | SECTION_QUERY |
@@ -2575,11 +2750,431 @@ static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm, HANDL
             *mapping = NULL;
         }
     }
+    return status;
+}
+
+
+/******************************************************************************
+ *	open_dll_file
+ *
+ * Open a file for a new dll. Helper for find_dll_file.
+ */
+static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm, HANDLE *mapping,
+                               SECTION_IMAGE_INFORMATION *image_info, struct file_id *id )
+{
+    NTSTATUS status;
+    HANDLE handle;
+    BOOL has_id;
+
+    if ((*pwm = find_fullname_module( nt_name ))) return STATUS_SUCCESS;
+
+    if ((status = open_dll_handle( nt_name, &handle, id, &has_id ))) return status;
+
+    if (has_id && (*pwm = find_fileid_module( id )))
+    {
+        TRACE( "%s is the same file as existing module %p %s\n", debugstr_w( nt_name->Buffer ),
+               (*pwm)->ldr.DllBase, debugstr_w( (*pwm)->ldr.FullDllName.Buffer ));
+        NtClose( handle );
+        return STATUS_SUCCESS;
+    }
+
+    status = create_dll_section( handle, nt_name, mapping, image_info );
     NtClose( handle );
     return status;
 }
 
 
+/* dll files being opened ahead of time by the loader workers */
+
+enum prefetch_state
+{
+    PREFETCH_QUEUED,
+    PREFETCH_RUNNING,
+    PREFETCH_DONE
+};
+
+struct prefetch_file
+{
+    struct list                entry;
+    const WINE_MODREF         *owner;       /* module whose imports requested it */
+    const WCHAR               *paths;       /* search path */
+    WCHAR                      name[256];   /* dll name */
+    enum prefetch_state        state;
+    NTSTATUS                   status;
+    unsigned int               path_count;  /* number of path entries searched */
+    UNICODE_STRING             nt_name;
+    HANDLE                     mapping;
+    SECTION_IMAGE_INFORMATION  image_info;
+    struct file_id             id;
+    BOOL                       has_id;
+};
+
+#define MAX_LOADER_WORKERS 4
+#define TEB_LOADER_WORKER  0x2000  /* SameTebFlags LoaderWorker bit */
+
+static struct list prefetch_list = LIST_INIT( prefetch_list );
+static RTL_CONDITION_VARIABLE prefetch_cv;
+static unsigned int loader_workers;
+static BOOL loader_workers_exit;
+
+static RTL_CRITICAL_SECTION prefetch_section;
+static RTL_CRITICAL_SECTION_DEBUG prefetch_critsect_debug =
+{
+    0, 0, &prefetch_section,
+    { &prefetch_critsect_debug.ProcessLocksList, &prefetch_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": prefetch_section") }
+};
+static RTL_CRITICAL_SECTION prefetch_section = { &prefetch_critsect_debug, -1, 0, 0, 0, 0 };
+
+
+/***********************************************************************
+ *	prefetch_dll_file
+ *
+ * Search the dll along its path, open it and create its section.
+ * This is the part of search_dll_file that doesn't need the loader_section.
+ */
+static void prefetch_dll_file( struct prefetch_file *file )
+{
+    const WCHAR *paths = file->paths, *ptr;
+    WCHAR *name;
+    HANDLE handle;
+    BOOL found_image = FALSE;
+    NTSTATUS status = STATUS_DLL_NOT_FOUND;
+    ULONG len = wcslen( paths ) + wcslen( file->name ) + 2;
+
+    if (!(name = RtlAllocateHeap( GetProcessHeap(), 0, len * sizeof(WCHAR) )))
+    {
+        file->status = STATUS_NO_MEMORY;
+        return;
+    }
+
+    while (*paths)
+    {
+        ptr = paths;
+        while (*ptr && *ptr != ';') ptr++;
+        len = ptr - paths;
+        if (*ptr == ';') ptr++;
+        memcpy( name, paths, len * sizeof(WCHAR) );
+        if (len && name[len - 1] != '\\') name[len++] = '\\';
+        wcscpy( name + len, file->name );
+        paths = ptr;
+        file->path_count++;
+
+        if ((status = RtlDosPathNameToNtPathName_U_WithStatus( name, &file->nt_name, NULL, NULL ))) break;
+
+        status = open_dll_handle( &file->nt_name, &handle, &file->id, &file->has_id );
+        if (!status)
+        {
+            status = create_dll_section( handle, &file->nt_name, &file->mapping, &file->image_info );
+            NtClose( handle );
+        }
+        if (status == STATUS_IMAGE_MACHINE_TYPE_MISMATCH) found_image = TRUE;
+        else if (status != STATUS_DLL_NOT_FOUND) break;
+        RtlFreeUnicodeString( &file->nt_name );
+    }
+    if (status == STATUS_DLL_NOT_FOUND && found_image) status = STATUS_IMAGE_MACHINE_TYPE_MISMATCH;
+    file->status = status;
+    RtlFreeHeap( GetProcessHeap(), 0, name );
+}
+
+
+/***********************************************************************
+ *	loader_worker
+ *
+ * Thread running the queued dll prefetches. It never enters the loader_section.
+ */
+static void WINAPI loader_worker( void *arg )
+{
+    struct prefetch_file *file;
+
+    RtlEnterCriticalSection( &prefetch_section );
+    for (;;)
+    {
+        LIST_FOR_EACH_ENTRY( file, &prefetch_list, struct prefetch_file, entry )
+            if (file->state == PREFETCH_QUEUED) goto found;
+
+        if (loader_workers_exit) break;
+        RtlSleepConditionVariableCS( &prefetch_cv, &prefetch_section, NULL );
+        continue;
+
+    found:
+        file->state = PREFETCH_RUNNING;
+        RtlLeaveCriticalSection( &prefetch_section );
+        prefetch_dll_file( file );
+        RtlEnterCriticalSection( &prefetch_section );
+        file->state = PREFETCH_DONE;
+        RtlWakeAllConditionVariable( &prefetch_cv );
+    }
+    RtlLeaveCriticalSection( &prefetch_section );
+    RtlExitUserThread( 0 );
+}
+
+
+/***********************************************************************
+ *	start_loader_workers
+ *
+ * Start the threads that open the dependencies of the main exe in parallel.
+ * Only used during process init, the threads skip the loader initialization.
+ */
+static void start_loader_workers(void)
+{
+    static BOOL started;
+    THREAD_BASIC_INFORMATION info;
+    unsigned int count;
+    HANDLE thread;
+
+    /* the threads need kernel32 to start */
+    if (started || !pBaseThreadInitThunk) return;
+    started = TRUE;
+
+    if (NtCurrentTeb()->WowTebOffset) return;
+    if ((count = NtCurrentTeb()->Peb->NumberOfProcessors) <= 1) return;
+    count = min( count, MAX_LOADER_WORKERS );
+
+    while (loader_workers < count)
+    {
+        if (RtlCreateUserThread( GetCurrentProcess(), NULL, TRUE, 0, 0, 0,
+                                 loader_worker, NULL, &thread, NULL )) break;
+        if (!NtQueryInformationThread( thread, ThreadBasicInformation, &info, sizeof(info), NULL ))
+        {
+            ((TEB *)info.TebBaseAddress)->SameTebFlags |= TEB_LOADER_WORKER;
+            NtResumeThread( thread, NULL );
+            loader_workers++;
+        }
+        else NtTerminateThread( thread, 0 );
+        NtClose( thread );
+    }
+    TRACE( "started %u loader workers\n", loader_workers );
+}
+
+
+/***********************************************************************
+ *	stop_loader_workers
+ */
+static void stop_loader_workers(void)
+{
+    RtlEnterCriticalSection( &prefetch_section );
+    loader_workers_exit = TRUE;
+    RtlWakeAllConditionVariable( &prefetch_cv );
+    RtlLeaveCriticalSection( &prefetch_section );
+}
+
+
+/***********************************************************************
+ *	find_prefetch_file
+ *
+ * The prefetch_section must be locked while calling this function.
+ */
+static struct prefetch_file *find_prefetch_file( const WCHAR *paths, const WCHAR *name )
+{
+    struct prefetch_file *file;
+
+    LIST_FOR_EACH_ENTRY( file, &prefetch_list, struct prefetch_file, entry )
+        if (file->paths == paths && !wcsicmp( file->name, name )) return file;
+    return NULL;
+}
+
+
+/***********************************************************************
+ *	wait_prefetch_file
+ *
+ * Wait for a prefetch to complete, running it directly if no worker took it yet.
+ * The prefetch_section must be locked while calling this function.
+ */
+static void wait_prefetch_file( struct prefetch_file *file )
+{
+    if (file->state == PREFETCH_QUEUED)
+    {
+        file->state = PREFETCH_RUNNING;
+        RtlLeaveCriticalSection( &prefetch_section );
+        prefetch_dll_file( file );
+        RtlEnterCriticalSection( &prefetch_section );
+        file->state = PREFETCH_DONE;
+    }
+    while (file->state != PREFETCH_DONE)
+        RtlSleepConditionVariableCS( &prefetch_cv, &prefetch_section, NULL );
+}
+
+
+/***********************************************************************
+ *	free_prefetch_file
+ */
+static void free_prefetch_file( struct prefetch_file *file )
+{
+    if (file->mapping) NtClose( file->mapping );
+    RtlFreeUnicodeString( &file->nt_name );
+    RtlFreeHeap( GetProcessHeap(), 0, file );
+}
+
+
+/***********************************************************************
+ *	queue_import_prefetch
+ *
+ * Queue the not yet loaded imports of a module for opening by the loader workers.
+ * The loader_section must be locked while calling this function.
+ */
+static void queue_import_prefetch( WINE_MODREF *wm, const IMAGE_IMPORT_DESCRIPTOR *imports,
+                                   int nb_imports, LPCWSTR load_path )
+{
+    BOOL system = wm->system || (wm->ldr.Flags & LDR_WINE_INTERNAL);
+    const WCHAR *paths;
+    struct prefetch_file *file;
+    const char *name;
+    WCHAR buffer[256];
+    BOOL queued = FALSE;
+    int i;
+
+    if (imports_fixup_done) return;
+    start_loader_workers();
+    if (!loader_workers) return;
+
+    /* same search order as load_dll */
+    if (system && system_dll_path.Buffer) paths = system_dll_path.Buffer;
+    else paths = load_path ? load_path : default_load_path;
+    if (!paths) return;
+
+    RtlEnterCriticalSection( &prefetch_section );
+    for (i = 0; i < nb_imports; i++)
+    {
+        name = get_rva( wm->ldr.DllBase, imports[i].Name );
+        if (build_import_name( buffer, name, strlen(name) )) continue;
+        if (contains_path( buffer )) continue;
+        if (find_basename_module( buffer )) continue;
+        if (find_prefetch_file( paths, buffer )) continue;
+        if (!(file = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*file) ))) break;
+        file->owner = wm;
+        file->paths = paths;
+        wcscpy( file->name, buffer );
+        file->state = PREFETCH_QUEUED;
+        list_add_tail( &prefetch_list, &file->entry );
+        queued = TRUE;
+    }
+    if (queued) RtlWakeAllConditionVariable( &prefetch_cv );
+    RtlLeaveCriticalSection( &prefetch_section );
+}
+
+
+/***********************************************************************
+ *	flush_import_prefetch
+ *
+ * Discard the unused prefetches queued for the imports of a module.
+ * The loader_section must be locked while calling this function.
+ */
+static void flush_import_prefetch( const WINE_MODREF *wm )
+{
+    struct prefetch_file *file, *next;
+
+    if (list_empty( &prefetch_list )) return;
+
+    RtlEnterCriticalSection( &prefetch_section );
+    LIST_FOR_EACH_ENTRY_SAFE( file, next, &prefetch_list, struct prefetch_file, entry )
+    {
+        if (file->owner != wm) continue;
+        if (file->state == PREFETCH_QUEUED) file->state = PREFETCH_DONE;
+        while (file->state != PREFETCH_DONE)
+            RtlSleepConditionVariableCS( &prefetch_cv, &prefetch_section, NULL );
+        list_remove( &file->entry );
+        free_prefetch_file( file );
+    }
+    RtlLeaveCriticalSection( &prefetch_section );
+}
+
+
+/***********************************************************************
+ *	find_path_module
+ *
+ * Check the first entries of a search path for a module that is already loaded
+ * under that name, which is what open_dll_file does before opening each file.
+ * The loader_section must be locked while calling this function.
+ */
+static WINE_MODREF *find_path_module( LPCWSTR paths, LPCWSTR search, unsigned int count,
+                                      UNICODE_STRING *nt_name )
+{
+    WINE_MODREF *wm = NULL;
+    const WCHAR *ptr;
+    WCHAR *name;
+    ULONG len = wcslen( paths ) + wcslen( search ) + 2;
+
+    if (!(name = RtlAllocateHeap( GetProcessHeap(), 0, len * sizeof(WCHAR) ))) return NULL;
+
+    for (; *paths && count; count--)
+    {
+        ptr = paths;
+        while (*ptr && *ptr != ';') ptr++;
+        len = ptr - paths;
+        if (*ptr == ';') ptr++;
+        memcpy( name, paths, len * sizeof(WCHAR) );
+        if (len && name[len - 1] != '\\') name[len++] = '\\';
+        wcscpy( name + len, search );
+        paths = ptr;
+
+        if (RtlDosPathNameToNtPathName_U_WithStatus( name, nt_name, NULL, NULL )) break;
+        if ((wm = find_fullname_module( nt_name ))) break;
+        RtlFreeUnicodeString( nt_name );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, name );
+    return wm;
+}
+
+
+/***********************************************************************
+ *	get_prefetched_file
+ *
+ * Retrieve the result of a prefetch, with the same semantics as search_dll_file.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL get_prefetched_file( LPCWSTR paths, LPCWSTR search, UNICODE_STRING *nt_name,
+                                 WINE_MODREF **pwm, HANDLE *mapping, SECTION_IMAGE_INFORMATION *image_info,
+                                 struct file_id *id, NTSTATUS *status )
+{
+    struct prefetch_file *file;
+
+    if (list_empty( &prefetch_list )) return FALSE;
+
+    RtlEnterCriticalSection( &prefetch_section );
+    if ((file = find_prefetch_file( paths, search )))
+    {
+        list_remove( &file->entry );
+        wait_prefetch_file( file );
+    }
+    RtlLeaveCriticalSection( &prefetch_section );
+    if (!file) return FALSE;
+
+    TRACE( "using prefetched %s for %s, status %x\n", debugstr_us(&file->nt_name), debugstr_w(search), file->status );
+
+    /* a module loaded under the name of an entry up to the one that was found takes precedence */
+    if ((*pwm = find_path_module( paths, search, file->path_count, nt_name )))
+    {
+        TRACE( "%s is already loaded as %p\n", debugstr_us(nt_name), (*pwm)->ldr.DllBase );
+        *status = STATUS_SUCCESS;
+        free_prefetch_file( file );
+        return TRUE;
+    }
+
+    *status = file->status;
+    *nt_name = file->nt_name;
+    file->nt_name.Buffer = NULL;
+    if (!*status)
+    {
+        /* now check against the loaded modules, like open_dll_file does */
+        if (file->has_id && (*pwm = find_fileid_module( &file->id )))
+        {
+            TRACE( "%s is the same file as existing module %p %s\n", debugstr_us(nt_name),
+                   (*pwm)->ldr.DllBase, debugstr_w( (*pwm)->ldr.FullDllName.Buffer ));
+        }
+        else
+        {
+            *mapping = file->mapping;
+            *image_info = file->image_info;
+            if (file->has_id) *id = file->id;
+            file->mapping = NULL;
+        }
+    }
+    free_prefetch_file( file );
+    return TRUE;
+}
+
+
 /******************************************************************************
  *	find_existing_module
  *
@@ -3003,6 +3598,7 @@ static NTSTATUS search_dll_file( LPCWSTR paths, LPCWSTR search, UNICODE_STRING *
     ULONG len;
 
     if (!paths) paths = default_load_path;
+    if (get_prefetched_file( paths, search, nt_name, pwm, mapping, image_info, id, &status )) return status;
     len = wcslen( paths );
 
     if (len < wcslen( system_dir )) len = wcslen( system_dir );
@@ -3759,6 +4355,8 @@ void WINAPI LdrShutdownThread(void)
 
     /* don't do any detach calls if process is exiting */
     if (process_detaching) return;
+    /* loader workers never attached to the dlls */
+    if (NtCurrentTeb()->SameTebFlags & TEB_LOADER_WORKER) return;
 
     RtlProcessFlsData( NtCurrentTeb()->FlsSlots, 1 );
 
@@ -3812,6 +4410,7 @@ static void free_modref( WINE_MODREF *wm )
 
     RemoveEntryList(&wm->ldr.InLoadOrderLinks);
     RemoveEntryList(&wm->ldr.InMemoryOrderLinks);
+    remove_module_index( wm );
     if (wm->ldr.InInitializationOrderLinks.Flink)
         RemoveEntryList(&wm->ldr.InInitializationOrderLinks);
 
@@ -3842,7 +4441,6 @@ static void free_modref( WINE_MODREF *wm )
     free_tls_slot( &wm->ldr );
     RtlReleaseActivationContext( wm->ldr.ActivationContext );
     NtUnmapViewOfSection( NtCurrentProcess(), wm->ldr.DllBase );
-    if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
@@ -4170,6 +4768,10 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, ULONG_PTR unknown2, ULONG_PTR
 
     if (process_detaching) NtTerminateThread( GetCurrentThread(), 0 );
 
+    /* loader workers run while the loader_section is held by the initial thread,
+     * they skip the attach and go straight to their entry point */
+    if (NtCurrentTeb()->SameTebFlags & TEB_LOADER_WORKER) signal_start_thread( context );
+
     RtlEnterCriticalSection( &loader_section );
 
     if (!imports_fixup_done)
@@ -4178,6 +4780,7 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, ULONG_PTR unknown2, ULONG_PTR
         WINE_MODREF *kernel32;
         PEB *peb = NtCurrentTeb()->Peb;
         DWORD hci = 2;
+        SIZE_T size;
 
         peb->LdrData            = &ldr;
         peb->FastPebLock        = &peb_lock;
@@ -4196,9 +4799,13 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, ULONG_PTR unknown2, ULONG_PTR
         version_init();
 
         get_env_var( L"WINESYSTEMDLLPATH", 0, &system_dll_path );
+        startup_trace_enabled = RtlQueryEnvironmentVariable( NULL, L"WINESTARTUPTRACE", 16, NULL, 0, &size )
+                                != STATUS_VARIABLE_NOT_FOUND;
 
+        init_module_index();
         wm = build_main_module();
         wm->ldr.LoadCount = -1;
+        trace_module_stage( wm, __WINE_STARTUP_TRACE_PROCESS );
 
         build_ntdll_module();
         RtlSetHeapInformation( GetProcessHeap(), HeapCompatibilityInformation, &hci, sizeof(hci) );
@@ -4223,10 +4830,12 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, ULONG_PTR unknown2, ULONG_PTR
         LdrGetProcedureAddress( kernel32_handle, &func_name, 0, (void **)&pCtrlRoutine );
 
         actctx_init();
+        if (startup_trace_enabled) __wine_startup_trace( "fixup_imports", __WINE_STARTUP_TRACE_BEGIN );
         if (wm->ldr.Flags & LDR_COR_ILONLY)
             status = fixup_imports_ilonly( wm, NULL, entry );
         else
             status = fixup_imports( wm, NULL );
+        if (startup_trace_enabled) __wine_startup_trace( "fixup_imports", __WINE_STARTUP_TRACE_END );
 
         if (status)
         {
@@ -4237,6 +4846,7 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, ULONG_PTR unknown2, ULONG_PTR
             unix_funcs->write_crash_log("missingmodule", crash_log);
             NtTerminateProcess( GetCurrentProcess(), status );
         }
+        stop_loader_workers();
         imports_fixup_done = TRUE;
     }
     else wm = get_modref( NtCurrentTeb()->Peb->ImageBaseAddress );
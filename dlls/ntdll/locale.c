@@ -1244,6 +1244,11 @@ found:
 }
 
 
+/* ASCII runs are converted a 64-bit word at a time; a word is all ASCII if none of these bits are set */
+typedef UINT64 DECLSPEC_ALIGN(1) unaligned_ui64;
+#define ASCII_MASK_CHAR  0x8080808080808080ull
+#define ASCII_MASK_WCHAR 0xff80ff80ff80ff80ull
+
 /* helper for the various utf8 mbstowcs functions */
 static unsigned int decode_utf8_char( unsigned char ch, const char **str, const char *strend )
 {
@@ -1317,7 +1322,16 @@ NTSTATUS WINAPI RtlUTF8ToUnicodeN( WCHAR *dst, DWORD dstlen, DWORD *reslen, cons
         for (len = 0; src < srcend; len++)
         {
             unsigned char ch = *src++;
-            if (ch < 0x80) continue;
+            if (ch < 0x80)
+            {
+                while (srcend - src >= 8 && !(*(const unaligned_ui64 *)src & ASCII_MASK_CHAR))
+                {
+                    src += 8;
+                    len += 8;
+                }
+                for (; src < srcend && (unsigned char)*src < 0x80; src++) len++;
+                continue;
+            }
             if ((res = decode_utf8_char( ch, &src, srcend )) > 0x10ffff)
                 status = STATUS_SOME_NOT_MAPPED;
             else
@@ -1329,12 +1343,45 @@ NTSTATUS WINAPI RtlUTF8ToUnicodeN( WCHAR *dst, DWORD dstlen, DWORD *reslen, cons
 
     while ((dst < dstend) && (src < srcend))
     {
-        unsigned char ch = *src++;
+        unsigned char ch = *src++, c1, c2;
+
         if (ch < 0x80)  /* special fast case for 7-bit ASCII */
         {
             *dst++ = ch;
+            while (srcend - src >= 8 && dstend - dst >= 8 && !(*(const unaligned_ui64 *)src & ASCII_MASK_CHAR))
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+                dst[3] = src[3];
+                dst[4] = src[4];
+                dst[5] = src[5];
+                dst[6] = src[6];
+                dst[7] = src[7];
+                src += 8;
+                dst += 8;
+            }
+            while (src < srcend && dst < dstend && (unsigned char)*src < 0x80) *dst++ = *src++;
+            continue;
+        }
+        /* valid two and three byte sequences, anything else goes through decode_utf8_char */
+        if (ch >= 0xc2 && ch < 0xe0 && src < srcend && (c1 = *src ^ 0x80) < 0x40)
+        {
+            *dst++ = ((ch & 0x1f) << 6) | c1;
+            src++;
             continue;
         }
+        if (ch >= 0xe0 && ch < 0xf0 && srcend - src >= 2 &&
+            (c1 = src[0] ^ 0x80) < 0x40 && (c2 = src[1] ^ 0x80) < 0x40)
+        {
+            res = ((ch & 0x0f) << 12) | (c1 << 6) | c2;
+            if (res >= 0x800 && (res < 0xd800 || res > 0xdfff))
+            {
+                *dst++ = res;
+                src += 2;
+                continue;
+            }
+        }
         if ((res = decode_utf8_char( ch, &src, srcend )) <= 0xffff)
         {
             *dst++ = res;
@@ -1377,7 +1424,16 @@ NTSTATUS WINAPI RtlUnicodeToUTF8N( char *dst, DWORD dstlen, DWORD *reslen, const
     {
         for (len = 0; srclen; srclen--, src++)
         {
-            if (*src < 0x80) len++;  /* 0x00-0x7f: 1 byte */
+            if (*src < 0x80)  /* 0x00-0x7f: 1 byte */
+            {
+                len++;
+                while (srclen >= 5 && !(*(const unaligned_ui64 *)(src + 1) & ASCII_MASK_WCHAR))
+                {
+                    src += 4;
+                    srclen -= 4;
+                    len += 4;
+                }
+            }
             else if (*src < 0x800) len += 2;  /* 0x80-0x7ff: 2 bytes */
             else
             {
@@ -1407,6 +1463,16 @@ NTSTATUS WINAPI RtlUnicodeToUTF8N( char *dst, DWORD dstlen, DWORD *reslen, const
         {
             if (dst > end - 1) break;
             *dst++ = ch;
+            while (srclen >= 5 && end - dst >= 4 && !(*(const unaligned_ui64 *)(src + 1) & ASCII_MASK_WCHAR))
+            {
+                dst[0] = src[1];
+                dst[1] = src[2];
+                dst[2] = src[3];
+                dst[3] = src[4];
+                src += 4;
+                srclen -= 4;
+                dst += 4;
+            }
             continue;
         }
         if (ch < 0x800)  /* 0x80-0x7ff: 2 bytes */
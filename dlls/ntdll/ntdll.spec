@@ -1632,6 +1632,10 @@
 # Unix interface
 @ stdcall -syscall __wine_unix_call(int64 long ptr)
 @ stdcall -syscall __wine_unix_spawnvp(long ptr)
+@ stdcall -syscall __wine_wait_any_objects(long ptr long ptr ptr)
+@ stdcall -syscall __wine_wait_any_supported(ptr ptr)
+@ stdcall -syscall __wine_wait_on_address(ptr long long ptr)
+@ stdcall -syscall __wine_wake_address(ptr long long)
 @ cdecl __wine_set_unix_funcs(long ptr)
 @ stdcall __wine_ctrl_routine(ptr)
 @ extern __wine_syscall_dispatcher
@@ -1640,6 +1644,7 @@
 
 # Debugging
 @ stdcall -syscall -norelay __wine_dbg_write(ptr long)
+@ stdcall -syscall -norelay __wine_startup_trace(str long)
 @ cdecl -norelay __wine_dbg_get_channel_flags(ptr)
 @ cdecl -norelay __wine_dbg_header(long long str)
 @ cdecl -norelay __wine_dbg_output(str)
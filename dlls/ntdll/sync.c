@@ -155,6 +155,14 @@ static BOOL crit_section_has_debuginfo( const RTL_CRITICAL_SECTION *crit )
     return crit->DebugInfo != NULL && crit->DebugInfo != no_debug_info_marker;
 }
 
+/* Critical sections without debug info wait on their lock word too, only the
+ * ones made global by MakeCriticalSectionGlobal, which clears the debug info,
+ * need a semaphore that can be shared with other processes. */
+static BOOL crit_section_uses_semaphore( const RTL_CRITICAL_SECTION *crit )
+{
+    return crit->DebugInfo == NULL;
+}
+
 static inline HANDLE get_semaphore( RTL_CRITICAL_SECTION *crit )
 {
     HANDLE ret = crit->LockSemaphore;
@@ -174,8 +182,7 @@ static inline NTSTATUS wait_semaphore( RTL_CRITICAL_SECTION *crit, int timeout )
 {
     LARGE_INTEGER time = {.QuadPart = timeout * (LONGLONG)-10000000};
 
-    /* debug info is cleared by MakeCriticalSectionGlobal */
-    if (!crit_section_has_debuginfo( crit ))
+    if (crit_section_uses_semaphore( crit ))
     {
         HANDLE sem = get_semaphore( crit );
         return NtWaitForSingleObject( sem, FALSE, &time );
@@ -282,7 +289,7 @@ NTSTATUS WINAPI RtlDeleteCriticalSection( RTL_CRITICAL_SECTION *crit )
             crit->DebugInfo = NULL;
         }
     }
-    else NtClose( crit->LockSemaphore );
+    else if (crit_section_uses_semaphore( crit )) NtClose( crit->LockSemaphore );
     crit->LockSemaphore = 0;
     return STATUS_SUCCESS;
 }
@@ -355,8 +362,7 @@ NTSTATUS WINAPI RtlpUnWaitCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
     NTSTATUS ret;
 
-    /* debug info is cleared by MakeCriticalSectionGlobal */
-    if (!crit_section_has_debuginfo( crit ))
+    if (crit_section_uses_semaphore( crit ))
     {
         HANDLE sem = get_semaphore( crit );
         ret = NtReleaseSemaphore( sem, 1, NULL );
@@ -373,15 +379,6 @@ NTSTATUS WINAPI RtlpUnWaitCriticalSection( RTL_CRITICAL_SECTION *crit )
 }
 
 
-static inline void small_pause(void)
-{
-#ifdef __i386__
-    __asm__ __volatile__( "rep;nop" : : : "memory" );
-#else
-    __asm__ __volatile__( "" : : : "memory" );
-#endif
-}
-
 /******************************************************************************
  *      RtlEnterCriticalSection   (NTDLL.@)
  */
@@ -389,17 +386,22 @@ NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
     if (crit->SpinCount)
     {
-        ULONG count;
+        ULONG count, pause = 1, i;
 
         if (RtlTryEnterCriticalSection( crit )) return STATUS_SUCCESS;
-        for (count = crit->SpinCount; count > 0; count--)
+
+        /* Spin with an exponential backoff, so that the spinning threads don't
+         * keep the cache line of the lock busy; SpinCount limits the total
+         * number of pauses. */
+        for (count = crit->SpinCount; count > 0; count -= min( count, pause ))
         {
             if (crit->LockCount > 0) break;  /* more than one waiter, don't bother spinning */
             if (crit->LockCount == -1)       /* try again */
             {
                 if (InterlockedCompareExchange( &crit->LockCount, 0, -1 ) == -1) goto done;
             }
-            small_pause();
+            for (i = 0; i < pause; i++) YieldProcessor();
+            if (pause < 64) pause *= 2;
         }
     }
 
@@ -503,6 +505,17 @@ DWORD WINAPI RtlRunOnceExecuteOnce( RTL_RUN_ONCE *once, PRTL_RUN_ONCE_INIT_FN fu
     return RtlRunOnceComplete( once, 0, context ? *context : NULL );
 }
 
+static BOOL use_unix_futexes(void);
+static NTSTATUS futex_wait_masked( const LONG *addr, LONG val, ULONG mask, const LARGE_INTEGER *timeout );
+static void futex_wake_masked( const LONG *addr, int count, ULONG mask );
+
+/* adaptive spinning of the SRW locks before blocking */
+#define SRW_SPIN_COUNT 1024
+
+/* futex masks to wake exclusive or shared waiters separately */
+#define SRW_FUTEX_EXCLUSIVE 1
+#define SRW_FUTEX_SHARED    2
+
 struct srw_lock
 {
     short exclusive_waiters;
@@ -522,15 +535,57 @@ struct srw_lock
 };
 C_ASSERT( sizeof(struct srw_lock) == 4 );
 
+/* spin until the lock might be available, or give up after SRW_SPIN_COUNT pauses */
+static BOOL srw_lock_spin( const struct srw_lock *lock, BOOL exclusive )
+{
+    struct srw_lock cur;
+    unsigned int count;
+
+    if (NtCurrentTeb()->Peb->NumberOfProcessors <= 1) return FALSE;
+
+    for (count = 0; count < SRW_SPIN_COUNT; count++)
+    {
+        cur = *(volatile const struct srw_lock *)lock;
+        if (exclusive ? !cur.owners : cur.owners != -1 && !cur.exclusive_waiters) return TRUE;
+        YieldProcessor();
+    }
+    return FALSE;
+}
+
+/* With unix futexes, both exclusive and shared waiters wait on the whole lock
+ * word, and futex masks tell them apart. */
+static void srw_lock_wait( struct srw_lock *lock, struct srw_lock value, BOOL exclusive )
+{
+    union { struct srw_lock s; LONG l; } v = { value };
+
+    if (use_unix_futexes())
+        futex_wait_masked( (LONG *)lock, v.l, exclusive ? SRW_FUTEX_EXCLUSIVE : SRW_FUTEX_SHARED, NULL );
+    else if (exclusive)
+        RtlWaitOnAddress( &lock->owners, &value.owners, sizeof(short), NULL );
+    else
+        RtlWaitOnAddress( lock, &value, sizeof(value), NULL );
+}
+
+static void srw_lock_wake( struct srw_lock *lock, BOOL exclusive )
+{
+    if (use_unix_futexes())
+        futex_wake_masked( (LONG *)lock, exclusive ? 1 : INT_MAX,
+                           exclusive ? SRW_FUTEX_EXCLUSIVE : SRW_FUTEX_SHARED );
+    else if (exclusive)
+        RtlWakeAddressSingle( &lock->owners );
+    else
+        RtlWakeAddressAll( lock );
+}
+
 /***********************************************************************
  *              RtlInitializeSRWLock (NTDLL.@)
  *
  * NOTES
  *  Please note that SRWLocks do not keep track of the owner of a lock.
  *  It doesn't make any difference which thread for example unlocks an
- *  SRWLock (see corresponding tests). This implementation uses two
- *  keyed events (one for the exclusive waiters and one for the shared
- *  waiters) and is limited to 2^15-1 waiting threads.
+ *  SRWLock (see corresponding tests). This implementation waits on the
+ *  lock word with separate wake masks for exclusive and shared waiters,
+ *  and is limited to 2^15-1 waiting threads.
  */
 void WINAPI RtlInitializeSRWLock( RTL_SRWLOCK *lock )
 {
@@ -548,6 +603,7 @@ void WINAPI RtlInitializeSRWLock( RTL_SRWLOCK *lock )
 void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 {
     union { RTL_SRWLOCK *rtl; struct srw_lock *s; LONG *l; } u = { lock };
+    BOOL spun = FALSE;
 
     InterlockedIncrement16( &u.s->exclusive_waiters );
 
@@ -575,7 +631,12 @@ void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
         } while (InterlockedCompareExchange( u.l, new.l, old.l ) != old.l);
 
         if (!wait) return;
-        RtlWaitOnAddress( &u.s->owners, &new.s.owners, sizeof(short), NULL );
+        if (!spun)
+        {
+            spun = TRUE;
+            if (srw_lock_spin( u.s, TRUE )) continue;
+        }
+        srw_lock_wait( u.s, new.s, TRUE );
     }
 }
 
@@ -589,6 +650,7 @@ void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 void WINAPI RtlAcquireSRWLockShared( RTL_SRWLOCK *lock )
 {
     union { RTL_SRWLOCK *rtl; struct srw_lock *s; LONG *l; } u = { lock };
+    BOOL spun = FALSE;
 
     for (;;)
     {
@@ -614,7 +676,12 @@ void WINAPI RtlAcquireSRWLockShared( RTL_SRWLOCK *lock )
         } while (InterlockedCompareExchange( u.l, new.l, old.l ) != old.l);
 
         if (!wait) return;
-        RtlWaitOnAddress( u.s, &new.s, sizeof(struct srw_lock), NULL );
+        if (!spun)
+        {
+            spun = TRUE;
+            if (srw_lock_spin( u.s, FALSE )) continue;
+        }
+        srw_lock_wait( u.s, new.s, FALSE );
     }
 }
 
@@ -636,10 +703,7 @@ void WINAPI RtlReleaseSRWLockExclusive( RTL_SRWLOCK *lock )
         new.s.owners = 0;
     } while (InterlockedCompareExchange( u.l, new.l, old.l ) != old.l);
 
-    if (new.s.exclusive_waiters)
-        RtlWakeAddressSingle( &u.s->owners );
-    else
-        RtlWakeAddressAll( u.s );
+    srw_lock_wake( u.s, new.s.exclusive_waiters != 0 );
 }
 
 /***********************************************************************
@@ -662,7 +726,7 @@ void WINAPI RtlReleaseSRWLockShared( RTL_SRWLOCK *lock )
     } while (InterlockedCompareExchange( u.l, new.l, old.l ) != old.l);
 
     if (!new.s.owners)
-        RtlWakeAddressSingle( &u.s->owners );
+        srw_lock_wake( u.s, TRUE );
 }
 
 /***********************************************************************
@@ -851,6 +915,13 @@ NTSTATUS WINAPI RtlSleepConditionVariableSRW( RTL_CONDITION_VARIABLE *variable,
  * NtWaitForAlertByThreadId, which manipulate a single flag (similar to an
  * auto-reset event) per thread. This can be tested by attempting to wake a
  * thread waiting in RtlWaitOnAddress() via NtAlertThreadByThreadId.
+ *
+ * Where the unix side supports futexes, aligned 4-byte addresses are waited
+ * on directly with a private futex. Other sizes wait on the sequence word of
+ * their hash bucket, which is incremented by every wake of an address in the
+ * bucket; colliding addresses only cause spurious wakeups, which the callers
+ * of RtlWaitOnAddress() have to deal with anyway. The queues of waiting
+ * threads are only used as a fallback.
  */
 
 struct futex_entry
@@ -864,6 +935,9 @@ struct futex_queue
 {
     struct list queue;
     LONG lock;
+    LONG waiters;           /* threads waiting directly on an address */
+    LONG seq;               /* sequence word for the other sizes */
+    LONG seq_waiters;       /* threads waiting on the sequence word */
 };
 
 static struct futex_queue futex_queues[256];
@@ -875,17 +949,6 @@ static struct futex_queue *get_futex_queue( const void *addr )
     return &futex_queues[(val >> 4) % ARRAY_SIZE(futex_queues)];
 }
 
-static void spin_lock( LONG *lock )
-{
-    while (InterlockedCompareExchange( lock, -1, 0 ))
-        YieldProcessor();
-}
-
-static void spin_unlock( LONG *lock )
-{
-    InterlockedExchange( lock, 0 );
-}
-
 static BOOL compare_addr( const void *addr, const void *cmp, SIZE_T size )
 {
     switch (size)
@@ -903,6 +966,83 @@ static BOOL compare_addr( const void *addr, const void *cmp, SIZE_T size )
     return FALSE;
 }
 
+static BOOL use_unix_futexes(void)
+{
+    static int supported = -1;
+    LONG dummy = 0;
+
+    if (supported == -1)
+        supported = __wine_wait_on_address( &dummy, 1, ~0u, NULL ) != STATUS_NOT_IMPLEMENTED;
+    return supported;
+}
+
+/* wait on an aligned 32-bit address, waking only with a bit in common with mask */
+static NTSTATUS futex_wait_masked( const LONG *addr, LONG val, ULONG mask, const LARGE_INTEGER *timeout )
+{
+    struct futex_queue *queue = get_futex_queue( addr );
+    NTSTATUS ret;
+
+    InterlockedIncrement( &queue->waiters );
+    ret = __wine_wait_on_address( addr, val, mask, timeout );
+    InterlockedDecrement( &queue->waiters );
+    return ret;
+}
+
+static void futex_wake_masked( const LONG *addr, int count, ULONG mask )
+{
+    struct futex_queue *queue = get_futex_queue( addr );
+
+    /* Order the caller's store to the address with the waiter count; the
+     * waiters increment it before the value is compared. */
+    MemoryBarrier();
+    if (queue->waiters) __wine_wake_address( addr, count, mask );
+}
+
+static NTSTATUS wait_on_address_futex( struct futex_queue *queue, const void *addr, const void *cmp,
+                                       SIZE_T size, const LARGE_INTEGER *timeout )
+{
+    NTSTATUS ret;
+    LONG seq;
+
+    if (size == 4 && !((ULONG_PTR)addr % 4))
+        return futex_wait_masked( addr, *(const LONG *)cmp, ~0u, timeout );
+
+    InterlockedIncrement( &queue->seq_waiters );
+    seq = __atomic_load_n( &queue->seq, __ATOMIC_SEQ_CST );
+    if (compare_addr( addr, cmp, size ))
+        ret = __wine_wait_on_address( &queue->seq, seq, ~0u, timeout );
+    else
+        ret = STATUS_SUCCESS;
+    InterlockedDecrement( &queue->seq_waiters );
+    return ret;
+}
+
+static void wake_address_futex( struct futex_queue *queue, const void *addr, BOOL all )
+{
+    /* Order the caller's store to the address with the waiter counts; the
+     * waiters increment them before comparing the value. */
+    MemoryBarrier();
+
+    if (queue->waiters && !((ULONG_PTR)addr % 4))
+        __wine_wake_address( addr, all ? INT_MAX : 1, ~0u );
+    if (queue->seq_waiters)
+    {
+        InterlockedIncrement( &queue->seq );
+        __wine_wake_address( &queue->seq, INT_MAX, ~0u );
+    }
+}
+
+static void spin_lock( LONG *lock )
+{
+    while (InterlockedCompareExchange( lock, -1, 0 ))
+        YieldProcessor();
+}
+
+static void spin_unlock( LONG *lock )
+{
+    InterlockedExchange( lock, 0 );
+}
+
 /***********************************************************************
  *           RtlWaitOnAddress   (NTDLL.@)
  */
@@ -918,6 +1058,13 @@ NTSTATUS WINAPI RtlWaitOnAddress( const void *addr, const void *cmp, SIZE_T size
     if (size != 1 && size != 2 && size != 4 && size != 8)
         return STATUS_INVALID_PARAMETER;
 
+    if (use_unix_futexes())
+    {
+        ret = wait_on_address_futex( queue, addr, cmp, size, timeout );
+        TRACE("returning %#x\n", ret);
+        return ret;
+    }
+
     entry.addr = addr;
     entry.tid = GetCurrentThreadId();
 
@@ -965,6 +1112,12 @@ void WINAPI RtlWakeAddressAll( const void *addr )
 
     if (!addr) return;
 
+    if (use_unix_futexes())
+    {
+        wake_address_futex( queue, addr, TRUE );
+        return;
+    }
+
     spin_lock( &queue->lock );
 
     if (!queue->queue.next)
@@ -1002,6 +1155,12 @@ void WINAPI RtlWakeAddressSingle( const void *addr )
 
     if (!addr) return;
 
+    if (use_unix_futexes())
+    {
+        wake_address_futex( queue, addr, FALSE );
+        return;
+    }
+
     spin_lock( &queue->lock );
 
     if (!queue->queue.next)
@@ -1099,6 +1099,73 @@ static void test_set_io_completion(void)
     pNtClose( h );
 }
 
+static DWORD WINAPI completion_wait_thread( void *arg )
+{
+    HANDLE h = arg;
+    IO_STATUS_BLOCK iosb;
+    ULONG_PTR key, value;
+    NTSTATUS res;
+
+    res = pNtRemoveIoCompletion( h, &key, &value, &iosb, NULL );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    ok( key == CKEY_SECOND, "Invalid completion key: %#lx\n", key );
+    return 0;
+}
+
+static void test_io_completion_many(void)
+{
+    static const ULONG total = 3000;
+    IO_STATUS_BLOCK iosb;
+    ULONG_PTR key, value;
+    LARGE_INTEGER timeout = {{0}};
+    HANDLE h, thread;
+    NTSTATUS res;
+    ULONG i, count;
+
+    res = pNtCreateIoCompletion( &h, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( res == STATUS_SUCCESS, "NtCreateIoCompletion failed: %#x\n", res );
+
+    /* more packets than the shared ring holds, they are returned in order */
+    for (i = 0; i < total; i++)
+    {
+        res = pNtSetIoCompletion( h, CKEY_FIRST, i, STATUS_SUCCESS, i );
+        ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    }
+    count = get_pending_msgs( h );
+    ok( count == total, "Unexpected msg count: %d\n", count );
+
+    for (i = 0; i < total; i++)
+    {
+        res = pNtRemoveIoCompletion( h, &key, &value, &iosb, &timeout );
+        ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+        if (res) break;
+        ok( value == i, "got value %lu, expected %u\n", value, i );
+        ok( iosb.Information == i, "got information %lu, expected %u\n", iosb.Information, i );
+    }
+    count = get_pending_msgs( h );
+    ok( !count, "Unexpected msg count: %d\n", count );
+
+    res = pNtRemoveIoCompletion( h, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_TIMEOUT, "NtRemoveIoCompletion failed: %#x\n", res );
+
+    /* a thread blocked in NtRemoveIoCompletion is woken up by a new packet */
+    thread = CreateThread( NULL, 0, completion_wait_thread, h, 0, NULL );
+    ok( WaitForSingleObject( thread, 100 ) == WAIT_TIMEOUT, "thread didn't wait\n" );
+    res = pNtSetIoCompletion( h, CKEY_SECOND, 0, STATUS_SUCCESS, 0 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    ok( !WaitForSingleObject( thread, 5000 ), "thread didn't finish\n" );
+    CloseHandle( thread );
+
+    /* the port handle can be waited on while packets are queued */
+    res = pNtSetIoCompletion( h, CKEY_SECOND, 0, STATUS_SUCCESS, 0 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    ok( !WaitForSingleObject( h, 0 ), "port not signaled\n" );
+    res = pNtRemoveIoCompletion( h, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+
+    pNtClose( h );
+}
+
 static void test_file_io_completion(void)
 {
     static const char pipe_name[] = "\\\\.\\pipe\\iocompletiontestnamedpipe";
@@ -5389,6 +5456,7 @@ START_TEST(file)
     append_file_test();
     nt_mailslot_test();
     test_set_io_completion();
+    test_io_completion_many();
     test_file_io_completion();
     test_file_basic_information();
     test_file_all_information();
@@ -722,6 +722,33 @@ static void test_query_procperf(void)
     HeapFree( GetProcessHeap(), 0, sppi);
 }
 
+static void test_query_info_time(void)
+{
+    SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION sppi[64];
+    SYSTEM_PERFORMANCE_INFORMATION spi;
+    LARGE_INTEGER freq, start, end;
+    ULONG len;
+    int i;
+
+    QueryPerformanceFrequency(&freq);
+
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < 1000; i++)
+        pNtQuerySystemInformation(SystemProcessorPerformanceInformation, sppi, sizeof(sppi), &len);
+    QueryPerformanceCounter(&end);
+    if (winetest_debug > 1)
+        trace("average SystemProcessorPerformanceInformation query time %u ns\n",
+              (unsigned int)((end.QuadPart - start.QuadPart) * 1000000 / freq.QuadPart));
+
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < 1000; i++)
+        pNtQuerySystemInformation(SystemPerformanceInformation, &spi, sizeof(spi), &len);
+    QueryPerformanceCounter(&end);
+    if (winetest_debug > 1)
+        trace("average SystemPerformanceInformation query time %u ns\n",
+              (unsigned int)((end.QuadPart - start.QuadPart) * 1000000 / freq.QuadPart));
+}
+
 static void test_query_module(void)
 {
     const RTL_PROCESS_MODULE_INFORMATION_EX *infoex;
@@ -1549,6 +1576,64 @@ static void test_query_battery(void)
        "expected %u minutes remaining got %u minutes\n", time_left, bs.EstimatedTime);
 }
 
+static BOOL is_thread_in_process_list( DWORD tid )
+{
+    SYSTEM_PROCESS_INFORMATION *spi, *spi_buf;
+    ULONG size = 0x4000, i;
+    NTSTATUS status;
+    BOOL found = FALSE;
+
+    for (;;)
+    {
+        spi_buf = HeapAlloc( GetProcessHeap(), 0, size );
+        status = pNtQuerySystemInformation( SystemProcessInformation, spi_buf, size, &size );
+        if (status != STATUS_INFO_LENGTH_MISMATCH) break;
+        HeapFree( GetProcessHeap(), 0, spi_buf );
+    }
+    ok( status == STATUS_SUCCESS, "got %08x\n", status );
+
+    for (spi = spi_buf; !status; spi = (SYSTEM_PROCESS_INFORMATION *)((char *)spi + spi->NextEntryOffset))
+    {
+        if (HandleToULong( spi->UniqueProcessId ) == GetCurrentProcessId())
+        {
+            for (i = 0; i < spi->dwThreadCount; i++)
+                if (HandleToULong( spi->ti[i].ClientId.UniqueThread ) == tid) found = TRUE;
+        }
+        if (!spi->NextEntryOffset) break;
+    }
+
+    HeapFree( GetProcessHeap(), 0, spi_buf );
+    return found;
+}
+
+static DWORD WINAPI process_list_thread( void *arg )
+{
+    WaitForSingleObject( arg, INFINITE );
+    return 0;
+}
+
+static void test_query_process_thread_list(void)
+{
+    HANDLE thread, event;
+    DWORD tid;
+
+    /* query twice, the second query can be served from the cached snapshot */
+    ok( is_thread_in_process_list( GetCurrentThreadId() ), "current thread not found\n" );
+    ok( is_thread_in_process_list( GetCurrentThreadId() ), "current thread not found\n" );
+
+    event = CreateEventW( NULL, TRUE, FALSE, NULL );
+    thread = CreateThread( NULL, 0, process_list_thread, event, 0, &tid );
+    ok( thread != NULL, "CreateThread failed with %u\n", GetLastError() );
+    ok( is_thread_in_process_list( tid ), "new thread not found\n" );
+
+    SetEvent( event );
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+    ok( !is_thread_in_process_list( tid ), "exited thread still listed\n" );
+
+    CloseHandle( event );
+}
+
 static void test_query_processor_power_info(void)
 {
     NTSTATUS status;
@@ -3555,7 +3640,9 @@ START_TEST(info)
     test_query_timeofday();
     test_query_process( TRUE );
     test_query_process( FALSE );
+    test_query_process_thread_list();
     test_query_procperf();
+    test_query_info_time();
     test_query_module();
     test_query_handle();
     test_query_handle_ex();
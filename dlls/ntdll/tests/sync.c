@@ -603,6 +603,320 @@ static void test_wait_on_address(void)
     ok(address == 0, "got %s\n", wine_dbgstr_longlong(address));
 }
 
+#define CONTENTION_THREADS 4
+
+enum contention_lock
+{
+    CONTENTION_SRWLOCK,
+    CONTENTION_SRWLOCK_SHARED,
+    CONTENTION_CS,
+    CONTENTION_CS_SPIN,
+    CONTENTION_CS_NO_DEBUG_INFO,
+    CONTENTION_ADDRESS,
+    CONTENTION_ADDRESS64,
+};
+
+static struct
+{
+    enum contention_lock type;
+    unsigned int count;
+    HANDLE start_event;
+    SRWLOCK srwlock;
+    CRITICAL_SECTION cs;
+    CRITICAL_SECTION cs_spin;
+    CRITICAL_SECTION cs_no_debug_info;
+    LONG address;
+    LONG64 address64;
+    unsigned int value;
+} contention;
+
+/* simple mutex on top of RtlWaitOnAddress, 2 means that there may be waiters */
+static void address_lock(void)
+{
+    static const LONG two = 2;
+
+    if (!InterlockedCompareExchange( &contention.address, 1, 0 )) return;
+    while (InterlockedExchange( &contention.address, 2 ))
+        pRtlWaitOnAddress( &contention.address, &two, sizeof(two), NULL );
+}
+
+static void address_unlock(void)
+{
+    if (InterlockedExchange( &contention.address, 0 ) == 2)
+        pRtlWakeAddressSingle( &contention.address );
+}
+
+static LONG64 exchange64( LONG64 *dest, LONG64 value )
+{
+    LONG64 old;
+
+    do old = *dest; while (InterlockedCompareExchange64( dest, value, old ) != old);
+    return old;
+}
+
+static void address64_lock(void)
+{
+    static const LONG64 two = 2;
+
+    if (!InterlockedCompareExchange64( &contention.address64, 1, 0 )) return;
+    while (exchange64( &contention.address64, 2 ))
+        pRtlWaitOnAddress( &contention.address64, &two, sizeof(two), NULL );
+}
+
+static void address64_unlock(void)
+{
+    if (exchange64( &contention.address64, 0 ) == 2)
+        pRtlWakeAddressSingle( &contention.address64 );
+}
+
+static DWORD WINAPI contention_thread( void *arg )
+{
+    unsigned int i;
+
+    WaitForSingleObject( contention.start_event, INFINITE );
+
+    for (i = 0; i < contention.count; i++)
+    {
+        switch (contention.type)
+        {
+        case CONTENTION_SRWLOCK:
+            AcquireSRWLockExclusive( &contention.srwlock );
+            contention.value++;
+            ReleaseSRWLockExclusive( &contention.srwlock );
+            break;
+        case CONTENTION_SRWLOCK_SHARED:
+            /* three readers for each writer */
+            if (i % 4)
+            {
+                AcquireSRWLockShared( &contention.srwlock );
+                InterlockedIncrement( (LONG *)&contention.value );
+                ReleaseSRWLockShared( &contention.srwlock );
+                break;
+            }
+            AcquireSRWLockExclusive( &contention.srwlock );
+            contention.value++;
+            ReleaseSRWLockExclusive( &contention.srwlock );
+            break;
+        case CONTENTION_CS:
+            EnterCriticalSection( &contention.cs );
+            contention.value++;
+            LeaveCriticalSection( &contention.cs );
+            break;
+        case CONTENTION_CS_SPIN:
+            EnterCriticalSection( &contention.cs_spin );
+            contention.value++;
+            LeaveCriticalSection( &contention.cs_spin );
+            break;
+        case CONTENTION_CS_NO_DEBUG_INFO:
+            EnterCriticalSection( &contention.cs_no_debug_info );
+            contention.value++;
+            LeaveCriticalSection( &contention.cs_no_debug_info );
+            break;
+        case CONTENTION_ADDRESS:
+            address_lock();
+            contention.value++;
+            address_unlock();
+            break;
+        case CONTENTION_ADDRESS64:
+            address64_lock();
+            contention.value++;
+            address64_unlock();
+            break;
+        }
+    }
+    return 0;
+}
+
+static void test_lock_contention(void)
+{
+    static const char *names[] =
+    {
+        "SRWLock", "SRWLock (shared)", "critical section", "critical section (spin)",
+        "critical section (no debug info)", "WaitOnAddress", "WaitOnAddress (8 bytes)",
+    };
+    HANDLE threads[CONTENTION_THREADS];
+    LARGE_INTEGER frequency, start, end;
+    unsigned int i, type;
+
+    if (!pRtlWaitOnAddress)
+    {
+        win_skip("RtlWaitOnAddress not supported, skipping test\n");
+        return;
+    }
+
+    QueryPerformanceFrequency( &frequency );
+    contention.count = winetest_interactive ? 1000000 : 50000;
+    contention.start_event = CreateEventW( NULL, TRUE, FALSE, NULL );
+    InitializeSRWLock( &contention.srwlock );
+    InitializeCriticalSection( &contention.cs );
+    InitializeCriticalSectionAndSpinCount( &contention.cs_spin, 4000 );
+    InitializeCriticalSectionEx( &contention.cs_no_debug_info, 0, CRITICAL_SECTION_NO_DEBUG_INFO );
+
+    for (type = CONTENTION_SRWLOCK; type <= CONTENTION_ADDRESS64; type++)
+    {
+        contention.type = type;
+        contention.value = 0;
+        ResetEvent( contention.start_event );
+        for (i = 0; i < CONTENTION_THREADS; i++)
+            threads[i] = CreateThread( NULL, 0, contention_thread, NULL, 0, NULL );
+
+        QueryPerformanceCounter( &start );
+        SetEvent( contention.start_event );
+        WaitForMultipleObjects( CONTENTION_THREADS, threads, TRUE, INFINITE );
+        QueryPerformanceCounter( &end );
+
+        ok( contention.value == CONTENTION_THREADS * contention.count, "%s: got %u\n",
+            names[type], contention.value );
+        if (winetest_debug > 1)
+            trace( "%s: %u ns per lock with %u threads\n", names[type],
+                   (unsigned int)((end.QuadPart - start.QuadPart) * 1000000000 / frequency.QuadPart
+                                  / (CONTENTION_THREADS * contention.count)), CONTENTION_THREADS );
+
+        for (i = 0; i < CONTENTION_THREADS; i++) CloseHandle( threads[i] );
+    }
+
+    ok( !contention.address, "got %d\n", contention.address );
+    ok( !contention.address64, "got %s\n", wine_dbgstr_longlong(contention.address64) );
+    DeleteCriticalSection( &contention.cs );
+    DeleteCriticalSection( &contention.cs_spin );
+    DeleteCriticalSection( &contention.cs_no_debug_info );
+    CloseHandle( contention.start_event );
+}
+
+static void test_handle_churn(void)
+{
+    static const char *names[] = { "create", "wait", "duplicate and reset", "close" };
+    LARGE_INTEGER frequency, start, end, zero = {{0}};
+    ULONGLONG elapsed[ARRAY_SIZE(names)] = {0};
+    unsigned int i, round, count = 1000;
+    HANDLE *events, dup;
+    NTSTATUS status;
+    LONG prev_state;
+
+    QueryPerformanceFrequency( &frequency );
+    events = HeapAlloc( GetProcessHeap(), 0, count * sizeof(*events) );
+
+    for (round = 0; round < (winetest_interactive ? 1000 : 10); round++)
+    {
+        QueryPerformanceCounter( &start );
+        for (i = 0; i < count; i++)
+        {
+            status = pNtCreateEvent( &events[i], EVENT_ALL_ACCESS, NULL, NotificationEvent, TRUE );
+            ok( !status, "NtCreateEvent failed %08x\n", status );
+        }
+        QueryPerformanceCounter( &end );
+        elapsed[0] += end.QuadPart - start.QuadPart;
+
+        start = end;
+        for (i = 0; i < count; i++)
+        {
+            status = NtWaitForSingleObject( events[i], FALSE, &zero );
+            ok( !status, "NtWaitForSingleObject returned %08x\n", status );
+        }
+        QueryPerformanceCounter( &end );
+        elapsed[1] += end.QuadPart - start.QuadPart;
+
+        /* duplicated handles replace the originals */
+        start = end;
+        for (i = 0; i < count; i++)
+        {
+            if (!DuplicateHandle( GetCurrentProcess(), events[i], GetCurrentProcess(), &dup,
+                                  0, FALSE, DUPLICATE_SAME_ACCESS | DUPLICATE_CLOSE_SOURCE ))
+            {
+                ok( 0, "DuplicateHandle failed %u\n", GetLastError() );
+                continue;
+            }
+            events[i] = dup;
+            status = NtWaitForSingleObject( events[i], FALSE, &zero );
+            ok( !status, "NtWaitForSingleObject returned %08x\n", status );
+            prev_state = 0xdeadbeef;
+            status = pNtResetEvent( events[i], &prev_state );
+            ok( !status, "NtResetEvent failed %08x\n", status );
+            ok( prev_state == 1, "got prev_state %d\n", prev_state );
+            status = NtWaitForSingleObject( events[i], FALSE, &zero );
+            ok( status == STATUS_TIMEOUT, "NtWaitForSingleObject returned %08x\n", status );
+        }
+        QueryPerformanceCounter( &end );
+        elapsed[2] += end.QuadPart - start.QuadPart;
+
+        start = end;
+        for (i = 0; i < count; i++)
+        {
+            status = pNtClose( events[i] );
+            ok( !status, "NtClose failed %08x\n", status );
+        }
+        QueryPerformanceCounter( &end );
+        elapsed[3] += end.QuadPart - start.QuadPart;
+
+        status = NtWaitForSingleObject( events[count - 1], FALSE, &zero );
+        ok( status == STATUS_INVALID_HANDLE, "NtWaitForSingleObject returned %08x\n", status );
+    }
+
+    if (winetest_debug > 1)
+    {
+        for (i = 0; i < ARRAY_SIZE(names); i++)
+            trace( "%s: %u ns per handle\n", names[i],
+                   (unsigned int)(elapsed[i] * 1000000000 / frequency.QuadPart / (round * count)) );
+    }
+
+    HeapFree( GetProcessHeap(), 0, events );
+}
+
+static void test_delay_execution(void)
+{
+    static const unsigned int delays[] = { 0, 1, 2, 5 };
+    LARGE_INTEGER frequency, start, end, timeout;
+    unsigned int i, j, count = winetest_interactive ? 1000 : 20;
+    LONGLONG elapsed, max_elapsed;
+    NTSTATUS status;
+
+    QueryPerformanceFrequency( &frequency );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count * 100; i++)
+    {
+        status = NtYieldExecution();
+        ok( status == STATUS_SUCCESS || status == STATUS_NO_YIELD_PERFORMED,
+            "NtYieldExecution returned %08x\n", status );
+    }
+    QueryPerformanceCounter( &end );
+    if (winetest_debug > 1)
+        trace( "yield: %u ns per call\n", (unsigned int)((end.QuadPart - start.QuadPart) * 1000000000
+               / frequency.QuadPart / (count * 100)) );
+
+    /* granularity of short sleeps */
+    for (i = 0; i < ARRAY_SIZE(delays); i++)
+    {
+        timeout.QuadPart = (LONGLONG)delays[i] * -10000;
+        elapsed = max_elapsed = 0;
+        for (j = 0; j < count; j++)
+        {
+            QueryPerformanceCounter( &start );
+            status = NtDelayExecution( FALSE, &timeout );
+            QueryPerformanceCounter( &end );
+            ok( status == STATUS_SUCCESS, "NtDelayExecution returned %08x\n", status );
+            /* allow for the performance counter being coarser than the sleep clock */
+            ok( (end.QuadPart - start.QuadPart) * 1000 + frequency.QuadPart / 1000 >= delays[i] * frequency.QuadPart,
+                "sleep %u ms returned after %u us\n", delays[i],
+                (unsigned int)((end.QuadPart - start.QuadPart) * 1000000 / frequency.QuadPart) );
+            elapsed += end.QuadPart - start.QuadPart;
+            max_elapsed = max( max_elapsed, end.QuadPart - start.QuadPart );
+        }
+        if (winetest_debug > 1)
+            trace( "sleep %u ms: average %u us, max %u us\n", delays[i],
+                   (unsigned int)(elapsed * 1000000 / frequency.QuadPart / count),
+                   (unsigned int)(max_elapsed * 1000000 / frequency.QuadPart) );
+    }
+
+    timeout.QuadPart = 0;
+    status = NtDelayExecution( TRUE, &timeout );
+    ok( status == STATUS_SUCCESS, "NtDelayExecution returned %08x\n", status );
+
+    timeout.QuadPart = -10000;
+    status = NtDelayExecution( TRUE, &timeout );
+    ok( status == STATUS_SUCCESS, "NtDelayExecution returned %08x\n", status );
+}
+
 static HANDLE thread_ready, thread_done;
 
 static DWORD WINAPI resource_shared_thread(void *arg)
@@ -942,6 +1256,9 @@ START_TEST(sync)
     pRtlWakeAddressSingle           = (void *)GetProcAddress(module, "RtlWakeAddressSingle");
 
     test_wait_on_address();
+    test_lock_contention();
+    test_handle_churn();
+    test_delay_execution();
     test_event();
     test_mutant();
     test_semaphore();
@@ -0,0 +1,102 @@
+/*
+ * Benchmarks for the system call transitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdarg.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+#include "wine/test.h"
+
+static NTSTATUS (WINAPI *pNtClose)( HANDLE );
+static NTSTATUS (WINAPI *pNtCreateEvent)( HANDLE *, ACCESS_MASK, const OBJECT_ATTRIBUTES *, EVENT_TYPE, BOOLEAN );
+static ULONG    (WINAPI *pNtGetCurrentProcessorNumber)(void);
+static NTSTATUS (WINAPI *pNtQueryObject)( HANDLE, OBJECT_INFORMATION_CLASS, void *, ULONG, ULONG * );
+static NTSTATUS (WINAPI *pNtQueryPerformanceCounter)( LARGE_INTEGER *, LARGE_INTEGER * );
+
+#define LOOP_COUNT 10000
+
+static LARGE_INTEGER frequency;
+
+static LONGLONG get_time(void)
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter( &counter );
+    return counter.QuadPart;
+}
+
+static void trace_time( const char *name, LONGLONG start, unsigned int count )
+{
+    if (winetest_debug > 1)
+        trace( "%-28s %6u ns\n", name,
+               (unsigned int)((get_time() - start) * 1000000000 / frequency.QuadPart / count) );
+}
+
+static void test_syscall_overhead(void)
+{
+    static HANDLE handles[LOOP_COUNT];
+    OBJECT_BASIC_INFORMATION info;
+    LARGE_INTEGER counter;
+    NTSTATUS status;
+    LONGLONG start;
+    unsigned int i;
+
+    /* cheapest possible round trip, the unix side is a single vdso or cpu instruction */
+    start = get_time();
+    for (i = 0; i < LOOP_COUNT; i++) pNtGetCurrentProcessorNumber();
+    trace_time( "NtGetCurrentProcessorNumber", start, LOOP_COUNT );
+
+    start = get_time();
+    for (i = 0; i < LOOP_COUNT; i++) pNtQueryPerformanceCounter( &counter, NULL );
+    trace_time( "NtQueryPerformanceCounter", start, LOOP_COUNT );
+
+    for (i = 0; i < LOOP_COUNT; i++)
+    {
+        status = pNtCreateEvent( &handles[i], EVENT_ALL_ACCESS, NULL, NotificationEvent, FALSE );
+        ok( !status, "NtCreateEvent failed %#x\n", status );
+    }
+
+    /* wineserver round trip */
+    start = get_time();
+    for (i = 0; i < LOOP_COUNT; i++) pNtQueryObject( handles[i], ObjectBasicInformation, &info, sizeof(info), NULL );
+    trace_time( "NtQueryObject", start, LOOP_COUNT );
+
+    start = get_time();
+    for (i = 0; i < LOOP_COUNT; i++)
+    {
+        status = pNtClose( handles[i] );
+        ok( !status, "NtClose failed %#x\n", status );
+    }
+    trace_time( "NtClose", start, LOOP_COUNT );
+}
+
+START_TEST(syscall)
+{
+    HMODULE module = GetModuleHandleA( "ntdll.dll" );
+
+    pNtClose                     = (void *)GetProcAddress( module, "NtClose" );
+    pNtCreateEvent               = (void *)GetProcAddress( module, "NtCreateEvent" );
+    pNtGetCurrentProcessorNumber = (void *)GetProcAddress( module, "NtGetCurrentProcessorNumber" );
+    pNtQueryObject               = (void *)GetProcAddress( module, "NtQueryObject" );
+    pNtQueryPerformanceCounter   = (void *)GetProcAddress( module, "NtQueryPerformanceCounter" );
+
+    QueryPerformanceFrequency( &frequency );
+
+    test_syscall_overhead();
+}
@@ -567,6 +567,24 @@ static void CALLBACK simple_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
     ReleaseSemaphore(semaphore, 1, NULL);
 }
 
+struct affinity_info
+{
+    HANDLE semaphore;
+    ULONG_PTR mask;
+};
+
+static void CALLBACK affinity_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    struct affinity_info *info = userdata;
+    THREAD_BASIC_INFORMATION tbi;
+    NTSTATUS status;
+
+    status = NtQueryInformationThread(GetCurrentThread(), ThreadBasicInformation, &tbi, sizeof(tbi), NULL);
+    ok(!status, "NtQueryInformationThread failed with status %x\n", status);
+    info->mask = tbi.AffinityMask;
+    ReleaseSemaphore(info->semaphore, 1, NULL);
+}
+
 static void CALLBACK simple2_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
 {
     Sleep(50);
@@ -578,6 +596,8 @@ static void test_tp_simple(void)
     TP_CALLBACK_ENVIRON environment;
     TP_CALLBACK_ENVIRON_V3 environment3;
     TP_CLEANUP_GROUP *group;
+    struct affinity_info affinity;
+    ULONG_PTR process_mask, system_mask;
     HANDLE semaphore;
     NTSTATUS status;
     TP_POOL *pool;
@@ -612,6 +632,17 @@ static void test_tp_simple(void)
     result = WaitForSingleObject(semaphore, 1000);
     ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
 
+    /* workers are shared, they must not be restricted to a subset of the processors */
+    GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+    affinity.semaphore = semaphore;
+    affinity.mask = 0;
+    status = pTpSimpleTryPost(affinity_cb, &affinity, &environment);
+    ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+    result = WaitForSingleObject(semaphore, 1000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+    ok(affinity.mask == process_mask, "got worker affinity %lx, expected %lx\n",
+       (DWORD_PTR)affinity.mask, (DWORD_PTR)process_mask);
+
     /* test with environment version 3 */
     memset(&environment3, 0, sizeof(environment3));
     environment3.Version = 3;
@@ -811,6 +842,101 @@ static void test_tp_work_scheduler(void)
     pTpReleasePool(pool);
 }
 
+#define THROUGHPUT_PRODUCERS 8
+#define THROUGHPUT_WORK_ITEMS 16
+
+struct throughput_producer
+{
+    TP_WORK *work[THROUGHPUT_WORK_ITEMS];
+    HANDLE start_event;
+    DWORD count;
+};
+
+static void CALLBACK throughput_work_cb(TP_CALLBACK_INSTANCE *instance, void *userdata, TP_WORK *work)
+{
+    InterlockedIncrement((LONG *)userdata);
+}
+
+static DWORD CALLBACK throughput_producer_proc(void *arg)
+{
+    struct throughput_producer *producer = arg;
+    DWORD i;
+
+    WaitForSingleObject(producer->start_event, INFINITE);
+    for (i = 0; i < producer->count; i++)
+        pTpPostWork(producer->work[i % THROUGHPUT_WORK_ITEMS]);
+    return 0;
+}
+
+static void test_tp_work_throughput(void)
+{
+    struct throughput_producer producers[THROUGHPUT_PRODUCERS];
+    HANDLE threads[THROUGHPUT_PRODUCERS], start_event;
+    TP_CALLBACK_ENVIRON environment;
+    LARGE_INTEGER frequency, start, end;
+    DWORD total, i, j;
+    NTSTATUS status;
+    LONG userdata;
+    TP_POOL *pool;
+
+    /* 10M tiny work items are too slow for a regular test run */
+    if (winetest_interactive) total = 10000000;
+    else if (winetest_debug > 1) total = 200000;
+    else total = 20000;
+
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %x\n", status);
+    ok(pool != NULL, "expected pool != NULL\n");
+
+    start_event = CreateEventW(NULL, TRUE, FALSE, NULL);
+    ok(start_event != NULL, "CreateEvent failed with %u\n", GetLastError());
+
+    memset(&environment, 0, sizeof(environment));
+    environment.Version = 1;
+    environment.Pool = pool;
+
+    userdata = 0;
+    for (i = 0; i < THROUGHPUT_PRODUCERS; i++)
+    {
+        for (j = 0; j < THROUGHPUT_WORK_ITEMS; j++)
+        {
+            producers[i].work[j] = NULL;
+            status = pTpAllocWork(&producers[i].work[j], throughput_work_cb, &userdata, &environment);
+            ok(!status, "TpAllocWork failed with status %x\n", status);
+        }
+        producers[i].start_event = start_event;
+        producers[i].count = total / THROUGHPUT_PRODUCERS;
+        threads[i] = CreateThread(NULL, 0, throughput_producer_proc, &producers[i], 0, NULL);
+        ok(threads[i] != NULL, "CreateThread failed with %u\n", GetLastError());
+    }
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    SetEvent(start_event);
+
+    WaitForMultipleObjects(THROUGHPUT_PRODUCERS, threads, TRUE, INFINITE);
+    for (i = 0; i < THROUGHPUT_PRODUCERS; i++)
+        for (j = 0; j < THROUGHPUT_WORK_ITEMS; j++)
+            pTpWaitForWork(producers[i].work[j], FALSE);
+
+    QueryPerformanceCounter(&end);
+    ok(userdata == total, "expected userdata = %u, got %u\n", total, userdata);
+    if (winetest_debug > 1)
+        trace("%u work items from %u producers in %u ms\n", total, THROUGHPUT_PRODUCERS,
+              (DWORD)((end.QuadPart - start.QuadPart) * 1000 / frequency.QuadPart));
+
+    /* cleanup */
+    for (i = 0; i < THROUGHPUT_PRODUCERS; i++)
+    {
+        CloseHandle(threads[i]);
+        for (j = 0; j < THROUGHPUT_WORK_ITEMS; j++)
+            pTpReleaseWork(producers[i].work[j]);
+    }
+    CloseHandle(start_event);
+    pTpReleasePool(pool);
+}
+
 static void CALLBACK simple_release_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
 {
     HANDLE *semaphores = userdata;
@@ -1606,6 +1732,104 @@ static void test_tp_window_length(void)
     CloseHandle(semaphore);
 }
 
+struct many_timers_info
+{
+    HANDLE semaphore;
+    LARGE_INTEGER due;
+    LONG early;
+    LONG fired;
+};
+
+static void CALLBACK many_timers_cb(TP_CALLBACK_INSTANCE *instance, void *userdata, TP_TIMER *timer)
+{
+    struct many_timers_info *info = userdata;
+    LARGE_INTEGER now;
+
+    NtQuerySystemTime(&now);
+    if (now.QuadPart < info->due.QuadPart) InterlockedIncrement(&info->early);
+    InterlockedIncrement(&info->fired);
+    ReleaseSemaphore(info->semaphore, 1, NULL);
+}
+
+static void test_tp_many_timers(void)
+{
+    struct many_timers_info info[64], cancelled;
+    TP_CALLBACK_ENVIRON environment;
+    TP_TIMER *timers[64], *timer;
+    LARGE_INTEGER when;
+    HANDLE semaphore;
+    NTSTATUS status;
+    TP_POOL *pool;
+    DWORD result;
+    int i;
+
+    semaphore = CreateSemaphoreA(NULL, 0, ARRAY_SIZE(timers) + 1, NULL);
+    ok(semaphore != NULL, "CreateSemaphoreA failed %u\n", GetLastError());
+
+    /* allocate new threadpool */
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %x\n", status);
+    ok(pool != NULL, "expected pool != NULL\n");
+
+    memset(&environment, 0, sizeof(environment));
+    environment.Version = 1;
+    environment.Pool = pool;
+
+    /* timers with due times in random order, spread over more than 64ms */
+    for (i = 0; i < ARRAY_SIZE(timers); i++)
+    {
+        memset(&info[i], 0, sizeof(info[i]));
+        info[i].semaphore = semaphore;
+        timers[i] = NULL;
+        status = pTpAllocTimer(&timers[i], many_timers_cb, &info[i], &environment);
+        ok(!status, "TpAllocTimer failed with status %x\n", status);
+        ok(timers[i] != NULL, "expected timers[%d] != NULL\n", i);
+    }
+
+    /* a timer which gets cancelled before it expires */
+    memset(&cancelled, 0, sizeof(cancelled));
+    cancelled.semaphore = semaphore;
+    timer = NULL;
+    status = pTpAllocTimer(&timer, many_timers_cb, &cancelled, &environment);
+    ok(!status, "TpAllocTimer failed with status %x\n", status);
+    ok(timer != NULL, "expected timer != NULL\n");
+    NtQuerySystemTime(&when);
+    when.QuadPart += (ULONGLONG)100 * 10000;
+    pTpSetTimer(timer, &when, 0, 0);
+
+    NtQuerySystemTime(&when);
+    for (i = 0; i < ARRAY_SIZE(timers); i++)
+    {
+        info[i].due.QuadPart = when.QuadPart + (ULONGLONG)((i * 37) % 200) * 10000;
+        pTpSetTimer(timers[i], &info[i].due, 0, (i % 4) * 10);
+    }
+    pTpSetTimer(timer, NULL, 0, 0);
+
+    for (i = 0; i < ARRAY_SIZE(timers); i++)
+    {
+        result = WaitForSingleObject(semaphore, 1000);
+        ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+    }
+    result = WaitForSingleObject(semaphore, 100);
+    ok(result == WAIT_TIMEOUT, "WaitForSingleObject returned %u\n", result);
+
+    for (i = 0; i < ARRAY_SIZE(timers); i++)
+    {
+        ok(info[i].fired == 1, "timer %d fired %d times\n", i, info[i].fired);
+        ok(!info[i].early || broken(info[i].early) /* timer resolution */,
+           "timer %d fired before its due time\n", i);
+    }
+    ok(!cancelled.fired, "cancelled timer fired\n");
+
+    /* cleanup */
+    for (i = 0; i < ARRAY_SIZE(timers); i++)
+        pTpReleaseTimer(timers[i]);
+    pTpReleaseTimer(timer);
+    pTpReleasePool(pool);
+    CloseHandle(semaphore);
+}
+
 struct wait_info
 {
     HANDLE semaphore;
@@ -1875,18 +2099,27 @@ static void CALLBACK multi_wait_cb(TP_CALLBACK_INSTANCE *instance, void *userdat
         multi_wait_info.result = index;
     else if (result == WAIT_TIMEOUT)
         multi_wait_info.result = 0x10000 | index;
+    else if (result == WAIT_ABANDONED_0)
+        multi_wait_info.result = 0x20000 | index;
     else
         ok(0, "unexpected result %u\n", result);
     ReleaseSemaphore(multi_wait_info.semaphore, 1, NULL);
 }
 
+static DWORD WINAPI multi_wait_abandon_thread(void *arg)
+{
+    DWORD result = WaitForSingleObject(arg, 1000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+    return 0;
+}
+
 static void test_tp_multi_wait(void)
 {
     TP_CALLBACK_ENVIRON environment;
     HANDLE semaphores[512];
     TP_WAIT *waits[512];
     LARGE_INTEGER when;
-    HANDLE semaphore;
+    HANDLE semaphore, timer, mutex, thread;
     NTSTATUS status;
     TP_POOL *pool;
     DWORD result;
@@ -1962,6 +2195,56 @@ static void test_tp_multi_wait(void)
 
     ok(multi_wait_info.result >> 16, "expected multi_wait_info.result >> 16 != 0\n");
 
+    /* mix in a waitable timer, other objects still have to be signaled */
+    timer = CreateWaitableTimerW(NULL, TRUE, NULL);
+    ok(timer != NULL, "failed to create waitable timer\n");
+    for (i = 0; i < ARRAY_SIZE(semaphores); i++)
+        pTpSetWait(waits[i], i == 100 ? timer : semaphores[i], NULL);
+
+    for (i = 500; i >= 0; i -= 100)
+    {
+        multi_wait_info.result = 0;
+        if (i == 100)
+        {
+            when.QuadPart = (ULONGLONG)10 * -10000;
+            SetWaitableTimer(timer, &when, 0, NULL, NULL, FALSE);
+        }
+        else ReleaseSemaphore(semaphores[i], 1, NULL);
+
+        result = WaitForSingleObject(semaphore, 1000);
+        ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+        ok(multi_wait_info.result == i, "expected result %d, got %u\n", i, multi_wait_info.result);
+    }
+    CancelWaitableTimer(timer);
+
+    /* a timeout or an abandoned mutex must not be reported as another object
+     * being signaled, even when more than 0x80 objects are waited on */
+    mutex = CreateMutexW(NULL, FALSE, NULL);
+    ok(mutex != NULL, "failed to create mutex\n");
+    thread = CreateThread(NULL, 0, multi_wait_abandon_thread, mutex, 0, NULL);
+    ok(thread != NULL, "failed to create thread\n");
+    result = WaitForSingleObject(thread, 1000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+    CloseHandle(thread);
+
+    multi_wait_info.result = 0;
+    when.QuadPart = (ULONGLONG)50 * -10000;
+    for (i = 0; i < ARRAY_SIZE(semaphores); i++)
+        pTpSetWait(waits[i], i == 0 ? mutex : semaphores[i], i == 300 ? &when : NULL);
+
+    result = WaitForSingleObject(semaphore, 1000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+    ok(multi_wait_info.result == 0 || multi_wait_info.result == (0x20000 | 0),
+       "expected result 0, got %#x\n", multi_wait_info.result);
+
+    multi_wait_info.result = 0;
+    result = WaitForSingleObject(semaphore, 1000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+    ok(multi_wait_info.result == (0x10000 | 300), "expected result 0x1012c, got %#x\n", multi_wait_info.result);
+
+    result = WaitForSingleObject(semaphore, 100);
+    ok(result == WAIT_TIMEOUT, "WaitForSingleObject returned %u\n", result);
+
     /* destroy the wait objects and semaphores while waiting */
     for (i = 0; i < ARRAY_SIZE(semaphores); i++)
     {
@@ -1978,6 +2261,8 @@ static void test_tp_multi_wait(void)
 
     pTpReleasePool(pool);
     CloseHandle(semaphore);
+    CloseHandle(timer);
+    CloseHandle(mutex);
 }
 
 struct io_cb_ctx
@@ -2370,12 +2655,14 @@ START_TEST(threadpool)
     test_tp_simple();
     test_tp_work();
     test_tp_work_scheduler();
+    test_tp_work_throughput();
     test_tp_group_wait();
     test_tp_group_cancel();
     test_tp_instance();
     test_tp_disassociate();
     test_tp_timer();
     test_tp_window_length();
+    test_tp_many_timers();
     test_tp_wait();
     test_tp_multi_wait();
     test_tp_io();
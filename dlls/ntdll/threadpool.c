@@ -68,11 +68,37 @@ static RTL_CRITICAL_SECTION_DEBUG critsect_compl_debug =
       0, 0, { (DWORD_PTR)(__FILE__ ": threadpool_compl_cs") }
 };
 
+/* hierarchical timer wheel: timers are kept in slots which get wider the
+ * further in the future the timers expire, and are moved down a level when
+ * the current time reaches their slot */
+#define TIMER_WHEEL_BITS    6
+#define TIMER_WHEEL_SLOTS   (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS  4
+#define TIMER_WHEEL_DETACHED 0xff   /* not in a slot, e.g. expired */
+
+struct timer_wheel_entry
+{
+    struct list entry;
+    ULONGLONG   expire;             /* expiration time in ticks */
+    ULONGLONG   window;             /* ticks the expiration may be delayed, to coalesce timers */
+    BYTE        level;              /* level of the slot, TIMER_WHEEL_LEVELS for the overflow list */
+    BYTE        slot;
+};
+
+struct timer_wheel
+{
+    ULONGLONG   now;                /* first tick which hasn't been expired yet */
+    ULONG64     occupied[TIMER_WHEEL_LEVELS];
+    struct list slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    struct list overflow;           /* timers beyond the range of the highest level */
+};
+
 struct timer_queue;
 struct queue_timer
 {
     struct timer_queue *q;
     struct list entry;
+    struct timer_wheel_entry wheel_entry;
     ULONG runcount;             /* number of callbacks pending execution */
     RTL_WAITORTIMERCALLBACKFUNC callback;
     PVOID param;
@@ -87,7 +113,10 @@ struct timer_queue
 {
     DWORD magic;
     RTL_CRITICAL_SECTION cs;
-    struct list timers;         /* sorted by expiration time */
+    struct list timers;         /* all timers of the queue */
+    struct timer_wheel wheel;   /* pending timers, in ms */
+    struct list expired;        /* expired timers not processed yet */
+    ULONGLONG deadline;         /* time the queue thread wakes up at */
     BOOL quit;                  /* queue should be deleted; once set, never unset */
     HANDLE event;
     HANDLE thread;
@@ -100,6 +129,49 @@ struct timer_queue
 #define THREADPOOL_WORKER_TIMEOUT 5000
 #define MAXIMUM_WAITQUEUE_OBJECTS (MAXIMUM_WAIT_OBJECTS - 1)
 
+#define THREADPOOL_QUEUE_SIZE     1024  /* slots of the shared queue of each priority */
+#define THREADPOOL_DEQUE_SIZE     256   /* slots of the local deque of each priority */
+#define THREADPOOL_MAX_DEQUES     64    /* further workers only use the shared queues */
+#define THREADPOOL_FAIRNESS_TICKS 32    /* check the shared queue first every that many items */
+
+struct threadpool_object;
+
+/* bounded queue of objects submitted from outside the worker threads, any thread
+ * may add or remove objects without locking */
+struct threadpool_queue
+{
+    LONG                    head;
+    LONG                    tail;
+    struct
+    {
+        LONG                      seq;
+        struct threadpool_object *object;
+    } slots[THREADPOOL_QUEUE_SIZE];
+    /* objects which didn't fit in the slots, locked via pool->cs */
+    LONG                    overflow_count;
+    struct list             overflow;
+};
+
+/* work-stealing deque of a worker thread: the owner adds and removes objects at the
+ * bottom, idle workers steal them from the top */
+struct threadpool_deque
+{
+    LONG                    top;
+    LONG                    bottom;
+    struct threadpool_object *objects[THREADPOOL_DEQUE_SIZE];
+};
+
+/* per worker queues, reused by a later worker once their owner is gone */
+struct threadpool_worker
+{
+    struct threadpool      *pool;
+    BOOL                    in_use;     /* locked via pool->cs */
+    unsigned int            index;
+    unsigned int            tick;
+    /* order matches TP_CALLBACK_PRIORITY - high, normal, low. */
+    struct threadpool_deque deques[3];
+};
+
 /* internal threadpool representation */
 struct threadpool
 {
@@ -107,14 +179,19 @@ struct threadpool
     LONG                    objcount;
     BOOL                    shutdown;
     CRITICAL_SECTION        cs;
-    /* Pools of work items, locked via .cs, order matches TP_CALLBACK_PRIORITY - high, normal, low. */
-    struct list             pools[3];
-    RTL_CONDITION_VARIABLE  update_event;
-    /* information about worker threads, locked via .cs */
+    /* Queues of objects with pending callbacks, order matches TP_CALLBACK_PRIORITY - high, normal, low. */
+    struct threadpool_queue queues[3];
+    /* per worker deques, allocated via .cs and never freed before the pool */
+    struct threadpool_worker *workers[THREADPOOL_MAX_DEQUES];
+    LONG                    num_worker_slots;
+    LONG                    wake_seq;
+    LONG                    num_idle_workers;
+    /* information about worker threads, changed via .cs */
     int                     max_workers;
     int                     min_workers;
-    int                     num_workers;
-    int                     num_busy_workers;
+    LONG                    num_workers;
+    LONG                    num_busy_workers;
+    ULONG                   ideal_processor; /* soft placement of the last created worker */
     HANDLE                  compl_port;
     TP_POOL_STACK_INFORMATION stack_info;
 };
@@ -153,10 +230,11 @@ struct threadpool_object
     /* information about the group, locked via .group->cs */
     struct list             group_entry;
     BOOL                    is_group_member;
-    /* information about the pool, locked via .pool->cs */
-    struct list             pool_entry;
-    RTL_CONDITION_VARIABLE  finished_event;
-    RTL_CONDITION_VARIABLE  group_finished_event;
+    /* information about the pool, the counters are updated with interlocked operations */
+    struct list             pool_entry;         /* entry in an overflow list, locked via .pool->cs */
+    LONG                    queued;             /* object is in one of the pool queues */
+    LONG                    finished_seq;       /* incremented when callbacks finish */
+    LONG                    num_finish_waiters;
     HANDLE                  completed_event;
     LONG                    num_pending_callbacks;
     LONG                    num_running_callbacks;
@@ -178,7 +256,7 @@ struct threadpool_object
             /* information about the timer, locked via timerqueue.cs */
             BOOL            timer_initialized;
             BOOL            timer_pending;
-            struct list     timer_entry;
+            struct timer_wheel_entry timer_entry;
             BOOL            timer_set;
             ULONGLONG       timeout;
             LONG            period;
@@ -191,6 +269,7 @@ struct threadpool_object
             /* information about the wait object, locked via waitqueue.cs */
             struct waitqueue_bucket *bucket;
             BOOL            wait_pending;
+            BOOL            server_wait;    /* handle can't be waited on by wide buckets */
             struct list     wait_entry;
             ULONGLONG       timeout;
             HANDLE          handle;
@@ -244,7 +323,8 @@ static struct
     CRITICAL_SECTION        cs;
     LONG                    objcount;
     BOOL                    thread_running;
-    struct list             pending_timers;
+    struct timer_wheel      wheel;
+    ULONGLONG               deadline;
     RTL_CONDITION_VARIABLE  update_event;
 }
 timerqueue =
@@ -252,7 +332,8 @@ timerqueue =
     { &timerqueue_debug, -1, 0, 0, 0, 0 },      /* cs */
     0,                                          /* objcount */
     FALSE,                                      /* thread_running */
-    LIST_INIT( timerqueue.pending_timers ),     /* pending_timers */
+    { 0 },                                      /* wheel */
+    EXPIRE_NEVER,                               /* deadline */
     RTL_CONDITION_VARIABLE_INIT                 /* update_event */
 };
 
@@ -270,12 +351,14 @@ static struct
 {
     CRITICAL_SECTION        cs;
     LONG                    num_buckets;
+    LONG                    max_wide_objects;
     struct list             buckets;
 }
 waitqueue =
 {
     { &waitqueue_debug, -1, 0, 0, 0, 0 },       /* cs */
     0,                                          /* num_buckets */
+    -1,                                         /* max_wide_objects */
     LIST_INIT( waitqueue.buckets )              /* buckets */
 };
 
@@ -286,14 +369,23 @@ static RTL_CRITICAL_SECTION_DEBUG waitqueue_debug =
       0, 0, { (DWORD_PTR)(__FILE__ ": waitqueue.cs") }
 };
 
+/* Wide buckets wait for up to waitqueue.max_wide_objects objects with a
+ * single __wine_wait_any_objects call, which is available with esync or
+ * fsync and returns the index of the signaled object separately. Wait
+ * objects with handles which need a server wait are moved to regular
+ * buckets. */
 struct waitqueue_bucket
 {
     struct list             bucket_entry;
     LONG                    objcount;
+    LONG                    capacity;
     struct list             reserved;
     struct list             waiting;
     HANDLE                  update_event;
     BOOL                    alertable;
+    BOOL                    wide;
+    struct threadpool_object **objects;
+    HANDLE                 *handles;
 };
 
 /* global I/O completion queue object */
@@ -364,6 +456,9 @@ static inline struct threadpool_instance *impl_from_TP_CALLBACK_INSTANCE( TP_CAL
 
 static void CALLBACK threadpool_worker_proc( void *param );
 static void tp_object_submit( struct threadpool_object *object, BOOL signaled );
+static BOOL tp_object_claim( struct threadpool_object *object );
+static void tp_object_signal_finished( struct threadpool_object *object );
+static BOOL tp_waitqueue_move( struct threadpool_object *wait, BOOL wide );
 static void tp_object_execute( struct threadpool_object *object, BOOL wait_thread );
 static void tp_object_prepare_shutdown( struct threadpool_object *object );
 static BOOL tp_object_release( struct threadpool_object *object );
@@ -547,6 +642,214 @@ static inline PLARGE_INTEGER get_nt_timeout( PLARGE_INTEGER pTime, ULONG timeout
 }
 
 
+/************************** Timer Wheel Impl **************************/
+
+static void timer_wheel_init( struct timer_wheel *wheel, ULONGLONG now )
+{
+    unsigned int i, j;
+
+    wheel->now = now;
+    for (i = 0; i < TIMER_WHEEL_LEVELS; i++)
+    {
+        wheel->occupied[i] = 0;
+        for (j = 0; j < TIMER_WHEEL_SLOTS; j++)
+            list_init( &wheel->slots[i][j] );
+    }
+    list_init( &wheel->overflow );
+}
+
+static unsigned int timer_wheel_first_slot( ULONG64 bits )
+{
+    DWORD index;
+
+    if (BitScanForward( &index, (DWORD)bits )) return index;
+    BitScanForward( &index, (DWORD)(bits >> 32) );
+    return index + 32;
+}
+
+/* start time of a slot, relative to the current time of the wheel */
+static ULONGLONG timer_wheel_slot_start( const struct timer_wheel *wheel, unsigned int level, unsigned int slot )
+{
+    unsigned int shift = TIMER_WHEEL_BITS * level;
+
+    if (level == TIMER_WHEEL_LEVELS)
+        return ((wheel->now >> shift) + 1) << shift;
+    return ((wheel->now >> (shift + TIMER_WHEEL_BITS)) << (shift + TIMER_WHEEL_BITS)) | ((ULONGLONG)slot << shift);
+}
+
+/***********************************************************************
+ *           timer_wheel_add    (internal)
+ *
+ * Adds a timer to the lowest level that has the current time in the same
+ * block as the expiration time. Timers which have already expired go to
+ * the slot of the current time.
+ */
+static void timer_wheel_add( struct timer_wheel *wheel, struct timer_wheel_entry *entry )
+{
+    ULONGLONG time = max( entry->expire, wheel->now );
+    unsigned int level, shift;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        shift = TIMER_WHEEL_BITS * level;
+        if ((time >> (shift + TIMER_WHEEL_BITS)) != (wheel->now >> (shift + TIMER_WHEEL_BITS))) continue;
+
+        entry->level = level;
+        entry->slot  = (time >> shift) & (TIMER_WHEEL_SLOTS - 1);
+        list_add_tail( &wheel->slots[level][entry->slot], &entry->entry );
+        wheel->occupied[level] |= (ULONG64)1 << entry->slot;
+        return;
+    }
+
+    entry->level = TIMER_WHEEL_LEVELS;
+    entry->slot  = 0;
+    list_add_tail( &wheel->overflow, &entry->entry );
+}
+
+/* remove a timer from the wheel, or from the list of expired timers */
+static void timer_wheel_remove( struct timer_wheel *wheel, struct timer_wheel_entry *entry )
+{
+    list_remove( &entry->entry );
+    if (entry->level < TIMER_WHEEL_LEVELS && list_empty( &wheel->slots[entry->level][entry->slot] ))
+        wheel->occupied[entry->level] &= ~((ULONG64)1 << entry->slot);
+    entry->level = TIMER_WHEEL_DETACHED;
+}
+
+static void timer_wheel_redistribute( struct timer_wheel *wheel, struct list *list )
+{
+    struct timer_wheel_entry *entry, *next;
+    struct list entries = LIST_INIT( entries );
+
+    list_move_tail( &entries, list );
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &entries, struct timer_wheel_entry, entry )
+    {
+        list_remove( &entry->entry );
+        timer_wheel_add( wheel, entry );
+    }
+}
+
+/* move the timers of the slots which start at the current time down a level */
+static void timer_wheel_cascade( struct timer_wheel *wheel )
+{
+    unsigned int level, slot;
+
+    if (!(wheel->now & (((ULONGLONG)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)))
+        timer_wheel_redistribute( wheel, &wheel->overflow );
+
+    for (level = TIMER_WHEEL_LEVELS - 1; level > 0; level--)
+    {
+        if (wheel->now & (((ULONGLONG)1 << (TIMER_WHEEL_BITS * level)) - 1)) continue;
+
+        slot = (wheel->now >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+        if (!(wheel->occupied[level] & ((ULONG64)1 << slot))) continue;
+        wheel->occupied[level] &= ~((ULONG64)1 << slot);
+        timer_wheel_redistribute( wheel, &wheel->slots[level][slot] );
+    }
+}
+
+/* next time after the current block of the lowest level where timers have to be cascaded */
+static ULONGLONG timer_wheel_next_cascade( const struct timer_wheel *wheel )
+{
+    unsigned int level, slot, shift;
+    ULONG64 bits;
+
+    for (level = 1; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        shift = TIMER_WHEEL_BITS * level;
+        slot = (wheel->now >> shift) & (TIMER_WHEEL_SLOTS - 1);
+        if ((bits = wheel->occupied[level] & (~(ULONG64)1 << slot)))
+            return timer_wheel_slot_start( wheel, level, timer_wheel_first_slot( bits ) );
+    }
+    return timer_wheel_slot_start( wheel, TIMER_WHEEL_LEVELS, 0 );
+}
+
+/***********************************************************************
+ *           timer_wheel_expire    (internal)
+ *
+ * Moves all timers expiring up to the given time to the expired list,
+ * skipping over empty slots.
+ */
+static void timer_wheel_expire( struct timer_wheel *wheel, ULONGLONG time, struct list *expired )
+{
+    struct timer_wheel_entry *entry;
+    ULONGLONG tick, next;
+    unsigned int slot;
+    ULONG64 bits;
+
+    if (time < wheel->now) return;
+
+    for (;;)
+    {
+        slot = wheel->now & (TIMER_WHEEL_SLOTS - 1);
+        if ((bits = wheel->occupied[0] & (~(ULONG64)0 << slot)))
+        {
+            slot = timer_wheel_first_slot( bits );
+            tick = (wheel->now & ~(ULONGLONG)(TIMER_WHEEL_SLOTS - 1)) | slot;
+            if (tick > time) break;
+
+            wheel->now = tick;
+            wheel->occupied[0] &= ~((ULONG64)1 << slot);
+            LIST_FOR_EACH_ENTRY( entry, &wheel->slots[0][slot], struct timer_wheel_entry, entry )
+                entry->level = TIMER_WHEEL_DETACHED;
+            list_move_tail( expired, &wheel->slots[0][slot] );
+            continue;
+        }
+
+        next = timer_wheel_next_cascade( wheel );
+        if (next > time + 1) break;
+        wheel->now = next;
+        timer_wheel_cascade( wheel );
+        if (next > time) return;
+    }
+
+    /* nothing to cascade up to the new current time */
+    wheel->now = time + 1;
+}
+
+/***********************************************************************
+ *           timer_wheel_next_deadline    (internal)
+ *
+ * Returns the latest time at which all timers expiring by then can be
+ * expired together without delaying any of them beyond its window, or
+ * EXPIRE_NEVER if there are no timers. Slots are visited in the order of
+ * their start time, until they start after the first window ends.
+ */
+static ULONGLONG timer_wheel_next_deadline( const struct timer_wheel *wheel )
+{
+    ULONGLONG lower = EXPIRE_NEVER, upper = EXPIRE_NEVER;
+    const struct timer_wheel_entry *entry;
+    const struct list *list;
+    unsigned int level, slot;
+    ULONG64 bits;
+
+    for (level = 0; level <= TIMER_WHEEL_LEVELS; level++)
+    {
+        if (level < TIMER_WHEEL_LEVELS)
+        {
+            slot = (wheel->now >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+            /* the current slot of the higher levels has been cascaded already */
+            bits = wheel->occupied[level] & (level ? ~(ULONG64)1 << slot : ~(ULONG64)0 << slot);
+        }
+        else bits = list_empty( &wheel->overflow ) ? 0 : 1;
+
+        while (bits)
+        {
+            slot = timer_wheel_first_slot( bits );
+            bits &= bits - 1;
+            if (timer_wheel_slot_start( wheel, level, slot ) > upper) return lower;
+
+            list = level < TIMER_WHEEL_LEVELS ? &wheel->slots[level][slot] : &wheel->overflow;
+            LIST_FOR_EACH_ENTRY( entry, list, struct timer_wheel_entry, entry )
+                upper = min( upper, entry->expire + entry->window );
+            LIST_FOR_EACH_ENTRY( entry, list, struct timer_wheel_entry, entry )
+                if (entry->expire <= upper && (lower == EXPIRE_NEVER || entry->expire > lower))
+                    lower = entry->expire;
+        }
+    }
+
+    return lower;
+}
+
 /************************** Timer Queue Impl **************************/
 
 static void queue_remove_timer(struct queue_timer *t)
@@ -559,6 +862,8 @@ static void queue_remove_timer(struct queue_timer *t)
     assert(t->runcount == 0);
     assert(t->destroy);
 
+    if (t->expire != EXPIRE_NEVER)
+        timer_wheel_remove(&q->wheel, &t->wheel_entry);
     list_remove(&t->entry);
     if (t->event)
         NtSetEvent(t->event, NULL);
@@ -597,65 +902,70 @@ static inline ULONGLONG queue_current_time(void)
     return now.QuadPart * 1000 / freq.QuadPart;
 }
 
-static void queue_add_timer(struct queue_timer *t, ULONGLONG time,
-                            BOOL set_event)
+static void queue_move_timer(struct queue_timer *t, ULONGLONG time,
+                             BOOL set_event)
 {
     /* We MUST hold the queue cs while calling this function.  */
     struct timer_queue *q = t->q;
-    struct list *ptr = &q->timers;
 
     assert(!q->quit || (t->destroy && time == EXPIRE_NEVER));
 
-    if (time != EXPIRE_NEVER)
-        LIST_FOR_EACH(ptr, &q->timers)
-        {
-            struct queue_timer *cur = LIST_ENTRY(ptr, struct queue_timer, entry);
-            if (time < cur->expire)
-                break;
-        }
-    list_add_before(ptr, &t->entry);
-
+    if (t->expire != EXPIRE_NEVER)
+        timer_wheel_remove(&q->wheel, &t->wheel_entry);
     t->expire = time;
+    if (time == EXPIRE_NEVER)
+        return;
 
-    /* If we insert at the head of the list, we need to expire sooner
-       than expected.  */
-    if (set_event && &t->entry == list_head(&q->timers))
+    t->wheel_entry.expire = time;
+    t->wheel_entry.window = 0;
+    timer_wheel_add(&q->wheel, &t->wheel_entry);
+
+    /* If the timer expires before the thread wakes up, we need to expire
+       sooner than expected.  */
+    if (set_event && time < q->deadline)
+    {
+        q->deadline = time;
         NtSetEvent(q->event, NULL);
+    }
 }
 
-static inline void queue_move_timer(struct queue_timer *t, ULONGLONG time,
-                                    BOOL set_event)
+static inline void queue_add_timer(struct queue_timer *t, ULONGLONG time,
+                                   BOOL set_event)
 {
     /* We MUST hold the queue cs while calling this function.  */
-    list_remove(&t->entry);
-    queue_add_timer(t, time, set_event);
+    list_add_tail(&t->q->timers, &t->entry);
+    t->expire = EXPIRE_NEVER;
+    queue_move_timer(t, time, set_event);
 }
 
 static void queue_timer_expire(struct timer_queue *q)
 {
     struct queue_timer *t = NULL;
 
+    ULONGLONG now, next;
+
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    now = queue_current_time();
+    /* Expire all timers which are due at once, but process only one of
+       them per call.  */
+    if (list_empty(&q->expired))
+        timer_wheel_expire(&q->wheel, now, &q->expired);
+    if (list_head(&q->expired))
     {
-        ULONGLONG now, next;
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
-        if (!t->destroy && t->expire <= ((now = queue_current_time())))
+        t = LIST_ENTRY(list_head(&q->expired), struct queue_timer, wheel_entry.entry);
+        assert(!t->destroy && t->expire <= now);
+
+        ++t->runcount;
+        if (t->period)
         {
-            ++t->runcount;
-            if (t->period)
-            {
-                next = t->expire + t->period;
-                /* avoid trigger cascade if overloaded / hibernated */
-                if (next < now)
-                    next = now + t->period;
-            }
-            else
-                next = EXPIRE_NEVER;
-            queue_move_timer(t, next, FALSE);
+            next = t->expire + t->period;
+            /* avoid trigger cascade if overloaded / hibernated */
+            if (next < now)
+                next = now + t->period;
         }
         else
-            t = NULL;
+            next = EXPIRE_NEVER;
+        queue_move_timer(t, next, FALSE);
     }
     RtlLeaveCriticalSection(&q->cs);
 
@@ -678,20 +988,15 @@ static void queue_timer_expire(struct timer_queue *q)
 
 static ULONG queue_get_timeout(struct timer_queue *q)
 {
-    struct queue_timer *t;
     ULONG timeout = INFINITE;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    if (!list_empty(&q->expired))
+        timeout = 0;
+    else if ((q->deadline = timer_wheel_next_deadline(&q->wheel)) != EXPIRE_NEVER)
     {
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
-        assert(!t->destroy || t->expire == EXPIRE_NEVER);
-
-        if (t->expire != EXPIRE_NEVER)
-        {
-            ULONGLONG time = queue_current_time();
-            timeout = t->expire < time ? 0 : t->expire - time;
-        }
+        ULONGLONG time = queue_current_time();
+        timeout = q->deadline < time ? 0 : min(q->deadline - time, INFINITE - 1);
     }
     RtlLeaveCriticalSection(&q->cs);
 
@@ -717,8 +1022,8 @@ static void WINAPI timer_queue_thread_proc(LPVOID p)
         {
             /* There are two possible ways to trigger the event.  Either
                we are quitting and the last timer got removed, or a new
-               timer got put at the head of the list so we need to adjust
-               our timeout.  */
+               timer expires before the current deadline so we need to
+               adjust our timeout.  */
             RtlEnterCriticalSection(&q->cs);
             if (q->quit && list_empty(&q->timers))
                 done = TRUE;
@@ -750,8 +1055,7 @@ static void queue_destroy_timer(struct queue_timer *t)
            cleanup wrapper.  */
         queue_remove_timer(t);
     else
-        /* Make sure no destroyed timer masks an active timer at the head
-           of the sorted list.  */
+        /* Make sure a destroyed timer doesn't fire again.  */
         queue_move_timer(t, EXPIRE_NEVER, FALSE);
 }
 
@@ -776,6 +1080,9 @@ NTSTATUS WINAPI RtlCreateTimerQueue(PHANDLE NewTimerQueue)
 
     RtlInitializeCriticalSection(&q->cs);
     list_init(&q->timers);
+    timer_wheel_init(&q->wheel, queue_current_time());
+    list_init(&q->expired);
+    q->deadline = EXPIRE_NEVER;
     q->quit = FALSE;
     q->magic = TIMER_QUEUE_MAGIC;
     status = NtCreateEvent(&q->event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE);
@@ -1041,15 +1348,31 @@ NTSTATUS WINAPI RtlDeleteTimer(HANDLE TimerQueue, HANDLE Timer,
     return status;
 }
 
+/***********************************************************************
+ *           tp_timerqueue_add    (internal)
+ *
+ * Adds a timer to the timer wheel. The timer expires in the first
+ * millisecond tick after its timeout. Must be called with timerqueue.cs
+ * held.
+ */
+static void tp_timerqueue_add( struct threadpool_object *timer )
+{
+    struct timer_wheel_entry *entry = &timer->u.timer.timer_entry;
+
+    entry->expire = (timer->u.timer.timeout + 9999) / 10000;
+    entry->window = timer->u.timer.window_length;
+    timer_wheel_add( &timerqueue.wheel, entry );
+    timer->u.timer.timer_pending = TRUE;
+}
+
 /***********************************************************************
  *           timerqueue_thread_proc    (internal)
  */
 static void CALLBACK timerqueue_thread_proc( void *param )
 {
-    ULONGLONG timeout_lower, timeout_upper, new_timeout;
-    struct threadpool_object *other_timer;
+    struct timer_wheel_entry *entry, *next;
+    struct list expired;
     LARGE_INTEGER now, timeout;
-    struct list *ptr;
 
     TRACE( "starting timer queue thread\n" );
 
@@ -1058,17 +1381,18 @@ static void CALLBACK timerqueue_thread_proc( void *param )
     {
         NtQuerySystemTime( &now );
 
-        /* Check for expired timers. */
-        while ((ptr = list_head( &timerqueue.pending_timers )))
+        /* Check for expired timers, the wheel runs in milliseconds. */
+        list_init( &expired );
+        timer_wheel_expire( &timerqueue.wheel, now.QuadPart / 10000, &expired );
+
+        LIST_FOR_EACH_ENTRY_SAFE( entry, next, &expired, struct timer_wheel_entry, entry )
         {
-            struct threadpool_object *timer = LIST_ENTRY( ptr, struct threadpool_object, u.timer.timer_entry );
+            struct threadpool_object *timer = CONTAINING_RECORD( entry, struct threadpool_object, u.timer.timer_entry );
             assert( timer->type == TP_OBJECT_TYPE_TIMER );
             assert( timer->u.timer.timer_pending );
-            if (timer->u.timer.timeout > now.QuadPart)
-                break;
 
             /* Queue a new callback in one of the worker threads. */
-            list_remove( &timer->u.timer.timer_entry );
+            list_remove( &entry->entry );
             timer->u.timer.timer_pending = FALSE;
             tp_object_submit( timer, FALSE );
 
@@ -1079,38 +1403,17 @@ static void CALLBACK timerqueue_thread_proc( void *param )
                 if (timer->u.timer.timeout <= now.QuadPart)
                     timer->u.timer.timeout = now.QuadPart + 1;
 
-                LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                                     struct threadpool_object, u.timer.timer_entry )
-                {
-                    assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-                    if (timer->u.timer.timeout < other_timer->u.timer.timeout)
-                        break;
-                }
-                list_add_before( &other_timer->u.timer.timer_entry, &timer->u.timer.timer_entry );
-                timer->u.timer.timer_pending = TRUE;
+                tp_timerqueue_add( timer );
             }
         }
 
-        timeout_lower = timeout_upper = MAXLONGLONG;
-
-        /* Determine next timeout and use the window length to optimize wakeup times. */
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
-        {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (other_timer->u.timer.timeout >= timeout_upper)
-                break;
-
-            timeout_lower = other_timer->u.timer.timeout;
-            new_timeout   = timeout_lower + (ULONGLONG)other_timer->u.timer.window_length * 10000;
-            if (new_timeout < timeout_upper)
-                timeout_upper = new_timeout;
-        }
+        /* Use the window length of the timers to coalesce wakeups. */
+        timerqueue.deadline = timer_wheel_next_deadline( &timerqueue.wheel );
 
         /* Wait for timer update events or until the next timer expires. */
         if (timerqueue.objcount)
         {
-            timeout.QuadPart = timeout_lower;
+            timeout.QuadPart = timerqueue.deadline == EXPIRE_NEVER ? MAXLONGLONG : timerqueue.deadline * 10000;
             RtlSleepConditionVariableCS( &timerqueue.update_event, &timerqueue.cs, &timeout );
             continue;
         }
@@ -1132,6 +1435,59 @@ static void CALLBACK timerqueue_thread_proc( void *param )
     RtlExitUserThread( 0 );
 }
 
+/* number of NUMA nodes with processors, used to place new workers */
+static ULONG numa_node_count;
+static RTL_RUN_ONCE numa_nodes_once = RTL_RUN_ONCE_INIT;
+
+static DWORD WINAPI tp_init_numa_nodes( RTL_RUN_ONCE *once, void *param, void **context )
+{
+    LOGICAL_PROCESSOR_RELATIONSHIP relation = RelationNumaNode;
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info = NULL, *ptr;
+    NTSTATUS status;
+    ULONG size = 0;
+
+    for (;;)
+    {
+        status = NtQuerySystemInformationEx( SystemLogicalProcessorInformationEx, &relation,
+                                             sizeof(relation), info, size, &size );
+        if (status != STATUS_INFO_LENGTH_MISMATCH) break;
+        RtlFreeHeap( GetProcessHeap(), 0, info );
+        if (!(info = RtlAllocateHeap( GetProcessHeap(), 0, size ))) return TRUE;
+    }
+
+    if (!status)
+    {
+        for (ptr = info; (char *)ptr < (char *)info + size;
+             ptr = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)ptr + ptr->Size))
+        {
+            if (!ptr->u.NumaNode.GroupMask.Mask || ptr->u.NumaNode.GroupMask.Group) continue;
+            numa_node_count++;
+        }
+    }
+
+    TRACE( "found %u NUMA nodes with processors\n", numa_node_count );
+    RtlFreeHeap( GetProcessHeap(), 0, info );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           tp_worker_get_ideal_processor    (internal)
+ *
+ * On hosts with several NUMA nodes, new workers prefer the processor of the
+ * thread submitting the work, so that the data it touches stays local.
+ * Returns ~0u when there is no preference.
+ */
+static ULONG tp_worker_get_ideal_processor(void)
+{
+    ULONG cpu;
+
+    RtlRunOnceExecuteOnce( &numa_nodes_once, tp_init_numa_nodes, NULL, NULL );
+    if (numa_node_count < 2) return ~0u;
+
+    cpu = NtGetCurrentProcessorNumber();
+    return cpu < MAXIMUM_PROCESSORS ? cpu : ~0u;
+}
+
 /***********************************************************************
  *           tp_new_worker_thread    (internal)
  *
@@ -1142,12 +1498,14 @@ static NTSTATUS tp_new_worker_thread( struct threadpool *pool )
     HANDLE thread;
     NTSTATUS status;
 
-    status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, 0, 0, 0,
+    status = RtlCreateUserThread( GetCurrentProcess(), NULL, TRUE, 0, 0, 0,
                                   threadpool_worker_proc, pool, &thread, NULL );
     if (status == STATUS_SUCCESS)
     {
         InterlockedIncrement( &pool->refcount );
-        pool->num_workers++;
+        InterlockedIncrement( &pool->num_workers );
+        pool->ideal_processor = tp_worker_get_ideal_processor();
+        NtResumeThread( thread, NULL );
         NtClose( thread );
     }
     return status;
@@ -1176,7 +1534,13 @@ static NTSTATUS tp_timerqueue_lock( struct threadpool_object *timer )
     /* Make sure that the timerqueue thread is running. */
     if (!timerqueue.thread_running)
     {
+        LARGE_INTEGER now;
         HANDLE thread;
+
+        NtQuerySystemTime( &now );
+        timer_wheel_init( &timerqueue.wheel, now.QuadPart / 10000 );
+        timerqueue.deadline = EXPIRE_NEVER;
+
         status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, 0, 0, 0,
                                       timerqueue_thread_proc, NULL, &thread, NULL );
         if (status == STATUS_SUCCESS)
@@ -1211,14 +1575,14 @@ static void tp_timerqueue_unlock( struct threadpool_object *timer )
         /* If timer was pending, remove it. */
         if (timer->u.timer.timer_pending)
         {
-            list_remove( &timer->u.timer.timer_entry );
+            timer_wheel_remove( &timerqueue.wheel, &timer->u.timer.timer_entry );
             timer->u.timer.timer_pending = FALSE;
         }
 
         /* If the last timer object was destroyed, then wake up the thread. */
         if (!--timerqueue.objcount)
         {
-            assert( list_empty( &timerqueue.pending_timers ) );
+            assert( timer_wheel_next_deadline( &timerqueue.wheel ) == EXPIRE_NEVER );
             RtlWakeAllConditionVariable( &timerqueue.update_event );
         }
 
@@ -1232,12 +1596,13 @@ static void tp_timerqueue_unlock( struct threadpool_object *timer )
  */
 static void CALLBACK waitqueue_thread_proc( void *param )
 {
-    struct threadpool_object *objects[MAXIMUM_WAITQUEUE_OBJECTS];
-    HANDLE handles[MAXIMUM_WAITQUEUE_OBJECTS + 1];
     struct waitqueue_bucket *bucket = param;
+    struct threadpool_object **objects = bucket->objects;
+    HANDLE *handles = bucket->handles;
     struct threadpool_object *wait, *next;
     LARGE_INTEGER now, timeout;
-    DWORD num_handles;
+    DWORD num_handles, index, i;
+    BOOL retry;
     NTSTATUS status;
 
     TRACE( "starting wait queue thread\n" );
@@ -1249,6 +1614,7 @@ static void CALLBACK waitqueue_thread_proc( void *param )
         NtQuerySystemTime( &now );
         timeout.QuadPart = MAXLONGLONG;
         num_handles = 0;
+        retry = FALSE;
 
         LIST_FOR_EACH_ENTRY_SAFE( wait, next, &bucket->waiting, struct threadpool_object,
                                   u.wait.wait_entry )
@@ -1265,10 +1631,8 @@ static void CALLBACK waitqueue_thread_proc( void *param )
                 if ((wait->u.wait.flags & (WT_EXECUTEINWAITTHREAD | WT_EXECUTEINIOTHREAD)))
                 {
                     InterlockedIncrement( &wait->refcount );
-                    wait->num_pending_callbacks++;
-                    RtlEnterCriticalSection( &wait->pool->cs );
-                    tp_object_execute( wait, TRUE );
-                    RtlLeaveCriticalSection( &wait->pool->cs );
+                    InterlockedIncrement( &wait->num_pending_callbacks );
+                    if (tp_object_claim( wait )) tp_object_execute( wait, TRUE );
                     tp_object_release( wait );
                 }
                 else tp_object_submit( wait, FALSE );
@@ -1278,7 +1642,14 @@ static void CALLBACK waitqueue_thread_proc( void *param )
                 if (wait->u.wait.timeout < timeout.QuadPart)
                     timeout.QuadPart = wait->u.wait.timeout;
 
-                assert( num_handles < MAXIMUM_WAITQUEUE_OBJECTS );
+                if (wait->u.wait.server_wait && bucket->wide)
+                {
+                    /* If that fails, try again later, the timeout is still handled here. */
+                    if (!tp_waitqueue_move( wait, FALSE )) retry = TRUE;
+                    continue;
+                }
+
+                assert( num_handles < bucket->capacity );
                 InterlockedIncrement( &wait->refcount );
                 objects[num_handles] = wait;
                 handles[num_handles] = wait->u.wait.handle;
@@ -1301,14 +1672,40 @@ static void CALLBACK waitqueue_thread_proc( void *param )
         }
         else
         {
+            if (retry)
+            {
+                NtQuerySystemTime( &now );
+                timeout.QuadPart = min( timeout.QuadPart, now.QuadPart + 100 * 10000 );
+            }
+
             handles[num_handles] = bucket->update_event;
             RtlLeaveCriticalSection( &waitqueue.cs );
-            status = NtWaitForMultipleObjects( num_handles + 1, handles, TRUE, bucket->alertable, &timeout );
+            if (bucket->wide)
+                status = __wine_wait_any_objects( num_handles + 1, handles, bucket->alertable, &timeout, &index );
+            else
+            {
+                status = NtWaitForMultipleObjects( num_handles + 1, handles, TRUE, bucket->alertable, &timeout );
+                index = status - STATUS_WAIT_0;
+                if (index <= num_handles) status = STATUS_WAIT_0;
+            }
             RtlEnterCriticalSection( &waitqueue.cs );
 
-            if (status >= STATUS_WAIT_0 && status < STATUS_WAIT_0 + num_handles)
+            if (status == STATUS_NOT_IMPLEMENTED && bucket->wide)
             {
-                wait = objects[status - STATUS_WAIT_0];
+                /* Find the handles which need a server wait, they are moved
+                 * to a regular bucket before the next wait. */
+                for (i = 0; i < num_handles; i++)
+                {
+                    wait = objects[i];
+                    if (wait->u.wait.bucket == bucket && wait->u.wait.handle == handles[i] &&
+                        __wine_wait_any_supported( handles[i], NULL ) == STATUS_NOT_IMPLEMENTED)
+                        wait->u.wait.server_wait = TRUE;
+                }
+            }
+
+            if (status == STATUS_WAIT_0 && index < num_handles)
+            {
+                wait = objects[index];
                 assert( wait->type == TP_OBJECT_TYPE_WAIT );
                 if (wait->u.wait.bucket)
                 {
@@ -1321,11 +1718,9 @@ static void CALLBACK waitqueue_thread_proc( void *param )
                     }
                     if ((wait->u.wait.flags & (WT_EXECUTEINWAITTHREAD | WT_EXECUTEINIOTHREAD)))
                     {
-                        wait->u.wait.signaled++;
-                        wait->num_pending_callbacks++;
-                        RtlEnterCriticalSection( &wait->pool->cs );
-                        tp_object_execute( wait, TRUE );
-                        RtlLeaveCriticalSection( &wait->pool->cs );
+                        InterlockedIncrement( &wait->u.wait.signaled );
+                        InterlockedIncrement( &wait->num_pending_callbacks );
+                        if (tp_object_claim( wait )) tp_object_execute( wait, TRUE );
                     }
                     else tp_object_submit( wait, TRUE );
                 }
@@ -1344,13 +1739,14 @@ static void CALLBACK waitqueue_thread_proc( void *param )
 
         /* Try to merge bucket with other threads. */
         if (waitqueue.num_buckets > 1 && bucket->objcount &&
-            bucket->objcount <= MAXIMUM_WAITQUEUE_OBJECTS * 1 / 3)
+            bucket->objcount <= bucket->capacity * 1 / 3)
         {
             struct waitqueue_bucket *other_bucket;
             LIST_FOR_EACH_ENTRY( other_bucket, &waitqueue.buckets, struct waitqueue_bucket, bucket_entry )
             {
                 if (other_bucket != bucket && other_bucket->objcount && other_bucket->alertable == bucket->alertable &&
-                    other_bucket->objcount + bucket->objcount <= MAXIMUM_WAITQUEUE_OBJECTS * 2 / 3)
+                    other_bucket->wide == bucket->wide &&
+                    other_bucket->objcount + bucket->objcount <= bucket->capacity * 2 / 3)
                 {
                     other_bucket->objcount += bucket->objcount;
                     bucket->objcount = 0;
@@ -1402,48 +1798,29 @@ static void CALLBACK waitqueue_thread_proc( void *param )
 }
 
 /***********************************************************************
- *           tp_waitqueue_lock    (internal)
+ *           tp_waitqueue_new_bucket    (internal)
+ *
+ * Creates a new bucket and the corresponding wait thread. Must be called
+ * with waitqueue.cs held.
  */
-static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
+static NTSTATUS tp_waitqueue_new_bucket( BOOL alertable, BOOL wide, struct waitqueue_bucket **out )
 {
     struct waitqueue_bucket *bucket;
+    LONG capacity = wide ? waitqueue.max_wide_objects : MAXIMUM_WAITQUEUE_OBJECTS;
     NTSTATUS status;
     HANDLE thread;
-    BOOL alertable = (wait->u.wait.flags & WT_EXECUTEINIOTHREAD) != 0;
-    assert( wait->type == TP_OBJECT_TYPE_WAIT );
-
-    wait->u.wait.signaled       = 0;
-    wait->u.wait.bucket         = NULL;
-    wait->u.wait.wait_pending   = FALSE;
-    wait->u.wait.timeout        = 0;
-    wait->u.wait.handle         = INVALID_HANDLE_VALUE;
 
-    RtlEnterCriticalSection( &waitqueue.cs );
-
-    /* Try to assign to existing bucket if possible. */
-    LIST_FOR_EACH_ENTRY( bucket, &waitqueue.buckets, struct waitqueue_bucket, bucket_entry )
-    {
-        if (bucket->objcount < MAXIMUM_WAITQUEUE_OBJECTS && bucket->alertable == alertable)
-        {
-            list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
-            wait->u.wait.bucket = bucket;
-            bucket->objcount++;
-
-            status = STATUS_SUCCESS;
-            goto out;
-        }
-    }
-
-    /* Create a new bucket and corresponding worker thread. */
-    bucket = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*bucket) );
+    bucket = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*bucket) + capacity * sizeof(*bucket->objects) +
+                              (capacity + 1) * sizeof(*bucket->handles) );
     if (!bucket)
-    {
-        status = STATUS_NO_MEMORY;
-        goto out;
-    }
+        return STATUS_NO_MEMORY;
 
     bucket->objcount = 0;
+    bucket->capacity = capacity;
     bucket->alertable = alertable;
+    bucket->wide = wide;
+    bucket->objects = (struct threadpool_object **)(bucket + 1);
+    bucket->handles = (HANDLE *)(bucket->objects + capacity);
     list_init( &bucket->reserved );
     list_init( &bucket->waiting );
 
@@ -1452,28 +1829,109 @@ static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
     if (status)
     {
         RtlFreeHeap( GetProcessHeap(), 0, bucket );
-        goto out;
+        return status;
+    }
+
+    /* The update event itself has to support wide waits. */
+    if (wide && __wine_wait_any_supported( bucket->update_event, NULL ))
+    {
+        NtClose( bucket->update_event );
+        RtlFreeHeap( GetProcessHeap(), 0, bucket );
+        return tp_waitqueue_new_bucket( alertable, FALSE, out );
     }
 
     status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, 0, 0, 0,
                                   waitqueue_thread_proc, bucket, &thread, NULL );
-    if (status == STATUS_SUCCESS)
+    if (status)
     {
-        list_add_tail( &waitqueue.buckets, &bucket->bucket_entry );
-        waitqueue.num_buckets++;
+        NtClose( bucket->update_event );
+        RtlFreeHeap( GetProcessHeap(), 0, bucket );
+        return status;
+    }
+
+    list_add_tail( &waitqueue.buckets, &bucket->bucket_entry );
+    waitqueue.num_buckets++;
+    NtClose( thread );
+
+    *out = bucket;
+    return STATUS_SUCCESS;
+}
+
+/***********************************************************************
+ *           tp_waitqueue_move    (internal)
+ *
+ * Moves a pending wait object to a bucket of the given kind. Must be
+ * called with waitqueue.cs held.
+ */
+static BOOL tp_waitqueue_move( struct threadpool_object *wait, BOOL wide )
+{
+    struct waitqueue_bucket *bucket = wait->u.wait.bucket, *other_bucket;
+
+    LIST_FOR_EACH_ENTRY( other_bucket, &waitqueue.buckets, struct waitqueue_bucket, bucket_entry )
+    {
+        if (other_bucket->objcount < other_bucket->capacity && other_bucket->alertable == bucket->alertable &&
+            other_bucket->wide == wide)
+            goto found;
+    }
+    if (tp_waitqueue_new_bucket( bucket->alertable, wide, &other_bucket ))
+        return FALSE;
+
+found:
+    TRACE( "moving wait %p from bucket %p to %p\n", wait, bucket, other_bucket );
+
+    list_remove( &wait->u.wait.wait_entry );
+    list_add_tail( &other_bucket->waiting, &wait->u.wait.wait_entry );
+    wait->u.wait.bucket = other_bucket;
+    bucket->objcount--;
+    other_bucket->objcount++;
+
+    NtSetEvent( other_bucket->update_event, NULL );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           tp_waitqueue_lock    (internal)
+ */
+static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
+{
+    struct waitqueue_bucket *bucket;
+    NTSTATUS status;
+    ULONG max_count;
+    BOOL alertable = (wait->u.wait.flags & WT_EXECUTEINIOTHREAD) != 0;
+    BOOL wide;
+    assert( wait->type == TP_OBJECT_TYPE_WAIT );
+
+    wait->u.wait.signaled       = 0;
+    wait->u.wait.bucket         = NULL;
+    wait->u.wait.wait_pending   = FALSE;
+    wait->u.wait.server_wait    = FALSE;
+    wait->u.wait.timeout        = 0;
+    wait->u.wait.handle         = INVALID_HANDLE_VALUE;
+
+    RtlEnterCriticalSection( &waitqueue.cs );
 
-        list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
-        wait->u.wait.bucket = bucket;
-        bucket->objcount++;
+    /* One slot of each bucket is used by the update event. */
+    if (waitqueue.max_wide_objects < 0)
+        waitqueue.max_wide_objects = __wine_wait_any_supported( NULL, &max_count ) ? 0 : max_count - 1;
+    wide = waitqueue.max_wide_objects > MAXIMUM_WAITQUEUE_OBJECTS;
 
-        NtClose( thread );
-    }
-    else
+    /* Try to assign to existing bucket if possible. */
+    LIST_FOR_EACH_ENTRY( bucket, &waitqueue.buckets, struct waitqueue_bucket, bucket_entry )
     {
-        NtClose( bucket->update_event );
-        RtlFreeHeap( GetProcessHeap(), 0, bucket );
+        if (bucket->objcount < bucket->capacity && bucket->alertable == alertable && bucket->wide == wide)
+            goto found;
     }
 
+    /* Create a new bucket and corresponding worker thread. */
+    if ((status = tp_waitqueue_new_bucket( alertable, wide, &bucket )))
+        goto out;
+
+found:
+    list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
+    wait->u.wait.bucket = bucket;
+    bucket->objcount++;
+    status = STATUS_SUCCESS;
+
 out:
     RtlLeaveCriticalSection( &waitqueue.cs );
     return status;
@@ -1558,12 +2016,13 @@ static void CALLBACK ioqueue_thread_proc( void *param )
 
             if (io->u.io.pending_count)
             {
-                --io->u.io.pending_count;
                 if (!array_reserve((void **)&io->u.io.completions, &io->u.io.completion_max,
                         io->u.io.completion_count + 1, sizeof(*io->u.io.completions)))
                 {
                     ERR( "Failed to allocate memory.\n" );
+                    --io->u.io.pending_count;
                     RtlLeaveCriticalSection( &io->pool->cs );
+                    tp_object_signal_finished( io );
                     continue;
                 }
 
@@ -1571,7 +2030,10 @@ static void CALLBACK ioqueue_thread_proc( void *param )
                 completion->iosb = iosb;
                 completion->cvalue = value;
 
+                /* Submit before dropping the pending count, so that the object
+                 * never looks finished in between. */
                 tp_object_submit( io, FALSE );
+                --io->u.io.pending_count;
             }
             RtlLeaveCriticalSection( &io->pool->cs );
         }
@@ -1644,6 +2106,156 @@ static NTSTATUS tp_ioqueue_lock( struct threadpool_object *io, HANDLE file )
     return status;
 }
 
+static void tp_queue_init( struct threadpool_queue *queue )
+{
+    unsigned int i;
+
+    queue->head = queue->tail = 0;
+    for (i = 0; i < THREADPOOL_QUEUE_SIZE; ++i)
+    {
+        queue->slots[i].seq = i;
+        queue->slots[i].object = NULL;
+    }
+    queue->overflow_count = 0;
+    list_init( &queue->overflow );
+}
+
+/***********************************************************************
+ *           tp_queue_push    (internal)
+ *
+ * Adds an object to the tail of a shared queue. The slots are a bounded
+ * MPMC ring, where the sequence number of each slot tells whether it is
+ * ready to be filled or emptied for a given position. Objects only go to
+ * the overflow list when the ring is full.
+ */
+static void tp_queue_push( struct threadpool *pool, struct threadpool_queue *queue,
+                           struct threadpool_object *object )
+{
+    LONG pos, seq;
+
+    if (!__atomic_load_n( &queue->overflow_count, __ATOMIC_ACQUIRE ))
+    {
+        pos = __atomic_load_n( &queue->tail, __ATOMIC_RELAXED );
+        for (;;)
+        {
+            seq = __atomic_load_n( &queue->slots[pos % THREADPOOL_QUEUE_SIZE].seq, __ATOMIC_ACQUIRE );
+            if (seq == pos)
+            {
+                if (__atomic_compare_exchange_n( &queue->tail, &pos, pos + 1, TRUE,
+                                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED ))
+                {
+                    queue->slots[pos % THREADPOOL_QUEUE_SIZE].object = object;
+                    __atomic_store_n( &queue->slots[pos % THREADPOOL_QUEUE_SIZE].seq, pos + 1, __ATOMIC_RELEASE );
+                    return;
+                }
+            }
+            else if (seq - pos < 0) break;  /* full */
+            else pos = __atomic_load_n( &queue->tail, __ATOMIC_RELAXED );
+        }
+    }
+
+    RtlEnterCriticalSection( &pool->cs );
+    list_add_tail( &queue->overflow, &object->pool_entry );
+    InterlockedIncrement( &queue->overflow_count );
+    RtlLeaveCriticalSection( &pool->cs );
+}
+
+/***********************************************************************
+ *           tp_queue_pop    (internal)
+ *
+ * Removes the object at the head of a shared queue.
+ */
+static struct threadpool_object *tp_queue_pop( struct threadpool *pool, struct threadpool_queue *queue )
+{
+    struct threadpool_object *object = NULL;
+    struct list *ptr;
+    LONG pos, seq;
+
+    pos = __atomic_load_n( &queue->head, __ATOMIC_RELAXED );
+    for (;;)
+    {
+        seq = __atomic_load_n( &queue->slots[pos % THREADPOOL_QUEUE_SIZE].seq, __ATOMIC_ACQUIRE );
+        if (seq == pos + 1)
+        {
+            if (__atomic_compare_exchange_n( &queue->head, &pos, pos + 1, TRUE,
+                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED ))
+            {
+                object = queue->slots[pos % THREADPOOL_QUEUE_SIZE].object;
+                __atomic_store_n( &queue->slots[pos % THREADPOOL_QUEUE_SIZE].seq,
+                                  pos + THREADPOOL_QUEUE_SIZE, __ATOMIC_RELEASE );
+                return object;
+            }
+        }
+        else if (seq - (pos + 1) < 0) break;  /* empty */
+        else pos = __atomic_load_n( &queue->head, __ATOMIC_RELAXED );
+    }
+
+    if (!__atomic_load_n( &queue->overflow_count, __ATOMIC_ACQUIRE )) return NULL;
+
+    RtlEnterCriticalSection( &pool->cs );
+    if ((ptr = list_head( &queue->overflow )))
+    {
+        object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+        list_remove( &object->pool_entry );
+        InterlockedDecrement( &queue->overflow_count );
+    }
+    RtlLeaveCriticalSection( &pool->cs );
+    return object;
+}
+
+/* add an object to the bottom of a deque, only called by its owner */
+static BOOL tp_deque_push( struct threadpool_deque *deque, struct threadpool_object *object )
+{
+    LONG bottom = deque->bottom, top = __atomic_load_n( &deque->top, __ATOMIC_ACQUIRE );
+
+    if (bottom - top >= THREADPOOL_DEQUE_SIZE) return FALSE;
+    deque->objects[bottom % THREADPOOL_DEQUE_SIZE] = object;
+    __atomic_store_n( &deque->bottom, bottom + 1, __ATOMIC_RELEASE );
+    return TRUE;
+}
+
+/* remove the object at the bottom of a deque, only called by its owner */
+static struct threadpool_object *tp_deque_pop( struct threadpool_deque *deque )
+{
+    struct threadpool_object *object;
+    LONG bottom = deque->bottom - 1, top;
+
+    if (bottom < __atomic_load_n( &deque->top, __ATOMIC_RELAXED )) return NULL;
+
+    InterlockedExchange( &deque->bottom, bottom );
+    top = deque->top;
+    if (top > bottom)
+    {
+        deque->bottom = bottom + 1;
+        return NULL;
+    }
+
+    object = deque->objects[bottom % THREADPOOL_DEQUE_SIZE];
+    if (top == bottom)
+    {
+        /* last object, race against the thieves for it */
+        if (InterlockedCompareExchange( &deque->top, top + 1, top ) != top) object = NULL;
+        deque->bottom = bottom + 1;
+    }
+    return object;
+}
+
+/* take the object at the top of the deque of another worker */
+static struct threadpool_object *tp_deque_steal( struct threadpool_deque *deque )
+{
+    struct threadpool_object *object;
+    LONG top, bottom;
+
+    top = __atomic_load_n( &deque->top, __ATOMIC_ACQUIRE );
+    MemoryBarrier();
+    bottom = __atomic_load_n( &deque->bottom, __ATOMIC_ACQUIRE );
+    if (top >= bottom) return NULL;
+
+    object = deque->objects[top % THREADPOOL_DEQUE_SIZE];
+    if (InterlockedCompareExchange( &deque->top, top + 1, top ) != top) return NULL;
+    return object;
+}
+
 /***********************************************************************
  *           tp_threadpool_alloc    (internal)
  *
@@ -1666,14 +2278,18 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     RtlInitializeCriticalSection( &pool->cs );
     pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool.cs");
 
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
-        list_init( &pool->pools[i] );
-    RtlInitializeConditionVariable( &pool->update_event );
+    for (i = 0; i < ARRAY_SIZE(pool->queues); ++i)
+        tp_queue_init( &pool->queues[i] );
+    memset( pool->workers, 0, sizeof(pool->workers) );
+    pool->num_worker_slots        = 0;
+    pool->wake_seq                = 0;
+    pool->num_idle_workers        = 0;
 
     pool->max_workers             = 500;
     pool->min_workers             = 0;
     pool->num_workers             = 0;
     pool->num_busy_workers        = 0;
+    pool->ideal_processor         = ~0u;
     pool->stack_info.StackReserve = nt->OptionalHeader.SizeOfStackReserve;
     pool->stack_info.StackCommit  = nt->OptionalHeader.SizeOfStackCommit;
 
@@ -1695,7 +2311,8 @@ static void tp_threadpool_shutdown( struct threadpool *pool )
     assert( pool != default_threadpool );
 
     pool->shutdown = TRUE;
-    RtlWakeAllConditionVariable( &pool->update_event );
+    InterlockedIncrement( &pool->wake_seq );
+    RtlWakeAddressAll( &pool->wake_seq );
 }
 
 /***********************************************************************
@@ -1714,8 +2331,13 @@ static BOOL tp_threadpool_release( struct threadpool *pool )
 
     assert( pool->shutdown );
     assert( !pool->objcount );
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
-        assert( list_empty( &pool->pools[i] ) );
+    for (i = 0; i < ARRAY_SIZE(pool->queues); ++i)
+    {
+        assert( pool->queues[i].head == pool->queues[i].tail );
+        assert( list_empty( &pool->queues[i].overflow ) );
+    }
+    for (i = 0; i < ARRAY_SIZE(pool->workers); ++i)
+        RtlFreeHeap( GetProcessHeap(), 0, pool->workers[i] );
 
     pool->cs.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &pool->cs );
@@ -1775,22 +2397,23 @@ static NTSTATUS tp_threadpool_lock( struct threadpool **out, TP_CALLBACK_ENVIRON
         pool = default_threadpool;
     }
 
-    RtlEnterCriticalSection( &pool->cs );
-
     /* Make sure that the threadpool has at least one thread. */
     if (!pool->num_workers)
-        status = tp_new_worker_thread( pool );
+    {
+        RtlEnterCriticalSection( &pool->cs );
+        if (!pool->num_workers)
+            status = tp_new_worker_thread( pool );
+        RtlLeaveCriticalSection( &pool->cs );
+    }
 
     /* Keep a reference, and increment objcount to ensure that the
      * last thread doesn't terminate. */
     if (status == STATUS_SUCCESS)
     {
         InterlockedIncrement( &pool->refcount );
-        pool->objcount++;
+        InterlockedIncrement( &pool->objcount );
     }
 
-    RtlLeaveCriticalSection( &pool->cs );
-
     if (status != STATUS_SUCCESS)
         return status;
 
@@ -1805,9 +2428,7 @@ static NTSTATUS tp_threadpool_lock( struct threadpool **out, TP_CALLBACK_ENVIRON
  */
 static void tp_threadpool_unlock( struct threadpool *pool )
 {
-    RtlEnterCriticalSection( &pool->cs );
-    pool->objcount--;
-    RtlLeaveCriticalSection( &pool->cs );
+    InterlockedDecrement( &pool->objcount );
     tp_threadpool_release( pool );
 }
 
@@ -1896,8 +2517,9 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
     object->is_group_member         = FALSE;
 
     memset( &object->pool_entry, 0, sizeof(object->pool_entry) );
-    RtlInitializeConditionVariable( &object->finished_event );
-    RtlInitializeConditionVariable( &object->group_finished_event );
+    object->queued                  = 0;
+    object->finished_seq            = 0;
+    object->num_finish_waiters      = 0;
     object->completed_event         = NULL;
     object->num_pending_callbacks   = 0;
     object->num_running_callbacks   = 0;
@@ -1918,7 +2540,7 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
             TP_CALLBACK_ENVIRON_V3 *environment_v3 = (TP_CALLBACK_ENVIRON_V3 *)environment;
 
             object->priority = environment_v3->CallbackPriority;
-            assert( object->priority < ARRAY_SIZE(pool->pools) );
+            assert( object->priority < ARRAY_SIZE(pool->queues) );
         }
 
         if (environment->ActivationContext)
@@ -1955,10 +2577,85 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
         tp_object_release( object );
 }
 
-static void tp_object_prio_queue( struct threadpool_object *object )
+/* TLS slot of the threadpool, pointing to the worker running on the thread */
+static ULONG worker_tls_index = ~0u;
+static RTL_RUN_ONCE worker_tls_once = RTL_RUN_ONCE_INIT;
+
+static DWORD WINAPI tp_alloc_worker_tls( RTL_RUN_ONCE *once, void *param, void **context )
+{
+    PEB *peb = NtCurrentTeb()->Peb;
+    ULONG index;
+
+    /* the slot is marked in use like a TlsAlloc one, so applications never see it */
+    RtlAcquirePebLock();
+    index = RtlFindClearBitsAndSet( peb->TlsBitmap, 1, 1 );
+    if (index != ~0u) NtCurrentTeb()->TlsSlots[index] = 0;
+    RtlReleasePebLock();
+    if (index == ~0u) WARN( "no TLS slot left, workers won't use their own deques\n" );
+    worker_tls_index = index;
+    return TRUE;
+}
+
+static inline struct threadpool_worker *tp_get_current_worker(void)
+{
+    if (worker_tls_index == ~0u) return NULL;
+    return NtCurrentTeb()->TlsSlots[worker_tls_index];
+}
+
+static inline void tp_set_current_worker( struct threadpool_worker *worker )
+{
+    if (worker_tls_index != ~0u) NtCurrentTeb()->TlsSlots[worker_tls_index] = worker;
+}
+
+/***********************************************************************
+ *           tp_object_enqueue    (internal)
+ *
+ * Queues an object with pending callbacks, unless it already is. Objects
+ * submitted from a worker thread of the same pool go to its own deque.
+ */
+static BOOL tp_object_enqueue( struct threadpool_object *object, BOOL local )
+{
+    struct threadpool_worker *worker = tp_get_current_worker();
+    struct threadpool *pool = object->pool;
+
+    if (InterlockedCompareExchange( &object->queued, 1, 0 ))
+        return FALSE;
+
+    /* The queue holds a reference until a worker removes the object. */
+    InterlockedIncrement( &object->refcount );
+    InterlockedIncrement( &pool->num_busy_workers );
+
+    if (!local || !worker || worker->pool != pool ||
+        !tp_deque_push( &worker->deques[object->priority], object ))
+        tp_queue_push( pool, &pool->queues[object->priority], object );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           tp_threadpool_signal    (internal)
+ *
+ * Wakes up an idle worker for newly queued work, or starts a new one if
+ * all workers are busy.
+ */
+static void tp_threadpool_signal( struct threadpool *pool )
 {
-    ++object->pool->num_busy_workers;
-    list_add_tail( &object->pool->pools[object->priority], &object->pool_entry );
+    /* Pairs with the idle workers, which increment num_idle_workers before
+     * looking for work a last time. */
+    MemoryBarrier();
+    if (pool->num_idle_workers)
+    {
+        InterlockedIncrement( &pool->wake_seq );
+        RtlWakeAddressSingle( &pool->wake_seq );
+        return;
+    }
+
+    if (pool->num_busy_workers <= pool->num_workers || pool->num_workers >= pool->max_workers)
+        return;
+
+    RtlEnterCriticalSection( &pool->cs );
+    if (pool->num_busy_workers > pool->num_workers && pool->num_workers < pool->max_workers)
+        tp_new_worker_thread( pool );
+    RtlLeaveCriticalSection( &pool->cs );
 }
 
 /***********************************************************************
@@ -1970,35 +2667,50 @@ static void tp_object_prio_queue( struct threadpool_object *object )
 static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
 {
     struct threadpool *pool = object->pool;
-    NTSTATUS status = STATUS_UNSUCCESSFUL;
 
     assert( !object->shutdown );
     assert( !pool->shutdown );
 
-    RtlEnterCriticalSection( &pool->cs );
-
-    /* Start new worker threads if required. */
-    if (pool->num_busy_workers >= pool->num_workers &&
-        pool->num_workers < pool->max_workers)
-        status = tp_new_worker_thread( pool );
+    /* Count how often the object was signaled. */
+    if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
+        InterlockedIncrement( &object->u.wait.signaled );
 
     /* Queue work item and increment refcount. */
     InterlockedIncrement( &object->refcount );
-    if (!object->num_pending_callbacks++)
-        tp_object_prio_queue( object );
+    InterlockedIncrement( &object->num_pending_callbacks );
+    tp_object_enqueue( object, TRUE );
 
-    /* Count how often the object was signaled. */
-    if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
-        object->u.wait.signaled++;
+    tp_threadpool_signal( pool );
+}
 
-    /* No new thread started - wake up one existing thread. */
-    if (status != STATUS_SUCCESS)
-    {
-        assert( pool->num_workers > 0 );
-        RtlWakeConditionVariable( &pool->update_event );
-    }
+static BOOL object_is_finished( struct threadpool_object *object, BOOL group )
+{
+    if (object->num_pending_callbacks)
+        return FALSE;
+    if (object->type == TP_OBJECT_TYPE_IO && object->u.io.pending_count)
+        return FALSE;
 
-    RtlLeaveCriticalSection( &pool->cs );
+    if (group)
+        return !object->num_running_callbacks;
+    else
+        return !object->num_associated_callbacks;
+}
+
+/***********************************************************************
+ *           tp_object_signal_finished    (internal)
+ *
+ * Wakes up the threads in tp_object_wait after the callback counters of
+ * an object changed.
+ */
+static void tp_object_signal_finished( struct threadpool_object *object )
+{
+    if (!object->num_finish_waiters)
+        return;
+    if (!object_is_finished( object, TRUE ) && !object_is_finished( object, FALSE ))
+        return;
+
+    InterlockedIncrement( &object->finished_seq );
+    RtlWakeAddressAll( &object->finished_seq );
 }
 
 /***********************************************************************
@@ -2009,40 +2721,49 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
 static void tp_object_cancel( struct threadpool_object *object )
 {
     struct threadpool *pool = object->pool;
-    LONG pending_callbacks = 0;
-
-    RtlEnterCriticalSection( &pool->cs );
-    if (object->num_pending_callbacks)
-    {
-        pending_callbacks = object->num_pending_callbacks;
-        object->num_pending_callbacks = 0;
-        list_remove( &object->pool_entry );
+    LONG pending_callbacks;
 
-        if (object->type == TP_OBJECT_TYPE_WAIT)
-            object->u.wait.signaled = 0;
-    }
+    /* The object stays queued, the worker removing it won't find anything to do. */
+    pending_callbacks = InterlockedExchange( &object->num_pending_callbacks, 0 );
+    if (pending_callbacks && object->type == TP_OBJECT_TYPE_WAIT)
+        InterlockedExchange( &object->u.wait.signaled, 0 );
     if (object->type == TP_OBJECT_TYPE_IO)
     {
+        RtlEnterCriticalSection( &pool->cs );
         object->u.io.skipped_count += object->u.io.pending_count;
         object->u.io.pending_count = 0;
+        RtlLeaveCriticalSection( &pool->cs );
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    tp_object_signal_finished( object );
 
     while (pending_callbacks--)
         tp_object_release( object );
 }
 
-static BOOL object_is_finished( struct threadpool_object *object, BOOL group )
+/***********************************************************************
+ *           tp_object_claim    (internal)
+ *
+ * Takes one of the pending callbacks of an object. The callback is
+ * accounted as running before it stops being pending, so that waiters
+ * never see the object idle in between.
+ */
+static BOOL tp_object_claim( struct threadpool_object *object )
 {
-    if (object->num_pending_callbacks)
-        return FALSE;
-    if (object->type == TP_OBJECT_TYPE_IO && object->u.io.pending_count)
-        return FALSE;
+    LONG pending;
 
-    if (group)
-        return !object->num_running_callbacks;
-    else
-        return !object->num_associated_callbacks;
+    InterlockedIncrement( &object->num_associated_callbacks );
+    InterlockedIncrement( &object->num_running_callbacks );
+
+    while ((pending = object->num_pending_callbacks))
+    {
+        if (InterlockedCompareExchange( &object->num_pending_callbacks, pending - 1, pending ) == pending)
+            return TRUE;
+    }
+
+    InterlockedDecrement( &object->num_running_callbacks );
+    InterlockedDecrement( &object->num_associated_callbacks );
+    tp_object_signal_finished( object );
+    return FALSE;
 }
 
 /***********************************************************************
@@ -2053,17 +2774,16 @@ static BOOL object_is_finished( struct threadpool_object *object, BOOL group )
  */
 static void tp_object_wait( struct threadpool_object *object, BOOL group_wait )
 {
-    struct threadpool *pool = object->pool;
+    LONG seq;
 
-    RtlEnterCriticalSection( &pool->cs );
-    while (!object_is_finished( object, group_wait ))
+    InterlockedIncrement( &object->num_finish_waiters );
+    for (;;)
     {
-        if (group_wait)
-            RtlSleepConditionVariableCS( &object->group_finished_event, &pool->cs, NULL );
-        else
-            RtlSleepConditionVariableCS( &object->finished_event, &pool->cs, NULL );
+        seq = __atomic_load_n( &object->finished_seq, __ATOMIC_SEQ_CST );
+        if (object_is_finished( object, group_wait )) break;
+        RtlWaitOnAddress( &object->finished_seq, &seq, sizeof(seq), NULL );
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    InterlockedDecrement( &object->num_finish_waiters );
 }
 
 static void tp_ioqueue_unlock( struct threadpool_object *io )
@@ -2140,25 +2860,51 @@ static BOOL tp_object_release( struct threadpool_object *object )
     return TRUE;
 }
 
-static struct list *threadpool_get_next_item( const struct threadpool *pool )
+/***********************************************************************
+ *           threadpool_get_next_item    (internal)
+ *
+ * Finds the next queued object, looking at the own deque, the shared
+ * queue and the deques of the other workers, for each priority in turn.
+ */
+static struct threadpool_object *threadpool_get_next_item( struct threadpool *pool,
+                                                           struct threadpool_worker *worker )
 {
-    struct list *ptr;
-    unsigned int i;
+    struct threadpool_object *object;
+    struct threadpool_worker *other;
+    unsigned int i, j, start, count;
+    BOOL shared_first;
+
+    /* Don't let a worker reposting work to itself starve the shared queues. */
+    shared_first = worker && !(++worker->tick % THREADPOOL_FAIRNESS_TICKS);
+    count = __atomic_load_n( &pool->num_worker_slots, __ATOMIC_ACQUIRE );
+    start = worker ? worker->index + worker->tick : 0;
 
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
+    for (i = 0; i < ARRAY_SIZE(pool->queues); ++i)
     {
-        if ((ptr = list_head( &pool->pools[i] )))
-            break;
+        if (shared_first && (object = tp_queue_pop( pool, &pool->queues[i] )))
+            return object;
+        if (worker && (object = tp_deque_pop( &worker->deques[i] )))
+            return object;
+        if (!shared_first && (object = tp_queue_pop( pool, &pool->queues[i] )))
+            return object;
+
+        for (j = 0; j < count; ++j)
+        {
+            other = pool->workers[(start + j) % count];
+            if (other == worker) continue;
+            if ((object = tp_deque_steal( &other->deques[i] )))
+                return object;
+        }
     }
 
-    return ptr;
+    return NULL;
 }
 
 /***********************************************************************
  *           tp_object_execute    (internal)
  *
- * Executes a threadpool object callback, object->pool->cs has to be
- * held.
+ * Executes a threadpool object callback, which has been claimed with
+ * tp_object_claim.
  */
 static void tp_object_execute( struct threadpool_object *object, BOOL wait_thread )
 {
@@ -2168,25 +2914,25 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
     struct threadpool *pool = object->pool;
     TP_WAIT_RESULT wait_result = 0;
     NTSTATUS status;
-
-    object->num_pending_callbacks--;
+    LONG signaled;
 
     /* For wait objects check if they were signaled or have timed out. */
     if (object->type == TP_OBJECT_TYPE_WAIT)
     {
-        wait_result = object->u.wait.signaled ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
-        if (wait_result == WAIT_OBJECT_0) object->u.wait.signaled--;
+        while ((signaled = object->u.wait.signaled) &&
+               InterlockedCompareExchange( &object->u.wait.signaled, signaled - 1, signaled ) != signaled)
+            ;
+        wait_result = signaled ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
     }
     else if (object->type == TP_OBJECT_TYPE_IO)
     {
+        RtlEnterCriticalSection( &pool->cs );
         assert( object->u.io.completion_count );
         completion = object->u.io.completions[--object->u.io.completion_count];
+        RtlLeaveCriticalSection( &pool->cs );
     }
 
-    /* Leave critical section and do the actual callback. */
-    object->num_associated_callbacks++;
-    object->num_running_callbacks++;
-    RtlLeaveCriticalSection( &pool->cs );
+    /* Do the actual callback. */
     if (wait_thread) RtlLeaveCriticalSection( &waitqueue.cs );
 
     /* Initialize threadpool instance struct. */
@@ -2292,7 +3038,6 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
 
 skip_cleanup:
     if (wait_thread) RtlEnterCriticalSection( &waitqueue.cs );
-    RtlEnterCriticalSection( &pool->cs );
 
     /* Simple callbacks are automatically shutdown after execution. */
     if (object->type == TP_OBJECT_TYPE_SIMPLE)
@@ -2301,16 +3046,40 @@ skip_cleanup:
         object->shutdown = TRUE;
     }
 
-    object->num_running_callbacks--;
-    if (object_is_finished( object, TRUE ))
-        RtlWakeAllConditionVariable( &object->group_finished_event );
-
+    InterlockedDecrement( &object->num_running_callbacks );
     if (instance.associated)
+        InterlockedDecrement( &object->num_associated_callbacks );
+    tp_object_signal_finished( object );
+}
+
+/***********************************************************************
+ *           tp_worker_run_object    (internal)
+ *
+ * Executes a pending callback of an object removed from a queue.
+ */
+static void tp_worker_run_object( struct threadpool_object *object )
+{
+    struct threadpool *pool = object->pool;
+
+    /* Clear the queued flag before claiming the callback, so that a concurrent
+     * tp_object_submit either queues the object again or is seen below. */
+    InterlockedExchange( &object->queued, 0 );
+    if (tp_object_claim( object ))
     {
-        object->num_associated_callbacks--;
-        if (object_is_finished( object, FALSE ))
-            RtlWakeAllConditionVariable( &object->finished_event );
+        /* If further pending callbacks are queued, move the work item to
+         * the end of the shared queue. */
+        if (object->num_pending_callbacks && tp_object_enqueue( object, FALSE ))
+            tp_threadpool_signal( pool );
+
+        tp_object_execute( object, FALSE );
+        tp_object_release( object );
     }
+
+    assert(pool->num_busy_workers);
+    InterlockedDecrement( &pool->num_busy_workers );
+
+    /* release the reference of the queue */
+    tp_object_release( object );
 }
 
 /***********************************************************************
@@ -2319,54 +3088,101 @@ skip_cleanup:
 static void CALLBACK threadpool_worker_proc( void *param )
 {
     struct threadpool *pool = param;
+    struct threadpool_object *object;
+    struct threadpool_worker *worker = NULL;
     LARGE_INTEGER timeout;
-    struct list *ptr;
+    ULONG ideal_processor;
+    unsigned int i;
+    NTSTATUS status;
+    LONG seq;
 
     TRACE( "starting worker thread for pool %p\n", pool );
 
+    /* Take over the deques of a former worker, or allocate new ones. */
     RtlEnterCriticalSection( &pool->cs );
-    for (;;)
+    ideal_processor = pool->ideal_processor;
+    for (i = 0; i < ARRAY_SIZE(pool->workers); ++i)
     {
-        while ((ptr = threadpool_get_next_item( pool )))
+        if (!pool->workers[i])
         {
-            struct threadpool_object *object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
-            assert( object->num_pending_callbacks > 0 );
-
-            /* If further pending callbacks are queued, move the work item to
-             * the end of the pool list. Otherwise remove it from the pool. */
-            list_remove( &object->pool_entry );
-            if (object->num_pending_callbacks > 1)
-                tp_object_prio_queue( object );
-
-            tp_object_execute( object, FALSE );
-
-            assert(pool->num_busy_workers);
-            pool->num_busy_workers--;
+            if (!(worker = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*worker) ))) break;
+            worker->pool  = pool;
+            worker->index = i;
+            pool->workers[i] = worker;
+            __atomic_store_n( &pool->num_worker_slots, i + 1, __ATOMIC_RELEASE );
+        }
+        if (!pool->workers[i]->in_use)
+        {
+            worker = pool->workers[i];
+            worker->in_use = TRUE;
+            break;
+        }
+    }
+    if (i == ARRAY_SIZE(pool->workers)) worker = NULL;
+    RtlLeaveCriticalSection( &pool->cs );
+    if (ideal_processor != ~0u)
+        NtSetInformationThread( GetCurrentThread(), ThreadIdealProcessor, &ideal_processor, sizeof(ideal_processor) );
+    RtlRunOnceExecuteOnce( &worker_tls_once, tp_alloc_worker_tls, NULL, NULL );
+    tp_set_current_worker( worker );
 
-            tp_object_release( object );
+    for (;;)
+    {
+        if ((object = threadpool_get_next_item( pool, worker )))
+        {
+            tp_worker_run_object( object );
+            continue;
         }
 
         /* Shutdown worker thread if requested. */
         if (pool->shutdown)
             break;
 
-        /* Wait for new tasks or until the timeout expires. A thread only terminates
-         * when no new tasks are available, and the number of threads can be
-         * decreased without violating the min_workers limit. An exception is when
-         * min_workers == 0, then objcount is used to detect if the last thread
-         * can be terminated. */
+        /* Wait for new tasks or until the timeout expires. The wake sequence
+         * is read before looking for work a last time, so that a submission
+         * racing with it makes RtlWaitOnAddress return immediately. */
+        seq = __atomic_load_n( &pool->wake_seq, __ATOMIC_SEQ_CST );
+        InterlockedIncrement( &pool->num_idle_workers );
+        if ((object = threadpool_get_next_item( pool, worker )))
+        {
+            InterlockedDecrement( &pool->num_idle_workers );
+            tp_worker_run_object( object );
+            continue;
+        }
         timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
-        if (RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout ) == STATUS_TIMEOUT &&
-            !threadpool_get_next_item( pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
-            (!pool->min_workers && !pool->objcount)))
+        status = pool->shutdown ? STATUS_SUCCESS
+                                : RtlWaitOnAddress( &pool->wake_seq, &seq, sizeof(seq), &timeout );
+        InterlockedDecrement( &pool->num_idle_workers );
+        if (status != STATUS_TIMEOUT) continue;
+
+        /* A thread only terminates when no new tasks are available, and the number
+         * of threads can be decreased without violating the min_workers limit. An
+         * exception is when min_workers == 0, then objcount is used to detect if
+         * the last thread can be terminated. Submissions don't take the lock, so
+         * look for work again once the thread isn't counted anymore. */
+        RtlEnterCriticalSection( &pool->cs );
+        if (pool->num_workers > max( pool->min_workers, 1 ) || (!pool->min_workers && !pool->objcount))
         {
-            break;
+            InterlockedDecrement( &pool->num_workers );
+            if (!(object = threadpool_get_next_item( pool, worker )))
+            {
+                if (worker) worker->in_use = FALSE;
+                RtlLeaveCriticalSection( &pool->cs );
+                goto done;
+            }
+            InterlockedIncrement( &pool->num_workers );
         }
+        RtlLeaveCriticalSection( &pool->cs );
+        if (object) tp_worker_run_object( object );
     }
-    pool->num_workers--;
+
+    RtlEnterCriticalSection( &pool->cs );
+    InterlockedDecrement( &pool->num_workers );
+    if (worker) worker->in_use = FALSE;
     RtlLeaveCriticalSection( &pool->cs );
 
+done:
     TRACE( "terminating worker thread for pool %p\n", pool );
+    tp_set_current_worker( NULL );
     tp_threadpool_release( pool );
     RtlExitUserThread( 0 );
 }
@@ -2569,12 +3385,9 @@ void WINAPI TpCancelAsyncIoOperation( TP_IO *io )
     TRACE("pending_count %u.\n", this->u.io.pending_count);
 
     this->u.io.pending_count--;
-    if (object_is_finished( this, TRUE ))
-        RtlWakeAllConditionVariable( &this->group_finished_event );
-    if (object_is_finished( this, FALSE ))
-        RtlWakeAllConditionVariable( &this->finished_event );
 
     RtlLeaveCriticalSection( &this->pool->cs );
+    tp_object_signal_finished( this );
 }
 
 /***********************************************************************
@@ -2694,7 +3507,6 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
 {
     struct threadpool_instance *this = impl_from_TP_CALLBACK_INSTANCE( instance );
     struct threadpool_object *object = this->object;
-    struct threadpool *pool;
 
     TRACE( "%p\n", instance );
 
@@ -2707,14 +3519,8 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
     if (!this->associated)
         return;
 
-    pool = object->pool;
-    RtlEnterCriticalSection( &pool->cs );
-
-    object->num_associated_callbacks--;
-    if (object_is_finished( object, FALSE ))
-        RtlWakeAllConditionVariable( &object->finished_event );
-
-    RtlLeaveCriticalSection( &pool->cs );
+    InterlockedDecrement( &object->num_associated_callbacks );
+    tp_object_signal_finished( object );
     this->associated = FALSE;
 }
 
@@ -2956,7 +3762,6 @@ BOOL WINAPI TpSetPoolMinThreads( TP_POOL *pool, DWORD minimum )
 VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LONG window_length )
 {
     struct threadpool_object *this = impl_from_TP_TIMER( timer );
-    struct threadpool_object *other_timer;
     BOOL submit_timer = FALSE;
     ULONGLONG timestamp;
 
@@ -2995,31 +3800,27 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
     /* First remove existing timeout. */
     if (this->u.timer.timer_pending)
     {
-        list_remove( &this->u.timer.timer_entry );
+        timer_wheel_remove( &timerqueue.wheel, &this->u.timer.timer_entry );
         this->u.timer.timer_pending = FALSE;
     }
 
     /* If the timer was enabled, then add it back to the queue. */
     if (timeout)
     {
+        struct timer_wheel_entry *entry = &this->u.timer.timer_entry;
+
         this->u.timer.timeout       = timestamp;
         this->u.timer.period        = period;
         this->u.timer.window_length = window_length;
+        tp_timerqueue_add( this );
 
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
+        /* Wake up the timer thread only when the timer can't be expired
+         * together with the timers it is going to wake up for anyway. */
+        if (entry->expire + entry->window < timerqueue.deadline)
         {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (this->u.timer.timeout < other_timer->u.timer.timeout)
-                break;
-        }
-        list_add_before( &other_timer->u.timer.timer_entry, &this->u.timer.timer_entry );
-
-        /* Wake up the timer thread when the timeout has to be updated. */
-        if (list_head( &timerqueue.pending_timers ) == &this->u.timer.timer_entry )
+            timerqueue.deadline = entry->expire;
             RtlWakeAllConditionVariable( &timerqueue.update_event );
-
-        this->u.timer.timer_pending = TRUE;
+        }
     }
 
     RtlLeaveCriticalSection( &timerqueue.cs );
@@ -3041,6 +3842,7 @@ VOID WINAPI TpSetWait( TP_WAIT *wait, HANDLE handle, LARGE_INTEGER *timeout )
     RtlEnterCriticalSection( &waitqueue.cs );
 
     assert( this->u.wait.bucket );
+    if (this->u.wait.handle != handle) this->u.wait.server_wait = FALSE;
     this->u.wait.handle = handle;
 
     if (handle || this->u.wait.wait_pending)
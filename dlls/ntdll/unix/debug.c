@@ -32,6 +32,7 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -58,6 +59,7 @@ struct debug_info
 C_ASSERT( sizeof(struct debug_info) == 0x800 );
 
 static BOOL init_done;
+static int startup_trace_fd = -1;
 static struct debug_info initial_info;  /* debug info for initial thread */
 static unsigned char default_flags = (1 << __WINE_DBCL_ERR) | (1 << __WINE_DBCL_FIXME);
 static int nb_debug_options = -1;
@@ -261,6 +263,36 @@ int WINAPI __wine_dbg_write( const char *str, unsigned int len )
     return write( 2, str, len );
 }
 
+/***********************************************************************
+ *		__wine_startup_trace  (NTDLL.@)
+ */
+void WINAPI __wine_startup_trace( const char *name, unsigned int type )
+{
+    struct
+    {
+        struct __wine_startup_trace_record record;
+        char name[256];
+    } data;
+    struct timespec ts;
+    ULONGLONG time;
+    size_t len;
+
+    if (startup_trace_fd == -1) return;
+
+    len = min( strlen( name ), sizeof(data.name) );
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    time = (ULONGLONG)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    data.record.time_low  = time;
+    data.record.time_high = time >> 32;
+    data.record.pid       = getpid();
+    data.record.tid       = GetCurrentThreadId();
+    data.record.type      = type;
+    data.record.len       = len;
+    memcpy( data.name, name, len );
+    /* a single append write keeps records from concurrent processes intact */
+    write( startup_trace_fd, &data, sizeof(data.record) + len );
+}
+
 /***********************************************************************
  *		__wine_dbg_output  (NTDLL.@)
  */
@@ -326,6 +358,7 @@ int __cdecl __wine_dbg_header( enum __wine_debug_class cls, struct __wine_debug_
 void dbg_init(void)
 {
     struct __wine_debug_channel *options, default_option = { default_flags };
+    const char *trace;
 
     setbuf( stdout, NULL );
     setbuf( stderr, NULL );
@@ -338,6 +371,10 @@ void dbg_init(void)
     debug_options = options;
     options[nb_debug_options] = default_option;
     init_done = TRUE;
+
+    if ((trace = getenv( "WINESTARTUPTRACE" )) && *trace &&
+        (startup_trace_fd = open( trace, O_WRONLY | O_CREAT | O_APPEND, 0666 )) != -1)
+        fcntl( startup_trace_fd, F_SETFD, FD_CLOEXEC );
 }
 
 
@@ -2200,7 +2200,9 @@ static RTL_USER_PROCESS_PARAMETERS *build_initial_params( void **module )
     add_registry_environment( &env, &env_pos, &env_size );
     env[env_pos++] = 0;
 
+    __wine_startup_trace( "load_main_exe", __WINE_STARTUP_TRACE_BEGIN );
     status = load_main_exe( NULL, main_argv[1], curdir, &image, module );
+    __wine_startup_trace( "load_main_exe", __WINE_STARTUP_TRACE_END );
     if (!status)
     {
         if (main_image_info.ImageCharacteristics & IMAGE_FILE_DLL) status = STATUS_INVALID_IMAGE_FORMAT;
@@ -2365,8 +2367,10 @@ void init_startup_info(void)
     free( env );
     free( info );
 
+    __wine_startup_trace( "load_main_exe", __WINE_STARTUP_TRACE_BEGIN );
     status = load_main_exe( params->ImagePathName.Buffer, NULL,
                             params->CommandLine.Buffer, &image, &module );
+    __wine_startup_trace( "load_main_exe", __WINE_STARTUP_TRACE_END );
     if (status)
     {
         MESSAGE( "wine: failed to start %s\n", debugstr_us(&params->ImagePathName) );
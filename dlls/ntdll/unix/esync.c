@@ -99,51 +99,66 @@ C_ASSERT(sizeof(struct event) == 8);
 
 static char shm_name[29];
 static int shm_fd;
-static void **shm_addrs;
-static int shm_addrs_size;  /* length of the allocated shm_addrs array */
 static long pagesize;
 
-static pthread_mutex_t shm_addrs_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Pages of the shared memory section, mapped on first use and never
+ * unmapped. The server reuses the slots of destroyed objects, so the
+ * mappings stay in use under handle churn. Lookups are lock-free. */
+#define ESYNC_SHM_BLOCK_SIZE  (65536 / sizeof(void *))
+#define ESYNC_SHM_ENTRIES     256
+
+static void **shm_addrs[ESYNC_SHM_ENTRIES];
 
 static void *get_shm( unsigned int idx )
 {
-    int entry  = (idx * 8) / pagesize;
-    int offset = (idx * 8) % pagesize;
-    void *ret;
-
-    pthread_mutex_lock( &shm_addrs_mutex );
+    unsigned long page = ((unsigned long)idx * 8) / pagesize;
+    int offset = ((unsigned long)idx * 8) % pagesize;
+    unsigned long entry = page / ESYNC_SHM_BLOCK_SIZE, slot = page % ESYNC_SHM_BLOCK_SIZE;
+    void **block, *addr;
 
-    if (entry >= shm_addrs_size)
+    if (entry >= ESYNC_SHM_ENTRIES)
     {
-        int new_size = max(shm_addrs_size * 2, entry + 1);
+        ERR("Shared memory index %u is too large.\n", idx);
+        return NULL;
+    }
 
-        if (!(shm_addrs = realloc( shm_addrs, new_size * sizeof(shm_addrs[0]) )))
-            ERR("Failed to grow shm_addrs array to size %d.\n", shm_addrs_size);
-        memset( shm_addrs + shm_addrs_size, 0, (new_size - shm_addrs_size) * sizeof(shm_addrs[0]) );
-        shm_addrs_size = new_size;
+    if (!(block = __atomic_load_n( &shm_addrs[entry], __ATOMIC_ACQUIRE )))
+    {
+        block = anon_mmap_alloc( ESYNC_SHM_BLOCK_SIZE * sizeof(void *), PROT_READ | PROT_WRITE );
+        if (block == MAP_FAILED)
+        {
+            ERR("Failed to allocate shm_addrs block %lu.\n", entry);
+            return NULL;
+        }
+        if (InterlockedCompareExchangePointer( (void **)&shm_addrs[entry], block, NULL ))
+        {
+            munmap( block, ESYNC_SHM_BLOCK_SIZE * sizeof(void *) ); /* someone beat us to it */
+            block = shm_addrs[entry];
+        }
     }
 
-    if (!shm_addrs[entry])
+    if (!(addr = __atomic_load_n( &block[slot], __ATOMIC_ACQUIRE )))
     {
-        void *addr = mmap( NULL, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, entry * pagesize );
+        addr = mmap( NULL, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, page * pagesize );
         if (addr == (void *)-1)
-            ERR("Failed to map page %d (offset %#lx).\n", entry, entry * pagesize);
+            ERR("Failed to map page %lu (offset %#lx).\n", page, page * pagesize);
 
-        TRACE("Mapping page %d at %p.\n", entry, addr);
+        TRACE("Mapping page %lu at %p.\n", page, addr);
 
-        if (InterlockedCompareExchangePointer( &shm_addrs[entry], addr, 0 ))
+        if (InterlockedCompareExchangePointer( &block[slot], addr, 0 ))
+        {
             munmap( addr, pagesize ); /* someone beat us to it */
+            addr = block[slot];
+        }
     }
 
-    ret = (void *)((unsigned long)shm_addrs[entry] + offset);
-
-    pthread_mutex_unlock( &shm_addrs_mutex );
-
-    return ret;
+    return (void *)((unsigned long)addr + offset);
 }
 
 /* We'd like lookup to be fast. To that end, we use a static list indexed by handle.
- * This is copied and adapted from the fd cache code. */
+ * This is copied and adapted from the fd cache code. Entries are only
+ * modified with fd_cache_mutex held, and published by storing the type
+ * last, so that lookups don't need any lock. */
 
 #define ESYNC_LIST_BLOCK_SIZE  (65536 / sizeof(struct esync))
 #define ESYNC_LIST_ENTRIES     256
@@ -158,9 +173,12 @@ static inline UINT_PTR handle_to_index( HANDLE handle, UINT_PTR *entry )
     return idx % ESYNC_LIST_BLOCK_SIZE;
 }
 
+/* Must be called with fd_cache_mutex held. */
 static struct esync *add_to_list( HANDLE handle, enum esync_type type, int fd, void *shm )
 {
     UINT_PTR entry, idx = handle_to_index( handle, &entry );
+    struct esync *obj;
+    int old_fd = -1;
 
     if (entry >= ESYNC_LIST_ENTRIES)
     {
@@ -170,32 +188,45 @@ static struct esync *add_to_list( HANDLE handle, enum esync_type type, int fd, v
 
     if (!esync_list[entry])  /* do we need to allocate a new block of entries? */
     {
-        if (!entry) esync_list[0] = esync_list_initial_block;
-        else
+        struct esync *block = esync_list_initial_block;
+
+        if (entry)
         {
-            void *ptr = anon_mmap_alloc( ESYNC_LIST_BLOCK_SIZE * sizeof(struct esync),
-                                         PROT_READ | PROT_WRITE );
-            if (ptr == MAP_FAILED) return FALSE;
-            esync_list[entry] = ptr;
+            block = anon_mmap_alloc( ESYNC_LIST_BLOCK_SIZE * sizeof(struct esync),
+                                     PROT_READ | PROT_WRITE );
+            if (block == MAP_FAILED) return FALSE;
         }
+        __atomic_store_n( &esync_list[entry], block, __ATOMIC_RELEASE );
     }
 
-    if (!InterlockedCompareExchange( (int *)&esync_list[entry][idx].type, type, 0 ))
+    obj = &esync_list[entry][idx];
+
+    /* The entry of a handle which was closed behind our back is stale. */
+    if (obj->type)
     {
-        esync_list[entry][idx].fd = fd;
-        esync_list[entry][idx].shm = shm;
+        WARN( "replacing stale entry for handle %p\n", handle );
+        __atomic_store_n( &obj->type, 0, __ATOMIC_RELEASE );
+        old_fd = obj->fd;
     }
-    return &esync_list[entry][idx];
+
+    obj->fd = fd;
+    obj->shm = shm;
+    __atomic_store_n( &obj->type, type, __ATOMIC_RELEASE );
+
+    if (old_fd != -1) close( old_fd );
+    return obj;
 }
 
 static struct esync *get_cached_object( HANDLE handle )
 {
     UINT_PTR entry, idx = handle_to_index( handle, &entry );
+    struct esync *block;
 
-    if (entry >= ESYNC_LIST_ENTRIES || !esync_list[entry]) return NULL;
-    if (!esync_list[entry][idx].type) return NULL;
+    if (entry >= ESYNC_LIST_ENTRIES) return NULL;
+    if (!(block = __atomic_load_n( &esync_list[entry], __ATOMIC_ACQUIRE ))) return NULL;
+    if (!__atomic_load_n( &block[idx].type, __ATOMIC_ACQUIRE )) return NULL;
 
-    return &esync_list[entry][idx];
+    return &block[idx];
 }
 
 /* Gets an object. This is either a proper esync object (i.e. an event,
@@ -242,28 +273,24 @@ static NTSTATUS get_object( HANDLE handle, struct esync **obj )
             }
         }
         SERVER_END_REQ;
-    }
-    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
 
-    if (*obj)
-    {
-        /* We managed to grab it while in the CS; return it. */
-        return STATUS_SUCCESS;
+        if (!ret)
+        {
+            TRACE("Got fd %d for handle %p.\n", fd, handle);
+            *obj = add_to_list( handle, type, fd, shm_idx ? get_shm( shm_idx ) : 0 );
+        }
     }
+    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
 
     if (ret)
     {
         WARN("Failed to retrieve fd for handle %p, status %#x.\n", handle, ret);
         *obj = NULL;
-        return ret;
     }
-
-    TRACE("Got fd %d for handle %p.\n", fd, handle);
-
-    *obj = add_to_list( handle, type, fd, shm_idx ? get_shm( shm_idx ) : 0 );
     return ret;
 }
 
+/* Must be called with fd_cache_mutex held. */
 NTSTATUS esync_close( HANDLE handle )
 {
     UINT_PTR entry, idx = handle_to_index( handle, &entry );
@@ -282,6 +309,31 @@ NTSTATUS esync_close( HANDLE handle )
     return STATUS_INVALID_HANDLE;
 }
 
+/* Called for a handle duplicated in the current process, with
+ * fd_cache_mutex held. If the source is cached, the new handle is cached
+ * too, so that it doesn't need a server round trip before its first use.
+ * The entry of a closed source is moved instead of duplicating the fd. */
+void esync_duplicate( HANDLE source, HANDLE dest, BOOL close_source )
+{
+    struct esync *obj;
+    enum esync_type type;
+    int fd;
+
+    if (!(obj = get_cached_object( source ))) return;
+
+    type = obj->type;
+    if (close_source)
+    {
+        if (!InterlockedExchange( (int *)&obj->type, 0 )) return;
+        fd = obj->fd;
+    }
+    else if ((fd = fcntl( obj->fd, F_DUPFD_CLOEXEC, 0 )) == -1)
+        return;
+
+    TRACE("%p -> %p, fd %d.\n", source, dest, fd);
+    if (!add_to_list( dest, type, fd, obj->shm )) close( fd );
+}
+
 static NTSTATUS create_esync( enum esync_type type, HANDLE *handle, ACCESS_MASK access,
                               const OBJECT_ATTRIBUTES *attr, int initval, int max )
 {
@@ -316,13 +368,12 @@ static NTSTATUS create_esync( enum esync_type type, HANDLE *handle, ACCESS_MASK
         }
     }
     SERVER_END_REQ;
-    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
-
     if (!ret || ret == STATUS_OBJECT_NAME_EXISTS)
     {
         add_to_list( *handle, type, fd, shm_idx ? get_shm( shm_idx ) : 0 );
         TRACE("-> handle %p, fd %d.\n", *handle, fd);
     }
+    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
 
     free( objattr );
     return ret;
@@ -356,14 +407,13 @@ static NTSTATUS open_esync( enum esync_type type, HANDLE *handle,
         }
     }
     SERVER_END_REQ;
-    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
-
     if (!ret)
     {
         add_to_list( *handle, type, fd, shm_idx ? get_shm( shm_idx ) : 0 );
 
         TRACE("-> handle %p, fd %d.\n", *handle, fd);
     }
+    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
     return ret;
 }
 
@@ -796,15 +846,24 @@ static BOOL update_grabbed_object( struct esync *obj )
     return ret;
 }
 
+/* The index of the signaled object is returned separately for wide waits,
+ * where it may not fit below STATUS_ABANDONED_WAIT_0. */
+static inline NTSTATUS wait_result( NTSTATUS status, int i, DWORD *index )
+{
+    if (!index) return status + i;
+    *index = i;
+    return status;
+}
+
 /* A value of STATUS_NOT_IMPLEMENTED returned from this function means that we
- * need to delegate to server_select(). */
+ * need to delegate to server_select(). The caller provides room for count
+ * objects and count + 1 poll fds. */
 static NTSTATUS __esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
-                             BOOLEAN alertable, const LARGE_INTEGER *timeout )
+                             BOOLEAN alertable, const LARGE_INTEGER *timeout,
+                             struct esync **objs, struct pollfd *fds, DWORD *index )
 {
     static const LARGE_INTEGER zero;
 
-    struct esync *objs[MAXIMUM_WAIT_OBJECTS];
-    struct pollfd fds[MAXIMUM_WAIT_OBJECTS + 1];
     int has_esync = 0, has_server = 0;
     BOOL msgwait = FALSE;
     LONGLONG timeleft;
@@ -907,22 +966,24 @@ static NTSTATUS __esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEA
                     {
                         TRACE("Woken up by handle %p [%d].\n", handles[i], i);
                         mutex->count++;
-                        return i;
+                        return wait_result( STATUS_WAIT_0, i, index );
                     }
                     else if (!mutex->count)
                     {
                         if ((size = read( obj->fd, &value, sizeof(value) )) == sizeof(value))
                         {
+                            NTSTATUS status = STATUS_WAIT_0;
+
                             if (mutex->tid == ~0)
                             {
                                 TRACE("Woken up by abandoned mutex %p [%d].\n", handles[i], i);
-                                i += STATUS_ABANDONED_WAIT_0;
+                                status = STATUS_ABANDONED_WAIT_0;
                             }
                             else
                                 TRACE("Woken up by handle %p [%d].\n", handles[i], i);
                             mutex->tid = GetCurrentThreadId();
                             mutex->count++;
-                            return i;
+                            return wait_result( status, i, index );
                         }
                     }
                     break;
@@ -937,7 +998,7 @@ static NTSTATUS __esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEA
                         {
                             TRACE("Woken up by handle %p [%d].\n", handles[i], i);
                             InterlockedDecrement( &semaphore->count );
-                            return i;
+                            return wait_result( STATUS_WAIT_0, i, index );
                         }
                     }
                     break;
@@ -954,7 +1015,7 @@ static NTSTATUS __esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEA
                         {
                             TRACE("Woken up by handle %p [%d].\n", handles[i], i);
                             event->signaled = 0;
-                            return i;
+                            return wait_result( STATUS_WAIT_0, i, index );
                         }
                     }
                     break;
@@ -972,7 +1033,7 @@ static NTSTATUS __esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEA
                                 break;
                         }
                         TRACE("Woken up by handle %p [%d].\n", handles[i], i);
-                        return i;
+                        return wait_result( STATUS_WAIT_0, i, index );
                     }
                     break;
                 }
@@ -1034,7 +1095,7 @@ static NTSTATUS __esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEA
                             if (fds[i].revents & POLLIN)
                             {
                                 TRACE("Woken up by handle %p [%d].\n", handles[i], i);
-                                return i;
+                                return wait_result( STATUS_WAIT_0, i, index );
                             }
                         }
                         else
@@ -1044,8 +1105,8 @@ static NTSTATUS __esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEA
                                 /* We found our object. */
                                 TRACE("Woken up by handle %p [%d].\n", handles[i], i);
                                 if (update_grabbed_object( obj ))
-                                    return STATUS_ABANDONED_WAIT_0 + i;
-                                return i;
+                                    return wait_result( STATUS_ABANDONED_WAIT_0, i, index );
+                                return wait_result( STATUS_WAIT_0, i, index );
                             }
                         }
                     }
@@ -1255,6 +1316,8 @@ static void server_set_msgwait( int in_msgwait )
 NTSTATUS esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
                              BOOLEAN alertable, const LARGE_INTEGER *timeout )
 {
+    struct esync *objs[MAXIMUM_WAIT_OBJECTS];
+    struct pollfd fds[MAXIMUM_WAIT_OBJECTS + 1];
     BOOL msgwait = FALSE;
     struct esync *obj;
     NTSTATUS ret;
@@ -1265,7 +1328,7 @@ NTSTATUS esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_an
         server_set_msgwait( 1 );
     }
 
-    ret = __esync_wait_objects( count, handles, wait_any, alertable, timeout );
+    ret = __esync_wait_objects( count, handles, wait_any, alertable, timeout, objs, fds, NULL );
 
     if (msgwait)
         server_set_msgwait( 0 );
@@ -1273,6 +1336,44 @@ NTSTATUS esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_an
     return ret;
 }
 
+/* Returns STATUS_NOT_IMPLEMENTED if the handle has to be waited on by the server. */
+NTSTATUS esync_check_object( HANDLE handle )
+{
+    struct esync *obj;
+
+    return get_object( handle, &obj );
+}
+
+/* Waits for any of up to ESYNC_MAX_WAIT_OBJECTS handles, which all have to
+ * be esync objects. Used by the threadpool, which never waits on queues. */
+NTSTATUS esync_wait_any_objects( DWORD count, const HANDLE *handles, BOOLEAN alertable,
+                                 const LARGE_INTEGER *timeout, DWORD *index )
+{
+    struct esync **objs;
+    struct pollfd *fds;
+    NTSTATUS ret;
+    DWORD i;
+
+    if (count > ESYNC_MAX_WAIT_OBJECTS) return STATUS_INVALID_PARAMETER_1;
+
+    /* Mixing esync and server objects isn't supported, fail before grabbing anything. */
+    for (i = 0; i < count; i++)
+        if ((ret = esync_check_object( handles[i] ))) return ret;
+
+    if (!(objs = malloc( count * sizeof(*objs) ))) return STATUS_NO_MEMORY;
+    if (!(fds = malloc( (count + 1) * sizeof(*fds) )))
+    {
+        free( objs );
+        return STATUS_NO_MEMORY;
+    }
+
+    ret = __esync_wait_objects( count, handles, TRUE, alertable, timeout, objs, fds, index );
+
+    free( fds );
+    free( objs );
+    return ret;
+}
+
 NTSTATUS esync_signal_and_wait( HANDLE signal, HANDLE wait, BOOLEAN alertable,
     const LARGE_INTEGER *timeout )
 {
@@ -1340,7 +1441,4 @@ void esync_init(void)
     }
 
     pagesize = sysconf( _SC_PAGESIZE );
-
-    shm_addrs = calloc( 128, sizeof(shm_addrs[0]) );
-    shm_addrs_size = 128;
 }
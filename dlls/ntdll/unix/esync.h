@@ -21,6 +21,7 @@
 extern int do_esync(void) DECLSPEC_HIDDEN;
 extern void esync_init(void) DECLSPEC_HIDDEN;
 extern NTSTATUS esync_close( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void esync_duplicate( HANDLE source, HANDLE dest, BOOL close_source ) DECLSPEC_HIDDEN;
 
 extern NTSTATUS esync_create_semaphore(HANDLE *handle, ACCESS_MASK access,
     const OBJECT_ATTRIBUTES *attr, LONG initial, LONG max) DECLSPEC_HIDDEN;
@@ -50,6 +51,13 @@ extern NTSTATUS esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN
 extern NTSTATUS esync_signal_and_wait( HANDLE signal, HANDLE wait, BOOLEAN alertable,
     const LARGE_INTEGER *timeout ) DECLSPEC_HIDDEN;
 
+/* poll() has no fixed limit, this only bounds the memory used by a single wait */
+#define ESYNC_MAX_WAIT_OBJECTS 1024
+
+extern NTSTATUS esync_check_object( HANDLE handle ) DECLSPEC_HIDDEN;
+extern NTSTATUS esync_wait_any_objects( DWORD count, const HANDLE *handles,
+    BOOLEAN alertable, const LARGE_INTEGER *timeout, DWORD *index ) DECLSPEC_HIDDEN;
+
 
 /* We have to synchronize on the fd cache mutex so that our calls to receive_fd
  * don't race with theirs. It looks weird, I know.
@@ -715,13 +715,22 @@ static NTSTATUS do_single_wait( int *addr, int val, ULONGLONG *end, BOOLEAN aler
         return STATUS_PENDING;
 }
 
+/* The index of the signaled object is returned separately for wide waits,
+ * where it may not fit below STATUS_ABANDONED_WAIT_0. */
+static inline NTSTATUS wait_result( NTSTATUS status, int i, DWORD *index )
+{
+    if (!index) return status + i;
+    *index = i;
+    return status;
+}
+
+/* The caller provides room for count objects and count + 1 futexes. */
 static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
-    BOOLEAN wait_any, BOOLEAN alertable, const LARGE_INTEGER *timeout )
+    BOOLEAN wait_any, BOOLEAN alertable, const LARGE_INTEGER *timeout,
+    struct fsync **objs, struct futex_wait_block *futexes, DWORD *index )
 {
     static const LARGE_INTEGER zero = {0};
 
-    struct futex_wait_block futexes[MAXIMUM_WAIT_OBJECTS + 1];
-    struct fsync *objs[MAXIMUM_WAIT_OBJECTS];
     int has_fsync = 0, has_server = 0;
     BOOL msgwait = FALSE;
     int dummy_futex = 0;
@@ -845,7 +854,7 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                                     && __sync_val_compare_and_swap( &semaphore->count, current, current - 1 ) == current)
                             {
                                 TRACE("Woken up by handle %p [%d].\n", handles[i], i);
-                                return i;
+                                return wait_result( STATUS_WAIT_0, i, index );
                             }
                             small_pause();
                         }
@@ -863,7 +872,7 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                         {
                             TRACE("Woken up by handle %p [%d].\n", handles[i], i);
                             mutex->count++;
-                            return i;
+                            return wait_result( STATUS_WAIT_0, i, index );
                         }
 
                         for (spin = 0; spin <= spincount; ++spin)
@@ -872,13 +881,13 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                             {
                                 TRACE("Woken up by handle %p [%d].\n", handles[i], i);
                                 mutex->count = 1;
-                                return i;
+                                return wait_result( STATUS_WAIT_0, i, index );
                             }
                             else if (tid == ~0 && (tid = __sync_val_compare_and_swap( &mutex->tid, ~0, GetCurrentThreadId() )) == ~0)
                             {
                                 TRACE("Woken up by abandoned mutex %p [%d].\n", handles[i], i);
                                 mutex->count = 1;
-                                return STATUS_ABANDONED_WAIT_0 + i;
+                                return wait_result( STATUS_ABANDONED_WAIT_0, i, index );
                             }
                             small_pause();
                         }
@@ -897,7 +906,7 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                             if (__sync_val_compare_and_swap( &event->signaled, 1, 0 ))
                             {
                                 TRACE("Woken up by handle %p [%d].\n", handles[i], i);
-                                return i;
+                                return wait_result( STATUS_WAIT_0, i, index );
                             }
                             small_pause();
                         }
@@ -917,7 +926,7 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                             if (__atomic_load_n( &event->signaled, __ATOMIC_SEQ_CST ))
                             {
                                 TRACE("Woken up by handle %p [%d].\n", handles[i], i);
-                                return i;
+                                return wait_result( STATUS_WAIT_0, i, index );
                             }
                             small_pause();
                         }
@@ -1218,6 +1227,8 @@ static void server_set_msgwait( int in_msgwait )
 NTSTATUS fsync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
                              BOOLEAN alertable, const LARGE_INTEGER *timeout )
 {
+    struct futex_wait_block futexes[MAXIMUM_WAIT_OBJECTS + 1];
+    struct fsync *objs[MAXIMUM_WAIT_OBJECTS];
     BOOL msgwait = FALSE;
     struct fsync *obj;
     NTSTATUS ret;
@@ -1228,7 +1239,7 @@ NTSTATUS fsync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_an
         server_set_msgwait( 1 );
     }
 
-    ret = __fsync_wait_objects( count, handles, wait_any, alertable, timeout );
+    ret = __fsync_wait_objects( count, handles, wait_any, alertable, timeout, objs, futexes, NULL );
 
     if (msgwait)
         server_set_msgwait( 0 );
@@ -1236,6 +1247,33 @@ NTSTATUS fsync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_an
     return ret;
 }
 
+/* Returns STATUS_NOT_IMPLEMENTED if the handle has to be waited on by the server. */
+NTSTATUS fsync_check_object( HANDLE handle )
+{
+    struct fsync *obj;
+
+    return get_object( handle, &obj );
+}
+
+/* Waits for any of up to FSYNC_MAX_WAIT_OBJECTS handles, which all have to
+ * be fsync objects. Used by the threadpool, which never waits on queues. */
+NTSTATUS fsync_wait_any_objects( DWORD count, const HANDLE *handles, BOOLEAN alertable,
+                                 const LARGE_INTEGER *timeout, DWORD *index )
+{
+    struct futex_wait_block futexes[FSYNC_MAX_WAIT_OBJECTS + 1];
+    struct fsync *objs[FSYNC_MAX_WAIT_OBJECTS];
+    NTSTATUS ret;
+    DWORD i;
+
+    if (count > FSYNC_MAX_WAIT_OBJECTS) return STATUS_INVALID_PARAMETER_1;
+
+    /* Mixing fsync and server objects isn't supported, fail before grabbing anything. */
+    for (i = 0; i < count; i++)
+        if ((ret = fsync_check_object( handles[i] ))) return ret;
+
+    return __fsync_wait_objects( count, handles, TRUE, alertable, timeout, objs, futexes, index );
+}
+
 NTSTATUS fsync_signal_and_wait( HANDLE signal, HANDLE wait, BOOLEAN alertable,
     const LARGE_INTEGER *timeout )
 {
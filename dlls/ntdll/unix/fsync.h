@@ -47,3 +47,10 @@ extern NTSTATUS fsync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN
                                     BOOLEAN alertable, const LARGE_INTEGER *timeout ) DECLSPEC_HIDDEN;
 extern NTSTATUS fsync_signal_and_wait( HANDLE signal, HANDLE wait,
     BOOLEAN alertable, const LARGE_INTEGER *timeout ) DECLSPEC_HIDDEN;
+
+/* FUTEX_WAIT_MULTIPLE takes up to 128 futexes, one of them is the APC futex */
+#define FSYNC_MAX_WAIT_OBJECTS 127
+
+extern NTSTATUS fsync_check_object( HANDLE handle ) DECLSPEC_HIDDEN;
+extern NTSTATUS fsync_wait_any_objects( DWORD count, const HANDLE *handles,
+    BOOLEAN alertable, const LARGE_INTEGER *timeout, DWORD *index ) DECLSPEC_HIDDEN;
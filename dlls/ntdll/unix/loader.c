@@ -352,8 +352,13 @@ static void * const syscalls[] =
     NtWriteVirtualMemory,
     NtYieldExecution,
     __wine_dbg_write,
+    __wine_startup_trace,
     __wine_unix_call,
     __wine_unix_spawnvp,
+    __wine_wait_any_objects,
+    __wine_wait_any_supported,
+    __wine_wait_on_address,
+    __wine_wake_address,
     wine_nt_to_unix_file_name,
     wine_server_call,
     wine_server_fd_to_handle,
@@ -1371,6 +1376,142 @@ already_loaded:
 }
 
 
+#ifdef __x86_64__
+
+/* per-syscall counters, enabled with WINESYSCALLSTATS=1 and dumped at exit */
+
+#define SYSCALL_STATS_MAX_ARGS 17
+
+struct syscall_stats
+{
+    LONG64 count;
+    LONG64 time;  /* in nanoseconds */
+};
+
+static struct syscall_stats *syscall_stats[4];
+static ULONG_PTR *syscall_stats_funcs[4];
+static ULONG_PTR *syscall_stats_thunks[4];
+static ULONG syscall_stats_limit[4];
+
+typedef ULONG_PTR (WINAPI *syscall_stats_func)( ULONG_PTR, ULONG_PTR, ULONG_PTR, ULONG_PTR, ULONG_PTR, ULONG_PTR,
+                                                ULONG_PTR, ULONG_PTR, ULONG_PTR, ULONG_PTR, ULONG_PTR, ULONG_PTR,
+                                                ULONG_PTR, ULONG_PTR, ULONG_PTR, ULONG_PTR, ULONG_PTR );
+
+static inline LONG64 syscall_stats_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * (LONG64)1000000000 + ts.tv_nsec;
+}
+
+/* installed in the service tables instead of the syscalls, the dispatcher copies the arguments
+ * to the stack so forwarding the maximum count is harmless for functions that take fewer */
+static ULONG_PTR WINAPI syscall_stats_thunk( ULONG_PTR a1, ULONG_PTR a2, ULONG_PTR a3, ULONG_PTR a4,
+                                             ULONG_PTR a5, ULONG_PTR a6, ULONG_PTR a7, ULONG_PTR a8,
+                                             ULONG_PTR a9, ULONG_PTR a10, ULONG_PTR a11, ULONG_PTR a12,
+                                             ULONG_PTR a13, ULONG_PTR a14, ULONG_PTR a15, ULONG_PTR a16,
+                                             ULONG_PTR a17 )
+{
+    ULONG id = signal_get_syscall_id(), table = (id >> 12) & 3;
+    struct syscall_stats *stats = &syscall_stats[table][id & 0xfff];
+    syscall_stats_func func = (syscall_stats_func)syscall_stats_funcs[table][id & 0xfff];
+    LONG64 start = syscall_stats_time();
+    ULONG_PTR ret;
+
+    __atomic_add_fetch( &stats->count, 1, __ATOMIC_RELAXED );
+    ret = func( a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17 );
+    __atomic_add_fetch( &stats->time, syscall_stats_time() - start, __ATOMIC_RELAXED );
+    return ret;
+}
+
+static int compare_syscall_stats( const void *a, const void *b )
+{
+    const struct syscall_stats *stats1 = *(const struct syscall_stats **)a;
+    const struct syscall_stats *stats2 = *(const struct syscall_stats **)b;
+
+    if (stats1->time != stats2->time) return stats1->time < stats2->time ? 1 : -1;
+    return 0;
+}
+
+static void dump_syscall_stats(void)
+{
+    struct syscall_stats **sorted;
+    unsigned int i, j, count = 0;
+
+    for (i = 0; i < ARRAY_SIZE(syscall_stats); i++) count += syscall_stats_limit[i];
+    if (!(sorted = malloc( count * sizeof(*sorted) ))) return;
+
+    for (i = count = 0; i < ARRAY_SIZE(syscall_stats); i++)
+        for (j = 0; j < syscall_stats_limit[i]; j++)
+            if (syscall_stats[i][j].count) sorted[count++] = &syscall_stats[i][j];
+    qsort( sorted, count, sizeof(*sorted), compare_syscall_stats );
+
+    fprintf( stderr, "%04x: syscall statistics\n", (int)GetCurrentProcessId() );
+    fprintf( stderr, "%-40s %12s %14s %10s\n", "syscall", "count", "total us", "avg ns" );
+    for (i = 0; i < count; i++)
+    {
+        struct syscall_stats *stats = sorted[i];
+        void *func = NULL;
+        char name[32];
+        Dl_info info;
+
+        for (j = 0; j < ARRAY_SIZE(syscall_stats); j++)
+        {
+            if (stats < syscall_stats[j] || stats >= syscall_stats[j] + syscall_stats_limit[j]) continue;
+            func = (void *)syscall_stats_funcs[j][stats - syscall_stats[j]];
+            snprintf( name, sizeof(name), "%u:%u", j, (unsigned int)(stats - syscall_stats[j]) );
+            break;
+        }
+        fprintf( stderr, "%-40s %12lld %14lld %10lld\n",
+                 dladdr( func, &info ) && info.dli_sname && info.dli_saddr == func ? info.dli_sname : name,
+                 (long long)stats->count, (long long)stats->time / 1000,
+                 (long long)(stats->time / stats->count) );
+    }
+    free( sorted );
+}
+
+static void init_syscall_stats( ULONG id, SYSTEM_SERVICE_TABLE *table )
+{
+    static int enabled = -1;
+    ULONG i;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINESYSCALLSTATS" );
+        enabled = env && atoi( env );
+        if (enabled) atexit( dump_syscall_stats );
+    }
+    if (!enabled) return;
+
+    if (!(syscall_stats[id] = calloc( table->ServiceLimit, sizeof(*syscall_stats[id]) )) ||
+        !(syscall_stats_funcs[id] = malloc( table->ServiceLimit * sizeof(ULONG_PTR) )) ||
+        !(syscall_stats_thunks[id] = malloc( table->ServiceLimit * sizeof(ULONG_PTR) )))
+        return;
+
+    for (i = 0; i < table->ServiceLimit; i++)
+    {
+        syscall_stats_funcs[id][i] = table->ServiceTable[i];
+        if (table->ArgumentTable[i] <= SYSCALL_STATS_MAX_ARGS * sizeof(ULONG_PTR))
+            syscall_stats_thunks[id][i] = (ULONG_PTR)syscall_stats_thunk;
+        else
+            syscall_stats_thunks[id][i] = table->ServiceTable[i];
+    }
+    syscall_stats_limit[id] = table->ServiceLimit;
+    table->ServiceTable = syscall_stats_thunks[id];
+}
+
+#else
+
+static void init_syscall_stats( ULONG id, SYSTEM_SERVICE_TABLE *table )
+{
+    const char *env = getenv( "WINESYSCALLSTATS" );
+
+    if (env && atoi( env ) && !id) FIXME( "syscall statistics not supported on this platform\n" );
+}
+
+#endif
+
 /***********************************************************************
  *           ntdll_init_syscalls
  */
@@ -1391,6 +1532,7 @@ NTSTATUS ntdll_init_syscalls( ULONG id, SYSTEM_SERVICE_TABLE *table, void **disp
     }
     info->dispatcher = __wine_syscall_dispatcher;
     memcpy( table->ArgumentTable, info->args, table->ServiceLimit );
+    init_syscall_stats( id, table );
     KeServiceDescriptorTable[id] = *table;
     return STATUS_SUCCESS;
 }
@@ -2158,7 +2300,10 @@ static void start_main_thread(void)
     signal_alloc_thread( teb );
     signal_init_thread( teb );
     dbg_init();
+    init_fork_server();
+    __wine_startup_trace( "server_init_process", __WINE_STARTUP_TRACE_BEGIN );
     startup_info_size = server_init_process();
+    __wine_startup_trace( "server_init_process", __WINE_STARTUP_TRACE_END );
     hacks_init();
     fsync_init();
     esync_init();
@@ -2175,6 +2320,7 @@ static void start_main_thread(void)
     init_thread_stack( teb, is_win64 ? 0x7fffffff : 0, 0, 0 );
     NtCreateKeyedEvent( &keyed_event, GENERIC_READ | GENERIC_WRITE, NULL, 0 );
     load_ntdll();
+    wait_profile_init();
     if (main_image_info.Machine != current_machine) load_wow64_ntdll( main_image_info.Machine );
     ntdll_init_syscalls( 0, &syscall_table, p__wine_syscall_dispatcher );
     status = p__wine_set_unix_funcs( NTDLL_UNIXLIB_VERSION, &unix_funcs );
@@ -25,8 +25,10 @@
 
 #include "config.h"
 
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -81,15 +83,19 @@ static UINT process_error_mode;
 
 static char **build_argv( const UNICODE_STRING *cmdline, int reserved )
 {
-    char **argv, *arg, *src, *dst;
+    char **argv, *arg, *str, *src, *dst;
     int argc, in_quotes = 0, bcount = 0, len = cmdline->Length / sizeof(WCHAR);
 
-    if (!(src = malloc( len * 3 + 1 ))) return NULL;
+    if (!(src = str = malloc( len * 3 + 1 ))) return NULL;
     len = ntdll_wcstoumbs( cmdline->Buffer, len, src, len * 3, FALSE );
     src[len++] = 0;
 
     argc = reserved + 2 + len / 2;
-    argv = malloc( argc * sizeof(*argv) + len );
+    if (!(argv = malloc( argc * sizeof(*argv) + len )))
+    {
+        free( str );
+        return NULL;
+    }
     arg = dst = (char *)(argv + argc);
     argc = reserved;
     while (*src)
@@ -142,6 +148,7 @@ static char **build_argv( const UNICODE_STRING *cmdline, int reserved )
     *dst = 0;
     argv[argc++] = arg;
     argv[argc] = NULL;
+    free( str );
     return argv;
 }
 
@@ -420,6 +427,325 @@ static BOOL is_unix_console_handle( HANDLE handle )
 }
 
 
+/* fork server, a small helper process forked at init when WINEFORKSERVER is set.
+ * It is single-threaded and has almost nothing mapped, so forking it is much
+ * cheaper than forking a fully initialized process. */
+
+struct fork_request
+{
+    unsigned int    flags;       /* FORK_* flags */
+    unsigned int    argv_size;   /* size of the argv strings */
+    unsigned int    env_size;    /* size of the environment strings */
+    pe_image_info_t pe_info;     /* image info for exec_wineloader */
+};
+
+#define FORK_NEW_SESSION  0x01   /* detach from the console */
+#define FORK_STDIN        0x02   /* stdin fd follows */
+#define FORK_STDOUT       0x04   /* stdout fd follows */
+#define FORK_UNIXDIR      0x08   /* current directory fd follows */
+/* the server socket of the new process is sent along with the request */
+
+static int fork_server_socket = -1;
+static pthread_mutex_t fork_server_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* send a buffer and optionally a file descriptor on the fork server socket */
+static BOOL fork_server_send( int socket, const void *data, size_t size, int fd )
+{
+    struct msghdr msghdr;
+    struct iovec vec;
+    ssize_t ret;
+#ifndef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+    char cmsg_buffer[256];
+    struct cmsghdr *cmsg;
+#endif
+
+    memset( &msghdr, 0, sizeof(msghdr) );
+    if (fd != -1)
+    {
+#ifdef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+        msghdr.msg_accrights    = (void *)&fd;
+        msghdr.msg_accrightslen = sizeof(fd);
+#else
+        msghdr.msg_control    = cmsg_buffer;
+        msghdr.msg_controllen = sizeof(cmsg_buffer);
+        cmsg = CMSG_FIRSTHDR( &msghdr );
+        cmsg->cmsg_len   = CMSG_LEN( sizeof(fd) );
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type  = SCM_RIGHTS;
+        *(int *)CMSG_DATA(cmsg) = fd;
+        msghdr.msg_controllen = cmsg->cmsg_len;
+#endif
+    }
+    msghdr.msg_iov    = &vec;
+    msghdr.msg_iovlen = 1;
+
+    while (size)
+    {
+        vec.iov_base = (void *)data;
+        vec.iov_len  = size;
+        if ((ret = sendmsg( socket, &msghdr, 0 )) == -1)
+        {
+            if (errno == EINTR) continue;
+            return FALSE;
+        }
+        data = (const char *)data + ret;
+        size -= ret;
+        /* the fd goes with the first chunk */
+        msghdr.msg_control = NULL;
+        msghdr.msg_controllen = 0;
+#ifdef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+        msghdr.msg_accrights = NULL;
+        msghdr.msg_accrightslen = 0;
+#endif
+    }
+    return TRUE;
+}
+
+/* receive a buffer and optionally a file descriptor on the fork server socket */
+static BOOL fork_server_recv( int socket, void *data, size_t size, int *fd )
+{
+    struct msghdr msghdr;
+    struct iovec vec;
+    ssize_t ret;
+#ifndef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+    char cmsg_buffer[256];
+    struct cmsghdr *cmsg;
+#endif
+
+    if (fd) *fd = -1;
+    while (size)
+    {
+        memset( &msghdr, 0, sizeof(msghdr) );
+#ifdef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+        msghdr.msg_accrights    = (void *)fd;
+        msghdr.msg_accrightslen = fd ? sizeof(*fd) : 0;
+#else
+        msghdr.msg_control    = cmsg_buffer;
+        msghdr.msg_controllen = sizeof(cmsg_buffer);
+#endif
+        msghdr.msg_iov    = &vec;
+        msghdr.msg_iovlen = 1;
+        vec.iov_base = data;
+        vec.iov_len  = size;
+        if ((ret = recvmsg( socket, &msghdr, 0 )) <= 0)
+        {
+            if (ret == -1 && errno == EINTR) continue;
+            return FALSE;
+        }
+#ifndef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+        for (cmsg = CMSG_FIRSTHDR( &msghdr ); cmsg; cmsg = CMSG_NXTHDR( &msghdr, cmsg ))
+        {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+            if (fd && *fd == -1) *fd = *(int *)CMSG_DATA(cmsg);
+            else close( *(int *)CMSG_DATA(cmsg) );
+        }
+#endif
+        data = (char *)data + ret;
+        size -= ret;
+    }
+    return TRUE;
+}
+
+/* split a block of nul-separated strings into a NULL terminated array */
+static char **split_strings( char *strings, unsigned int size, int reserved )
+{
+    unsigned int i, count = reserved + 1;
+    char **array, *p;
+
+    for (i = 0; i < size; i++) if (!strings[i]) count++;
+    if (!(array = malloc( count * sizeof(*array) ))) return NULL;
+    count = reserved;
+    for (p = strings; p < strings + size; p += strlen(p) + 1) array[count++] = p;
+    array[count] = NULL;
+    return array;
+}
+
+/* handle a spawn request in the fork server, returns the errno value to send back */
+static int fork_server_spawn( int socket )
+{
+    extern char **environ;
+    struct fork_request req;
+    int socketfd, stdin_fd = -1, stdout_fd = -1, unixdir = -1, err = 0;
+    char *strings = NULL, **argv = NULL, **env = NULL;
+    pid_t pid;
+
+    if (!fork_server_recv( socket, &req, sizeof(req), &socketfd )) _exit(0);  /* parent is gone */
+    if ((req.flags & FORK_STDIN) && !fork_server_recv( socket, &err, sizeof(err), &stdin_fd )) _exit(0);
+    if ((req.flags & FORK_STDOUT) && !fork_server_recv( socket, &err, sizeof(err), &stdout_fd )) _exit(0);
+    if ((req.flags & FORK_UNIXDIR) && !fork_server_recv( socket, &err, sizeof(err), &unixdir )) _exit(0);
+    if (!(strings = malloc( req.argv_size + req.env_size ))) _exit(1);
+    if (!fork_server_recv( socket, strings, req.argv_size + req.env_size, NULL )) _exit(0);
+
+    err = ENOMEM;
+    if (!(argv = split_strings( strings, req.argv_size, 2 ))) goto done;
+    if (!(env = split_strings( strings + req.argv_size, req.env_size, 0 ))) goto done;
+
+    if (!(pid = fork()))
+    {
+        close( socket );
+        signal( SIGCHLD, SIG_DFL );
+        if (req.flags & FORK_NEW_SESSION)
+        {
+            setsid();
+            set_stdio_fd( -1, -1 );  /* close stdin and stdout */
+        }
+        else set_stdio_fd( stdin_fd, stdout_fd );
+
+        if (stdin_fd != -1 && stdin_fd != 0) close( stdin_fd );
+        if (stdout_fd != -1 && stdout_fd != 1) close( stdout_fd );
+        if (unixdir != -1)
+        {
+            fchdir( unixdir );
+            close( unixdir );
+        }
+        environ = env;
+        exec_wineloader( argv, socketfd, &req.pe_info );
+        _exit(1);
+    }
+    err = (pid == -1) ? errno : 0;
+
+done:
+    if (socketfd != -1) close( socketfd );
+    if (stdin_fd != -1) close( stdin_fd );
+    if (stdout_fd != -1) close( stdout_fd );
+    if (unixdir != -1) close( unixdir );
+    free( env );
+    free( argv );
+    free( strings );
+    return err;
+}
+
+/* close the fds inherited from the parent, the server socket in particular */
+static void fork_server_close_fds( int keep )
+{
+    struct dirent *de;
+    DIR *dir;
+    int fd, max_fd;
+
+    if ((dir = opendir( "/proc/self/fd" )))
+    {
+        while ((de = readdir( dir )))
+        {
+            fd = atoi( de->d_name );
+            if (fd > 2 && fd != keep && fd != dirfd( dir )) close( fd );
+        }
+        closedir( dir );
+        return;
+    }
+    max_fd = min( sysconf( _SC_OPEN_MAX ), 65536 );
+    for (fd = 3; fd < max_fd; fd++) if (fd != keep) close( fd );
+}
+
+/***********************************************************************
+ *           init_fork_server
+ *
+ * Start the fork server if enabled. Must be called while the process is still single-threaded.
+ */
+void init_fork_server(void)
+{
+    const char *env = getenv( "WINEFORKSERVER" );
+    int fds[2], err;
+    pid_t pid;
+
+    if (!env || !atoi( env )) return;
+    if (socketpair( PF_UNIX, SOCK_STREAM, 0, fds ) == -1) return;
+
+    if (!(pid = fork()))  /* fork server */
+    {
+        fork_server_close_fds( fds[1] );
+        signal( SIGCHLD, SIG_IGN );  /* let the system reap the children */
+        signal( SIGPIPE, SIG_IGN );
+        for (;;)
+        {
+            err = fork_server_spawn( fds[1] );
+            if (!fork_server_send( fds[1], &err, sizeof(err), -1 )) _exit(0);
+        }
+    }
+    close( fds[1] );
+    if (pid == -1)
+    {
+        close( fds[0] );
+        return;
+    }
+    fcntl( fds[0], F_SETFD, FD_CLOEXEC );
+    fork_server_socket = fds[0];
+}
+
+/***********************************************************************
+ *           fork_server_exec
+ *
+ * Start a new process through the fork server.
+ */
+static NTSTATUS fork_server_exec( const RTL_USER_PROCESS_PARAMETERS *params, BOOL new_session, int socketfd,
+                                  int stdin_fd, int stdout_fd, int unixdir, char *winedebug,
+                                  const pe_image_info_t *pe_info )
+{
+    extern char **environ;
+    struct fork_request req;
+    char **argv, **env, *buffer, *p;
+    unsigned int size;
+    int err = 0;
+    BOOL ret;
+
+    if (fork_server_socket == -1) return STATUS_NOT_SUPPORTED;
+    if (!(argv = build_argv( &params->CommandLine, 2 ))) return STATUS_NO_MEMORY;
+
+    memset( &req, 0, sizeof(req) );
+    req.pe_info = *pe_info;
+    /* the native machine is only known after the fork server got started */
+    if (req.pe_info.image_flags & IMAGE_FLAGS_ComPlusNativeReady)
+    {
+        req.pe_info.machine = native_machine;
+        req.pe_info.image_flags &= ~IMAGE_FLAGS_ComPlusNativeReady;
+    }
+    if (new_session) req.flags |= FORK_NEW_SESSION;
+    if (stdin_fd != -1) req.flags |= FORK_STDIN;
+    if (stdout_fd != -1) req.flags |= FORK_STDOUT;
+    if (unixdir != -1) req.flags |= FORK_UNIXDIR;
+
+    for (env = argv + 2; *env; env++) req.argv_size += strlen( *env ) + 1;
+    for (env = environ; *env; env++)
+    {
+        if (winedebug && !strncmp( *env, "WINEDEBUG=", 10 )) continue;
+        req.env_size += strlen( *env ) + 1;
+    }
+    if (winedebug) req.env_size += strlen( winedebug ) + 1;
+
+    if (!(buffer = malloc( req.argv_size + req.env_size )))
+    {
+        free( argv );
+        return STATUS_NO_MEMORY;
+    }
+    p = buffer;
+    for (env = argv + 2; *env; env++) p += strlen( strcpy( p, *env )) + 1;
+    for (env = environ; *env; env++)
+    {
+        if (winedebug && !strncmp( *env, "WINEDEBUG=", 10 )) continue;
+        p += strlen( strcpy( p, *env )) + 1;
+    }
+    if (winedebug) strcpy( p, winedebug );
+    size = req.argv_size + req.env_size;
+
+    pthread_mutex_lock( &fork_server_mutex );
+    ret = fork_server_send( fork_server_socket, &req, sizeof(req), socketfd ) &&
+          (stdin_fd == -1 || fork_server_send( fork_server_socket, &err, sizeof(err), stdin_fd )) &&
+          (stdout_fd == -1 || fork_server_send( fork_server_socket, &err, sizeof(err), stdout_fd )) &&
+          (unixdir == -1 || fork_server_send( fork_server_socket, &err, sizeof(err), unixdir )) &&
+          fork_server_send( fork_server_socket, buffer, size, -1 ) &&
+          fork_server_recv( fork_server_socket, &err, sizeof(err), NULL );
+    pthread_mutex_unlock( &fork_server_mutex );
+
+    free( buffer );
+    free( argv );
+    if (!ret)
+    {
+        WARN( "fork server failed, falling back to fork\n" );
+        return STATUS_NOT_SUPPORTED;
+    }
+    return err ? STATUS_NO_MEMORY : STATUS_SUCCESS;
+}
+
+
 /***********************************************************************
  *           spawn_process
  */
@@ -428,6 +754,7 @@ static NTSTATUS spawn_process( const RTL_USER_PROCESS_PARAMETERS *params, int so
 {
     NTSTATUS status = STATUS_SUCCESS;
     int stdin_fd = -1, stdout_fd = -1;
+    BOOL new_session;
     pid_t pid;
     char **argv;
 
@@ -439,13 +766,18 @@ static NTSTATUS spawn_process( const RTL_USER_PROCESS_PARAMETERS *params, int so
         isatty(1) && is_unix_console_handle( params->hStdOutput ))
         stdout_fd = 1;
 
+    new_session = params->ConsoleFlags || params->ConsoleHandle == CONSOLE_HANDLE_ALLOC ||
+                  (params->hStdInput == INVALID_HANDLE_VALUE && params->hStdOutput == INVALID_HANDLE_VALUE);
+
+    status = fork_server_exec( params, new_session, socketfd, stdin_fd, stdout_fd, unixdir, winedebug, pe_info );
+    if (status != STATUS_NOT_SUPPORTED) goto done;
+    status = STATUS_SUCCESS;
+
     if (!(pid = fork()))  /* child */
     {
         if (!(pid = fork()))  /* grandchild */
         {
-            if (params->ConsoleFlags ||
-                params->ConsoleHandle == CONSOLE_HANDLE_ALLOC ||
-                (params->hStdInput == INVALID_HANDLE_VALUE && params->hStdOutput == INVALID_HANDLE_VALUE))
+            if (new_session)
             {
                 setsid();
                 set_stdio_fd( -1, -1 );  /* close stdin and stdout */
@@ -480,6 +812,7 @@ static NTSTATUS spawn_process( const RTL_USER_PROCESS_PARAMETERS *params, int so
     }
     else status = STATUS_NO_MEMORY;
 
+done:
     if (stdin_fd != -1 && stdin_fd != 0) close( stdin_fd );
     if (stdout_fd != -1 && stdout_fd != 1) close( stdout_fd );
     return status;
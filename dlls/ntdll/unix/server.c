@@ -1674,7 +1674,10 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
     /* always remove the cached fd; if the server request fails we'll just
      * retrieve it again */
     if (options & DUPLICATE_CLOSE_SOURCE)
+    {
         fd = remove_fd_from_cache( source );
+        completion_close( source );
+    }
 
     SERVER_START_REQ( dup_handle )
     {
@@ -1691,6 +1694,14 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
     }
     SERVER_END_REQ;
 
+    if (do_esync() && source_process == NtCurrentProcess())
+    {
+        if (!ret && dest && dest_process == NtCurrentProcess())
+            esync_duplicate( source, *dest, options & DUPLICATE_CLOSE_SOURCE );
+        else if (options & DUPLICATE_CLOSE_SOURCE)
+            esync_close( source );
+    }
+
     server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
 
     if (fd != -1) close( fd );
@@ -1732,6 +1743,7 @@ NTSTATUS WINAPI NtClose( HANDLE handle )
     /* always remove the cached fd; if the server request fails we'll just
      * retrieve it again */
     fd = remove_fd_from_cache( handle );
+    completion_close( handle );
 
     if (do_fsync())
         fsync_close( handle );
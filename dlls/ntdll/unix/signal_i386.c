@@ -2533,6 +2533,21 @@ __ASM_GLOBAL_FUNC( signal_exit_thread,
                    "call *%ecx" )
 
 
+/***********************************************************************
+ *           signal_get_syscall_stack
+ *
+ * Return the user stack of the syscall being dispatched on the current thread,
+ * starting with the return address of the syscall thunk.
+ */
+void **signal_get_syscall_stack(void)
+{
+    struct syscall_frame *frame = x86_thread_data()->syscall_frame;
+
+    /* the stack pointer is saved after the dispatcher return address is popped */
+    return (void **)frame->esp;
+}
+
+
 /***********************************************************************
  *           __wine_syscall_dispatcher
  */
@@ -3428,6 +3428,32 @@ __ASM_GLOBAL_FUNC( signal_exit_thread,
                    __ASM_CFI(".cfi_rel_offset %r15,8\n\t")
                    "call *%rsi" )
 
+/***********************************************************************
+ *           signal_get_syscall_id
+ *
+ * Return the id of the syscall being dispatched on the current thread.
+ */
+ULONG signal_get_syscall_id(void)
+{
+    return amd64_thread_data()->syscall_frame->rax;
+}
+
+
+/***********************************************************************
+ *           signal_get_syscall_stack
+ *
+ * Return the user stack of the syscall being dispatched on the current thread,
+ * starting with the return address of the syscall thunk.
+ */
+void **signal_get_syscall_stack(void)
+{
+    struct syscall_frame *frame = amd64_thread_data()->syscall_frame;
+
+    /* the stack pointer is saved after the dispatcher return address is popped */
+    return (void **)frame->rsp;
+}
+
+
 /***********************************************************************
  *           __wine_syscall_dispatcher
  */
@@ -34,6 +34,9 @@
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/mman.h>
+#ifdef HAVE_SYS_PRCTL_H
+# include <sys/prctl.h>
+#endif
 #ifdef HAVE_SYS_SYSCALL_H
 #include <sys/syscall.h>
 #endif
@@ -108,6 +111,8 @@ static inline ULONGLONG monotonic_counter(void)
 
 #define FUTEX_WAIT 0
 #define FUTEX_WAKE 1
+#define FUTEX_WAIT_BITSET 9
+#define FUTEX_WAKE_BITSET 10
 
 static int futex_private = 128;
 
@@ -121,6 +126,16 @@ static inline int futex_wake( const int *addr, int val )
     return syscall( __NR_futex, addr, FUTEX_WAKE | futex_private, val, NULL, 0, 0 );
 }
 
+static inline int futex_wait_bitset( const int *addr, int val, struct timespec *end, unsigned int mask )
+{
+    return syscall( __NR_futex, addr, FUTEX_WAIT_BITSET | futex_private, val, end, 0, mask );
+}
+
+static inline int futex_wake_bitset( const int *addr, int val, unsigned int mask )
+{
+    return syscall( __NR_futex, addr, FUTEX_WAKE_BITSET | futex_private, val, NULL, 0, mask );
+}
+
 static inline int use_futexes(void)
 {
     static int supported = -1;
@@ -1484,16 +1499,14 @@ NTSTATUS WINAPI NtQueryTimer( HANDLE handle, TIMER_INFORMATION_CLASS class,
 
 
 /******************************************************************
- *		NtWaitForMultipleObjects (NTDLL.@)
+ *		wait_objects
  */
-NTSTATUS WINAPI NtWaitForMultipleObjects( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
-                                          BOOLEAN alertable, const LARGE_INTEGER *timeout )
+static NTSTATUS wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
+                              BOOLEAN alertable, const LARGE_INTEGER *timeout )
 {
     select_op_t select_op;
     UINT i, flags = SELECT_INTERRUPTIBLE;
 
-    if (!count || count > MAXIMUM_WAIT_OBJECTS) return STATUS_INVALID_PARAMETER_1;
-
     if (do_fsync())
     {
         NTSTATUS ret = fsync_wait_objects( count, handles, wait_any, alertable, timeout );
@@ -1515,6 +1528,32 @@ NTSTATUS WINAPI NtWaitForMultipleObjects( DWORD count, const HANDLE *handles, BO
 }
 
 
+/******************************************************************
+ *		NtWaitForMultipleObjects (NTDLL.@)
+ */
+NTSTATUS WINAPI NtWaitForMultipleObjects( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
+                                          BOOLEAN alertable, const LARGE_INTEGER *timeout )
+{
+    ULONG64 start;
+    NTSTATUS ret;
+
+    if (!count || count > MAXIMUM_WAIT_OBJECTS) return STATUS_INVALID_PARAMETER_1;
+
+    if (!wait_profiling( timeout )) return wait_objects( count, handles, wait_any, alertable, timeout );
+
+    start = wait_profile_time();
+    ret = wait_objects( count, handles, wait_any, alertable, timeout );
+    /* charge the wait to the object that ended it, if any */
+    if (ret < count)
+        wait_profile_record( WAIT_PROFILE_OBJECT, handles[ret], start );
+    else if (ret >= STATUS_ABANDONED_WAIT_0 && ret < STATUS_ABANDONED_WAIT_0 + count)
+        wait_profile_record( WAIT_PROFILE_OBJECT, handles[ret - STATUS_ABANDONED_WAIT_0], start );
+    else
+        wait_profile_record( WAIT_PROFILE_TIMEOUT, NULL, start );
+    return ret;
+}
+
+
 /******************************************************************
  *		NtWaitForSingleObject (NTDLL.@)
  */
@@ -1525,10 +1564,9 @@ NTSTATUS WINAPI NtWaitForSingleObject( HANDLE handle, BOOLEAN alertable, const L
 
 
 /******************************************************************
- *		NtSignalAndWaitForSingleObject (NTDLL.@)
+ *		signal_and_wait
  */
-NTSTATUS WINAPI NtSignalAndWaitForSingleObject( HANDLE signal, HANDLE wait,
-                                                BOOLEAN alertable, const LARGE_INTEGER *timeout )
+static NTSTATUS signal_and_wait( HANDLE signal, HANDLE wait, BOOLEAN alertable, const LARGE_INTEGER *timeout )
 {
     select_op_t select_op;
     UINT flags = SELECT_INTERRUPTIBLE;
@@ -1549,11 +1587,33 @@ NTSTATUS WINAPI NtSignalAndWaitForSingleObject( HANDLE signal, HANDLE wait,
 }
 
 
+/******************************************************************
+ *		NtSignalAndWaitForSingleObject (NTDLL.@)
+ */
+NTSTATUS WINAPI NtSignalAndWaitForSingleObject( HANDLE signal, HANDLE wait,
+                                                BOOLEAN alertable, const LARGE_INTEGER *timeout )
+{
+    ULONG64 start;
+    NTSTATUS ret;
+
+    if (!wait_profiling( timeout )) return signal_and_wait( signal, wait, alertable, timeout );
+
+    start = wait_profile_time();
+    ret = signal_and_wait( signal, wait, alertable, timeout );
+    if (ret == STATUS_WAIT_0 || ret == STATUS_ABANDONED_WAIT_0)
+        wait_profile_record( WAIT_PROFILE_OBJECT, wait, start );
+    else
+        wait_profile_record( WAIT_PROFILE_TIMEOUT, NULL, start );
+    return ret;
+}
+
+
 /******************************************************************
  *		NtYieldExecution (NTDLL.@)
  */
 NTSTATUS WINAPI NtYieldExecution(void)
 {
+    ntdll_get_thread_data()->yield_count++;
 #ifdef HAVE_SCHED_YIELD
     sched_yield();
     return STATUS_SUCCESS;
@@ -1563,29 +1623,83 @@ NTSTATUS WINAPI NtYieldExecution(void)
 }
 
 
+/* sleeps up to this many ticks use a small timer slack */
+#define SHORT_SLEEP_TICKS 20000
+#define SHORT_SLEEP_TIMER_SLACK 1000  /* in ns */
+
+/* check without a server call that no user APCs are pending */
+static BOOL no_user_apc_pending(void)
+{
+    int *apc_futex = ntdll_get_thread_data()->fsync_apc_futex;
+
+    return do_fsync() && apc_futex && !__atomic_load_n( apc_futex, __ATOMIC_SEQ_CST );
+}
+
+#ifdef __linux__
+/* sleep until a relative timeout on the monotonic clock */
+static void delay_relative( LONGLONG ticks )
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct timespec end;
+    BOOL restore_slack = FALSE;
+
+    if (ticks <= SHORT_SLEEP_TICKS)
+    {
+        thread_data->short_sleep_count++;
+#ifdef PR_SET_TIMERSLACK
+        /* the default slack of 50us is significant for sleeps of a few ms */
+        if (!thread_data->timer_slack) thread_data->timer_slack = prctl( PR_GET_TIMERSLACK );
+        if (thread_data->timer_slack > SHORT_SLEEP_TIMER_SLACK)
+            restore_slack = !prctl( PR_SET_TIMERSLACK, SHORT_SLEEP_TIMER_SLACK );
+#endif
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &end );
+    end.tv_sec += ticks / TICKSPERSEC;
+    end.tv_nsec += (ticks % TICKSPERSEC) * 100;
+    if (end.tv_nsec >= 1000000000)
+    {
+        end.tv_sec++;
+        end.tv_nsec -= 1000000000;
+    }
+    while (clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &end, NULL ) == EINTR);
+
+#ifdef PR_SET_TIMERSLACK
+    /* the slack applies to all timers of the thread, don't keep it lowered for other waits */
+    if (restore_slack) prctl( PR_SET_TIMERSLACK, thread_data->timer_slack );
+#endif
+}
+#endif
+
+
 /******************************************************************
  *		NtDelayExecution (NTDLL.@)
  */
 NTSTATUS WINAPI NtDelayExecution( BOOLEAN alertable, const LARGE_INTEGER *timeout )
 {
+    /* a zero timeout only yields, unless user APCs may have to run */
+    if (timeout && !timeout->QuadPart && (!alertable || no_user_apc_pending()))
+    {
+        NtYieldExecution();
+        return STATUS_SUCCESS;
+    }
+
     /* if alertable, we need to query the server */
     if (alertable)
     {
+        NTSTATUS ret = STATUS_NOT_IMPLEMENTED;
+
         if (do_fsync())
-        {
-            NTSTATUS ret = fsync_wait_objects( 0, NULL, TRUE, TRUE, timeout );
-            if (ret != STATUS_NOT_IMPLEMENTED)
-                return ret;
-        }
+            ret = fsync_wait_objects( 0, NULL, TRUE, TRUE, timeout );
 
-        if (do_esync())
-        {
-            NTSTATUS ret = esync_wait_objects( 0, NULL, TRUE, TRUE, timeout );
-            if (ret != STATUS_NOT_IMPLEMENTED)
-                return ret;
-        }
+        if (ret == STATUS_NOT_IMPLEMENTED && do_esync())
+            ret = esync_wait_objects( 0, NULL, TRUE, TRUE, timeout );
 
-        return server_wait( NULL, 0, SELECT_INTERRUPTIBLE | SELECT_ALERTABLE, timeout );
+        if (ret == STATUS_NOT_IMPLEMENTED)
+            ret = server_wait( NULL, 0, SELECT_INTERRUPTIBLE | SELECT_ALERTABLE, timeout );
+
+        /* an elapsed delay succeeds, like the non-alertable and zero timeout paths */
+        return ret == STATUS_TIMEOUT ? STATUS_SUCCESS : ret;
     }
 
     if (!timeout || timeout->QuadPart == TIMEOUT_INFINITE)  /* sleep forever */
@@ -1597,6 +1711,14 @@ NTSTATUS WINAPI NtDelayExecution( BOOLEAN alertable, const LARGE_INTEGER *timeou
         LARGE_INTEGER now;
         timeout_t when, diff;
 
+#ifdef __linux__
+        if (timeout->QuadPart < 0)
+        {
+            delay_relative( -timeout->QuadPart );
+            return STATUS_SUCCESS;
+        }
+#endif
+
         if ((when = timeout->QuadPart) < 0)
         {
             NtQuerySystemTime( &now );
@@ -1854,6 +1976,319 @@ NTSTATUS WINAPI NtReleaseKeyedEvent( HANDLE handle, const void *key,
 }
 
 
+#if defined(__linux__) || defined(__APPLE__)
+static LONGLONG get_absolute_timeout( const LARGE_INTEGER *timeout )
+{
+    LARGE_INTEGER now;
+
+    if (timeout->QuadPart >= 0) return timeout->QuadPart;
+    NtQuerySystemTime( &now );
+    return now.QuadPart - timeout->QuadPart;
+}
+
+static LONGLONG update_timeout( ULONGLONG end )
+{
+    LARGE_INTEGER now;
+    LONGLONG timeleft;
+
+    NtQuerySystemTime( &now );
+    timeleft = end - now.QuadPart;
+    if (timeleft < 0) timeleft = 0;
+    return timeleft;
+}
+#endif
+
+
+#ifdef __linux__
+
+/* I/O completion ports are backed by a ring in shared memory, see struct completion_shared_memory.
+ * The ring of each port handle is mapped on first use and cached until the handle is closed. */
+
+struct completion_view
+{
+    LONG                                       refcount;
+    unsigned int                               access;  /* access rights of the port handle */
+    volatile struct completion_shared_memory  *shared;
+};
+
+#define COMPLETION_LIST_BLOCK_SIZE  (65536 / sizeof(struct completion_view *))
+#define COMPLETION_LIST_ENTRIES     256
+
+static struct completion_view **completion_list[COMPLETION_LIST_ENTRIES];
+static pthread_rwlock_t completion_list_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static inline UINT_PTR completion_handle_to_index( HANDLE handle, UINT_PTR *entry )
+{
+    UINT_PTR idx = (((UINT_PTR)handle) >> 2) - 1;
+    *entry = idx / COMPLETION_LIST_BLOCK_SIZE;
+    return idx % COMPLETION_LIST_BLOCK_SIZE;
+}
+
+static void release_completion_view( struct completion_view *view )
+{
+    if (InterlockedDecrement( &view->refcount )) return;
+    munmap( (void *)view->shared, sizeof(*view->shared) );
+    free( view );
+}
+
+static struct completion_view *map_completion_view( HANDLE handle )
+{
+    struct completion_view *view;
+    unsigned int access = 0;
+    HANDLE mapping = 0;
+    int unix_fd, needs_close;
+    void *ptr = MAP_FAILED;
+
+    SERVER_START_REQ( get_completion_mapping )
+    {
+        req->handle = wine_server_obj_handle( handle );
+        if (!wine_server_call( req ))
+        {
+            mapping = wine_server_ptr_handle( reply->mapping );
+            access  = reply->access;
+        }
+    }
+    SERVER_END_REQ;
+    if (!mapping) return NULL;
+
+    if (!server_get_unix_fd( mapping, 0, &unix_fd, &needs_close, NULL, NULL ))
+    {
+        ptr = mmap( NULL, sizeof(*view->shared),
+                    PROT_READ | ((access & IO_COMPLETION_MODIFY_STATE) ? PROT_WRITE : 0),
+                    MAP_SHARED, unix_fd, 0 );
+        if (needs_close) close( unix_fd );
+    }
+    NtClose( mapping );
+    if (ptr == MAP_FAILED) return NULL;
+
+    if (!(view = malloc( sizeof(*view) )))
+    {
+        munmap( ptr, sizeof(*view->shared) );
+        return NULL;
+    }
+    view->refcount = 1;
+    view->access   = access;
+    view->shared   = ptr;
+    return view;
+}
+
+/* get a reference to the ring of a completion port handle */
+static struct completion_view *get_completion_view( HANDLE handle )
+{
+    UINT_PTR entry, idx = completion_handle_to_index( handle, &entry );
+    struct completion_view *view = NULL, *new_view;
+
+    if ((INT_PTR)handle < 0 || entry >= COMPLETION_LIST_ENTRIES) return NULL;
+
+    pthread_rwlock_rdlock( &completion_list_lock );
+    if (completion_list[entry] && (view = completion_list[entry][idx]))
+        InterlockedIncrement( &view->refcount );
+    pthread_rwlock_unlock( &completion_list_lock );
+    if (view) return view;
+
+    /* map it without holding the lock, it needs server calls and the fd cache */
+    if (!(new_view = map_completion_view( handle ))) return NULL;
+
+    pthread_rwlock_wrlock( &completion_list_lock );
+    if (!completion_list[entry])
+    {
+        void *ptr = anon_mmap_alloc( COMPLETION_LIST_BLOCK_SIZE * sizeof(struct completion_view *),
+                                     PROT_READ | PROT_WRITE );
+        if (ptr != MAP_FAILED) completion_list[entry] = ptr;
+    }
+    if (completion_list[entry])
+    {
+        if (!(view = completion_list[entry][idx]))
+        {
+            view = completion_list[entry][idx] = new_view;
+            new_view = NULL;
+        }
+        InterlockedIncrement( &view->refcount );
+    }
+    pthread_rwlock_unlock( &completion_list_lock );
+
+    if (!new_view) return view;
+    /* we lost a race with another thread, or there is no room in the cache */
+    if (view) release_completion_view( new_view );
+    else view = new_view;
+    return view;
+}
+
+/* drop the cached ring of a handle that is being closed */
+void completion_close( HANDLE handle )
+{
+    UINT_PTR entry, idx = completion_handle_to_index( handle, &entry );
+    struct completion_view *view = NULL;
+
+    if ((INT_PTR)handle < 0 || entry >= COMPLETION_LIST_ENTRIES || !completion_list[entry]) return;
+
+    pthread_rwlock_wrlock( &completion_list_lock );
+    view = completion_list[entry][idx];
+    completion_list[entry][idx] = NULL;
+    pthread_rwlock_unlock( &completion_list_lock );
+
+    if (view) release_completion_view( view );
+}
+
+static inline int futex_wait_shared( volatile int *addr, int val, struct timespec *timeout )
+{
+    /* not FUTEX_PRIVATE_FLAG, the ring is shared with other processes */
+    return syscall( __NR_futex, addr, FUTEX_WAIT, val, timeout, 0, 0 );
+}
+
+static inline int futex_wake_shared( volatile int *addr, int val )
+{
+    return syscall( __NR_futex, addr, FUTEX_WAKE, val, NULL, 0, 0 );
+}
+
+static BOOL push_completion_packet( volatile struct completion_shared_memory *shared, ULONG_PTR key,
+                                    ULONG_PTR value, NTSTATUS status, SIZE_T count )
+{
+    volatile struct completion_shared_entry *entry;
+    unsigned int pos, seq;
+
+    for (;;)
+    {
+        pos = __atomic_load_n( &shared->tail, __ATOMIC_RELAXED );
+        entry = &shared->entries[pos % COMPLETION_RING_SIZE];
+        seq = __atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE );
+        if ((int)(seq - pos) < 0) return FALSE;  /* full */
+        if (seq != pos) continue;
+        if (__atomic_compare_exchange_n( &shared->tail, &pos, pos + 1, 0,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED )) break;
+    }
+    entry->status      = status;
+    entry->ckey        = key;
+    entry->cvalue      = value;
+    entry->information = count;
+    __atomic_store_n( &entry->seq, pos + 1, __ATOMIC_RELEASE );
+    return TRUE;
+}
+
+static BOOL pop_completion_packet( volatile struct completion_shared_memory *shared,
+                                   FILE_IO_COMPLETION_INFORMATION *info )
+{
+    volatile struct completion_shared_entry *entry;
+    unsigned int pos, seq;
+
+    for (;;)
+    {
+        pos = __atomic_load_n( &shared->head, __ATOMIC_RELAXED );
+        entry = &shared->entries[pos % COMPLETION_RING_SIZE];
+        seq = __atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE );
+        if ((int)(seq - (pos + 1)) < 0) return FALSE;  /* empty */
+        if (seq != pos + 1) continue;
+        if (__atomic_compare_exchange_n( &shared->head, &pos, pos + 1, 0,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED )) break;
+    }
+    info->CompletionKey             = entry->ckey;
+    info->CompletionValue           = entry->cvalue;
+    info->IoStatusBlock.Information = entry->information;
+    info->IoStatusBlock.u.Status    = entry->status;
+    __atomic_store_n( &entry->seq, pos + COMPLETION_RING_SIZE, __ATOMIC_RELEASE );
+    return TRUE;
+}
+
+static BOOL completion_ring_empty( volatile struct completion_shared_memory *shared )
+{
+    unsigned int head = __atomic_load_n( &shared->head, __ATOMIC_SEQ_CST );
+    return __atomic_load_n( &shared->entries[head % COMPLETION_RING_SIZE].seq, __ATOMIC_SEQ_CST ) != head + 1;
+}
+
+/* add a packet without a server call, unless packets are already queued in the server */
+static BOOL set_completion_shared( HANDLE handle, struct completion_view *view, ULONG_PTR key,
+                                   ULONG_PTR value, NTSTATUS status, SIZE_T count )
+{
+    volatile struct completion_shared_memory *shared = view->shared;
+
+    if (!(view->access & IO_COMPLETION_MODIFY_STATE)) return FALSE;
+    if (__atomic_load_n( &shared->overflow, __ATOMIC_SEQ_CST )) return FALSE;
+    if (!push_completion_packet( shared, key, value, status, count )) return FALSE;
+
+    __atomic_add_fetch( &shared->futex, 1, __ATOMIC_SEQ_CST );
+    if (__atomic_load_n( &shared->waiters, __ATOMIC_SEQ_CST )) futex_wake_shared( &shared->futex, 1 );
+    if (__atomic_load_n( &shared->server_waiters, __ATOMIC_SEQ_CST ))
+    {
+        SERVER_START_REQ( wake_completion )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            wine_server_call( req );
+        }
+        SERVER_END_REQ;
+    }
+    return TRUE;
+}
+
+/* remove packets from the ring and wait on its futex; returns STATUS_PENDING if the server has to do it */
+static NTSTATUS remove_completion_shared( struct completion_view *view, FILE_IO_COMPLETION_INFORMATION *info,
+                                          ULONG count, ULONG *written, const LARGE_INTEGER *timeout )
+{
+    volatile struct completion_shared_memory *shared = view->shared;
+    ULONGLONG end = 0;
+    ULONG i = 0;
+    int value, ret;
+
+    if (!(view->access & IO_COMPLETION_MODIFY_STATE)) return STATUS_PENDING;
+    if (timeout) end = get_absolute_timeout( timeout );
+
+    for (;;)
+    {
+        if (__atomic_load_n( &shared->overflow, __ATOMIC_SEQ_CST )) return STATUS_PENDING;
+        while (i < count && pop_completion_packet( shared, &info[i] )) i++;
+        if (i)
+        {
+            *written = i;
+            return STATUS_SUCCESS;
+        }
+        if (__atomic_load_n( &shared->closed, __ATOMIC_SEQ_CST )) return STATUS_ABANDONED_WAIT_0;
+
+        __atomic_add_fetch( &shared->waiters, 1, __ATOMIC_SEQ_CST );
+        value = __atomic_load_n( &shared->futex, __ATOMIC_SEQ_CST );
+        ret = 0;
+        if (completion_ring_empty( shared ) && !__atomic_load_n( &shared->overflow, __ATOMIC_SEQ_CST ) &&
+            !__atomic_load_n( &shared->closed, __ATOMIC_SEQ_CST ))
+        {
+            if (timeout)
+            {
+                LONGLONG timeleft = update_timeout( end );
+                struct timespec tmo_p;
+
+                if (!timeleft) ret = -1;
+                else
+                {
+                    tmo_p.tv_sec = timeleft / (ULONGLONG)TICKSPERSEC;
+                    tmo_p.tv_nsec = (timeleft % TICKSPERSEC) * 100;
+                    futex_wait_shared( &shared->futex, value, &tmo_p );
+                }
+            }
+            else futex_wait_shared( &shared->futex, value, NULL );
+        }
+        __atomic_sub_fetch( &shared->waiters, 1, __ATOMIC_SEQ_CST );
+        if (ret) return STATUS_TIMEOUT;
+    }
+}
+
+static BOOL query_completion_shared( struct completion_view *view, ULONG *depth )
+{
+    volatile struct completion_shared_memory *shared = view->shared;
+    unsigned int head, tail;
+
+    if (!(view->access & IO_COMPLETION_QUERY_STATE)) return FALSE;
+    head = __atomic_load_n( &shared->head, __ATOMIC_SEQ_CST );
+    tail = __atomic_load_n( &shared->tail, __ATOMIC_SEQ_CST );
+    *depth = min( tail - head, COMPLETION_RING_SIZE ) + __atomic_load_n( &shared->overflow, __ATOMIC_SEQ_CST );
+    return TRUE;
+}
+
+#else
+
+void completion_close( HANDLE handle )
+{
+}
+
+#endif
+
+
 /***********************************************************************
  *             NtCreateIoCompletion (NTDLL.@)
  */
@@ -1915,9 +2350,21 @@ NTSTATUS WINAPI NtSetIoCompletion( HANDLE handle, ULONG_PTR key, ULONG_PTR value
                                    NTSTATUS status, SIZE_T count )
 {
     NTSTATUS ret;
+#ifdef __linux__
+    struct completion_view *view;
+#endif
 
     TRACE( "(%p, %lx, %lx, %x, %lx)\n", handle, key, value, status, count );
 
+#ifdef __linux__
+    if ((view = get_completion_view( handle )))
+    {
+        BOOL done = set_completion_shared( handle, view, key, value, status, count );
+        release_completion_view( view );
+        if (done) return STATUS_SUCCESS;
+    }
+#endif
+
     SERVER_START_REQ( add_completion )
     {
         req->handle      = wine_server_obj_handle( handle );
@@ -1940,9 +2387,30 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE handle, ULONG_PTR *key, ULONG_PTR *
 {
     NTSTATUS status;
     int waited = 0;
+#ifdef __linux__
+    struct completion_view *view;
+#endif
 
     TRACE( "(%p, %p, %p, %p, %p)\n", handle, key, value, io, timeout );
 
+#ifdef __linux__
+    if ((view = get_completion_view( handle )))
+    {
+        FILE_IO_COMPLETION_INFORMATION info;
+        ULONG written;
+
+        status = remove_completion_shared( view, &info, 1, &written, timeout );
+        release_completion_view( view );
+        if (status == STATUS_SUCCESS)
+        {
+            *key  = info.CompletionKey;
+            *value = info.CompletionValue;
+            *io   = info.IoStatusBlock;
+        }
+        if (status != STATUS_PENDING) return status;
+    }
+#endif
+
     for (;;)
     {
         SERVER_START_REQ( remove_completion )
@@ -1975,9 +2443,26 @@ NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE handle, FILE_IO_COMPLETION_INFORM
     NTSTATUS status;
     int waited = 0;
     ULONG i = 0;
+#ifdef __linux__
+    struct completion_view *view;
+#endif
 
     TRACE( "%p %p %u %p %p %u\n", handle, info, count, written, timeout, alertable );
 
+#ifdef __linux__
+    /* alertable waits need the server to deliver the APCs */
+    if (!alertable && count && (view = get_completion_view( handle )))
+    {
+        status = remove_completion_shared( view, info, count, written, timeout );
+        release_completion_view( view );
+        if (status != STATUS_PENDING)
+        {
+            if (status) *written = 1;
+            return status;
+        }
+    }
+#endif
+
     for (;;)
     {
         while (i < count)
@@ -2019,6 +2504,9 @@ NTSTATUS WINAPI NtQueryIoCompletion( HANDLE handle, IO_COMPLETION_INFORMATION_CL
                                      void *buffer, ULONG len, ULONG *ret_len )
 {
     NTSTATUS status;
+#ifdef __linux__
+    struct completion_view *view;
+#endif
 
     TRACE( "(%p, %d, %p, 0x%x, %p)\n", handle, class, buffer, len, ret_len );
 
@@ -2030,16 +2518,21 @@ NTSTATUS WINAPI NtQueryIoCompletion( HANDLE handle, IO_COMPLETION_INFORMATION_CL
     {
         ULONG *info = buffer;
         if (ret_len) *ret_len = sizeof(*info);
-        if (len == sizeof(*info))
+        if (len != sizeof(*info)) return STATUS_INFO_LENGTH_MISMATCH;
+#ifdef __linux__
+        if ((view = get_completion_view( handle )))
         {
-            SERVER_START_REQ( query_completion )
-            {
-                req->handle = wine_server_obj_handle( handle );
-                if (!(status = wine_server_call( req ))) *info = reply->depth;
-            }
-            SERVER_END_REQ;
+            BOOL done = query_completion_shared( view, info );
+            release_completion_view( view );
+            if (done) return STATUS_SUCCESS;
         }
-        else status = STATUS_INFO_LENGTH_MISMATCH;
+#endif
+        SERVER_START_REQ( query_completion )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            if (!(status = wine_server_call( req ))) *info = reply->depth;
+        }
+        SERVER_END_REQ;
         break;
     }
     default:
@@ -2517,29 +3010,6 @@ NTSTATUS WINAPI NtAlertThreadByThreadId( HANDLE tid )
 }
 
 
-#if defined(__linux__) || defined(__APPLE__)
-static LONGLONG get_absolute_timeout( const LARGE_INTEGER *timeout )
-{
-    LARGE_INTEGER now;
-
-    if (timeout->QuadPart >= 0) return timeout->QuadPart;
-    NtQuerySystemTime( &now );
-    return now.QuadPart - timeout->QuadPart;
-}
-
-static LONGLONG update_timeout( ULONGLONG end )
-{
-    LARGE_INTEGER now;
-    LONGLONG timeleft;
-
-    NtQuerySystemTime( &now );
-    timeleft = end - now.QuadPart;
-    if (timeleft < 0) timeleft = 0;
-    return timeleft;
-}
-#endif
-
-
 #ifdef __APPLE__
 
 /***********************************************************************
@@ -2644,3 +3114,115 @@ NTSTATUS WINAPI NtWaitForAlertByThreadId( const void *address, const LARGE_INTEG
 }
 
 #endif
+
+
+/***********************************************************************
+ *             __wine_wait_on_address (NTDLL.@)
+ *
+ * Waits on a private futex as long as the 32-bit value at addr equals val.
+ * Only wakes with a bit in common with mask end the wait. Returns
+ * STATUS_NOT_IMPLEMENTED when futexes are not available.
+ */
+NTSTATUS WINAPI __wine_wait_on_address( const LONG *addr, LONG val, ULONG mask, const LARGE_INTEGER *timeout )
+{
+#ifdef __linux__
+    struct timespec timespec;
+    LONGLONG timeleft;
+    ULONG64 start = 0;
+    NTSTATUS status;
+    int ret;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    if (wait_profiling( timeout )) start = wait_profile_time();
+
+    if (timeout && timeout->QuadPart != TIMEOUT_INFINITE)
+    {
+        /* FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout */
+        timeleft = update_timeout( get_absolute_timeout( timeout ) );
+        clock_gettime( CLOCK_MONOTONIC, &timespec );
+        timespec.tv_sec += timeleft / (ULONGLONG)TICKSPERSEC;
+        timespec.tv_nsec += (timeleft % TICKSPERSEC) * 100;
+        if (timespec.tv_nsec >= 1000000000)
+        {
+            timespec.tv_sec++;
+            timespec.tv_nsec -= 1000000000;
+        }
+        ret = futex_wait_bitset( (const int *)addr, val, &timespec, mask );
+    }
+    else
+        ret = futex_wait_bitset( (const int *)addr, val, NULL, mask );
+
+    status = (ret == -1 && errno == ETIMEDOUT) ? STATUS_TIMEOUT : STATUS_SUCCESS;
+    /* EAGAIN means the value had already changed and we didn't block */
+    if (start && (ret != -1 || errno != EAGAIN))
+        wait_profile_record( status ? WAIT_PROFILE_TIMEOUT : WAIT_PROFILE_ADDRESS, status ? NULL : addr, start );
+    return status;
+#else
+    return STATUS_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/***********************************************************************
+ *             __wine_wake_address (NTDLL.@)
+ *
+ * Wakes up to count threads waiting in __wine_wait_on_address with a mask
+ * that has a bit in common with mask.
+ */
+NTSTATUS WINAPI __wine_wake_address( const LONG *addr, int count, ULONG mask )
+{
+#ifdef __linux__
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    futex_wake_bitset( (const int *)addr, count, mask );
+    return STATUS_SUCCESS;
+#else
+    return STATUS_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/***********************************************************************
+ *             __wine_wait_any_supported (NTDLL.@)
+ *
+ * Checks whether handle can be passed to __wine_wait_any_objects, and returns
+ * the maximum number of handles it accepts. A NULL handle only queries the
+ * maximum. Returns STATUS_NOT_IMPLEMENTED when the handle needs the server.
+ */
+NTSTATUS WINAPI __wine_wait_any_supported( HANDLE handle, ULONG *max_count )
+{
+    NTSTATUS ret = STATUS_NOT_IMPLEMENTED;
+
+    if (do_fsync())
+    {
+        if (max_count) *max_count = FSYNC_MAX_WAIT_OBJECTS;
+        ret = handle ? fsync_check_object( handle ) : STATUS_SUCCESS;
+    }
+    else if (do_esync())
+    {
+        if (max_count) *max_count = ESYNC_MAX_WAIT_OBJECTS;
+        ret = handle ? esync_check_object( handle ) : STATUS_SUCCESS;
+    }
+    return ret;
+}
+
+
+/***********************************************************************
+ *             __wine_wait_any_objects (NTDLL.@)
+ *
+ * Like NtWaitForMultipleObjects with wait_any set, but accepts more than
+ * MAXIMUM_WAIT_OBJECTS handles. A signaled or abandoned object returns
+ * STATUS_WAIT_0 or STATUS_ABANDONED_WAIT_0 and stores its index in index.
+ * Returns STATUS_NOT_IMPLEMENTED when any of the handles would need a server
+ * wait.
+ */
+NTSTATUS WINAPI __wine_wait_any_objects( DWORD count, const HANDLE *handles, BOOLEAN alertable,
+                                         const LARGE_INTEGER *timeout, DWORD *index )
+{
+    if (!count) return STATUS_INVALID_PARAMETER_1;
+
+    if (do_fsync()) return fsync_wait_any_objects( count, handles, alertable, timeout, index );
+    if (do_esync()) return esync_wait_any_objects( count, handles, alertable, timeout, index );
+    return STATUS_NOT_IMPLEMENTED;
+}
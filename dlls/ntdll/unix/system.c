@@ -980,6 +980,20 @@ static BOOL sysfs_count_list_elements(const char *filename, DWORD *result)
     return TRUE;
 }
 
+/* convert a host CPU mask to the logical CPU numbering exposed to the application */
+static ULONG_PTR map_host_cpu_mask( ULONG_PTR host_mask )
+{
+    ULONG_PTR mask = 0;
+    unsigned int id;
+
+    if (!cpu_override.mapping.cpu_count) return host_mask;
+
+    for (id = 0; id < cpu_override.mapping.cpu_count; ++id)
+        if (host_mask & ((ULONG_PTR)1 << cpu_override.mapping.host_cpu_id[id]))
+            mask |= (ULONG_PTR)1 << id;
+    return mask;
+}
+
 /* for 'data', max_len is the array count. for 'dataex', max_len is in bytes */
 static NTSTATUS create_logical_proc_info( SYSTEM_LOGICAL_PROCESSOR_INFORMATION **data,
                                           SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX **dataex,
@@ -1029,7 +1043,7 @@ static NTSTATUS create_logical_proc_info( SYSTEM_LOGICAL_PROCESSOR_INFORMATION *
             DWORD phys_core = 0;
             ULONG_PTR thread_mask = 0;
 
-            if (i > 8*sizeof(ULONG_PTR))
+            if (i >= 8*sizeof(ULONG_PTR))
             {
                 FIXME("skipping logical processor %d\n", i);
                 continue;
@@ -1167,14 +1181,7 @@ static NTSTATUS create_logical_proc_info( SYSTEM_LOGICAL_PROCESSOR_INFORMATION *
 
                     if (cpu_override.mapping.cpu_count)
                     {
-                        ULONG_PTR host_mask = mask;
-                        unsigned int id;
-
-                        mask = 0;
-                        for (id = 0; id < cpu_override.mapping.cpu_count; ++id)
-                            if (host_mask & ((ULONG_PTR)1 << cpu_override.mapping.host_cpu_id[id]))
-                                mask |= (ULONG_PTR)1 << id;
-
+                        mask = map_host_cpu_mask( mask );
                         assert(mask);
                     }
 
@@ -1218,6 +1225,9 @@ static NTSTATUS create_logical_proc_info( SYSTEM_LOGICAL_PROCESSOR_INFORMATION *
                     sprintf(name, numa_info, i);
                     if (!sysfs_parse_bitmap( name, &mask )) continue;
 
+                    /* node numbers stay the host ones so that they can be passed to mbind() */
+                    mask = map_host_cpu_mask( mask ) & all_cpus_mask;
+
                     if (!logical_proc_info_add_numa_node(data, dataex, &len, max_len, mask, i))
                     {
                         fclose(fnuma_list);
@@ -2010,6 +2020,185 @@ static NTSTATUS get_firmware_info( SYSTEM_FIRMWARE_TABLE_INFORMATION *sfti, ULON
 
 #endif
 
+#ifdef linux
+
+/* /proc/stat is updated on every clock tick, don't parse it more often than that */
+#define PROC_STAT_REFRESH (TICKSPERSEC / 100)
+
+static pthread_mutex_t proc_stat_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* read a /proc file with a single pread on a descriptor that is kept open */
+static int pread_proc_file( int *fd, const char *path, char *buffer, size_t size )
+{
+    ssize_t ret;
+
+    if (*fd == -1 && (*fd = open( path, O_RDONLY | O_CLOEXEC )) == -1) return -1;
+    while ((ret = pread( *fd, buffer, size - 1, 0 )) == -1 && errno == EINTR);
+    if (ret < 0) return -1;
+    buffer[ret] = 0;
+    return ret;
+}
+
+static const char *next_line( const char *p )
+{
+    if ((p = strchr( p, '\n' ))) p++;
+    return p;
+}
+
+static const char *parse_proc_ulonglong( const char *p, ULONGLONG *value )
+{
+    ULONGLONG val = 0;
+
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p < '0' || *p > '9') return NULL;
+    while (*p >= '0' && *p <= '9') val = val * 10 + *p++ - '0';
+    *value = val;
+    return p;
+}
+
+/* parse the per-cpu lines of /proc/stat, returns the number of cpus or -1 if the buffer is too small */
+static int parse_proc_stat( const char *buffer, SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION **sppi,
+                            unsigned int *size )
+{
+    unsigned long clk_tck = sysconf(_SC_CLK_TCK);
+    const char *p = buffer, *end;
+    unsigned int cpus = 0, id, i;
+    ULONGLONG val[10];
+
+    /* skip the first line, it's the combined usage */
+    if (!(p = next_line( p ))) return -1;
+
+    while (!strncmp( p, "cpu", 3 ) && p[3] >= '0' && p[3] <= '9')
+    {
+        if (!(end = strchr( p, '\n' ))) return -1;  /* truncated line */
+        for (id = 0, p += 3; *p >= '0' && *p <= '9'; p++) id = id * 10 + *p - '0';
+        for (i = 0; i < ARRAY_SIZE(val); i++) if (!(p = parse_proc_ulonglong( p, &val[i] ))) break;
+        p = end + 1;
+        if (i < 4) continue;
+
+        if (id >= *size)
+        {
+            SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION *new;
+            unsigned int new_size = max( id + 1, *size * 2 );
+
+            if (!(new = realloc( *sppi, new_size * sizeof(*new) ))) break;
+            memset( new + *size, 0, (new_size - *size) * sizeof(*new) );
+            *sppi = new;
+            *size = new_size;
+        }
+        /* user, nice, system, idle, then iowait, irq, softirq... accounted as kernel time */
+        val[0] += val[1];
+        val[2] += val[3];
+        while (i-- > 4) val[2] += val[i];
+        (*sppi)[id].IdleTime.QuadPart   = val[3] * 10000000 / clk_tck;
+        (*sppi)[id].KernelTime.QuadPart = val[2] * 10000000 / clk_tck;
+        (*sppi)[id].UserTime.QuadPart   = val[0] * 10000000 / clk_tck;
+        if (id >= cpus) cpus = id + 1;
+    }
+    if (strlen( p ) < 4) return -1;  /* truncated before the next line could be identified */
+    return cpus;
+}
+
+/* get the per-cpu times, from a snapshot of /proc/stat refreshed at most every clock tick */
+static unsigned int get_proc_stat_cpu_times( SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION *sppi, unsigned int out_cpus )
+{
+    static SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION *cached;
+    static unsigned int cached_size, cached_cpus;
+    static ULONGLONG last_update;
+    static size_t buffer_size;
+    static char *buffer;
+    static int fd = -1;
+    LARGE_INTEGER now;
+    unsigned int cpus;
+    int ret;
+
+    NtQueryPerformanceCounter( &now, NULL );
+    mutex_lock( &proc_stat_mutex );
+    if (!cached_cpus || now.QuadPart - last_update >= PROC_STAT_REFRESH)
+    {
+        if (!buffer_size) buffer_size = 256 * (peb->NumberOfProcessors + 2);
+        for (;;)
+        {
+            if (!buffer && !(buffer = malloc( buffer_size ))) break;
+            if (pread_proc_file( &fd, "/proc/stat", buffer, buffer_size ) < 0) break;
+            if ((ret = parse_proc_stat( buffer, &cached, &cached_size )) >= 0)
+            {
+                cached_cpus = ret;
+                last_update = now.QuadPart;
+                break;
+            }
+            free( buffer );
+            buffer = NULL;
+            if ((buffer_size *= 2) > 1024 * 1024) break;
+        }
+    }
+    cpus = min( cached_cpus, out_cpus );
+    if (cpus) memcpy( sppi, cached, cpus * sizeof(*sppi) );
+    mutex_unlock( &proc_stat_mutex );
+    return cpus;
+}
+
+/* get the idle time and memory counters, refreshed at most every clock tick */
+static void get_proc_performance_info( ULONGLONG *idle_time, unsigned long long *totalram,
+                                       unsigned long long *freeram, unsigned long long *totalswap,
+                                       unsigned long long *freeswap )
+{
+    static unsigned long long cached_totalram, cached_freeram, cached_totalswap, cached_freeswap;
+    static ULONGLONG cached_idle, last_update;
+    static int uptime_fd = -1, meminfo_fd = -1;
+    LARGE_INTEGER now;
+    char buffer[4096];
+    const char *p;
+
+    NtQueryPerformanceCounter( &now, NULL );
+    mutex_lock( &proc_stat_mutex );
+    if (!last_update || now.QuadPart - last_update >= PROC_STAT_REFRESH)
+    {
+        if (pread_proc_file( &uptime_fd, "/proc/uptime", buffer, sizeof(buffer) ) > 0)
+        {
+            double uptime, idle;
+
+            if (sscanf( buffer, "%lf %lf", &uptime, &idle ) == 2) cached_idle = 10000000 * idle;
+        }
+
+        cached_totalram = cached_freeram = cached_totalswap = cached_freeswap = 0;
+        if (pread_proc_file( &meminfo_fd, "/proc/meminfo", buffer, sizeof(buffer) ) > 0)
+        {
+            static const struct { const char *name; unsigned long long *value; } fields[] =
+            {
+                { "MemTotal:", &cached_totalram },
+                { "MemFree:", &cached_freeram },
+                { "SwapTotal:", &cached_totalswap },
+                { "SwapFree:", &cached_freeswap },
+                { "Buffers:", &cached_freeram },
+                { "Cached:", &cached_freeram },
+            };
+            ULONGLONG value;
+            unsigned int i;
+
+            for (p = buffer; p; p = next_line( p ))
+            {
+                for (i = 0; i < ARRAY_SIZE(fields); i++)
+                {
+                    size_t len = strlen( fields[i].name );
+                    if (strncmp( p, fields[i].name, len )) continue;
+                    if (parse_proc_ulonglong( p + len, &value )) *fields[i].value += value * 1024;
+                    break;
+                }
+            }
+        }
+        last_update = now.QuadPart;
+    }
+    *idle_time = cached_idle;
+    *totalram = cached_totalram;
+    *freeram = cached_freeram;
+    *totalswap = cached_totalswap;
+    *freeswap = cached_freeswap;
+    mutex_unlock( &proc_stat_mutex );
+}
+
+#endif
+
 static void get_performance_info( SYSTEM_PERFORMANCE_INFORMATION *info )
 {
     unsigned long long totalram = 0, freeram = 0, totalswap = 0, freeswap = 0;
@@ -2018,16 +2207,10 @@ static void get_performance_info( SYSTEM_PERFORMANCE_INFORMATION *info )
 
 #if defined(linux)
     {
-        FILE *fp;
-
-        if ((fp = fopen("/proc/uptime", "r")))
-        {
-            double uptime, idle_time;
+        ULONGLONG idle_time;
 
-            fscanf(fp, "%lf %lf", &uptime, &idle_time);
-            fclose(fp);
-            info->IdleTime.QuadPart = 10000000 * idle_time;
-        }
+        get_proc_performance_info( &idle_time, &totalram, &freeram, &totalswap, &freeswap );
+        info->IdleTime.QuadPart = idle_time;
     }
 #elif defined(__FreeBSD__) || defined(__FreeBSD_kernel__)
     {
@@ -2053,32 +2236,7 @@ static void get_performance_info( SYSTEM_PERFORMANCE_INFORMATION *info )
 #endif
 
 #ifdef linux
-    {
-        FILE *fp;
-
-        if ((fp = fopen("/proc/meminfo", "r")))
-        {
-            unsigned long long value;
-            char line[64];
-
-            while (fgets(line, sizeof(line), fp))
-            {
-                if(sscanf(line, "MemTotal: %llu kB", &value) == 1)
-                    totalram += value * 1024;
-                else if(sscanf(line, "MemFree: %llu kB", &value) == 1)
-                    freeram += value * 1024;
-                else if(sscanf(line, "SwapTotal: %llu kB", &value) == 1)
-                    totalswap += value * 1024;
-                else if(sscanf(line, "SwapFree: %llu kB", &value) == 1)
-                    freeswap += value * 1024;
-                else if (sscanf(line, "Buffers: %llu", &value))
-                    freeram += value * 1024;
-                else if (sscanf(line, "Cached: %llu", &value))
-                    freeram += value * 1024;
-            }
-            fclose(fp);
-        }
-    }
+    /* memory counters are read along with the idle time above */
 #elif defined(__FreeBSD__) || defined(__FreeBSD_kernel__) || defined(__NetBSD__) || \
     defined(__OpenBSD__) || defined(__DragonFly__) || defined(__APPLE__)
     {
@@ -2551,6 +2709,80 @@ static void read_dev_urandom( void *buf, ULONG len )
     else WARN( "can't open /dev/urandom\n" );
 }
 
+/* snapshots older than this are refreshed through the server, mostly for the handle counts */
+#define PROCESS_LIST_MAX_AGE (TICKSPERSEC / 4)
+
+static volatile struct process_list_shared_memory *get_process_list_shared(void)
+{
+    static volatile struct process_list_shared_memory *process_list_shared;
+    static BOOL failed;
+    static const WCHAR nameW[] = {'\\','K','e','r','n','e','l','O','b','j','e','c','t','s','\\',
+                                  '_','_','w','i','n','e','_','p','r','o','c','e','s','s','_','l','i','s','t'};
+    UNICODE_STRING name = { sizeof(nameW), sizeof(nameW), (WCHAR *)nameW };
+    OBJECT_ATTRIBUTES attr;
+    SIZE_T view_size = 0;
+    void *ptr = NULL;
+    HANDLE handle;
+
+    if (process_list_shared || failed) return process_list_shared;
+
+    InitializeObjectAttributes( &attr, &name, 0, NULL, NULL );
+    if (NtOpenSection( &handle, SECTION_MAP_READ, &attr ))
+    {
+        failed = TRUE;
+        return NULL;
+    }
+    if (NtMapViewOfSection( handle, NtCurrentProcess(), &ptr, 0, 0, NULL, &view_size,
+                            ViewShare, 0, PAGE_READONLY ))
+    {
+        failed = TRUE;
+        ptr = NULL;
+    }
+    NtClose( handle );
+    if (!ptr) return NULL;
+
+    if (InterlockedCompareExchangePointer( (void **)&process_list_shared, ptr, NULL ))
+        NtUnmapViewOfSection( NtCurrentProcess(), ptr );
+    return process_list_shared;
+}
+
+/* copy the process list from the server shared memory, returns FALSE if the server needs to be asked */
+static BOOL read_process_list_shared( char *buffer, ULONG size, unsigned int *process_count,
+                                      unsigned int *total_thread_count, unsigned int *total_name_len,
+                                      NTSTATUS *status )
+{
+    volatile struct process_list_shared_memory *shared = get_process_list_shared();
+    unsigned int seq, info_size, retry;
+    LARGE_INTEGER now;
+
+    if (!shared) return FALSE;
+
+    NtQuerySystemTime( &now );
+    for (retry = 0; retry < 8; retry++)
+    {
+        if ((seq = __atomic_load_n( &shared->seq, __ATOMIC_ACQUIRE )) & SEQUENCE_MASK)
+        {
+            NtYieldExecution();
+            continue;
+        }
+        if (shared->stale || now.QuadPart - shared->update_time > PROCESS_LIST_MAX_AGE) return FALSE;
+
+        info_size = shared->info_size;
+        *process_count = shared->process_count;
+        *total_thread_count = shared->total_thread_count;
+        *total_name_len = shared->total_name_len;
+        if (info_size <= size && info_size <= PROCESS_LIST_SHARED_SIZE - sizeof(*shared))
+            memcpy( buffer, (const char *)(shared + 1), info_size );
+
+        __atomic_thread_fence( __ATOMIC_ACQUIRE );
+        if (__atomic_load_n( &shared->seq, __ATOMIC_RELAXED ) != seq) continue;
+
+        *status = info_size <= size ? STATUS_SUCCESS : STATUS_INFO_LENGTH_MISMATCH;
+        return TRUE;
+    }
+    return FALSE;
+}
+
 static NTSTATUS get_system_process_info( SYSTEM_INFORMATION_CLASS class, void *info, ULONG size, ULONG *len )
 {
     unsigned int process_count, total_thread_count, total_name_len, i, j;
@@ -2570,15 +2802,18 @@ C_ASSERT( sizeof(struct process_info) <= sizeof(SYSTEM_PROCESS_INFORMATION) );
     *len = 0;
     if (size && !(buffer = malloc( size ))) return STATUS_NO_MEMORY;
 
-    SERVER_START_REQ( list_processes )
+    if (!read_process_list_shared( buffer, size, &process_count, &total_thread_count, &total_name_len, &ret ))
     {
-        wine_server_set_reply( req, buffer, size );
-        ret = wine_server_call( req );
-        total_thread_count = reply->total_thread_count;
-        total_name_len = reply->total_name_len;
-        process_count = reply->process_count;
+        SERVER_START_REQ( list_processes )
+        {
+            wine_server_set_reply( req, buffer, size );
+            ret = wine_server_call( req );
+            total_thread_count = reply->total_thread_count;
+            total_name_len = reply->total_name_len;
+            process_count = reply->process_count;
+        }
+        SERVER_END_REQ;
     }
-    SERVER_END_REQ;
 
     if (ret)
     {
@@ -2804,38 +3039,7 @@ NTSTATUS WINAPI NtQuerySystemInformation( SYSTEM_INFORMATION_CLASS class,
             }
         }
 #elif defined(linux)
-        {
-            FILE *cpuinfo = fopen("/proc/stat", "r");
-            if (cpuinfo)
-            {
-                unsigned long clk_tck = sysconf(_SC_CLK_TCK);
-                unsigned long usr,nice,sys,idle,remainder[8];
-                int i, count, id;
-                char name[32];
-                char line[255];
-
-                /* first line is combined usage */
-                while (fgets(line,255,cpuinfo))
-                {
-                    count = sscanf(line, "%s %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu",
-                                   name, &usr, &nice, &sys, &idle,
-                                   &remainder[0], &remainder[1], &remainder[2], &remainder[3],
-                                   &remainder[4], &remainder[5], &remainder[6], &remainder[7]);
-
-                    if (count < 5 || strncmp( name, "cpu", 3 )) break;
-                    for (i = 0; i + 5 < count; ++i) sys += remainder[i];
-                    sys += idle;
-                    usr += nice;
-                    id = atoi( name + 3 ) + 1;
-                    if (id > out_cpus) break;
-                    if (id > cpus) cpus = id;
-                    sppi[id-1].IdleTime.QuadPart   = (ULONGLONG)idle * 10000000 / clk_tck;
-                    sppi[id-1].KernelTime.QuadPart = (ULONGLONG)sys * 10000000 / clk_tck;
-                    sppi[id-1].UserTime.QuadPart   = (ULONGLONG)usr * 10000000 / clk_tck;
-                }
-                fclose(cpuinfo);
-            }
-        }
+        cpus = get_proc_stat_cpu_times( sppi, out_cpus );
 #elif defined(__FreeBSD__) || defined (__FreeBSD_kernel__)
         {
             static int clockrate_name[] = { CTL_KERN, KERN_CLOCKRATE };
@@ -3535,31 +3739,42 @@ NTSTATUS WINAPI NtShutdownSystem( SHUTDOWN_ACTION action )
 
 /* Fallback using /proc/cpuinfo for Linux systems without cpufreq. For
  * most distributions on recent enough hardware, this is only likely to
- * happen while running in virtualized environments such as QEMU. */
+ * happen while running in virtualized environments such as QEMU.
+ * The file is large and slow to generate, so the value is cached for a second. */
 static ULONG mhz_from_cpuinfo(void)
 {
-    char line[512];
-    char *s, *value;
-    double cmz = 0;
-    FILE *f = fopen("/proc/cpuinfo", "r");
-    if(f)
+    static pthread_mutex_t cpuinfo_mutex = PTHREAD_MUTEX_INITIALIZER;
+    static ULONGLONG last_update;
+    static ULONG cached_mhz;
+    static int fd = -1;
+    LARGE_INTEGER now;
+    char buffer[4096];
+    const char *p;
+    double cmz;
+    ULONG ret;
+
+    NtQueryPerformanceCounter( &now, NULL );
+    mutex_lock( &cpuinfo_mutex );
+    if (!last_update || now.QuadPart - last_update >= TICKSPERSEC)
     {
-        while (fgets(line, sizeof(line), f) != NULL)
+        /* the first processor entry is enough */
+        cached_mhz = 0;
+        if (pread_proc_file( &fd, "/proc/cpuinfo", buffer, sizeof(buffer) ) > 0)
         {
-            if (!(value = strchr(line,':'))) continue;
-            s = value - 1;
-            while ((s >= line) && (*s == ' ' || *s == '\t')) s--;
-            s[1] = 0;
-            value++;
-            if (!strcmp( line, "cpu MHz" ))
+            for (p = buffer; p; p = next_line( p ))
             {
-                sscanf(value, " %lf", &cmz);
+                if (strncmp( p, "cpu MHz", 7 )) continue;
+                p += 7;
+                while (*p == ' ' || *p == '\t') p++;
+                if (*p == ':' && sscanf( p + 1, " %lf", &cmz ) == 1) cached_mhz = cmz;
                 break;
             }
         }
-        fclose( f );
+        last_update = now.QuadPart;
     }
-    return cmz;
+    ret = cached_mhz;
+    mutex_unlock( &cpuinfo_mutex );
+    return ret;
 }
 
 static const char * get_sys_str(const char *path, char *s)
@@ -60,6 +60,9 @@
 #ifdef HAVE_PRCTL
 #include <sys/prctl.h>
 #endif
+#ifdef HAVE_SCHED_H
+#include <sched.h>
+#endif
 
 #define NONAMELESSUNION
 #define NONAMELESSSTRUCT
@@ -1399,6 +1402,10 @@ static DECLSPEC_NORETURN void exit_thread( int status )
     static void *prev_teb;
     TEB *teb;
 
+    TRACE( "%04x: %u yields, %u short sleeps\n", GetCurrentThreadId(),
+           ntdll_get_thread_data()->yield_count, ntdll_get_thread_data()->short_sleep_count );
+    wait_profile_thread_exit();
+
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
 
     if ((teb = InterlockedExchangePointer( &prev_teb, NtCurrentTeb() )))
@@ -1420,6 +1427,7 @@ static DECLSPEC_NORETURN void exit_thread( int status )
  */
 void exit_process( int status )
 {
+    wait_profile_exit();
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
     signal_exit_thread( get_unix_exit_code( status ), process_exit_wrapper, NtCurrentTeb() );
 }
@@ -2131,6 +2139,28 @@ NTSTATUS WINAPI NtQueryInformationThread( HANDLE handle, THREADINFOCLASS class,
 }
 
 
+/* Linux has no soft processor preference for threads, so the current thread
+ * is moved to its ideal processor once and the scheduler may move it from there. */
+static void move_to_ideal_processor( ULONG number )
+{
+#if defined(HAVE_SCHED_SETAFFINITY) && defined(CPU_SET)
+    struct cpu_topology_override *override = get_cpu_topology_override();
+    cpu_set_t prev_set, set;
+
+    if (override)
+    {
+        if (number >= override->cpu_count) return;
+        number = override->host_cpu_id[number];
+    }
+    if (sched_getaffinity( 0, sizeof(prev_set), &prev_set ) || !CPU_ISSET( number, &prev_set )) return;
+
+    CPU_ZERO( &set );
+    CPU_SET( number, &set );
+    if (!sched_setaffinity( 0, sizeof(set), &set )) sched_setaffinity( 0, sizeof(prev_set), &prev_set );
+#endif
+}
+
+
 /******************************************************************************
  *              NtSetInformationThread  (NTDLL.@)
  */
@@ -2331,6 +2361,26 @@ NTSTATUS WINAPI NtSetInformationThread( HANDLE handle, THREADINFOCLASS class,
         FIXME( "ThreadEnableAlignmentFaultFixup stub!\n" );
         return STATUS_SUCCESS;
 
+    case ThreadIdealProcessor:
+    {
+        const ULONG *number = data;
+        ULONG prev = 0;
+
+        if (length != sizeof(ULONG)) return STATUS_INVALID_PARAMETER;
+        if (*number > MAXIMUM_PROCESSORS) return STATUS_INVALID_PARAMETER;
+        if (handle == GetCurrentThread())
+        {
+            /* the previous ideal processor is returned instead of a status,
+             * MAXIMUM_PROCESSORS only queries it */
+            prev = ntdll_get_thread_data()->ideal_processor;
+            if (*number == MAXIMUM_PROCESSORS) return prev;
+            ntdll_get_thread_data()->ideal_processor = *number;
+            move_to_ideal_processor( *number );
+        }
+        else FIXME( "ideal processor %u of other threads not supported\n", *number );
+        return prev;
+    }
+
     case ThreadBasicInformation:
     case ThreadTimes:
     case ThreadPriority:
@@ -2338,7 +2388,6 @@ NTSTATUS WINAPI NtSetInformationThread( HANDLE handle, THREADINFOCLASS class,
     case ThreadEventPair_Reusable:
     case ThreadPerformanceCount:
     case ThreadAmILastThread:
-    case ThreadIdealProcessor:
     case ThreadPriorityBoost:
     case ThreadSetTlsArrayAddress:
     case ThreadIsIoPending:
@@ -64,6 +64,11 @@ struct ntdll_thread_data
     void              *param;         /* thread entry point parameter */
     void              *jmp_buf;       /* setjmp buffer for exception handling */
     void              *heap;          /* thread local heap data */
+    unsigned int       yield_count;   /* number of NtYieldExecution calls */
+    unsigned int       short_sleep_count; /* number of short NtDelayExecution calls */
+    int                timer_slack;   /* default timer slack in ns, 0 if not queried yet */
+    struct wait_ring  *wait_ring;     /* samples of the wait profiler */
+    ULONG              ideal_processor; /* set with ThreadIdealProcessor */
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
@@ -155,6 +160,7 @@ extern void *create_startup_info( const UNICODE_STRING *nt_image, const RTL_USER
                                   DWORD *info_size ) DECLSPEC_HIDDEN;
 extern char **build_envp( const WCHAR *envW ) DECLSPEC_HIDDEN;
 extern NTSTATUS exec_wineloader( char **argv, int socketfd, const pe_image_info_t *pe_info ) DECLSPEC_HIDDEN;
+extern void init_fork_server(void) DECLSPEC_HIDDEN;
 extern NTSTATUS load_builtin( const pe_image_info_t *image_info, WCHAR *filename,
                               void **addr_ptr, SIZE_T *size_ptr ) DECLSPEC_HIDDEN;
 extern BOOL is_builtin_path( const UNICODE_STRING *path, WORD *machine ) DECLSPEC_HIDDEN;
@@ -195,6 +201,7 @@ extern NTSTATUS set_thread_context( HANDLE handle, const void *context, BOOL *se
 extern NTSTATUS get_thread_context( HANDLE handle, void *context, BOOL *self, USHORT machine ) DECLSPEC_HIDDEN;
 extern NTSTATUS alloc_object_attributes( const OBJECT_ATTRIBUTES *attr, struct object_attributes **ret,
                                          data_size_t *ret_len ) DECLSPEC_HIDDEN;
+extern void completion_close( HANDLE handle ) DECLSPEC_HIDDEN;
 
 extern void *anon_mmap_fixed( void *start, size_t size, int prot, int flags ) DECLSPEC_HIDDEN;
 extern void *anon_mmap_alloc( size_t size, int prot ) DECLSPEC_HIDDEN;
@@ -249,6 +256,12 @@ extern SYSTEM_SERVICE_TABLE KeServiceDescriptorTable[4] DECLSPEC_HIDDEN;
 extern void __wine_syscall_dispatcher(void) DECLSPEC_HIDDEN;
 extern void WINAPI DECLSPEC_NORETURN __wine_syscall_dispatcher_return( void *frame, ULONG_PTR retval ) DECLSPEC_HIDDEN;
 extern NTSTATUS signal_set_full_context( CONTEXT *context ) DECLSPEC_HIDDEN;
+#ifdef __x86_64__
+extern ULONG signal_get_syscall_id(void) DECLSPEC_HIDDEN;
+#endif
+#if defined(__i386__) || defined(__x86_64__)
+extern void **signal_get_syscall_stack(void) DECLSPEC_HIDDEN;
+#endif
 extern NTSTATUS get_thread_wow64_context( HANDLE handle, void *ctx, ULONG size ) DECLSPEC_HIDDEN;
 extern NTSTATUS set_thread_wow64_context( HANDLE handle, const void *ctx, ULONG size ) DECLSPEC_HIDDEN;
 extern void fill_vm_counters( VM_COUNTERS_EX *pvmi, int unix_pid ) DECLSPEC_HIDDEN;
@@ -285,6 +298,26 @@ extern struct cpu_topology_override *get_cpu_topology_override(void) DECLSPEC_HI
 
 extern void dbg_init(void) DECLSPEC_HIDDEN;
 
+enum wait_profile_type
+{
+    WAIT_PROFILE_OBJECT,
+    WAIT_PROFILE_ADDRESS,
+    WAIT_PROFILE_TIMEOUT,  /* timeouts, user APCs and errors */
+};
+
+extern int wait_profile_enabled DECLSPEC_HIDDEN;
+extern void wait_profile_init(void) DECLSPEC_HIDDEN;
+extern ULONG64 wait_profile_time(void) DECLSPEC_HIDDEN;
+extern void wait_profile_record( unsigned int type, const void *object, ULONG64 start ) DECLSPEC_HIDDEN;
+extern void wait_profile_thread_exit(void) DECLSPEC_HIDDEN;
+extern void wait_profile_exit(void) DECLSPEC_HIDDEN;
+
+/* zero timeouts only poll, so they are not worth profiling */
+static inline BOOL wait_profiling( const LARGE_INTEGER *timeout )
+{
+    return wait_profile_enabled && (!timeout || timeout->QuadPart);
+}
+
 extern NTSTATUS call_user_apc_dispatcher( CONTEXT *context_ptr, ULONG_PTR arg1, ULONG_PTR arg2, ULONG_PTR arg3,
                                           PNTAPCFUNC func, NTSTATUS status ) DECLSPEC_HIDDEN;
 extern NTSTATUS call_user_exception_dispatcher( EXCEPTION_RECORD *rec, CONTEXT *context ) DECLSPEC_HIDDEN;
@@ -42,6 +42,9 @@
 #ifdef HAVE_SYS_SYSCTL_H
 # include <sys/sysctl.h>
 #endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
 #ifdef HAVE_SYS_PARAM_H
 # include <sys/param.h>
 #endif
@@ -2283,7 +2286,8 @@ static NTSTATUS map_pe_header( void *ptr, size_t size, int fd, BOOL *removable )
  * virtual_mutex must be held by caller.
  */
 static NTSTATUS map_image_into_view( struct file_view *view, const WCHAR *filename, int fd, void *orig_base,
-                                     SIZE_T header_size, ULONG image_flags, int shared_fd, BOOL removable )
+                                     SIZE_T header_size, ULONG image_flags, int shared_fd, int reloc_fd,
+                                     BOOL removable )
 {
     IMAGE_DOS_HEADER *dos;
     IMAGE_NT_HEADERS *nt;
@@ -2304,7 +2308,13 @@ static NTSTATUS map_image_into_view( struct file_view *view, const WCHAR *filena
 
     fstat( fd, &st );
     header_size = min( header_size, st.st_size );
-    if ((status = map_pe_header( view->base, header_size, fd, &removable ))) return status;
+    if (reloc_fd != -1)
+    {
+        BOOL reloc_removable = FALSE;
+        status = map_pe_header( view->base, header_size, reloc_fd, &reloc_removable );
+    }
+    else status = map_pe_header( view->base, header_size, fd, &removable );
+    if (status) return status;
 
     status = STATUS_INVALID_IMAGE_FORMAT;  /* generic error */
     dos = (IMAGE_DOS_HEADER *)ptr;
@@ -2406,6 +2416,21 @@ static NTSTATUS map_image_into_view( struct file_view *view, const WCHAR *filena
             continue;
         }
 
+        if (reloc_fd != -1)
+        {
+            /* the relocated file is laid out like the image in memory */
+            TRACE_(module)( "mapping %s relocated section %.8s at %p size %lx flags %x\n",
+                            debugstr_w(filename), sec->Name, ptr + sec->VirtualAddress,
+                            map_size, sec->Characteristics );
+            if (map_file_into_view( view, reloc_fd, sec->VirtualAddress, map_size, sec->VirtualAddress,
+                                    VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY, FALSE ) != STATUS_SUCCESS)
+            {
+                ERR_(module)( "Could not map %s relocated section %.8s\n", debugstr_w(filename), sec->Name );
+                return status;
+            }
+            continue;
+        }
+
         TRACE_(module)( "mapping %s section %.8s at %p off %x size %x virt %x flags %x\n",
                         debugstr_w(filename), sec->Name, ptr + sec->VirtualAddress,
                         sec->PointerToRawData, sec->SizeOfRawData,
@@ -2519,6 +2544,26 @@ static NTSTATUS get_mapping_info( HANDLE handle, ACCESS_MASK access, unsigned in
 }
 
 
+/***********************************************************************
+ *             get_image_reloc_file
+ *
+ * Retrieve the server copy of an image already relocated to the given base, if possible.
+ */
+static HANDLE get_image_reloc_file( HANDLE mapping, void *base )
+{
+    HANDLE reloc_file = 0;
+
+    SERVER_START_REQ( get_image_reloc_file )
+    {
+        req->handle = wine_server_obj_handle( mapping );
+        req->base   = wine_server_client_ptr( base );
+        if (!wine_server_call( req )) reloc_file = wine_server_ptr_handle( reply->reloc_file );
+    }
+    SERVER_END_REQ;
+    return reloc_file;
+}
+
+
 /***********************************************************************
  *             virtual_map_image
  *
@@ -2531,6 +2576,8 @@ static NTSTATUS virtual_map_image( HANDLE mapping, ACCESS_MASK access, void **ad
     unsigned int vprot = SEC_IMAGE | SEC_FILE | VPROT_COMMITTED | VPROT_READ | VPROT_EXEC | VPROT_WRITECOPY;
     int unix_fd = -1, needs_close;
     int shared_fd = -1, shared_needs_close = 0;
+    int reloc_fd = -1, reloc_needs_close = 0;
+    HANDLE reloc_file = 0;
     SIZE_T size = image_info->map_size;
     struct file_view *view;
     NTSTATUS status;
@@ -2559,8 +2606,14 @@ static NTSTATUS virtual_map_image( HANDLE mapping, ACCESS_MASK access, void **ad
     if (status) status = map_view( &view, NULL, size, alloc_type & MEM_TOP_DOWN, vprot, zero_bits );
     if (status) goto done;
 
+    /* use the pages already relocated by another process if the image isn't at its preferred base */
+    if (view->base != base && (image_info->image_flags & IMAGE_FLAGS_ImageDynamicallyRelocated) &&
+        (reloc_file = get_image_reloc_file( mapping, view->base )) &&
+        server_get_unix_fd( reloc_file, FILE_READ_DATA, &reloc_fd, &reloc_needs_close, NULL, NULL ))
+        reloc_fd = -1;
+
     status = map_image_into_view( view, filename, unix_fd, base, image_info->header_size,
-                                  image_info->image_flags, shared_fd, needs_close );
+                                  image_info->image_flags, shared_fd, reloc_fd, needs_close );
     if (status == STATUS_SUCCESS)
     {
         SERVER_START_REQ( map_view )
@@ -2586,6 +2639,8 @@ done:
     server_leave_uninterrupted_section( &virtual_mutex, &sigset );
     if (needs_close) close( unix_fd );
     if (shared_needs_close) close( shared_fd );
+    if (reloc_needs_close) close( reloc_fd );
+    if (reloc_file) NtClose( reloc_file );
     return status;
 }
 
@@ -4025,6 +4080,29 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG_PTR z
     return status;
 }
 
+#define MAX_NUMA_NODES 64
+
+/***********************************************************************
+ *           set_numa_preferred_node
+ *
+ * Make future page faults in the range allocate from the given host NUMA node.
+ */
+static void set_numa_preferred_node( void *base, SIZE_T size, ULONG node )
+{
+#if defined(__linux__) && defined(__NR_mbind)
+    static const int mpol_preferred = 1;  /* MPOL_PREFERRED */
+    unsigned long nodemask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = { 0 };
+    const unsigned int bits = 8 * sizeof(unsigned long);
+
+    nodemask[node / bits] = 1ul << (node % bits);
+    /* the kernel ignores the last bit of maxnode */
+    if (syscall( __NR_mbind, base, size, mpol_preferred, nodemask, MAX_NUMA_NODES + 1, 0 ))
+        WARN( "mbind %p-%p node %u failed: %s\n", base, (char *)base + size, node, strerror(errno) );
+#else
+    FIXME( "Ignoring preferred node %u\n", node );
+#endif
+}
+
 /***********************************************************************
  *             NtAllocateVirtualMemoryEx   (NTDLL.@)
  *             ZwAllocateVirtualMemoryEx   (NTDLL.@)
@@ -4033,11 +4111,33 @@ NTSTATUS WINAPI NtAllocateVirtualMemoryEx( HANDLE process, PVOID *ret, SIZE_T *s
                                            ULONG protect, MEM_EXTENDED_PARAMETER *parameters,
                                            ULONG count )
 {
+    ULONG i, node = NUMA_NO_PREFERRED_NODE;
+    NTSTATUS status;
+
     if (count && !parameters) return STATUS_INVALID_PARAMETER;
 
-    if (count) FIXME( "Ignoring %d extended parameters %p\n", count, parameters );
+    for (i = 0; i < count; i++)
+    {
+        switch (parameters[i].Type)
+        {
+        case MemExtendedParameterNumaNode:
+            node = parameters[i].ULong;
+            if (node != NUMA_NO_PREFERRED_NODE && node >= MAX_NUMA_NODES) return STATUS_INVALID_PARAMETER;
+            break;
+        default:
+            FIXME( "Ignoring extended parameter type %u\n", (int)parameters[i].Type );
+            break;
+        }
+    }
+
+    status = NtAllocateVirtualMemory( process, ret, 0, size_ptr, type, protect );
 
-    return NtAllocateVirtualMemory( process, ret, 0, size_ptr, type, protect );
+    if (!status && node != NUMA_NO_PREFERRED_NODE && (type & (MEM_COMMIT | MEM_RESERVE)))
+    {
+        if (process == NtCurrentProcess()) set_numa_preferred_node( *ret, *size_ptr, node );
+        else FIXME( "Ignoring preferred node %u for process %p\n", node, process );
+    }
+    return status;
 }
 
 
@@ -0,0 +1,402 @@
+/*
+ * Wait and lock contention profiler
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * Enabled with WINEWAITPROFILE=<n>, which reports the n call sites that
+ * spent the most time blocked, at exit or on the first wait after the
+ * process gets SIGPROF.
+ *
+ * Every blocking wait is appended to a ring owned by the waiting thread,
+ * so that the common path takes no lock. Samples only hold the handle or
+ * address and the return address of the syscall. A full ring is merged into
+ * the process totals under a mutex. Objects and callers are only named for
+ * the reported call sites, after the mutex has been released.
+ */
+
+#if 0
+#pragma makedep unix
+#endif
+
+#include "config.h"
+
+#include <dlfcn.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#define NONAMELESSUNION
+#include "windef.h"
+#include "winternl.h"
+#include "wine/list.h"
+#include "unix_private.h"
+
+#define WAIT_RING_SIZE   256
+#define WAIT_TOTALS_SIZE 4096  /* must be a power of two */
+#define WAIT_NAME_LEN    80
+
+struct wait_sample
+{
+    const void  *object;  /* handle, or address for address waits */
+    void        *caller;  /* return address of the syscall */
+    ULONG64      time;    /* in nanoseconds */
+    unsigned int type;
+};
+
+struct wait_ring
+{
+    struct list        entry;
+    unsigned int       count;    /* samples written by the owner thread */
+    unsigned int       flushed;  /* samples merged into the totals */
+    struct wait_sample samples[WAIT_RING_SIZE];
+};
+
+struct wait_total
+{
+    const void  *object;
+    void        *caller;
+    unsigned int type;
+    unsigned int count;
+    ULONG64      time;
+    ULONG64      max_time;
+};
+
+int wait_profile_enabled = 0;
+
+static unsigned int report_count;
+static struct list rings = LIST_INIT( rings );
+static struct wait_total *totals;
+static unsigned int totals_used;
+static ULONG64 dropped_samples;
+static volatile int dump_requested;
+static pthread_mutex_t wait_profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *type_names[] = { "object", "address", "timeout" };
+
+/* signals are blocked while the mutex is held, so its owner can't be
+ * suspended or terminated before releasing it */
+static void lock_profile( sigset_t *sigset )
+{
+    pthread_sigmask( SIG_BLOCK, &server_block_set, sigset );
+    mutex_lock( &wait_profile_mutex );
+}
+
+static void unlock_profile( sigset_t *sigset )
+{
+    mutex_unlock( &wait_profile_mutex );
+    pthread_sigmask( SIG_SETMASK, sigset, NULL );
+}
+
+
+ULONG64 wait_profile_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * (ULONG64)1000000000 + ts.tv_nsec;
+}
+
+static void narrow_string( char *dst, size_t size, const WCHAR *src, size_t len )
+{
+    size_t i;
+
+    for (i = 0; i < len && i < size - 1; i++) dst[i] = src[i] < 0x80 ? src[i] : '?';
+    dst[i] = 0;
+}
+
+static void resolve_handle_name( HANDLE handle, char *buffer, size_t size )
+{
+    char info[1024], type[32], name[64];
+    OBJECT_TYPE_INFORMATION *type_info = (OBJECT_TYPE_INFORMATION *)info;
+    OBJECT_NAME_INFORMATION *name_info = (OBJECT_NAME_INFORMATION *)info;
+
+    strcpy( type, "?" );
+    name[0] = 0;
+    if (!NtQueryObject( handle, ObjectTypeInformation, type_info, sizeof(info) - sizeof(WCHAR), NULL ))
+        narrow_string( type, sizeof(type), type_info->TypeName.Buffer,
+                       type_info->TypeName.Length / sizeof(WCHAR) );
+    if (!NtQueryObject( handle, ObjectNameInformation, name_info, sizeof(info) - sizeof(WCHAR), NULL ))
+        narrow_string( name, sizeof(name), name_info->Name.Buffer, name_info->Name.Length / sizeof(WCHAR) );
+    snprintf( buffer, size, "%s %s", type, name );
+}
+
+/* lock words of critical sections are waited on directly; name them from their debug info */
+static void resolve_address_name( const void *addr, char *buffer, size_t size )
+{
+    RTL_CRITICAL_SECTION *crit = CONTAINING_RECORD( addr, RTL_CRITICAL_SECTION, LockSemaphore );
+    RTL_CRITICAL_SECTION_DEBUG *debug;
+    const char *name;
+    size_t len;
+
+    snprintf( buffer, size, "address" );
+    if (!virtual_check_buffer_for_read( crit, sizeof(*crit) )) return;
+    debug = crit->DebugInfo;
+    if (!debug || debug == (RTL_CRITICAL_SECTION_DEBUG *)-1) return;
+    if (!virtual_check_buffer_for_read( debug, sizeof(*debug) ) || debug->CriticalSection != crit) return;
+
+    snprintf( buffer, size, "critsection" );
+    if (!(name = (const char *)debug->Spare[0])) return;
+    for (len = 0; len < size && virtual_check_buffer_for_read( name + len, 1 ); len++)
+        if (!name[len]) break;
+    snprintf( buffer, size, "critsection %.*s", (int)len, name );
+}
+
+/* name a caller as module+offset */
+static void resolve_caller_name( const void *caller, char *buffer, size_t size )
+{
+    char info[1024], module[64];
+    MEMORY_SECTION_NAME *section = (MEMORY_SECTION_NAME *)info;
+    MEMORY_BASIC_INFORMATION mbi;
+    const WCHAR *name;
+    Dl_info dl_info;
+    size_t len, i;
+
+    buffer[0] = 0;
+    if (!caller) return;
+
+    if (!NtQueryVirtualMemory( NtCurrentProcess(), caller, MemoryBasicInformation, &mbi, sizeof(mbi), NULL ) &&
+        !NtQueryVirtualMemory( NtCurrentProcess(), caller, MemoryMappedFilenameInformation,
+                               section, sizeof(info) - sizeof(WCHAR), NULL ))
+    {
+        name = section->SectionFileName.Buffer;
+        len = section->SectionFileName.Length / sizeof(WCHAR);
+        for (i = len; i; i--) if (name[i - 1] == '\\') break;
+        narrow_string( module, sizeof(module), name + i, len - i );
+        snprintf( buffer, size, "%s+%#lx", module, (ULONG_PTR)caller - (ULONG_PTR)mbi.AllocationBase );
+    }
+    else if (dladdr( caller, &dl_info ) && dl_info.dli_fname)
+    {
+        const char *p = strrchr( dl_info.dli_fname, '/' );
+        snprintf( buffer, size, "%s+%#lx", p ? p + 1 : dl_info.dli_fname,
+                  (ULONG_PTR)caller - (ULONG_PTR)dl_info.dli_fbase );
+    }
+}
+
+static void resolve_object_name( const struct wait_total *total, char *buffer, size_t size )
+{
+    switch (total->type)
+    {
+    case WAIT_PROFILE_OBJECT:  resolve_handle_name( (HANDLE)total->object, buffer, size ); break;
+    case WAIT_PROFILE_ADDRESS: resolve_address_name( total->object, buffer, size ); break;
+    default:                   snprintf( buffer, size, "timeout/apc" ); break;
+    }
+}
+
+/* must be called with wait_profile_mutex held */
+static void merge_sample( const struct wait_sample *sample )
+{
+    unsigned int i, hash = ((ULONG_PTR)sample->object >> 2) * 31 + ((ULONG_PTR)sample->caller >> 4);
+    struct wait_total *total;
+
+    for (i = 0; i < WAIT_TOTALS_SIZE; i++)
+    {
+        total = &totals[(hash + i) & (WAIT_TOTALS_SIZE - 1)];
+        if (!total->count) break;
+        if (total->object == sample->object && total->caller == sample->caller && total->type == sample->type)
+            goto found;
+    }
+    if (i == WAIT_TOTALS_SIZE || totals_used >= WAIT_TOTALS_SIZE * 3 / 4)
+    {
+        dropped_samples++;
+        return;
+    }
+
+    total->object = sample->object;
+    total->caller = sample->caller;
+    total->type   = sample->type;
+    totals_used++;
+
+found:
+    total->count++;
+    total->time += sample->time;
+    total->max_time = max( total->max_time, sample->time );
+}
+
+/* must be called with wait_profile_mutex held */
+static void flush_ring( struct wait_ring *ring )
+{
+    unsigned int i, count = __atomic_load_n( &ring->count, __ATOMIC_ACQUIRE );
+
+    for (i = ring->flushed; i != count; i++) merge_sample( &ring->samples[i % WAIT_RING_SIZE] );
+    __atomic_store_n( &ring->flushed, count, __ATOMIC_RELAXED );
+}
+
+static int compare_totals( const void *a, const void *b )
+{
+    const struct wait_total *total1 = *(const struct wait_total **)a;
+    const struct wait_total *total2 = *(const struct wait_total **)b;
+
+    if (total1->time != total2->time) return total1->time < total2->time ? 1 : -1;
+    return 0;
+}
+
+static void dump_wait_profile(void)
+{
+    char name[WAIT_NAME_LEN], caller[WAIT_NAME_LEN];
+    struct wait_total **sorted, *top = NULL;
+    struct wait_ring *ring;
+    unsigned int i, sites = 0, count = 0;
+    ULONG64 dropped;
+    sigset_t sigset;
+
+    lock_profile( &sigset );
+
+    LIST_FOR_EACH_ENTRY( ring, &rings, struct wait_ring, entry ) flush_ring( ring );
+
+    /* copy the reported call sites, they are named after releasing the mutex */
+    if ((sorted = malloc( totals_used * sizeof(*sorted) )))
+    {
+        for (i = 0; i < WAIT_TOTALS_SIZE; i++) if (totals[i].count) sorted[sites++] = &totals[i];
+        qsort( sorted, sites, sizeof(*sorted), compare_totals );
+        count = min( sites, report_count );
+        if ((top = malloc( count * sizeof(*top) )))
+            for (i = 0; i < count; i++) top[i] = *sorted[i];
+        free( sorted );
+    }
+    dropped = dropped_samples;
+
+    unlock_profile( &sigset );
+
+    if (!top) return;
+
+    fprintf( stderr, "%04x: wait profile, %u call sites, %llu samples dropped\n",
+             (int)GetCurrentProcessId(), sites, (unsigned long long)dropped );
+    fprintf( stderr, "%-8s %-18s %-18s %10s %14s %12s  %s\n",
+             "type", "object", "caller", "count", "total us", "max us", "name" );
+    for (i = 0; i < count; i++)
+    {
+        resolve_object_name( &top[i], name, sizeof(name) );
+        resolve_caller_name( top[i].caller, caller, sizeof(caller) );
+        fprintf( stderr, "%-8s %-18p %-18p %10u %14llu %12llu  %s %s\n",
+                 type_names[top[i].type], top[i].object, top[i].caller, top[i].count,
+                 (unsigned long long)top[i].time / 1000, (unsigned long long)top[i].max_time / 1000,
+                 name, caller );
+    }
+    free( top );
+}
+
+static void sigprof_handler( int signal )
+{
+    dump_requested = 1;
+}
+
+
+/***********************************************************************
+ *           wait_profile_init
+ */
+void wait_profile_init(void)
+{
+    const char *env = getenv( "WINEWAITPROFILE" );
+    struct sigaction sig_act;
+
+    if (!env || atoi( env ) <= 0) return;
+    if (!(totals = calloc( WAIT_TOTALS_SIZE, sizeof(*totals) ))) return;
+
+    report_count = atoi( env );
+
+    memset( &sig_act, 0, sizeof(sig_act) );
+    sig_act.sa_handler = sigprof_handler;
+    sig_act.sa_flags = SA_RESTART;
+    sigaction( SIGPROF, &sig_act, NULL );
+
+    wait_profile_enabled = 1;
+}
+
+
+/***********************************************************************
+ *           wait_profile_record
+ *
+ * Account a wait that started at the given wait_profile_time().
+ */
+void wait_profile_record( unsigned int type, const void *object, ULONG64 start )
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct wait_ring *ring = thread_data->wait_ring;
+    struct wait_sample *sample;
+    ULONG64 time = wait_profile_time() - start;
+    sigset_t sigset;
+
+    if (!ring)
+    {
+        if (!(ring = calloc( 1, sizeof(*ring) ))) return;
+        lock_profile( &sigset );
+        list_add_tail( &rings, &ring->entry );
+        unlock_profile( &sigset );
+        thread_data->wait_ring = ring;
+    }
+
+    if (ring->count - __atomic_load_n( &ring->flushed, __ATOMIC_RELAXED ) == WAIT_RING_SIZE)
+    {
+        lock_profile( &sigset );
+        flush_ring( ring );
+        unlock_profile( &sigset );
+    }
+
+    sample = &ring->samples[ring->count % WAIT_RING_SIZE];
+    sample->object = object;
+#if defined(__i386__) || defined(__x86_64__)
+    sample->caller = signal_get_syscall_stack()[0];
+#else
+    sample->caller = NULL;
+#endif
+    sample->time   = time;
+    sample->type   = type;
+    __atomic_store_n( &ring->count, ring->count + 1, __ATOMIC_RELEASE );
+
+    if (dump_requested)
+    {
+        dump_requested = 0;
+        dump_wait_profile();
+    }
+}
+
+
+/***********************************************************************
+ *           wait_profile_thread_exit
+ */
+void wait_profile_thread_exit(void)
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct wait_ring *ring = thread_data->wait_ring;
+    sigset_t sigset;
+
+    if (!ring) return;
+
+    lock_profile( &sigset );
+    flush_ring( ring );
+    list_remove( &ring->entry );
+    unlock_profile( &sigset );
+
+    thread_data->wait_ring = NULL;
+    free( ring );
+}
+
+
+/***********************************************************************
+ *           wait_profile_exit
+ *
+ * Print the report while the server connection is still usable.
+ */
+void wait_profile_exit(void)
+{
+    if (wait_profile_enabled) dump_wait_profile();
+}
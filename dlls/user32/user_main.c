@@ -298,6 +298,28 @@ static void thread_detach(void)
 }
 
 
+static HMODULE imm32_module;
+
+static BOOL WINAPI load_imm32_once( INIT_ONCE *once, void *param, void **context )
+{
+    imm32_module = LoadLibraryW( L"imm32.dll" );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           load_imm32
+ *
+ * Load imm32 before the first window gets its IME window, its
+ * initialization fills the IME entry table.
+ */
+void load_imm32(void)
+{
+    static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
+
+    InitOnceExecuteOnce( &init_once, load_imm32_once, NULL, NULL );
+}
+
+
 /***********************************************************************
  *           UserClientDllInitialize  (USER32.@)
  *
@@ -305,7 +327,6 @@ static void thread_detach(void)
  */
 BOOL WINAPI DllMain( HINSTANCE inst, DWORD reason, LPVOID reserved )
 {
-    static HMODULE imm32_module;
     BOOL ret = TRUE;
 
     switch(reason)
@@ -313,8 +334,6 @@ BOOL WINAPI DllMain( HINSTANCE inst, DWORD reason, LPVOID reserved )
     case DLL_PROCESS_ATTACH:
         user32_module = inst;
         ret = process_attach();
-        if(ret)
-            imm32_module = LoadLibraryW(L"imm32.dll");
         break;
     case DLL_THREAD_DETACH:
         thread_detach();
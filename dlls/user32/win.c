@@ -1776,6 +1776,7 @@ HWND WIN_CreateWindowEx( CREATESTRUCTW *cs, LPCWSTR className, HINSTANCE module,
 
     /* create default IME window */
 
+    load_imm32();
     if (imm_register_window && !is_desktop_window( hwnd ) &&
         parent != get_hwnd_message_parent() && imm_register_window( hwnd ))
     {
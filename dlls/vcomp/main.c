@@ -35,6 +35,9 @@ WINE_DEFAULT_DEBUG_CHANNEL(vcomp);
 
 #define MAX_VECT_PARALLEL_CALLBACK_ARGS 128
 
+/* number of pause iterations before a waiting thread goes to sleep */
+#define VCOMP_SPIN_COUNT 4000
+
 typedef CRITICAL_SECTION *omp_lock_t;
 typedef CRITICAL_SECTION *omp_nest_lock_t;
 
@@ -83,13 +86,19 @@ struct vcomp_thread_data
     unsigned int            dynamic_type;
     unsigned int            dynamic_begin;
     unsigned int            dynamic_end;
+    /* the loop taken from the shared state, a nowait loop may already be
+     * followed by the next one in other threads */
+    unsigned int            dynamic_first;
+    unsigned int            dynamic_last;
+    unsigned int            dynamic_iterations;
+    int                     dynamic_step;
+    unsigned int            dynamic_chunksize;
 };
 
 struct vcomp_team_data
 {
-    CONDITION_VARIABLE      cond;
     int                     num_threads;
-    int                     finished_threads;
+    LONG                    finished_threads;
 
     /* callback arguments */
     int                     nargs;
@@ -97,8 +106,8 @@ struct vcomp_team_data
     va_list                 valist;
 
     /* barrier */
-    unsigned int            barrier;
-    int                     barrier_count;
+    LONG                    barrier;
+    LONG                    barrier_count;
 };
 
 struct vcomp_task_data
@@ -111,13 +120,9 @@ struct vcomp_task_data
     int                     num_sections;
     int                     section_index;
 
-    /* dynamic */
+    /* dynamic, the state holds the generation and the remaining iterations */
+    LONG64                  dynamic_state;
     unsigned int            dynamic;
-    unsigned int            dynamic_first;
-    unsigned int            dynamic_last;
-    unsigned int            dynamic_iterations;
-    int                     dynamic_step;
-    unsigned int            dynamic_chunksize;
 };
 
 static void **ptr_from_va_list(va_list valist)
@@ -411,6 +416,7 @@ static struct vcomp_thread_data *vcomp_init_thread_data(void)
     data->task.single           = 0;
     data->task.section          = 0;
     data->task.dynamic          = 0;
+    data->task.dynamic_state    = 0;
 
     thread_data = &data->thread;
     thread_data->team           = NULL;
@@ -427,6 +433,39 @@ static struct vcomp_thread_data *vcomp_init_thread_data(void)
     return thread_data;
 }
 
+/* spinning only pays off when every thread of the team has a processor */
+static unsigned int vcomp_spin_count(int num_threads)
+{
+    return (vcomp_num_procs > 1 && num_threads <= vcomp_num_procs) ? VCOMP_SPIN_COUNT : 0;
+}
+
+static void vcomp_wait_on_address(LONG *addr, LONG value, unsigned int spin)
+{
+    while (*(volatile LONG *)addr == value)
+    {
+        if (spin)
+        {
+            spin--;
+            YieldProcessor();
+            continue;
+        }
+        RtlWaitOnAddress(addr, &value, sizeof(value), NULL);
+    }
+}
+
+/* returns TRUE if the calling thread is the first to reach a construct of the team */
+static BOOL vcomp_claim_construct(unsigned int *task_counter, unsigned int thread_counter)
+{
+    unsigned int counter;
+
+    while ((int)(thread_counter - (counter = *(volatile unsigned int *)task_counter)) > 0)
+    {
+        if (InterlockedCompareExchange((LONG *)task_counter, thread_counter, counter) == counter)
+            return TRUE;
+    }
+    return FALSE;
+}
+
 static void vcomp_free_thread_data(void)
 {
     struct vcomp_thread_data *thread_data = vcomp_get_thread_data();
@@ -1057,26 +1096,24 @@ void CDECL _vcomp_flush(void)
 void CDECL _vcomp_barrier(void)
 {
     struct vcomp_team_data *team_data = vcomp_init_thread_data()->team;
+    LONG barrier;
 
     TRACE("()\n");
 
     if (!team_data)
         return;
 
-    EnterCriticalSection(&vcomp_section);
-    if (++team_data->barrier_count >= team_data->num_threads)
+    /* the last thread resets the count before releasing the others, so the
+     * generation read here always belongs to the current barrier */
+    barrier = *(volatile LONG *)&team_data->barrier;
+    if (InterlockedIncrement(&team_data->barrier_count) >= team_data->num_threads)
     {
-        team_data->barrier++;
-        team_data->barrier_count = 0;
-        WakeAllConditionVariable(&team_data->cond);
+        InterlockedExchange(&team_data->barrier_count, 0);
+        InterlockedIncrement(&team_data->barrier);
+        RtlWakeAddressAll(&team_data->barrier);
     }
     else
-    {
-        unsigned int barrier = team_data->barrier;
-        while (team_data->barrier == barrier)
-            SleepConditionVariableCS(&team_data->cond, &vcomp_section, INFINITE);
-    }
-    LeaveCriticalSection(&vcomp_section);
+        vcomp_wait_on_address(&team_data->barrier, barrier, vcomp_spin_count(team_data->num_threads));
 }
 
 void CDECL _vcomp_set_num_threads(int num_threads)
@@ -1102,20 +1139,11 @@ int CDECL _vcomp_single_begin(int flags)
 {
     struct vcomp_thread_data *thread_data = vcomp_init_thread_data();
     struct vcomp_task_data *task_data = thread_data->task;
-    int ret = FALSE;
 
     TRACE("(%x): semi-stub\n", flags);
 
-    EnterCriticalSection(&vcomp_section);
     thread_data->single++;
-    if ((int)(thread_data->single - task_data->single) > 0)
-    {
-        task_data->single = thread_data->single;
-        ret = TRUE;
-    }
-    LeaveCriticalSection(&vcomp_section);
-
-    return ret;
+    return vcomp_claim_construct(&task_data->single, thread_data->single);
 }
 
 void CDECL _vcomp_single_end(void)
@@ -1467,19 +1495,22 @@ void CDECL _vcomp_for_dynamic_init(unsigned int flags, unsigned int first, unsig
             type = VCOMP_DYNAMIC_FLAGS_GUIDED;
         }
 
-        EnterCriticalSection(&vcomp_section);
         thread_data->dynamic++;
-        thread_data->dynamic_type = type;
-        if ((int)(thread_data->dynamic - task_data->dynamic) > 0)
+        thread_data->dynamic_type       = type;
+        thread_data->dynamic_first      = first;
+        thread_data->dynamic_last       = last;
+        thread_data->dynamic_iterations = iterations;
+        thread_data->dynamic_step       = step;
+        thread_data->dynamic_chunksize  = chunksize;
+        if (vcomp_claim_construct(&task_data->dynamic, thread_data->dynamic))
         {
-            task_data->dynamic              = thread_data->dynamic;
-            task_data->dynamic_first        = first;
-            task_data->dynamic_last         = last;
-            task_data->dynamic_iterations   = iterations;
-            task_data->dynamic_step         = step;
-            task_data->dynamic_chunksize    = chunksize;
+            LONG64 state = task_data->dynamic_state, prev;
+
+            /* publish the new loop, other threads only wait for it from now on */
+            while ((prev = InterlockedCompareExchange64(&task_data->dynamic_state,
+                    ((ULONG64)thread_data->dynamic << 32) | iterations, state)) != state)
+                state = prev;
         }
-        LeaveCriticalSection(&vcomp_section);
     }
 }
 
@@ -1502,26 +1533,47 @@ int CDECL _vcomp_for_dynamic_next(unsigned int *begin, unsigned int *end)
     else if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_CHUNKED ||
              thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED)
     {
-        unsigned int iterations = 0;
-        EnterCriticalSection(&vcomp_section);
-        if (thread_data->dynamic == task_data->dynamic &&
-            task_data->dynamic_iterations != 0)
+        unsigned int iterations, remaining, generation;
+        LONG64 state, prev;
+
+        /* chunks are taken by decrementing the remaining iterations in the
+         * state, which fails if another loop has been published meanwhile */
+        state = InterlockedCompareExchange64(&task_data->dynamic_state, 0, 0);
+        for (;;)
         {
-            iterations = min(task_data->dynamic_iterations, task_data->dynamic_chunksize);
+            generation = state >> 32;
+            remaining  = (unsigned int)state;
+
+            if ((int)(generation - thread_data->dynamic) < 0)
+            {
+                /* the first thread is still initializing this loop */
+                YieldProcessor();
+                state = InterlockedCompareExchange64(&task_data->dynamic_state, 0, 0);
+                continue;
+            }
+            if (generation != thread_data->dynamic || !remaining)
+                return 0;
+
+            iterations = min(remaining, thread_data->dynamic_chunksize);
             if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED &&
-                task_data->dynamic_iterations > num_threads * task_data->dynamic_chunksize)
+                remaining > num_threads * thread_data->dynamic_chunksize)
             {
-                iterations = (task_data->dynamic_iterations + num_threads - 1) / num_threads;
+                iterations = (remaining + num_threads - 1) / num_threads;
             }
-            *begin = task_data->dynamic_first;
-            *end   = task_data->dynamic_first + (iterations - 1) * task_data->dynamic_step;
-            task_data->dynamic_iterations -= iterations;
-            task_data->dynamic_first      += iterations * task_data->dynamic_step;
-            if (!task_data->dynamic_iterations)
-                *end = task_data->dynamic_last;
+            if (!iterations)
+                return 0;
+
+            prev = InterlockedCompareExchange64(&task_data->dynamic_state, state - iterations, state);
+            if (prev == state) break;
+            state = prev;
         }
-        LeaveCriticalSection(&vcomp_section);
-        return iterations != 0;
+
+        *begin = thread_data->dynamic_first +
+                 (thread_data->dynamic_iterations - remaining) * thread_data->dynamic_step;
+        *end   = *begin + (iterations - 1) * thread_data->dynamic_step;
+        if (iterations == remaining)
+            *end = thread_data->dynamic_last;
+        return 1;
     }
 
     return 0;
@@ -1546,6 +1598,9 @@ static DWORD WINAPI _vcomp_fork_worker(void *param)
         struct vcomp_team_data *team = thread_data->team;
         if (team != NULL)
         {
+            int num_threads = team->num_threads;
+            unsigned int spin = vcomp_spin_count(num_threads);
+
             LeaveCriticalSection(&vcomp_section);
             _vcomp_fork_call_wrapper(team->wrapper, team->nargs, ptr_from_va_list(team->valist));
             EnterCriticalSection(&vcomp_section);
@@ -1553,8 +1608,19 @@ static DWORD WINAPI _vcomp_fork_worker(void *param)
             thread_data->team = NULL;
             list_remove(&thread_data->entry);
             list_add_tail(&vcomp_idle_threads, &thread_data->entry);
-            if (++team->finished_threads >= team->num_threads)
-                WakeAllConditionVariable(&team->cond);
+            LeaveCriticalSection(&vcomp_section);
+
+            /* the team data lives on the stack of the master, which returns
+             * as soon as the last thread has finished */
+            if (InterlockedIncrement(&team->finished_threads) >= num_threads)
+                RtlWakeAddressAll(&team->finished_threads);
+
+            /* stay hot for a moment, programs often fork again right away */
+            while (spin-- && !*(struct vcomp_team_data * volatile *)&thread_data->team)
+                YieldProcessor();
+
+            EnterCriticalSection(&vcomp_section);
+            continue;
         }
 
         if (!SleepConditionVariableCS(&thread_data->cond, &vcomp_section, 5000) &&
@@ -1594,7 +1660,6 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
     else
         num_threads = vcomp_num_threads;
 
-    InitializeConditionVariable(&team_data.cond);
     team_data.num_threads       = 1;
     team_data.finished_threads  = 0;
     team_data.nargs             = nargs;
@@ -1606,6 +1671,7 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
     task_data.single            = 0;
     task_data.section           = 0;
     task_data.dynamic           = 0;
+    task_data.dynamic_state     = 0;
 
     thread_data.team            = &team_data;
     thread_data.task            = &task_data;
@@ -1687,13 +1753,15 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
 
     if (team_data.num_threads > 1)
     {
-        EnterCriticalSection(&vcomp_section);
+        unsigned int spin = vcomp_spin_count(team_data.num_threads);
+        LONG finished = InterlockedIncrement(&team_data.finished_threads);
 
-        team_data.finished_threads++;
-        while (team_data.finished_threads < team_data.num_threads)
-            SleepConditionVariableCS(&team_data.cond, &vcomp_section, INFINITE);
+        while (finished < team_data.num_threads)
+        {
+            vcomp_wait_on_address(&team_data.finished_threads, finished, spin);
+            finished = *(volatile LONG *)&team_data.finished_threads;
+        }
 
-        LeaveCriticalSection(&vcomp_section);
         assert(list_empty(&thread_data.entry));
     }
 
@@ -1621,6 +1621,31 @@ static void CDECL for_dynamic_guided_cb(unsigned int flags, LONG *a, LONG *b, LO
     }
 }
 
+static void CDECL for_dynamic_nowait_cb(LONG *a, LONG *b)
+{
+    unsigned int begin, end;
+    int i;
+
+    /* back to back loops without barriers, fast threads start the next
+     * loop while the others still take chunks of the previous one */
+    for (i = 0; i < 200; i++)
+    {
+        p_vcomp_for_dynamic_init(VCOMP_DYNAMIC_FLAGS_CHUNKED | VCOMP_DYNAMIC_FLAGS_INCREMENT, 0, 99, 1, 1);
+        while (p_vcomp_for_dynamic_next(&begin, &end))
+        {
+            ok(begin == end && begin <= 99, "got begin %u, end %u\n", begin, end);
+            InterlockedExchangeAdd(a, begin);
+        }
+
+        p_vcomp_for_dynamic_init(VCOMP_DYNAMIC_FLAGS_CHUNKED, 1000, 0, 7, 1);
+        while (p_vcomp_for_dynamic_next(&begin, &end))
+        {
+            ok(begin == end && begin % 7 == 1000 % 7, "got begin %u, end %u\n", begin, end);
+            InterlockedExchangeAdd(b, begin);
+        }
+    }
+}
+
 static void test_vcomp_for_dynamic_init(void)
 {
     static const int guided_a[] = {0, 6041, 9072, 11179};
@@ -1668,6 +1693,16 @@ static void test_vcomp_for_dynamic_init(void)
         ok(d == 14790, "expected d == 14790, got %d\n", d);
     }
 
+    for (i = 2; i <= 4; i++)
+    {
+        pomp_set_num_threads(i);
+
+        a = b = 0;
+        p_vcomp_fork(TRUE, 2, for_dynamic_nowait_cb, &a, &b);
+        ok(a == 200 * 4950, "expected a == %d, got %d\n", 200 * 4950, a);
+        ok(b == 200 * 71929, "expected b == %d, got %d\n", 200 * 71929, b);
+    }
+
     /* test guided scheduling */
     a = b = c = d = 0;
     for_dynamic_guided_cb(VCOMP_DYNAMIC_FLAGS_GUIDED, &a, &b, &c, &d);
@@ -2619,6 +2654,86 @@ static void test_reduction_float_double(void)
     }
 }
 
+/* EPCC-style overheads, the cost of each construct is reported per repetition */
+#define EPCC_REPS 2000
+
+static void CDECL epcc_barrier_cb(void)
+{
+    int i;
+
+    for (i = 0; i < EPCC_REPS; i++)
+        p_vcomp_barrier();
+}
+
+static void CDECL epcc_for_dynamic_cb(LONG *count)
+{
+    int num_threads = pomp_get_num_threads();
+    unsigned int begin, end;
+    int i;
+
+    for (i = 0; i < EPCC_REPS; i++)
+    {
+        p_vcomp_for_dynamic_init(VCOMP_DYNAMIC_FLAGS_CHUNKED | VCOMP_DYNAMIC_FLAGS_INCREMENT,
+                                 0, 4 * num_threads - 1, 1, 1);
+        while (p_vcomp_for_dynamic_next(&begin, &end))
+            InterlockedExchangeAdd(count, end - begin + 1);
+        p_vcomp_barrier();
+    }
+}
+
+static void CDECL epcc_reduction_cb(int *sum)
+{
+    p_vcomp_reduction_i4(VCOMP_REDUCTION_FLAGS_ADD, sum, 1);
+}
+
+static double epcc_elapsed(LARGE_INTEGER start)
+{
+    LARGE_INTEGER end, freq;
+
+    QueryPerformanceCounter(&end);
+    QueryPerformanceFrequency(&freq);
+    return (end.QuadPart - start.QuadPart) * 1000000.0 / freq.QuadPart / EPCC_REPS;
+}
+
+static void test_overheads(void)
+{
+    int max_threads = pomp_get_max_threads();
+    LARGE_INTEGER start;
+    int num_threads, i, sum;
+    LONG count;
+
+    num_threads = min(pomp_get_num_procs(), 8);
+    if (num_threads < 2)
+    {
+        skip("overheads need at least two processors\n");
+        return;
+    }
+    pomp_set_num_threads(num_threads);
+
+    QueryPerformanceCounter(&start);
+    p_vcomp_fork(TRUE, 0, epcc_barrier_cb);
+    if (winetest_debug > 1)
+        trace("%d threads: barrier %.2f us\n", num_threads, epcc_elapsed(start));
+
+    count = 0;
+    QueryPerformanceCounter(&start);
+    p_vcomp_fork(TRUE, 1, epcc_for_dynamic_cb, &count);
+    if (winetest_debug > 1)
+        trace("%d threads: for dynamic,1 %.2f us\n", num_threads, epcc_elapsed(start));
+    ok(count == EPCC_REPS * 4 * num_threads, "expected count == %d, got %d\n",
+       EPCC_REPS * 4 * num_threads, count);
+
+    sum = 0;
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < EPCC_REPS; i++)
+        p_vcomp_fork(TRUE, 1, epcc_reduction_cb, &sum);
+    if (winetest_debug > 1)
+        trace("%d threads: parallel reduction %.2f us\n", num_threads, epcc_elapsed(start));
+    ok(sum == EPCC_REPS * num_threads, "expected sum == %d, got %d\n", EPCC_REPS * num_threads, sum);
+
+    pomp_set_num_threads(max_threads);
+}
+
 static void test_omp_get_num_procs(void)
 {
     SYSTEM_INFO sysinfo;
@@ -2661,6 +2776,7 @@ START_TEST(vcomp)
     test_reduction_integer32();
     test_reduction_integer64();
     test_reduction_float_double();
+    test_overheads();
 
     release_vcomp();
 }
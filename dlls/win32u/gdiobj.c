@@ -1201,7 +1201,9 @@ NTSTATUS gdi_init(void)
     init_gdi_shared();
     if (!gdi_shared) return STATUS_NO_MEMORY;
 
+    __wine_startup_trace( "font_init", __WINE_STARTUP_TRACE_BEGIN );
     dpi = font_init();
+    __wine_startup_trace( "font_init", __WINE_STARTUP_TRACE_END );
     init_stock_objects( dpi );
     return 0;
 }
@@ -151,6 +151,28 @@ extern int __cdecl __wine_dbg_header( enum __wine_debug_class cls, struct __wine
                                       const char *function );
 extern void __cdecl __wine_set_unix_env( const char *var, const char *val );
 
+/* startup trace, enabled by setting WINESTARTUPTRACE to the name of the log file */
+
+enum __wine_startup_trace_type
+{
+    __WINE_STARTUP_TRACE_BEGIN,    /* start of a startup stage */
+    __WINE_STARTUP_TRACE_END,      /* end of a startup stage */
+    __WINE_STARTUP_TRACE_PROCESS   /* name of the process image */
+};
+
+/* record in the log file, followed by the stage name (see tools/startuptrace) */
+struct __wine_startup_trace_record
+{
+    DWORD time_low;     /* monotonic time in nanoseconds */
+    DWORD time_high;
+    DWORD pid;          /* unix process id */
+    DWORD tid;          /* thread id, 0 before the server connection */
+    WORD  type;         /* enum __wine_startup_trace_type */
+    WORD  len;          /* length of the name */
+};
+
+extern void WINAPI __wine_startup_trace( const char *name, unsigned int type );
+
 /*
  * Exported definitions and macros
  */
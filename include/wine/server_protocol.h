@@ -867,6 +867,34 @@ struct input_shared_memory
 };
 
 
+struct completion_shared_entry
+{
+    unsigned int         seq;
+    unsigned int         status;
+    apc_param_t          ckey;
+    apc_param_t          cvalue;
+    apc_param_t          information;
+};
+
+#define COMPLETION_RING_SIZE 1024
+
+
+struct completion_shared_memory
+{
+    unsigned int         head;
+    unsigned int         __pad1[15];
+    unsigned int         tail;
+    unsigned int         __pad2[15];
+    int                  futex;
+    int                  waiters;
+    int                  server_waiters;
+    int                  overflow;
+    int                  closed;
+    unsigned int         __pad3[11];
+    struct completion_shared_entry entries[COMPLETION_RING_SIZE];
+};
+
+
 #define SEQUENCE_MASK_BITS  4
 #define SEQUENCE_MASK ((1UL << SEQUENCE_MASK_BITS) - 1)
 
@@ -1942,6 +1970,21 @@ struct get_mapping_info_reply
 
 
 
+struct get_image_reloc_file_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    client_ptr_t base;
+};
+struct get_image_reloc_file_reply
+{
+    struct reply_header __header;
+    obj_handle_t reloc_file;
+    char __pad_12[4];
+};
+
+
+
 struct map_view_request
 {
     struct request_header __header;
@@ -2062,6 +2105,21 @@ struct process_info
 };
 
 
+struct process_list_shared_memory
+{
+    unsigned int    seq;
+    int             stale;
+    timeout_t       update_time;
+    data_size_t     info_size;
+    int             process_count;
+    int             total_thread_count;
+    data_size_t     total_name_len;
+
+};
+
+#define PROCESS_LIST_SHARED_SIZE (4 * 1024 * 1024)
+
+
 struct list_processes_request
 {
     struct request_header __header;
@@ -5084,6 +5142,32 @@ struct query_completion_reply
 
 
 
+struct get_completion_mapping_request
+{
+    struct request_header __header;
+    obj_handle_t  handle;
+};
+struct get_completion_mapping_reply
+{
+    struct reply_header __header;
+    obj_handle_t  mapping;
+    unsigned int  access;
+};
+
+
+
+struct wake_completion_request
+{
+    struct request_header __header;
+    obj_handle_t  handle;
+};
+struct wake_completion_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct set_completion_info_request
 {
     struct request_header __header;
@@ -5712,6 +5796,7 @@ enum request
     REQ_create_mapping,
     REQ_open_mapping,
     REQ_get_mapping_info,
+    REQ_get_image_reloc_file,
     REQ_map_view,
     REQ_unmap_view,
     REQ_get_mapping_committed_range,
@@ -5899,6 +5984,8 @@ enum request
     REQ_add_completion,
     REQ_remove_completion,
     REQ_query_completion,
+    REQ_get_completion_mapping,
+    REQ_wake_completion,
     REQ_set_completion_info,
     REQ_add_fd_completion,
     REQ_set_fd_completion_mode,
@@ -6004,6 +6091,7 @@ union generic_request
     struct create_mapping_request create_mapping_request;
     struct open_mapping_request open_mapping_request;
     struct get_mapping_info_request get_mapping_info_request;
+    struct get_image_reloc_file_request get_image_reloc_file_request;
     struct map_view_request map_view_request;
     struct unmap_view_request unmap_view_request;
     struct get_mapping_committed_range_request get_mapping_committed_range_request;
@@ -6191,6 +6279,8 @@ union generic_request
     struct add_completion_request add_completion_request;
     struct remove_completion_request remove_completion_request;
     struct query_completion_request query_completion_request;
+    struct get_completion_mapping_request get_completion_mapping_request;
+    struct wake_completion_request wake_completion_request;
     struct set_completion_info_request set_completion_info_request;
     struct add_fd_completion_request add_fd_completion_request;
     struct set_fd_completion_mode_request set_fd_completion_mode_request;
@@ -6294,6 +6384,7 @@ union generic_reply
     struct create_mapping_reply create_mapping_reply;
     struct open_mapping_reply open_mapping_reply;
     struct get_mapping_info_reply get_mapping_info_reply;
+    struct get_image_reloc_file_reply get_image_reloc_file_reply;
     struct map_view_reply map_view_reply;
     struct unmap_view_reply unmap_view_reply;
     struct get_mapping_committed_range_reply get_mapping_committed_range_reply;
@@ -6481,6 +6572,8 @@ union generic_reply
     struct add_completion_reply add_completion_reply;
     struct remove_completion_reply remove_completion_reply;
     struct query_completion_reply query_completion_reply;
+    struct get_completion_mapping_reply get_completion_mapping_reply;
+    struct wake_completion_reply wake_completion_reply;
     struct set_completion_info_reply set_completion_info_reply;
     struct add_fd_completion_reply add_fd_completion_reply;
     struct set_fd_completion_mode_reply set_fd_completion_mode_reply;
@@ -6521,7 +6614,7 @@ union generic_reply
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 740
+#define SERVER_PROTOCOL_VERSION 743
 
 /* ### protocol_version end ### */
 
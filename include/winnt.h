@@ -749,6 +749,8 @@ typedef struct _MEMORY_BASIC_INFORMATION
 
 #define MEM_EXTENDED_PARAMETER_TYPE_BITS 8
 
+#define NUMA_NO_PREFERRED_NODE ((DWORD)-1)
+
 typedef enum MEM_EXTENDED_PARAMETER_TYPE {
     MemExtendedParameterInvalidType = 0,
     MemExtendedParameterAddressRequirements,
@@ -4683,6 +4683,10 @@ static inline PLIST_ENTRY RemoveTailList(PLIST_ENTRY le)
 /* Wine internal functions */
 
 extern NTSTATUS WINAPI __wine_unix_spawnvp( char * const argv[], int wait );
+extern NTSTATUS WINAPI __wine_wait_any_objects( DWORD count, const HANDLE *handles, BOOLEAN alertable, const LARGE_INTEGER *timeout, DWORD *index );
+extern NTSTATUS WINAPI __wine_wait_any_supported( HANDLE handle, ULONG *max_count );
+extern NTSTATUS WINAPI __wine_wait_on_address( const LONG *addr, LONG val, ULONG mask, const LARGE_INTEGER *timeout );
+extern NTSTATUS WINAPI __wine_wake_address( const LONG *addr, int count, ULONG mask );
 
 /* The thread information for 16-bit threads */
 /* NtCurrentTeb()->SubSystemTib points to this */
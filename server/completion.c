@@ -28,8 +28,14 @@
 
 #include "config.h"
 
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <sys/mman.h>
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
+#include <unistd.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -64,6 +70,9 @@ struct completion_wait
     struct completion *completion;
     struct list        queue;
     unsigned int       depth;
+    unsigned int       waiters;    /* threads waiting on the object */
+    struct object     *mapping;    /* shared memory ring, created on first client request */
+    volatile struct completion_shared_memory *shared;
 };
 
 struct completion
@@ -73,6 +82,8 @@ struct completion
 };
 
 static void completion_wait_dump( struct object*, int );
+static int completion_wait_add_queue( struct object *obj, struct wait_queue_entry *entry );
+static void completion_wait_remove_queue( struct object *obj, struct wait_queue_entry *entry );
 static int completion_wait_signaled( struct object *obj, struct wait_queue_entry *entry );
 static void completion_wait_satisfied( struct object *obj, struct wait_queue_entry *entry );
 static void completion_wait_destroy( struct object * );
@@ -82,8 +93,8 @@ static const struct object_ops completion_wait_ops =
     sizeof(struct completion_wait), /* size */
     &no_type,                       /* type */
     completion_wait_dump,           /* dump */
-    add_queue,                      /* add_queue */
-    remove_queue,                   /* remove_queue */
+    completion_wait_add_queue,      /* add_queue */
+    completion_wait_remove_queue,   /* remove_queue */
     completion_wait_signaled,       /* signaled */
     NULL,                           /* get_esync_fd */
     NULL,                           /* get_fsync_idx */
@@ -143,6 +154,100 @@ struct comp_msg
     unsigned int  status;
 };
 
+static inline void wake_shared_futex( volatile int *addr, int count )
+{
+#ifdef __linux__
+    /* not FUTEX_PRIVATE_FLAG, the waiters are in other processes */
+    syscall( __NR_futex, addr, 1 /* FUTEX_WAKE */, count, NULL, 0, 0 );
+#endif
+}
+
+/* add a packet to the shared ring, the clients may be doing the same concurrently */
+static int push_shared_packet( volatile struct completion_shared_memory *shared, apc_param_t ckey,
+                               apc_param_t cvalue, unsigned int status, apc_param_t information )
+{
+    volatile struct completion_shared_entry *entry;
+    unsigned int pos, seq, retries;
+
+    for (retries = 0; retries < 64; retries++)
+    {
+        pos = __atomic_load_n( &shared->tail, __ATOMIC_RELAXED );
+        entry = &shared->entries[pos % COMPLETION_RING_SIZE];
+        seq = __atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE );
+        if ((int)(seq - pos) < 0) return 0;  /* full */
+        if (seq != pos) continue;
+        if (!__atomic_compare_exchange_n( &shared->tail, &pos, pos + 1, 0,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED )) continue;
+        entry->status      = status;
+        entry->ckey        = ckey;
+        entry->cvalue      = cvalue;
+        entry->information = information;
+        __atomic_store_n( &entry->seq, pos + 1, __ATOMIC_RELEASE );
+        return 1;
+    }
+    return 0;
+}
+
+/* remove a packet from the shared ring; the memory is writable by the clients, so don't trust it */
+static int pop_shared_packet( volatile struct completion_shared_memory *shared, struct comp_msg *msg )
+{
+    volatile struct completion_shared_entry *entry;
+    unsigned int pos, seq, retries;
+
+    for (retries = 0; retries < 64; retries++)
+    {
+        pos = __atomic_load_n( &shared->head, __ATOMIC_RELAXED );
+        entry = &shared->entries[pos % COMPLETION_RING_SIZE];
+        seq = __atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE );
+        if ((int)(seq - (pos + 1)) < 0) return 0;  /* empty */
+        if (seq != pos + 1) continue;
+        if (!__atomic_compare_exchange_n( &shared->head, &pos, pos + 1, 0,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED )) continue;
+        msg->status      = entry->status;
+        msg->ckey        = entry->ckey;
+        msg->cvalue      = entry->cvalue;
+        msg->information = entry->information;
+        __atomic_store_n( &entry->seq, pos + COMPLETION_RING_SIZE, __ATOMIC_RELEASE );
+        return 1;
+    }
+    return 0;
+}
+
+static unsigned int shared_packet_count( volatile struct completion_shared_memory *shared )
+{
+    unsigned int count = __atomic_load_n( &shared->tail, __ATOMIC_ACQUIRE ) -
+                         __atomic_load_n( &shared->head, __ATOMIC_ACQUIRE );
+    return min( count, COMPLETION_RING_SIZE );
+}
+
+/* notify the threads waiting on the shared futex that packets were added */
+static void signal_shared_packets( volatile struct completion_shared_memory *shared, int count )
+{
+    __atomic_add_fetch( &shared->futex, 1, __ATOMIC_SEQ_CST );
+    if (__atomic_load_n( &shared->waiters, __ATOMIC_SEQ_CST )) wake_shared_futex( &shared->futex, count );
+}
+
+/* move the packets queued while the ring was full back to the ring, to keep the clients on the fast path */
+static void refill_shared_ring( struct completion_wait *wait )
+{
+    struct comp_msg *msg;
+    struct list *entry;
+    int count = 0;
+
+    while ((entry = list_head( &wait->queue )))
+    {
+        msg = LIST_ENTRY( entry, struct comp_msg, queue_entry );
+        if (!push_shared_packet( wait->shared, msg->ckey, msg->cvalue, msg->status, msg->information ))
+            break;
+        list_remove( entry );
+        wait->depth--;
+        free( msg );
+        count++;
+    }
+    wait->shared->overflow = wait->depth;
+    if (count) signal_shared_packets( wait->shared, count );
+}
+
 static void completion_wait_destroy( struct object *obj)
 {
     struct completion_wait *wait = (struct completion_wait *)obj;
@@ -152,6 +257,8 @@ static void completion_wait_destroy( struct object *obj)
     {
         free( tmp );
     }
+    if (wait->shared) munmap( (void *)wait->shared, sizeof(*wait->shared) );
+    if (wait->mapping) release_object( wait->mapping );
 }
 
 static void completion_wait_dump( struct object *obj, int verbose )
@@ -159,7 +266,29 @@ static void completion_wait_dump( struct object *obj, int verbose )
     struct completion_wait *wait = (struct completion_wait *)obj;
 
     assert( obj->ops == &completion_wait_ops );
-    fprintf( stderr, "Completion depth=%u\n", wait->depth );
+    fprintf( stderr, "Completion depth=%u shared=%u\n", wait->depth,
+             wait->shared ? shared_packet_count( wait->shared ) : 0 );
+}
+
+static int completion_wait_add_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct completion_wait *wait = (struct completion_wait *)obj;
+
+    assert( obj->ops == &completion_wait_ops );
+    if (!add_queue( obj, entry )) return 0;
+    wait->waiters++;
+    if (wait->shared) __atomic_store_n( &wait->shared->server_waiters, wait->waiters, __ATOMIC_SEQ_CST );
+    return 1;
+}
+
+static void completion_wait_remove_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct completion_wait *wait = (struct completion_wait *)obj;
+
+    assert( obj->ops == &completion_wait_ops );
+    remove_queue( obj, entry );
+    wait->waiters--;
+    if (wait->shared) __atomic_store_n( &wait->shared->server_waiters, wait->waiters, __ATOMIC_SEQ_CST );
 }
 
 static int completion_wait_signaled( struct object *obj, struct wait_queue_entry *entry )
@@ -167,7 +296,8 @@ static int completion_wait_signaled( struct object *obj, struct wait_queue_entry
     struct completion_wait *wait = (struct completion_wait *)obj;
 
     assert( obj->ops == &completion_wait_ops );
-    return !wait->completion || !list_empty( &wait->queue );
+    return !wait->completion || !list_empty( &wait->queue ) ||
+           (wait->shared && shared_packet_count( wait->shared ));
 }
 
 static void completion_wait_satisfied( struct object *obj, struct wait_queue_entry *entry )
@@ -215,6 +345,12 @@ static void completion_destroy( struct object *obj )
 
     assert( obj->ops == &completion_ops );
     completion->wait->completion = NULL;
+    if (completion->wait->shared)
+    {
+        __atomic_store_n( &completion->wait->shared->closed, 1, __ATOMIC_SEQ_CST );
+        __atomic_add_fetch( &completion->wait->shared->futex, 1, __ATOMIC_SEQ_CST );
+        wake_shared_futex( &completion->wait->shared->futex, INT_MAX );
+    }
     wake_up( &completion->wait->obj, 0 );
     release_object( &completion->wait->obj );
 }
@@ -237,6 +373,9 @@ static struct completion *create_completion( struct object *root, const struct u
     completion->wait->completion = completion;
     list_init( &completion->wait->queue );
     completion->wait->depth = 0;
+    completion->wait->waiters = 0;
+    completion->wait->mapping = NULL;
+    completion->wait->shared = NULL;
     return completion;
 }
 
@@ -245,12 +384,39 @@ struct completion *get_completion_obj( struct process *process, obj_handle_t han
     return (struct completion *) get_handle_obj( process, handle, access, &completion_ops );
 }
 
+/* create the shared ring of a completion port */
+static volatile struct completion_shared_memory *get_completion_shared( struct completion_wait *wait )
+{
+    volatile struct completion_shared_memory *shared;
+    unsigned int i;
+    void *ptr;
+
+    if (wait->shared) return wait->shared;
+    if (!(wait->mapping = create_shared_mapping( NULL, NULL, sizeof(*shared), NULL, &ptr ))) return NULL;
+
+    shared = ptr;
+    for (i = 0; i < COMPLETION_RING_SIZE; i++) shared->entries[i].seq = i;
+    shared->server_waiters = wait->waiters;
+    wait->shared = shared;
+    /* packets queued so far stay in the list until the ring is refilled */
+    refill_shared_ring( wait );
+    return shared;
+}
+
 void add_completion( struct completion *completion, apc_param_t ckey, apc_param_t cvalue,
                      unsigned int status, apc_param_t information )
 {
-    struct comp_msg *msg = mem_alloc( sizeof( *msg ) );
+    struct completion_wait *wait = completion->wait;
+    struct comp_msg *msg;
 
-    if (!msg)
+    if (wait->shared && !wait->depth && push_shared_packet( wait->shared, ckey, cvalue, status, information ))
+    {
+        signal_shared_packets( wait->shared, 1 );
+        wake_up( &wait->obj, 1 );
+        return;
+    }
+
+    if (!(msg = mem_alloc( sizeof( *msg ) )))
         return;
 
     msg->ckey = ckey;
@@ -258,9 +424,15 @@ void add_completion( struct completion *completion, apc_param_t ckey, apc_param_
     msg->status = status;
     msg->information = information;
 
-    list_add_tail( &completion->wait->queue, &msg->queue_entry );
-    completion->wait->depth++;
-    wake_up( &completion->wait->obj, 1 );
+    list_add_tail( &wait->queue, &msg->queue_entry );
+    wait->depth++;
+    if (wait->shared)
+    {
+        /* the threads waiting on the futex need to come to the server for this one */
+        __atomic_store_n( &wait->shared->overflow, wait->depth, __ATOMIC_SEQ_CST );
+        signal_shared_packets( wait->shared, 1 );
+    }
+    wake_up( &wait->obj, 1 );
 }
 
 /* create a completion */
@@ -311,7 +483,7 @@ DECL_HANDLER(remove_completion)
     struct completion* completion;
     struct completion_wait *wait;
     struct list *entry;
-    struct comp_msg *msg;
+    struct comp_msg *msg, shared_msg;
 
     if (req->waited && (wait = (struct completion_wait *)current->locked_completion))
         current->locked_completion = NULL;
@@ -331,13 +503,21 @@ DECL_HANDLER(remove_completion)
 
     assert( wait->obj.ops == &completion_wait_ops );
 
-    entry = list_head( &wait->queue );
-    if (!entry)
+    if (wait->shared && pop_shared_packet( wait->shared, &shared_msg ))
+    {
+        reply->ckey = shared_msg.ckey;
+        reply->cvalue = shared_msg.cvalue;
+        reply->status = shared_msg.status;
+        reply->information = shared_msg.information;
+        refill_shared_ring( wait );
+    }
+    else if (!(entry = list_head( &wait->queue )))
         set_error( STATUS_PENDING );
     else
     {
         list_remove( entry );
         wait->depth--;
+        if (wait->shared) refill_shared_ring( wait );
         msg = LIST_ENTRY( entry, struct comp_msg, queue_entry );
         reply->ckey = msg->ckey;
         reply->cvalue = msg->cvalue;
@@ -357,6 +537,38 @@ DECL_HANDLER(query_completion)
     if (!completion) return;
 
     reply->depth = completion->wait->depth;
+    if (completion->wait->shared) reply->depth += shared_packet_count( completion->wait->shared );
+
+    release_object( completion );
+}
+
+/* get the shared memory ring of a completion port */
+DECL_HANDLER(get_completion_mapping)
+{
+    struct completion *completion;
+    unsigned int access;
+
+    if (!(completion = get_completion_obj( current->process, req->handle, 0 ))) return;
 
+    access = get_handle_access( current->process, req->handle );
+    if (get_completion_shared( completion->wait ))
+    {
+        /* the ring is only written to by the clients that may add or remove packets */
+        reply->mapping = alloc_handle_no_access_check( current->process, completion->wait->mapping,
+                                                       SECTION_QUERY | SECTION_MAP_READ |
+                                                       ((access & IO_COMPLETION_MODIFY_STATE) ? SECTION_MAP_WRITE : 0),
+                                                       0 );
+        reply->access = access;
+    }
+    release_object( completion );
+}
+
+/* wake the threads waiting in the server after packets were added to the shared ring */
+DECL_HANDLER(wake_completion)
+{
+    struct completion *completion = get_completion_obj( current->process, req->handle, IO_COMPLETION_MODIFY_STATE );
+
+    if (!completion) return;
+    wake_up( &completion->wait->obj, 1 );
     release_object( completion );
 }
@@ -298,17 +298,26 @@ struct object *create_desktop_map_directory( struct winstation *winstation )
     return &ret->obj;
 }
 
-struct object *create_thread_map_directory( void )
+struct object *create_kernel_objects_directory( void )
 {
     static const WCHAR dir_kernelW[] = {'K','e','r','n','e','l','O','b','j','e','c','t','s'};
-    static const WCHAR dir_thread_mapsW[] = {'_','_','w','i','n','e','_','t','h','r','e','a','d','_','m','a','p','p','i','n','g','s'};
     static const struct unicode_str dir_kernel_str = {dir_kernelW, sizeof(dir_kernelW)};
+    struct directory *ret;
+
+    ret = create_directory( &root_directory->obj, &dir_kernel_str, OBJ_OPENIF, HASH_SIZE, NULL );
+    return &ret->obj;
+}
+
+struct object *create_thread_map_directory( void )
+{
+    static const WCHAR dir_thread_mapsW[] = {'_','_','w','i','n','e','_','t','h','r','e','a','d','_','m','a','p','p','i','n','g','s'};
     static const struct unicode_str dir_thread_maps_str = {dir_thread_mapsW, sizeof(dir_thread_mapsW)};
-    struct directory *mapping_root, *ret;
+    struct object *mapping_root;
+    struct directory *ret;
 
-    mapping_root = create_directory( &root_directory->obj, &dir_kernel_str, OBJ_OPENIF, HASH_SIZE, NULL );
-    ret = create_directory( &mapping_root->obj, &dir_thread_maps_str, OBJ_OPENIF, HASH_SIZE, NULL );
-    release_object( &mapping_root->obj );
+    mapping_root = create_kernel_objects_directory();
+    ret = create_directory( mapping_root, &dir_thread_maps_str, OBJ_OPENIF, HASH_SIZE, NULL );
+    release_object( mapping_root );
 
     return &ret->obj;
 }
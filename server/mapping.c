@@ -125,6 +125,47 @@ static const struct object_ops shared_map_ops =
 
 static struct list shared_map_list = LIST_INIT( shared_map_list );
 
+/* file holding a copy of a PE image already relocated to a given base address */
+struct reloc_map
+{
+    struct object   obj;             /* object header */
+    struct fd      *fd;              /* file descriptor of the mapped PE file */
+    client_ptr_t    base;            /* base address the image is relocated to */
+    struct file    *file;            /* temp file holding the relocated image */
+    struct list     entry;           /* entry in global reloc maps list */
+};
+
+static void reloc_map_dump( struct object *obj, int verbose );
+static void reloc_map_destroy( struct object *obj );
+
+static const struct object_ops reloc_map_ops =
+{
+    sizeof(struct reloc_map),  /* size */
+    &no_type,                  /* type */
+    reloc_map_dump,            /* dump */
+    no_add_queue,              /* add_queue */
+    NULL,                      /* remove_queue */
+    NULL,                      /* signaled */
+    NULL,                      /* get_esync_fd */
+    NULL,                      /* get_fsync_idx */
+    NULL,                      /* satisfied */
+    no_signal,                 /* signal */
+    no_get_fd,                 /* get_fd */
+    default_map_access,        /* map_access */
+    default_get_sd,            /* get_sd */
+    default_set_sd,            /* set_sd */
+    no_get_full_name,          /* get_full_name */
+    no_lookup_name,            /* lookup_name */
+    no_link_name,              /* link_name */
+    NULL,                      /* unlink_name */
+    no_open_file,              /* open_file */
+    no_kernel_obj_list,        /* get_kernel_obj_list */
+    no_close_handle,           /* close_handle */
+    reloc_map_destroy          /* destroy */
+};
+
+static struct list reloc_map_list = LIST_INIT( reloc_map_list );
+
 /* memory view mapped in client address space */
 struct memory_view
 {
@@ -132,6 +173,7 @@ struct memory_view
     struct fd      *fd;              /* fd for mapped file */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    struct reloc_map *reloc;         /* temp file for relocated PE mapping */
     pe_image_info_t image;           /* image info (for PE image mapping) */
     unsigned int    flags;           /* SEC_* flags */
     client_ptr_t    base;            /* view base address (in process addr space) */
@@ -165,6 +207,7 @@ struct mapping
     pe_image_info_t image;           /* image info (for PE image mapping) */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    struct reloc_map *reloc;         /* temp file for the last relocated PE mapping */
 };
 
 static void mapping_dump( struct object *obj, int verbose );
@@ -246,6 +289,22 @@ static void shared_map_destroy( struct object *obj )
     list_remove( &shared->entry );
 }
 
+static void reloc_map_dump( struct object *obj, int verbose )
+{
+    struct reloc_map *reloc = (struct reloc_map *)obj;
+    fprintf( stderr, "Relocated mapping fd=%p base=%08x%08x file=%p\n", reloc->fd,
+             (unsigned int)(reloc->base >> 32), (unsigned int)reloc->base, reloc->file );
+}
+
+static void reloc_map_destroy( struct object *obj )
+{
+    struct reloc_map *reloc = (struct reloc_map *)obj;
+
+    release_object( reloc->fd );
+    release_object( reloc->file );
+    list_remove( &reloc->entry );
+}
+
 /* extend a file beyond the current end of file */
 int grow_file( int unix_fd, file_pos_t new_size )
 {
@@ -415,6 +474,7 @@ static void add_process_view( struct thread *thread, struct memory_view *view )
             if (get_view_nt_name( view, &name ) && (process->image = memdup( name.str, name.len )))
                 process->imagelen = name.len;
             process->image_info = view->image;
+            process_list_changed();
             return;
         }
     }
@@ -426,6 +486,7 @@ static void free_memory_view( struct memory_view *view )
     if (view->fd) release_object( view->fd );
     if (view->committed) release_object( view->committed );
     if (view->shared) release_object( view->shared );
+    if (view->reloc) release_object( view->reloc );
     list_remove( &view->entry );
     free( view );
 }
@@ -635,6 +696,187 @@ static int build_shared_mapping( struct mapping *mapping, int fd,
     return 0;
 }
 
+/* find the relocated PE mapping of a given file for a given base address */
+static struct reloc_map *get_reloc_file( struct fd *fd, client_ptr_t base )
+{
+    struct reloc_map *ptr;
+
+    LIST_FOR_EACH_ENTRY( ptr, &reloc_map_list, struct reloc_map, entry )
+        if (ptr->base == base && is_same_file_fd( ptr->fd, fd ))
+            return (struct reloc_map *)grab_object( ptr );
+    return NULL;
+}
+
+/* check if a given rva falls inside a shared writable section */
+static int is_shared_section_rva( const IMAGE_SECTION_HEADER *sec, unsigned int nb_sec, mem_size_t rva )
+{
+    size_t map_size, file_size;
+    off_t file_start;
+    unsigned int i;
+
+    for (i = 0; i < nb_sec; i++)
+    {
+        if (!(sec[i].Characteristics & IMAGE_SCN_MEM_SHARED)) continue;
+        if (!(sec[i].Characteristics & IMAGE_SCN_MEM_WRITE)) continue;
+        get_section_sizes( &sec[i], &map_size, &file_start, &file_size );
+        if (rva >= sec[i].VirtualAddress && rva < sec[i].VirtualAddress + map_size) return 1;
+    }
+    return 0;
+}
+
+/* apply the base relocations of an image laid out in memory; same logic as LdrProcessRelocationBlock */
+static int apply_image_relocations( char *image, mem_size_t size, const IMAGE_DATA_DIRECTORY *dir,
+                                    const IMAGE_SECTION_HEADER *sec, unsigned int nb_sec, INT64 delta )
+{
+    const IMAGE_BASE_RELOCATION *rel, *end;
+    const USHORT *relocs;
+    unsigned int i, count;
+
+    if (!dir->VirtualAddress || dir->VirtualAddress >= size || dir->Size > size - dir->VirtualAddress)
+        return 0;
+
+    rel = (const IMAGE_BASE_RELOCATION *)(image + dir->VirtualAddress);
+    end = (const IMAGE_BASE_RELOCATION *)(image + dir->VirtualAddress + dir->Size);
+
+    while (rel < end - 1 && rel->SizeOfBlock)
+    {
+        if (rel->SizeOfBlock < sizeof(*rel) || rel->SizeOfBlock > (const char *)end - (const char *)rel)
+            return 0;
+        if (rel->VirtualAddress >= size) return 0;
+        /* shared sections live in the shared file, we can't relocate them here */
+        if (is_shared_section_rva( sec, nb_sec, rel->VirtualAddress )) return 0;
+
+        relocs = (const USHORT *)(rel + 1);
+        count = (rel->SizeOfBlock - sizeof(*rel)) / sizeof(USHORT);
+        for (i = 0; i < count; i++)
+        {
+            mem_size_t offset = rel->VirtualAddress + (relocs[i] & 0xfff);
+            char *ptr = image + offset;
+
+            switch (relocs[i] >> 12)
+            {
+            case IMAGE_REL_BASED_ABSOLUTE:
+                break;
+            case IMAGE_REL_BASED_HIGH:
+                if (offset + sizeof(short) > size) return 0;
+                *(short *)ptr += HIWORD( delta );
+                break;
+            case IMAGE_REL_BASED_LOW:
+                if (offset + sizeof(short) > size) return 0;
+                *(short *)ptr += LOWORD( delta );
+                break;
+            case IMAGE_REL_BASED_HIGHLOW:
+                if (offset + sizeof(int) > size) return 0;
+                *(int *)ptr += delta;
+                break;
+            case IMAGE_REL_BASED_DIR64:
+                if (offset + sizeof(INT64) > size) return 0;
+                *(INT64 *)ptr += delta;
+                break;
+            default:  /* let the client loader deal with it */
+                return 0;
+            }
+        }
+        rel = (const IMAGE_BASE_RELOCATION *)(relocs + count);
+    }
+    return 1;
+}
+
+/* allocate and fill the temp file for a PE image mapping relocated to a given base */
+static struct reloc_map *build_reloc_mapping( struct mapping *mapping, client_ptr_t base )
+{
+    struct reloc_map *reloc;
+    struct file *file;
+    IMAGE_DOS_HEADER *dos;
+    IMAGE_NT_HEADERS32 *nt32;
+    IMAGE_NT_HEADERS64 *nt64;
+    IMAGE_SECTION_HEADER *sec;
+    const IMAGE_DATA_DIRECTORY *dir;
+    mem_size_t size = mapping->image.map_size;
+    size_t header_size, map_size, file_size;
+    off_t read_pos;
+    char *image;
+    int unix_fd, reloc_fd;
+    unsigned int i, nb_sec;
+    long toread, res;
+
+    if ((unix_fd = get_unix_fd( mapping->fd )) == -1) return NULL;
+    if ((reloc_fd = create_temp_file( size )) == -1) return NULL;
+    if (!(file = create_file_for_fd( reloc_fd, FILE_GENERIC_READ|FILE_GENERIC_WRITE, 0 ))) return NULL;
+
+    image = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, reloc_fd, 0 );
+    if (image == MAP_FAILED) goto error;
+
+    /* load the headers */
+
+    header_size = min( mapping->image.header_size, size );
+    header_size = min( header_size, mapping->image.file_size );
+    if (pread( unix_fd, image, header_size, 0 ) != header_size) goto failed;
+
+    dos = (IMAGE_DOS_HEADER *)image;
+    if (header_size < sizeof(*nt64) || dos->e_lfanew > header_size - sizeof(*nt64)) goto failed;
+    nt32 = (IMAGE_NT_HEADERS32 *)(image + dos->e_lfanew);
+    nt64 = (IMAGE_NT_HEADERS64 *)(image + dos->e_lfanew);
+    nb_sec = nt32->FileHeader.NumberOfSections;
+    sec = (IMAGE_SECTION_HEADER *)((char *)&nt32->OptionalHeader + nt32->FileHeader.SizeOfOptionalHeader);
+    if ((char *)(sec + nb_sec) > image + header_size) goto failed;
+
+    switch (nt32->OptionalHeader.Magic)
+    {
+    case IMAGE_NT_OPTIONAL_HDR32_MAGIC:
+        if (nt32->OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_BASERELOC) goto failed;
+        dir = &nt32->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+        break;
+    case IMAGE_NT_OPTIONAL_HDR64_MAGIC:
+        if (nt64->OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_BASERELOC) goto failed;
+        dir = &nt64->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+        break;
+    default:
+        goto failed;
+    }
+
+    /* copy the sections data, except shared sections which come from the shared file */
+
+    for (i = 0; i < nb_sec; i++)
+    {
+        if ((sec[i].Characteristics & IMAGE_SCN_MEM_SHARED) &&
+            (sec[i].Characteristics & IMAGE_SCN_MEM_WRITE)) continue;
+        get_section_sizes( &sec[i], &map_size, &read_pos, &file_size );
+        if (sec[i].VirtualAddress > size || map_size > size - sec[i].VirtualAddress) goto failed;
+        if (!sec[i].PointerToRawData || !file_size) continue;
+        toread = file_size;
+        while (toread)
+        {
+            res = pread( unix_fd, image + sec[i].VirtualAddress + file_size - toread, toread, read_pos );
+            if (!res && toread < 0x200) break;  /* partial sector at EOF is not an error */
+            if (res <= 0) goto failed;
+            toread -= res;
+            read_pos += res;
+        }
+    }
+
+    if (!apply_image_relocations( image, size, dir, sec, nb_sec, base - mapping->image.base )) goto failed;
+
+    /* the loader uses the header base to know whether relocations are still needed */
+    if (nt32->OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC) nt32->OptionalHeader.ImageBase = base;
+    else nt64->OptionalHeader.ImageBase = base;
+
+    munmap( image, size );
+
+    if (!(reloc = alloc_object( &reloc_map_ops ))) goto error;
+    reloc->fd   = (struct fd *)grab_object( mapping->fd );
+    reloc->base = base;
+    reloc->file = file;
+    list_add_head( &reloc_map_list, &reloc->entry );
+    return reloc;
+
+ failed:
+    munmap( image, size );
+ error:
+    release_object( file );
+    return NULL;
+}
+
 /* load the CLR header from its section */
 static int load_clr_header( IMAGE_COR20_HEADER *hdr, size_t va, size_t size, int unix_fd,
                             IMAGE_SECTION_HEADER *sec, unsigned int nb_sec )
@@ -889,6 +1131,7 @@ static struct mapping *create_mapping( struct object *root, const struct unicode
     mapping->size        = size;
     mapping->fd          = NULL;
     mapping->shared      = NULL;
+    mapping->reloc       = NULL;
     mapping->committed   = NULL;
 
     if (!(mapping->flags = get_mapping_flags( handle, flags ))) goto error;
@@ -978,6 +1221,7 @@ struct mapping *create_fd_mapping( struct object *root, const struct unicode_str
     if (get_error() == STATUS_OBJECT_NAME_EXISTS) return mapping;  /* Nothing else to do */
 
     mapping->shared    = NULL;
+    mapping->reloc     = NULL;
     mapping->committed = NULL;
     mapping->flags     = SEC_FILE;
     mapping->fd        = (struct fd *)grab_object( fd );
@@ -1090,6 +1334,7 @@ static void mapping_destroy( struct object *obj )
     if (mapping->fd) release_object( mapping->fd );
     if (mapping->committed) release_object( mapping->committed );
     if (mapping->shared) release_object( mapping->shared );
+    if (mapping->reloc) release_object( mapping->reloc );
 }
 
 static enum server_fd_type mapping_get_fd_type( struct fd *fd )
@@ -1210,6 +1455,45 @@ DECL_HANDLER(get_mapping_info)
     release_object( mapping );
 }
 
+/* get a file holding a copy of an image mapping relocated to a given base */
+DECL_HANDLER(get_image_reloc_file)
+{
+    struct mapping *mapping;
+    struct reloc_map *reloc;
+
+    if (!(mapping = get_mapping_obj( current->process, req->handle, SECTION_MAP_READ ))) return;
+
+    if (!(mapping->flags & SEC_IMAGE) || (req->base & page_mask) || req->base == mapping->image.base)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        goto done;
+    }
+    /* only dynamically relocated dlls get relocated on mapping, as on Windows */
+    if (!(mapping->image.image_flags & IMAGE_FLAGS_ImageDynamicallyRelocated) ||
+        (mapping->image.image_flags & IMAGE_FLAGS_ImageMappedFlat) ||
+        (mapping->image.image_charact & IMAGE_FILE_RELOCS_STRIPPED) ||
+        !(mapping->image.image_charact & IMAGE_FILE_DLL))
+    {
+        set_error( STATUS_NOT_SUPPORTED );
+        goto done;
+    }
+
+    if (!(reloc = get_reloc_file( mapping->fd, req->base )) &&
+        !(reloc = build_reloc_mapping( mapping, req->base )))
+    {
+        set_error( STATUS_NOT_SUPPORTED );
+        goto done;
+    }
+
+    /* keep it referenced until the view is added */
+    if (mapping->reloc) release_object( mapping->reloc );
+    mapping->reloc = reloc;
+    reply->reloc_file = alloc_handle( current->process, reloc->file, GENERIC_READ, 0 );
+
+done:
+    release_object( mapping );
+}
+
 /* add a memory view in the current process */
 DECL_HANDLER(map_view)
 {
@@ -1276,6 +1560,9 @@ DECL_HANDLER(map_view)
         view->fd        = !is_fd_removable( mapping->fd ) ? (struct fd *)grab_object( mapping->fd ) : NULL;
         view->committed = mapping->committed ? (struct ranges *)grab_object( mapping->committed ) : NULL;
         view->shared    = mapping->shared ? (struct shared_map *)grab_object( mapping->shared ) : NULL;
+        view->reloc     = NULL;
+        if (mapping->reloc && mapping->reloc->base == req->base)
+            view->reloc = (struct reloc_map *)grab_object( mapping->reloc );
         if (view->flags & SEC_IMAGE) view->image = mapping->image;
         add_process_view( current, view );
         if (view->flags & SEC_IMAGE && view->base != mapping->image.base)
@@ -1050,6 +1050,7 @@ void add_process_thread( struct process *process, struct thread *thread )
         }
     }
     grab_object( thread );
+    process_list_changed();
 }
 
 /* remove a thread from a process running threads list */
@@ -1070,6 +1071,7 @@ void remove_process_thread( struct process *process, struct thread *thread )
     }
     else generate_debug_event( thread, DbgExitThreadStateChange, thread );
     release_object( thread );
+    process_list_changed();
 }
 
 /* suspend all the threads of a process */
@@ -1481,6 +1483,7 @@ DECL_HANDLER(init_process_done)
 
     process->start_time = current_time;
     current->entry_point = base + image_info->entry_point;
+    process_list_changed();
 
     init_process_tracing( process );
     generate_startup_debug_events( process );
@@ -1668,6 +1671,7 @@ static void set_process_priority( struct process *process, int priority )
         set_thread_priority( thread, priority, thread->priority );
 
     process->priority = priority;
+    process_list_changed();
 }
 
 static void set_process_affinity( struct process *process, affinity_t affinity )
@@ -1955,39 +1959,35 @@ DECL_HANDLER(resume_process)
     }
 }
 
-/* Get a list of processes and threads currently running */
-DECL_HANDLER(list_processes)
+/* compute the size of the process list data */
+static data_size_t get_process_list_size( int *process_count, int *thread_count, data_size_t *name_len )
 {
     struct process *process;
-    struct thread *thread;
-    unsigned int pos = 0;
-    char *buffer;
-
-    reply->process_count = 0;
-    reply->total_thread_count = 0;
-    reply->total_name_len = 0;
-    reply->info_size = 0;
+    data_size_t size = 0;
 
+    *process_count = *thread_count = 0;
+    *name_len = 0;
     LIST_FOR_EACH_ENTRY( process, &process_list, struct process, entry )
     {
-        reply->info_size = (reply->info_size + 7) & ~7;
-        reply->info_size += sizeof(struct process_info) + process->imagelen;
-        reply->info_size = (reply->info_size + 7) & ~7;
-        reply->info_size += process->running_threads * sizeof(struct thread_info);
-        reply->process_count++;
-        reply->total_thread_count += process->running_threads;
-        reply->total_name_len += process->imagelen;
-    }
-
-    if (reply->info_size > get_reply_max_size())
-    {
-        set_error( STATUS_INFO_LENGTH_MISMATCH );
-        return;
+        size = (size + 7) & ~7;
+        size += sizeof(struct process_info) + process->imagelen;
+        size = (size + 7) & ~7;
+        size += process->running_threads * sizeof(struct thread_info);
+        (*process_count)++;
+        *thread_count += process->running_threads;
+        *name_len += process->imagelen;
     }
+    return size;
+}
 
-    if (!(buffer = set_reply_data_size( reply->info_size ))) return;
+/* fill the process list data, the buffer size must come from get_process_list_size */
+static void fill_process_list( char *buffer, data_size_t size )
+{
+    struct process *process;
+    struct thread *thread;
+    unsigned int pos = 0;
 
-    memset( buffer, 0, reply->info_size );
+    memset( buffer, 0, size );
     LIST_FOR_EACH_ENTRY( process, &process_list, struct process, entry )
     {
         struct process_info *process_info;
@@ -2022,3 +2022,94 @@ DECL_HANDLER(list_processes)
         }
     }
 }
+
+static struct object *process_list_mapping;
+static volatile struct process_list_shared_memory *process_list_shared;
+
+/* get the shared memory copy of the process list, creating it on first use */
+static volatile struct process_list_shared_memory *get_process_list_shared(void)
+{
+    static const WCHAR process_listW[] = {'_','_','w','i','n','e','_','p','r','o','c','e','s','s','_','l','i','s','t'};
+    static const struct unicode_str process_list_str = {process_listW, sizeof(process_listW)};
+    static int failed;
+    struct object *dir;
+    void *ptr;
+
+    if (process_list_shared || failed) return process_list_shared;
+
+    failed = 1;
+    if (!(dir = create_kernel_objects_directory())) return NULL;
+    process_list_mapping = create_shared_mapping( dir, &process_list_str, PROCESS_LIST_SHARED_SIZE, NULL, &ptr );
+    release_object( dir );
+    if (!process_list_mapping) return NULL;
+
+    process_list_shared = ptr;
+    memset( (void *)process_list_shared, 0, sizeof(*process_list_shared) );
+    process_list_shared->stale = 1;
+    failed = 0;
+    return process_list_shared;
+}
+
+/* copy the process list to shared memory */
+static void update_process_list_shared( const char *data, data_size_t size, int process_count,
+                                        int thread_count, data_size_t name_len )
+{
+    volatile struct process_list_shared_memory *shared = get_process_list_shared();
+
+    if (!shared) return;
+
+    SHARED_WRITE_BEGIN( &shared->seq );
+    shared->update_time = current_time;
+    shared->process_count = process_count;
+    shared->total_thread_count = thread_count;
+    shared->total_name_len = name_len;
+    if (size <= PROCESS_LIST_SHARED_SIZE - sizeof(*shared))
+    {
+        memcpy( (char *)(shared + 1), data, size );
+        shared->info_size = size;
+        shared->stale = 0;
+    }
+    else
+    {
+        /* too large, clients have to use the list_processes request */
+        shared->info_size = 0;
+        shared->stale = 1;
+    }
+    SHARED_WRITE_END( &shared->seq );
+}
+
+/* invalidate the shared process list after a process or thread change, it gets
+ * rebuilt by the next list_processes request of a client that finds it stale */
+void process_list_changed(void)
+{
+    volatile struct process_list_shared_memory *shared = get_process_list_shared();
+
+    if (!shared || shared->stale) return;
+
+    SHARED_WRITE_BEGIN( &shared->seq );
+    shared->stale = 1;
+    SHARED_WRITE_END( &shared->seq );
+}
+
+/* Get a list of processes and threads currently running */
+DECL_HANDLER(list_processes)
+{
+    char *buffer;
+
+    reply->info_size = get_process_list_size( &reply->process_count, &reply->total_thread_count,
+                                              &reply->total_name_len );
+
+    if (reply->info_size > get_reply_max_size())
+    {
+        set_error( STATUS_INFO_LENGTH_MISMATCH );
+        return;
+    }
+
+    if (!(buffer = set_reply_data_size( reply->info_size ))) return;
+
+    fill_process_list( buffer, reply->info_size );
+
+    /* refresh the shared copy for the clients that can read it directly */
+    update_process_list_shared( buffer, reply->info_size, reply->process_count,
+                                    reply->total_thread_count, reply->total_name_len );
+}
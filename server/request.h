@@ -181,6 +181,7 @@ DECL_HANDLER(read_change);
 DECL_HANDLER(create_mapping);
 DECL_HANDLER(open_mapping);
 DECL_HANDLER(get_mapping_info);
+DECL_HANDLER(get_image_reloc_file);
 DECL_HANDLER(map_view);
 DECL_HANDLER(unmap_view);
 DECL_HANDLER(get_mapping_committed_range);
@@ -368,6 +369,8 @@ DECL_HANDLER(open_completion);
 DECL_HANDLER(add_completion);
 DECL_HANDLER(remove_completion);
 DECL_HANDLER(query_completion);
+DECL_HANDLER(get_completion_mapping);
+DECL_HANDLER(wake_completion);
 DECL_HANDLER(set_completion_info);
 DECL_HANDLER(add_fd_completion);
 DECL_HANDLER(set_fd_completion_mode);
@@ -472,6 +475,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_create_mapping,
     (req_handler)req_open_mapping,
     (req_handler)req_get_mapping_info,
+    (req_handler)req_get_image_reloc_file,
     (req_handler)req_map_view,
     (req_handler)req_unmap_view,
     (req_handler)req_get_mapping_committed_range,
@@ -659,6 +663,8 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_add_completion,
     (req_handler)req_remove_completion,
     (req_handler)req_query_completion,
+    (req_handler)req_get_completion_mapping,
+    (req_handler)req_wake_completion,
     (req_handler)req_set_completion_info,
     (req_handler)req_add_fd_completion,
     (req_handler)req_set_fd_completion_mode,
@@ -1117,6 +1123,11 @@ C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, flags) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, shared_file) == 20 );
 C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, total) == 24 );
 C_ASSERT( sizeof(struct get_mapping_info_reply) == 32 );
+C_ASSERT( FIELD_OFFSET(struct get_image_reloc_file_request, handle) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_image_reloc_file_request, base) == 16 );
+C_ASSERT( sizeof(struct get_image_reloc_file_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_image_reloc_file_reply, reloc_file) == 8 );
+C_ASSERT( sizeof(struct get_image_reloc_file_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, mapping) == 12 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, access) == 16 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, base) == 24 );
@@ -2155,6 +2166,13 @@ C_ASSERT( FIELD_OFFSET(struct query_completion_request, handle) == 12 );
 C_ASSERT( sizeof(struct query_completion_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_reply, depth) == 8 );
 C_ASSERT( sizeof(struct query_completion_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_completion_mapping_request, handle) == 12 );
+C_ASSERT( sizeof(struct get_completion_mapping_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_completion_mapping_reply, mapping) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_completion_mapping_reply, access) == 12 );
+C_ASSERT( sizeof(struct get_completion_mapping_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct wake_completion_request, handle) == 12 );
+C_ASSERT( sizeof(struct wake_completion_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_completion_info_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_completion_info_request, ckey) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_completion_info_request, chandle) == 24 );
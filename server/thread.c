@@ -843,6 +843,7 @@ int set_thread_priority( struct thread *thread, int priority_class, int priority
         thread->priority == priority)
         return 0;
     thread->priority = priority;
+    process_list_changed();
 
     apply_thread_priority( thread, priority_class, priority, FALSE );
     return 0;
@@ -869,7 +870,10 @@ static void set_thread_info( struct thread *thread,
     if (req->mask & SET_THREAD_INFO_TOKEN)
         security_set_thread_token( thread, req->token );
     if (req->mask & SET_THREAD_INFO_ENTRYPOINT)
+    {
         thread->entry_point = req->entry_point;
+        process_list_changed();
+    }
     if (req->mask & SET_THREAD_INFO_DBG_HIDDEN)
         thread->dbg_hidden = 1;
     if (req->mask & SET_THREAD_INFO_DESCRIPTION)
@@ -1666,6 +1670,7 @@ DECL_HANDLER(init_first_thread)
     current->unix_pid = process->unix_pid = req->unix_pid;
     current->unix_tid = req->unix_tid;
     process->nice_limit = req->nice_limit;
+    process_list_changed();
 
     if (!process->parent_id)
         process->affinity = current->affinity = get_thread_affinity( current );
@@ -1702,6 +1707,7 @@ DECL_HANDLER(init_thread)
     current->unix_tid = req->unix_tid;
     current->teb      = req->teb;
     current->entry_point = req->entry;
+    process_list_changed();
 
     init_thread_context( current );
     generate_debug_event( current, DbgCreateThreadStateChange, &req->entry );